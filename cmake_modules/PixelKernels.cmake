@@ -0,0 +1,13 @@
+# Add the internal pixel kernel library to a driver build.
+#
+# Usage:
+#   include(PixelKernels)
+#   target_link_libraries(mydriver pixelkernels ...)
+
+get_filename_component(PIXELKERNELS_DIR ${CMAKE_CURRENT_LIST_DIR}/../pixelkernels ABSOLUTE)
+
+if (NOT TARGET pixelkernels)
+    add_subdirectory(${PIXELKERNELS_DIR} ${CMAKE_BINARY_DIR}/pixelkernels)
+endif ()
+
+include_directories(${PIXELKERNELS_DIR})
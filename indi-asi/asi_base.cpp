@@ -25,6 +25,8 @@
 
 #include "config.h"
 
+#include <pixelkernels.h>
+
 #include <stream/streammanager.h>
 #include <indielapsedtimer.h>
 
@@ -32,14 +34,17 @@
 #include <cmath>
 #include <vector>
 #include <map>
+#include <thread>
 #include <unistd.h>
 
 #define MAX_EXP_RETRIES         3
 #define VERBOSE_EXPOSURE        3
 #define TEMP_TIMER_MS           1000 /* Temperature polling time (ms) */
 #define TEMP_THRESHOLD          .25  /* Differential temperature threshold (C)*/
+#define PIPELINE_SLACK          0.5  /* Age past its duration after which a pipelined exposure is stale (s) */
 
 #define CONTROL_TAB "Controls"
+#define STREAMING_TAB "Streaming"
 
 static bool warn_roi_height = true;
 static bool warn_roi_width = true;
@@ -61,21 +66,53 @@ void ASIBase::workerStreamVideo(const std::atomic_bool &isAboutToQuit)
         LOGF_ERROR("Failed to set exposure duration (%s).", Helpers::toString(ret));
     }
 
+    uint32_t totalBytes = PrimaryCCD.getFrameBufferSize();
+    if (mFrameRing.allocate(StreamBuffersNP[0].getValue(), totalBytes) == false)
+    {
+        Streamer->setStream(false);
+        LOGF_ERROR("Failed to allocate %g stream buffers of %u bytes.", StreamBuffersNP[0].getValue(), totalBytes);
+        return;
+    }
+
     ret = ASIStartVideoCapture(mCameraInfo.CameraID);
     if (ret != ASI_SUCCESS)
     {
         LOGF_ERROR("Failed to start video capture (%s).", Helpers::toString(ret));
     }
 
+    // The sender converts and hands frames to the streamer while the SDK fills the next one
+    bool isRGB = (mCurrentVideoFormat == ASI_IMG_RGB24);
+    std::thread sender([this, isRGB, totalBytes]
+    {
+        uint8_t *frame;
+        while ((frame = mFrameRing.wait()) != nullptr)
+        {
+            if (isRGB)
+                PixelKernels::swapChannels02(frame, totalBytes / 3);
+
+            Streamer->newFrame(frame, totalBytes);
+            mFrameRing.release(frame);
+        }
+    });
+
+    INDI::ElapsedTimer statsTimer;
+
     while (!isAboutToQuit)
     {
-        uint8_t *targetFrame = PrimaryCCD.getFrameBuffer();
-        uint32_t totalBytes  = PrimaryCCD.getFrameBufferSize();
-        int waitMS           = static_cast<int>((ExposureRequest * 2000.0) + 500);
+        int waitMS = static_cast<int>((ExposureRequest * 2000.0) + 500);
+
+        uint8_t *targetFrame = mFrameRing.acquire();
+        if (targetFrame == nullptr)
+        {
+            usleep(100);
+            continue;
+        }
 
         ret = ASIGetVideoData(mCameraInfo.CameraID, targetFrame, totalBytes, waitMS);
         if (ret != ASI_SUCCESS)
         {
+            mFrameRing.discard(targetFrame);
+
             if (ret != ASI_ERROR_TIMEOUT)
             {
                 Streamer->setStream(false);
@@ -87,14 +124,30 @@ void ASIBase::workerStreamVideo(const std::atomic_bool &isAboutToQuit)
             continue;
         }
 
-        if (mCurrentVideoFormat == ASI_IMG_RGB24)
-            for (uint32_t i = 0; i < totalBytes; i += 3)
-                std::swap(targetFrame[i], targetFrame[i + 2]);
+        mFrameRing.commit(targetFrame);
 
-        Streamer->newFrame(targetFrame, totalBytes);
+        if (statsTimer.elapsed() >= 1000)
+        {
+            StreamStatsNP[STREAM_FRAMES     ].setValue(mFrameRing.framesCommitted());
+            StreamStatsNP[STREAM_DROPPED    ].setValue(mFrameRing.framesDropped());
+            StreamStatsNP[STREAM_QUEUE_DEPTH].setValue(mFrameRing.queueDepth());
+            StreamStatsNP.setState(mFrameRing.framesDropped() > 0 ? IPS_BUSY : IPS_OK);
+            StreamStatsNP.apply();
+            statsTimer.start();
+        }
     }
 
     ASIStopVideoCapture(mCameraInfo.CameraID);
+
+    mFrameRing.close();
+    sender.join();
+    mFrameRing.free();
+
+    StreamStatsNP[STREAM_FRAMES     ].setValue(mFrameRing.framesCommitted());
+    StreamStatsNP[STREAM_DROPPED    ].setValue(mFrameRing.framesDropped());
+    StreamStatsNP[STREAM_QUEUE_DEPTH].setValue(0);
+    StreamStatsNP.setState(IPS_IDLE);
+    StreamStatsNP.apply();
 }
 
 void ASIBase::workerBlinkExposure(const std::atomic_bool &isAboutToQuit, int blinks, float duration)
@@ -152,51 +205,65 @@ void ASIBase::workerExposure(const std::atomic_bool &isAboutToQuit, float durati
 {
     ASI_ERROR_CODE ret;
 
-    workerBlinkExposure(
-        isAboutToQuit,
-        BlinkNP[BLINK_COUNT   ].getValue(),
-        BlinkNP[BLINK_DURATION].getValue()
-    );
+    ASI_BOOL isDark = (PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME) ? ASI_TRUE : ASI_FALSE;
 
-    PrimaryCCD.setExposureDuration(duration);
+    // If the previous frame already started this exposure, just wait for the remaining time
+    double alreadyExposed = adoptPipelinedExposure(duration, isDark);
+    mFrameWasPipelined = alreadyExposed >= 0;
 
-    LOGF_DEBUG("StartExposure->setexp : %.3fs", duration);
-    ret = ASISetControlValue(mCameraInfo.CameraID, ASI_EXPOSURE, duration * 1000 * 1000, ASI_FALSE);
-    if (ret != ASI_SUCCESS)
+    if (mFrameWasPipelined)
     {
-        LOGF_ERROR("Failed to set exposure duration (%s).", Helpers::toString(ret));
+        PrimaryCCD.setExposureDuration(duration);
+        LOGF_DEBUG("StartExposure->pipelined : %.3fs, %.3fs already exposed", duration, alreadyExposed);
     }
+    else
+    {
+        alreadyExposed = 0;
 
-    // Try exposure for 3 times
-    ASI_BOOL isDark = (PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME) ? ASI_TRUE : ASI_FALSE;
+        workerBlinkExposure(
+            isAboutToQuit,
+            BlinkNP[BLINK_COUNT   ].getValue(),
+            BlinkNP[BLINK_DURATION].getValue()
+        );
 
-    for (int i = 0; i < 3; i++)
-    {
-        ret = ASIStartExposure(mCameraInfo.CameraID, isDark);
-        if (ret == ASI_SUCCESS)
-            break;
+        PrimaryCCD.setExposureDuration(duration);
 
-        LOGF_ERROR("Failed to start exposure (%d)", Helpers::toString(ret));
-        // Wait 100ms before trying again
-        usleep(100 * 1000);
+        LOGF_DEBUG("StartExposure->setexp : %.3fs", duration);
+        ret = ASISetControlValue(mCameraInfo.CameraID, ASI_EXPOSURE, duration * 1000 * 1000, ASI_FALSE);
+        if (ret != ASI_SUCCESS)
+        {
+            LOGF_ERROR("Failed to set exposure duration (%s).", Helpers::toString(ret));
+        }
 
-        // JM 2020-02-17 Special hack for older ASI120 and ASI130 cameras (USB 2.0)
-        // that fail on 16bit images.
-        if (getImageType() == ASI_IMG_RAW16 &&
-                (strstr(getDeviceName(), "ASI120") || (strstr(getDeviceName(), "ASI130"))))
+        // Try exposure for 3 times
+        for (int i = 0; i < 3; i++)
         {
-            LOG_INFO("Switching to 8-bit video.");
-            setVideoFormat(ASI_IMG_RAW8);
+            ret = ASIStartExposure(mCameraInfo.CameraID, isDark);
+            if (ret == ASI_SUCCESS)
+                break;
+
+            LOGF_ERROR("Failed to start exposure (%d)", Helpers::toString(ret));
+            // Wait 100ms before trying again
+            usleep(100 * 1000);
+
+            // JM 2020-02-17 Special hack for older ASI120 and ASI130 cameras (USB 2.0)
+            // that fail on 16bit images.
+            if (getImageType() == ASI_IMG_RAW16 &&
+                    (strstr(getDeviceName(), "ASI120") || (strstr(getDeviceName(), "ASI130"))))
+            {
+                LOG_INFO("Switching to 8-bit video.");
+                setVideoFormat(ASI_IMG_RAW8);
+            }
         }
-    }
 
-    if (ret != ASI_SUCCESS)
-    {
-        LOG_WARN(
-            "ASI firmware might require an update to *compatible mode."
-            "Check http://www.indilib.org/devices/ccds/zwo-optics-asi-cameras.html for details."
-        );
-        return;
+        if (ret != ASI_SUCCESS)
+        {
+            LOG_WARN(
+                "ASI firmware might require an update to *compatible mode."
+                "Check http://www.indilib.org/devices/ccds/zwo-optics-asi-cameras.html for details."
+            );
+            return;
+        }
     }
 
     INDI::ElapsedTimer exposureTimer;
@@ -212,7 +279,7 @@ void ASIBase::workerExposure(const std::atomic_bool &isAboutToQuit, float durati
             return;
 
         float delay = 0.1;
-        float timeLeft = std::max(duration - exposureTimer.elapsed() / 1000.0, 0.0);
+        float timeLeft = std::max(duration - alreadyExposed - exposureTimer.elapsed() / 1000.0, 0.0);
 
         /*
          * Check the status every second until the time left is
@@ -274,6 +341,70 @@ void ASIBase::workerExposure(const std::atomic_bool &isAboutToQuit, float durati
     grabImage(duration);
 }
 
+void ASIBase::startPipelinedExposure(float duration, ASI_BOOL isDark)
+{
+    // Blinks are taken before every exposure, so we cannot start ahead of the client
+    if (PipelineSP[PIPELINE_ON].getState() != ISS_ON || BlinkNP[BLINK_COUNT].getValue() > 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mPipelinedMutex);
+
+    ASI_ERROR_CODE ret = ASIStartExposure(mCameraInfo.CameraID, isDark);
+    if (ret != ASI_SUCCESS)
+    {
+        LOGF_DEBUG("Failed to start pipelined exposure (%s).", Helpers::toString(ret));
+        mPipelined.active = false;
+        return;
+    }
+
+    mPipelined.active   = true;
+    mPipelined.duration = duration;
+    mPipelined.isDark   = isDark;
+    mPipelined.start    = std::chrono::steady_clock::now();
+    mPipelined.utcStart = std::chrono::system_clock::now();
+}
+
+double ASIBase::adoptPipelinedExposure(float duration, ASI_BOOL isDark)
+{
+    std::lock_guard<std::mutex> lock(mPipelinedMutex);
+
+    if (!mPipelined.active)
+        return -1;
+
+    mPipelined.active = false;
+
+    if (std::abs(mPipelined.duration - duration) > 1e-6 || mPipelined.isDark != isDark)
+    {
+        LOG_DEBUG("Pipelined exposure does not match request, restarting.");
+        ASIStopExposure(mCameraInfo.CameraID);
+        return -1;
+    }
+
+    // The frame has been sitting in the camera since it finished, it no longer matches the request time
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - mPipelined.start).count();
+    if (elapsed > duration + PIPELINE_SLACK)
+    {
+        LOGF_DEBUG("Pipelined exposure is stale (%.3fs old), restarting.", elapsed);
+        ASIStopExposure(mCameraInfo.CameraID);
+        return -1;
+    }
+
+    mFrameUTCStart = mPipelined.utcStart;
+    return elapsed;
+}
+
+void ASIBase::cancelPipelinedExposure()
+{
+    std::lock_guard<std::mutex> lock(mPipelinedMutex);
+
+    if (!mPipelined.active)
+        return;
+
+    LOG_DEBUG("Cancelling pipelined exposure.");
+    mPipelined.active = false;
+    ASIStopExposure(mCameraInfo.CameraID);
+}
+
 ///////////////////////////////////////////////////////////////////////
 /// Generic constructor
 ///////////////////////////////////////////////////////////////////////
@@ -325,6 +456,18 @@ bool ASIBase::initProperties()
     BlinkNP[BLINK_DURATION].fill("BLINK_DURATION", "Blink duration",         "%2.3f", 0,  60, 0.001, 0);
     BlinkNP.fill(getDeviceName(), "BLINK", "Blink", CONTROL_TAB, IP_RW, 60, IPS_IDLE);
 
+    StreamBuffersNP[0].fill("BUFFERS", "Frames", "%2.0f", 2, 64, 1, 8);
+    StreamBuffersNP.fill(getDeviceName(), "CCD_STREAM_BUFFERS", "Stream Buffers", STREAMING_TAB, IP_RW, 60, IPS_IDLE);
+
+    StreamStatsNP[STREAM_FRAMES     ].fill("STREAM_FRAMES",      "Frames",      "%.0f", 0, 1e12, 0, 0);
+    StreamStatsNP[STREAM_DROPPED    ].fill("STREAM_DROPPED",     "Dropped",     "%.0f", 0, 1e12, 0, 0);
+    StreamStatsNP[STREAM_QUEUE_DEPTH].fill("STREAM_QUEUE_DEPTH", "Queue Depth", "%.0f", 0, 64,   0, 0);
+    StreamStatsNP.fill(getDeviceName(), "CCD_STREAM_STATS", "Stream Stats", STREAMING_TAB, IP_RO, 60, IPS_IDLE);
+
+    PipelineSP[PIPELINE_ON ].fill("PIPELINE_ON",  "On",  ISS_OFF);
+    PipelineSP[PIPELINE_OFF].fill("PIPELINE_OFF", "Off", ISS_ON);
+    PipelineSP.fill(getDeviceName(), "CCD_EXPOSURE_PIPELINE", "Pipelining", CONTROL_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
+
     IUSaveText(&BayerT[2], getBayerString());
 
     ADCDepthNP[0].fill("BITS", "Bits", "%2.0f", 0, 32, 1, mCameraInfo.BitDepth);
@@ -435,6 +578,11 @@ bool ASIBase::updateProperties()
         }
 
         defineProperty(BlinkNP);
+        defineProperty(PipelineSP);
+        loadConfig(true, PipelineSP.getName());
+        defineProperty(StreamBuffersNP);
+        loadConfig(true, StreamBuffersNP.getName());
+        defineProperty(StreamStatsNP);
         defineProperty(ADCDepthNP);
         defineProperty(SDKVersionSP);
     }
@@ -458,6 +606,9 @@ bool ASIBase::updateProperties()
             deleteProperty(VideoFormatSP.getName());
 
         deleteProperty(BlinkNP.getName());
+        deleteProperty(PipelineSP.getName());
+        deleteProperty(StreamBuffersNP.getName());
+        deleteProperty(StreamStatsNP.getName());
         deleteProperty(SDKVersionSP.getName());
         deleteProperty(ADCDepthNP.getName());
     }
@@ -515,6 +666,7 @@ bool ASIBase::Disconnect()
     mTimerTemperature.stop();
 
     mWorker.quit();
+    cancelPipelinedExposure();
     Streamer->setStream(false);
 
     if (isSimulation() == false)
@@ -691,6 +843,8 @@ bool ASIBase::ISNewNumber(const char *dev, const char *name, double values[], ch
                 if (std::abs(ControlNP[i].getValue() - oldValues[i]) < 0.01)
                     continue;
 
+                cancelPipelinedExposure();
+
                 LOGF_DEBUG("Setting %s=%.2f...", ControlNP[i].getLabel(), ControlNP[i].getValue());
                 ret = ASISetControlValue(mCameraInfo.CameraID, numCtrlCap->ControlType, static_cast<long>(ControlNP[i].getValue()),
                                          ASI_FALSE);
@@ -726,10 +880,26 @@ bool ASIBase::ISNewNumber(const char *dev, const char *name, double values[], ch
 
         if (BlinkNP.isNameMatch(name))
         {
+            cancelPipelinedExposure();
             BlinkNP.setState(BlinkNP.update(values, names, n) ? IPS_OK : IPS_ALERT);
             BlinkNP.apply();
             return true;
         }
+
+        if (StreamBuffersNP.isNameMatch(name))
+        {
+            if (Streamer->isBusy())
+            {
+                LOG_ERROR("Cannot change stream buffers while streaming/recording.");
+                StreamBuffersNP.setState(IPS_ALERT);
+                StreamBuffersNP.apply();
+                return true;
+            }
+
+            StreamBuffersNP.setState(StreamBuffersNP.update(values, names, n) ? IPS_OK : IPS_ALERT);
+            StreamBuffersNP.apply();
+            return true;
+        }
     }
 
     return INDI::CCD::ISNewNumber(dev, name, values, names, n);
@@ -777,11 +947,32 @@ bool ASIBase::ISNewSwitch(const char *dev, const char *name, ISState *states, ch
                 }
             }
 
+            cancelPipelinedExposure();
+
             ControlSP.setState(IPS_OK);
             ControlSP.apply();
             return true;
         }
 
+        if (PipelineSP.isNameMatch(name))
+        {
+            if (PipelineSP.update(states, names, n) == false)
+            {
+                PipelineSP.setState(IPS_ALERT);
+                PipelineSP.apply();
+                return true;
+            }
+
+            if (PipelineSP[PIPELINE_OFF].getState() == ISS_ON)
+                cancelPipelinedExposure();
+            else
+                LOG_INFO("Exposure pipelining is enabled. Each exposure starts as soon as the previous frame is read out.");
+
+            PipelineSP.setState(IPS_OK);
+            PipelineSP.apply();
+            return true;
+        }
+
         /* Cooler */
         if (CoolerSP.isNameMatch(name))
         {
@@ -830,6 +1021,8 @@ bool ASIBase::setVideoFormat(uint8_t index)
     if (index == VideoFormatSP.findOnSwitchIndex())
         return true;
 
+    cancelPipelinedExposure();
+
     VideoFormatSP.reset();
     VideoFormatSP[index].setState(ISS_ON);
 
@@ -913,6 +1106,7 @@ bool ASIBase::AbortExposure()
     LOG_DEBUG("Aborting exposure...");
 
     mWorker.quit();
+    cancelPipelinedExposure();
 
     ASIStopExposure(mCameraInfo.CameraID);
     return true;
@@ -945,6 +1139,7 @@ bool ASIBase::StartStreaming()
         }
     }
 #endif
+    cancelPipelinedExposure();
     mWorker.start(std::bind(&ASIBase::workerStreamVideo, this, std::placeholders::_1));
     return true;
 }
@@ -994,6 +1189,8 @@ bool ASIBase::UpdateCCDFrame(int x, int y, int w, int h)
 
     LOGF_DEBUG("Frame ROI x:%d y:%d w:%d h:%d", subX, subY, subW, subH);
 
+    cancelPipelinedExposure();
+
     ASI_ERROR_CODE ret;
 
     ret = ASISetROIFormat(mCameraInfo.CameraID, subW, subH, binX, getImageType());
@@ -1055,12 +1252,16 @@ int ASIBase::grabImage(float duration)
 
     if (type == ASI_IMG_RGB24)
     {
-        buffer = static_cast<uint8_t *>(malloc(nTotalBytes));
-        if (buffer == nullptr)
+        try
+        {
+            mReadoutBuffer.resize(nTotalBytes);
+        }
+        catch (const std::bad_alloc &)
         {
             LOGF_ERROR("%s: %d malloc failed (RGB 24).", getDeviceName());
             return -1;
         }
+        buffer = mReadoutBuffer.data();
     }
 
     ret = ASIGetDataAfterExp(mCameraInfo.CameraID, buffer, nTotalBytes);
@@ -1070,28 +1271,20 @@ int ASIBase::grabImage(float duration)
             "Failed to get data after exposure (%dx%d #%d channels) (%s).",
             subW, subH, nChannels, Helpers::toString(ret)
         );
-        if (type == ASI_IMG_RGB24)
-            free(buffer);
         return -1;
     }
 
+    // The sensor is free now, keep it busy while this frame is processed and sent
+    startPipelinedExposure(duration, (PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME) ? ASI_TRUE : ASI_FALSE);
+
     if (type == ASI_IMG_RGB24)
     {
         uint8_t *dstR = image;
         uint8_t *dstG = image + subW * subH;
         uint8_t *dstB = image + subW * subH * 2;
 
-        const uint8_t *src = buffer;
-        const uint8_t *end = buffer + subW * subH * 3;
-
-        while (src != end)
-        {
-            *dstB++ = *src++;
-            *dstG++ = *src++;
-            *dstR++ = *src++;
-        }
-
-        free(buffer);
+        // BGR24 to planar RGB
+        PixelKernels::deinterleave3(buffer, dstB, dstG, dstR, subW * subH);
     }
     guard.unlock();
 
@@ -1402,6 +1595,21 @@ void ASIBase::addFITSKeywords(fitsfile *fptr, INDI::CCDChip *targetChip)
 {
     INDI::CCD::addFITSKeywords(fptr, targetChip);
 
+    // Pipelined exposures started before the client asked for them, so report the real start time
+    if (mFrameWasPipelined)
+    {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(mFrameUTCStart.time_since_epoch()).count();
+        time_t secs = ms / 1000;
+        struct tm utc;
+        char ts[32], dateObs[40];
+        gmtime_r(&secs, &utc);
+        strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &utc);
+        snprintf(dateObs, sizeof(dateObs), "%s.%03d", ts, static_cast<int>(ms % 1000));
+
+        int status = 0;
+        fits_update_key_s(fptr, TSTRING, "DATE-OBS", dateObs, "UTC start date of observation", &status);
+    }
+
     // e-/ADU
     auto np = ControlNP.findWidgetByName("Gain");
     if (np)
@@ -1435,6 +1643,8 @@ bool ASIBase::saveConfigItems(FILE *fp)
         VideoFormatSP.save(fp);
 
     BlinkNP.save(fp);
+    PipelineSP.save(fp);
+    StreamBuffersNP.save(fp);
 
     return true;
 }
@@ -28,7 +28,10 @@
 #include "indipropertynumber.h"
 #include "indipropertytext.h"
 #include "indisinglethreadpool.h"
+#include "asi_framering.h"
 
+#include <chrono>
+#include <mutex>
 #include <vector>
 
 #include <indiccd.h>
@@ -90,6 +93,15 @@ class ASIBase : public INDI::CCD
         /** Get image from CCD and send it to client */
         int grabImage(float duration);
 
+        /** Start the next exposure right after readout so the sensor integrates while the frame is sent */
+        void startPipelinedExposure(float duration, ASI_BOOL isDark);
+
+        /** Take over a pipelined exposure if it matches the request and is not stale, returns seconds already exposed or -1 */
+        double adoptPipelinedExposure(float duration, ASI_BOOL isDark);
+
+        /** Abort any pipelined exposure, called whenever the camera setup changes */
+        void cancelPipelinedExposure();
+
     protected:
         double mTargetTemperature;
         double mCurrentTemperature;
@@ -145,6 +157,44 @@ class ASIBase : public INDI::CCD
             BLINK_DURATION
         };
 
+        INDI::PropertyNumber  StreamBuffersNP {1};
+
+        INDI::PropertyNumber  StreamStatsNP {3};
+        enum
+        {
+            STREAM_FRAMES,
+            STREAM_DROPPED,
+            STREAM_QUEUE_DEPTH
+        };
+
+        /** Video frames from the SDK reader to the sender thread, which the streamer copies from */
+        ASIFrameRing mFrameRing;
+
+        INDI::PropertySwitch  PipelineSP {2};
+        enum
+        {
+            PIPELINE_ON,
+            PIPELINE_OFF
+        };
+
+        /** Exposure started ahead of the client request, valid while mPipelined.active is true */
+        struct
+        {
+            bool active {false};
+            float duration {0};
+            ASI_BOOL isDark {ASI_FALSE};
+            std::chrono::steady_clock::time_point start;
+            std::chrono::system_clock::time_point utcStart;
+        } mPipelined;
+        std::mutex mPipelinedMutex;
+
+        /** UTC start of the frame being saved, when it came from a pipelined exposure */
+        bool mFrameWasPipelined {false};
+        std::chrono::system_clock::time_point mFrameUTCStart;
+
+        /** Raw readout buffer, reused between frames */
+        std::vector<uint8_t> mReadoutBuffer;
+
         std::string mCameraName, mCameraID;
         ASI_CAMERA_INFO mCameraInfo;
         uint8_t mExposureRetry {0};
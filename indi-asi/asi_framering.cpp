@@ -0,0 +1,172 @@
+/*
+    ASI CCD Driver
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "asi_framering.h"
+
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// Frames are aligned for the SDK DMA copy and for vectorized byte swapping
+#define FRAME_ALIGNMENT 4096
+
+ASIFrameRing::~ASIFrameRing()
+{
+    free();
+}
+
+bool ASIFrameRing::allocate(size_t count, size_t size)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Frames still owned by the reader or the sender must come back first
+    mReleased.wait(lock, [this] { return mFree.size() + mPending.size() == mFrameCount; });
+
+    size_t alignedSize = (size + FRAME_ALIGNMENT - 1) / FRAME_ALIGNMENT * FRAME_ALIGNMENT;
+
+    mCommitted = 0;
+    mDropped = 0;
+
+    if (mMemory != nullptr && count == mFrameCount && alignedSize == mFrameSize)
+    {
+        mFree.insert(mFree.end(), mPending.begin(), mPending.end());
+        mPending.clear();
+        mDepth = 0;
+        mClosed = false;
+        return true;
+    }
+
+    std::free(mMemory);
+    mMemory = nullptr;
+    mFree.clear();
+    mPending.clear();
+    mFrameCount = 0;
+    mFrameSize = 0;
+    mDepth = 0;
+
+    if (posix_memalign(reinterpret_cast<void **>(&mMemory), FRAME_ALIGNMENT, count * alignedSize) != 0)
+    {
+        mMemory = nullptr;
+        return false;
+    }
+
+#ifdef __linux__
+    // Best effort: transparent huge pages and locked memory avoid page faults at high frame rates
+    madvise(mMemory, count * alignedSize, MADV_HUGEPAGE);
+    mlock(mMemory, count * alignedSize);
+#endif
+
+    mFrameCount = count;
+    mFrameSize = alignedSize;
+    for (size_t i = 0; i < count; i++)
+        mFree.push_back(mMemory + i * alignedSize);
+
+    mClosed = false;
+    return true;
+}
+
+void ASIFrameRing::free()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mMemory == nullptr)
+        return;
+
+#ifdef __linux__
+    munlock(mMemory, mFrameCount * mFrameSize);
+#endif
+    std::free(mMemory);
+    mMemory = nullptr;
+    mFree.clear();
+    mPending.clear();
+    mFrameCount = 0;
+    mFrameSize = 0;
+    mDepth = 0;
+}
+
+uint8_t *ASIFrameRing::acquire()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!mFree.empty())
+    {
+        uint8_t *frame = mFree.back();
+        mFree.pop_back();
+        return frame;
+    }
+
+    if (mPending.empty())
+        return nullptr;
+
+    // The sender is behind, drop the oldest frame in favour of the new one
+    uint8_t *frame = mPending.front();
+    mPending.pop_front();
+    mDepth = mPending.size();
+    ++mDropped;
+    return frame;
+}
+
+void ASIFrameRing::commit(uint8_t *frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.push_back(frame);
+        mDepth = mPending.size();
+        ++mCommitted;
+    }
+    mReady.notify_one();
+}
+
+void ASIFrameRing::discard(uint8_t *frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFree.push_back(frame);
+    }
+    mReleased.notify_all();
+}
+
+uint8_t *ASIFrameRing::wait()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    mReady.wait(lock, [this] { return mClosed || !mPending.empty(); });
+
+    if (mClosed || mPending.empty())
+        return nullptr;
+
+    uint8_t *frame = mPending.front();
+    mPending.pop_front();
+    mDepth = mPending.size();
+    return frame;
+}
+
+void ASIFrameRing::release(uint8_t *frame)
+{
+    discard(frame);
+}
+
+void ASIFrameRing::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mClosed = true;
+    }
+    mReady.notify_all();
+}
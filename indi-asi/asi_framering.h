@@ -0,0 +1,107 @@
+/*
+    ASI CCD Driver
+
+    Pool of preallocated video frames between the SDK reader and the streamer.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Pool of preallocated video frames passed from the SDK reader to the streamer.
+ *
+ * The reader acquires a free frame, fills it and commits it. The sender waits for a
+ * committed frame, hands it to the streamer and releases it. If the sender falls behind,
+ * the oldest committed frame is recycled and counted as dropped, so the reader never waits.
+ */
+class ASIFrameRing
+{
+    public:
+        ASIFrameRing() = default;
+        ~ASIFrameRing();
+
+        ASIFrameRing(const ASIFrameRing &) = delete;
+        ASIFrameRing &operator=(const ASIFrameRing &) = delete;
+
+    public:
+        /** Allocate @a count frames of @a size bytes, waits until no frame is in use */
+        bool allocate(size_t count, size_t size);
+
+        /** Release all frames */
+        void free();
+
+        size_t frameSize() const
+        {
+            return mFrameSize;
+        }
+
+    public:
+        /** Reader: get an empty frame, recycles the oldest pending frame if none is free */
+        uint8_t *acquire();
+
+        /** Reader: give the filled frame to the sender */
+        void commit(uint8_t *frame);
+
+        /** Reader: return an unused frame without committing it */
+        void discard(uint8_t *frame);
+
+        /** Sender: wait for a filled frame, nullptr once the ring is closed */
+        uint8_t *wait();
+
+        /** Sender: the frame can be reused */
+        void release(uint8_t *frame);
+
+        /** Wake up the sender and make wait() return nullptr */
+        void close();
+
+    public:
+        uint64_t framesCommitted() const
+        {
+            return mCommitted;
+        }
+        uint64_t framesDropped() const
+        {
+            return mDropped;
+        }
+        size_t queueDepth() const
+        {
+            return mDepth;
+        }
+
+    private:
+        uint8_t *mMemory {nullptr};
+        size_t mFrameSize {0};
+        size_t mFrameCount {0};
+
+        std::vector<uint8_t *> mFree;
+        std::deque<uint8_t *> mPending;
+        bool mClosed {false};
+
+        std::mutex mMutex;
+        std::condition_variable mReady;
+        std::condition_variable mReleased;
+
+        std::atomic<uint64_t> mCommitted {0};
+        std::atomic<uint64_t> mDropped {0};
+        std::atomic<size_t> mDepth {0};
+};
@@ -0,0 +1,180 @@
+/*
+    Celestron AUX bus reader
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "auxbus.h"
+
+#include <indilogger.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+// ms, how often the reader looks at the stop flag
+#define POLL_PERIOD 100
+
+AUXBus::AUXBus()
+{
+}
+
+AUXBus::~AUXBus()
+{
+    Stop();
+}
+
+bool AUXBus::Start(int portfd, Handler h)
+{
+    Stop();
+    if (portfd < 0)
+        return false;
+
+    fd      = portfd;
+    handler = h;
+    framer.reset();
+    stop    = false;
+    running = true;
+    thread  = std::thread(&AUXBus::run, this);
+    return true;
+}
+
+void AUXBus::Stop()
+{
+    stop = true;
+    if (thread.joinable())
+        thread.join();
+    running = false;
+
+    // Waiters get a broken promise
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+}
+
+AUXBus::Ticket AUXBus::expect(const AUXCommand &request)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // The reply comes from the destination of the request, to its source
+    pending.emplace_back();
+    Pending &p = pending.back();
+    p.id  = nextid++;
+    p.src = request.dst;
+    p.dst = request.src;
+    p.cmd = request.cmd;
+
+    Ticket ticket;
+    ticket.id    = p.id;
+    ticket.reply = p.reply.get_future();
+    if (!running)
+        pending.pop_back();
+    return ticket;
+}
+
+void AUXBus::cancel(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.remove_if([id](const Pending & p)
+    {
+        return p.id == id;
+    });
+}
+
+AUXBus::Stats AUXBus::getStats() const
+{
+    Stats stats;
+    stats.packets         = packets;
+    stats.checksum_errors = checksum_errors;
+    stats.dropped_bytes   = dropped_bytes;
+    stats.replies         = replies;
+    stats.unsolicited     = unsolicited;
+    stats.echoes          = echoes;
+    return stats;
+}
+
+// Matched on the view, an AUXCommand is only made for whoever takes the packet
+void AUXBus::dispatch(const AUXPacket &packet)
+{
+    packets++;
+    if (packet.src() == APP)
+    {
+        echoes++;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = pending.begin(); it != pending.end(); ++it)
+        {
+            if (it->src == packet.src() && it->dst == packet.dst() && it->cmd == packet.cmd())
+            {
+                it->reply.set_value(AUXCommand(packet));
+                pending.erase(it);
+                replies++;
+                return;
+            }
+        }
+    }
+
+    unsolicited++;
+    if (handler)
+    {
+        AUXCommand m(packet);
+        handler(m);
+    }
+}
+
+void AUXBus::run()
+{
+    while (!stop)
+    {
+        struct pollfd pfd;
+        pfd.fd     = fd;
+        pfd.events = POLLIN;
+        int rc     = poll(&pfd, 1, POLL_PERIOD);
+        if (rc < 0 && errno != EINTR)
+            break;
+        if (rc <= 0)
+            continue;
+
+        // Straight into the framer, the packets are taken from there in place
+        ssize_t n = read(fd, framer.space(), framer.spaceSize());
+        if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN))
+        {
+            DEBUGFDEVICE(AUXCommand::DEVICE_NAME, AUXCommand::DEBUG_LEVEL, "AUX bus reader stopped: %s",
+                         n == 0 ? "end of stream" : strerror(errno));
+            break;
+        }
+        if (n < 0)
+            continue;
+        framer.commit(n);
+
+        AUXPacket packet;
+        unsigned long errors = framer.getStats().checksum_errors;
+        while (framer.next(packet))
+            dispatch(packet);
+        if (framer.getStats().checksum_errors != errors)
+            DEBUGFDEVICE(AUXCommand::DEVICE_NAME, AUXCommand::DEBUG_LEVEL, "AUX bus: %lu checksum errors, resynced",
+                         framer.getStats().checksum_errors - errors);
+        checksum_errors = framer.getStats().checksum_errors;
+        dropped_bytes   = framer.getStats().dropped_bytes;
+    }
+
+    running = false;
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+}
@@ -0,0 +1,107 @@
+/*
+    Celestron AUX bus reader
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "auxproto.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <thread>
+
+/*
+ * Reader side of the AUX bus.
+ *
+ * A thread reads the port, frames the 0x3b packets and hands each one over: the reply to a
+ * pending request (from its destination, to its source, same command) completes the future
+ * of that request, anything else (hand controller traffic, GPS requests, late replies) goes
+ * to the packet handler, in the reader thread. Several requests may be pending at once, to
+ * different devices or to the same one: replies of one device come in the order of the
+ * requests. Our own packets echoed by the bus are dropped.
+ *
+ * Writing stays with the caller, register the request with expect() before sending it.
+ */
+class AUXBus
+{
+    public:
+        typedef std::function<void(AUXCommand &)> Handler;
+
+        typedef struct Ticket
+        {
+            uint64_t id;
+            std::future<AUXCommand> reply;
+        } Ticket;
+
+        typedef struct Stats
+        {
+            unsigned long packets;
+            unsigned long replies;
+            unsigned long unsolicited;
+            unsigned long echoes;
+            unsigned long checksum_errors;
+            unsigned long dropped_bytes;
+        } Stats;
+
+        AUXBus();
+        ~AUXBus();
+
+        /* Read fd in a thread of its own until Stop(), the end of the stream or an error */
+        bool Start(int fd, Handler handler);
+        void Stop();
+        bool isRunning() const
+        {
+            return running;
+        }
+
+        /* The reply to request completes the future. A request given up must be cancelled,
+           its reply would otherwise be taken for the reply to the next same request. */
+        Ticket expect(const AUXCommand &request);
+        void cancel(uint64_t id);
+
+        Stats getStats() const;
+
+    private:
+        typedef struct Pending
+        {
+            uint64_t id;
+            AUXTargets src, dst;
+            AUXCommands cmd;
+            std::promise<AUXCommand> reply;
+        } Pending;
+
+        void run();
+        void dispatch(const AUXPacket &packet);
+
+        int fd {-1};
+        Handler handler;
+        std::thread thread;
+        std::atomic<bool> stop {false};
+        std::atomic<bool> running {false};
+        AUXFramer framer;
+
+        std::mutex mutex;
+        std::list<Pending> pending;
+        uint64_t nextid {1};
+
+        std::atomic<unsigned long> packets {0}, replies {0}, unsolicited {0}, echoes {0}, checksum_errors {0},
+            dropped_bytes {0};
+};
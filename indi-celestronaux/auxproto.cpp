@@ -24,6 +24,7 @@
 #include "auxproto.h"
 
 #include <indilogger.h>
+#include <algorithm>
 #include <math.h>
 #include <string.h>
 #include <unistd.h>
@@ -38,19 +39,33 @@ int MAX_CMD_LEN = 32;
 
 uint8_t AUXCommand::DEBUG_LEVEL = 0;
 char AUXCommand::DEVICE_NAME[64] = {0};
+std::atomic<bool> AUXCommand::DEBUG_ENABLED {false};
 //////////////////////////////////////////////////
 /////// Utility functions
 //////////////////////////////////////////////////
 
+// "3B 03 20 10 01 CC", cut short to what fits
+static void hexDump(char *out, size_t size, const unsigned char *buf, size_t n)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    size_t o = 0;
+
+    for (size_t i = 0; i < n && o + 3 < size; i++)
+    {
+        out[o++] = digits[buf[i] >> 4];
+        out[o++] = digits[buf[i] & 0x0f];
+        out[o++] = ' ';
+    }
+    out[o > 0 ? o - 1 : 0] = '\0';
+}
 
 void logBytes(unsigned char *buf, int n, const char *deviceName, uint32_t debugLevel)
 {
-    char hex_buffer[BUFFER_SIZE] = {0};
-    for (int i = 0; i < n; i++)
-        sprintf(hex_buffer + 3 * i, "%02X ", buf[i]);
+    if (!AUXCommand::isDebugEnabled())
+        return;
 
-    if (n > 0)
-        hex_buffer[3 * n - 1] = '\0';
+    char hex_buffer[3 * AUX_MAX_PACKET];
+    hexDump(hex_buffer, sizeof(hex_buffer), buf, n);
 
     DEBUGFDEVICE(deviceName, debugLevel, "[%s]", hex_buffer);
 }
@@ -81,12 +96,11 @@ void logBytes(unsigned char *buf, int n, const char *deviceName, uint32_t debugL
 
 void AUXCommand::logResponse()
 {
-    char hex_buffer[BUFFER_SIZE] = {0}, part1[BUFFER_SIZE] = {0}, part2[BUFFER_SIZE] = {0}, part3[BUFFER_SIZE] = {0};
-    for (size_t i = 0; i < data.size(); i++)
-        sprintf(hex_buffer + 3 * i, "%02X ", data[i]);
+    if (!DEBUG_ENABLED)
+        return;
 
-    if (data.size() > 0)
-        hex_buffer[3 * data.size() - 1] = '\0';
+    char hex_buffer[3 * AUX_MAX_PACKET], part1[BUFFER_SIZE] = {0}, part2[BUFFER_SIZE] = {0}, part3[BUFFER_SIZE] = {0};
+    hexDump(hex_buffer, sizeof(hex_buffer), data.data(), data.size());
 
     const char * c = cmd_name(cmd);
     const char * s = node_name(src);
@@ -115,12 +129,11 @@ void AUXCommand::logResponse()
 
 void AUXCommand::logCommand()
 {
-    char hex_buffer[BUFFER_SIZE] = {0}, part1[BUFFER_SIZE] = {0}, part2[BUFFER_SIZE] = {0}, part3[BUFFER_SIZE] = {0};
-    for (size_t i = 0; i < data.size(); i++)
-        sprintf(hex_buffer + 3 * i, "%02X ", data[i]);
+    if (!DEBUG_ENABLED)
+        return;
 
-    if (data.size() > 0)
-        hex_buffer[3 * data.size() - 1] = '\0';
+    char hex_buffer[3 * AUX_MAX_PACKET], part1[BUFFER_SIZE] = {0}, part2[BUFFER_SIZE] = {0}, part3[BUFFER_SIZE] = {0};
+    hexDump(hex_buffer, sizeof(hex_buffer), data.data(), data.size());
 
     const char * c = cmd_name(cmd);
     const char * s = node_name(src);
@@ -152,6 +165,11 @@ void AUXCommand::setDebugInfo(const char *deviceName, uint8_t debugLevel)
     strncpy(DEVICE_NAME, deviceName, 64);
     DEBUG_LEVEL = debugLevel;
 }
+
+void AUXCommand::setDebugEnabled(bool enabled)
+{
+    DEBUG_ENABLED = enabled;
+}
 ////////////////////////////////////////////////
 //////  AUXCommand class
 ////////////////////////////////////////////////
@@ -167,6 +185,12 @@ AUXCommand::AUXCommand(const AUXBuffer &buf)
     parseBuf(buf);
 }
 
+AUXCommand::AUXCommand(const AUXPacket &packet)
+{
+    data.reserve(MAX_CMD_LEN);
+    parse(packet);
+}
+
 AUXCommand::AUXCommand(AUXCommands c, AUXTargets s, AUXTargets d, const AUXBuffer &dat)
 {
     cmd = c;
@@ -354,13 +378,13 @@ void AUXCommand::fillBuf(AUXBuffer &buf)
     buf.back() = checksum(buf);
 }
 
-void AUXCommand::parseBuf(AUXBuffer buf)
+void AUXCommand::parseBuf(const AUXBuffer &buf)
 {
     len   = buf[1];
     src   = (AUXTargets)buf[2];
     dst   = (AUXTargets)buf[3];
     cmd   = (AUXCommands)buf[4];
-    data  = AUXBuffer(buf.begin() + 5, buf.end() - 1);
+    data.assign(buf.begin() + 5, buf.end() - 1);
     valid = (checksum(buf) == buf.back());
     if (valid == false)
     {
@@ -370,7 +394,7 @@ void AUXCommand::parseBuf(AUXBuffer buf)
     };
 }
 
-void AUXCommand::parseBuf(AUXBuffer buf, bool do_checksum)
+void AUXCommand::parseBuf(const AUXBuffer &buf, bool do_checksum)
 {
     (void)do_checksum;
 
@@ -379,11 +403,25 @@ void AUXCommand::parseBuf(AUXBuffer buf, bool do_checksum)
     dst   = (AUXTargets)buf[3];
     cmd   = (AUXCommands)buf[4];
     if (buf.size() > 5)
-        data  = AUXBuffer(buf.begin() + 5, buf.end());
+        data.assign(buf.begin() + 5, buf.end());
 }
 
+void AUXCommand::parse(const AUXPacket &packet)
+{
+    len   = packet.size() - 3;
+    src   = packet.src();
+    dst   = packet.dst();
+    cmd   = packet.cmd();
+    data.assign(packet.data(), packet.data() + packet.dataSize());
+    valid = true;
+}
 
-unsigned char AUXCommand::checksum(AUXBuffer buf)
+unsigned char AUXCommand::checksum(const AUXBuffer &buf)
+{
+    return checksum(buf.data());
+}
+
+unsigned char AUXCommand::checksum(const unsigned char *buf)
 {
     int l  = buf[1];
     int cs = 0;
@@ -396,6 +434,95 @@ unsigned char AUXCommand::checksum(AUXBuffer buf)
     //return ((~sum([ord(c) for c in msg]) + 1) ) & 0xFF
 }
 
+////////////////////////////////////////////////
+//////  AUXFramer class
+////////////////////////////////////////////////
+
+AUXFramer::AUXFramer()
+{
+    reset();
+}
+
+void AUXFramer::reset()
+{
+    head = tail = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+unsigned char *AUXFramer::space()
+{
+    // Only the start of a packet is ever moved, and only when the end of the buffer is near
+    if (head == tail)
+        head = tail = 0;
+    else if (sizeof(buf) - tail < AUX_MAX_PACKET)
+    {
+        memmove(buf, buf + head, tail - head);
+        tail -= head;
+        head = 0;
+    }
+    return buf + tail;
+}
+
+void AUXFramer::commit(size_t n)
+{
+    tail += n;
+}
+
+size_t AUXFramer::feed(const unsigned char *bytes, size_t n)
+{
+    unsigned char *p = space();
+    n = std::min(n, spaceSize());
+    memcpy(p, bytes, n);
+    commit(n);
+    return n;
+}
+
+bool AUXFramer::next(AUXPacket &packet)
+{
+    while (true)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(memchr(buf + head, 0x3b, tail - head));
+        if (p == nullptr)
+        {
+            stats.dropped_bytes += tail - head;
+            head = tail;
+            return false;
+        }
+        stats.dropped_bytes += (p - buf) - head;
+        head = p - buf;
+
+        if (tail - head < 2)
+            return false;
+        if (p[1] < 3)
+        {
+            // Not a packet, look for the next preamble
+            head++;
+            stats.dropped_bytes++;
+            continue;
+        }
+        size_t size = p[1] + 3;
+        if (tail - head < size)
+            return false;
+
+        // The sum of everything but the preamble, checksum included, is 0
+        unsigned char sum = 0;
+        for (size_t i = 1; i < size; i++)
+            sum += p[i];
+        if (sum != 0)
+        {
+            stats.checksum_errors++;
+            stats.dropped_bytes++;
+            head++;
+            continue;
+        }
+
+        packet = AUXPacket(p);
+        head += size;
+        stats.packets++;
+        return true;
+    }
+}
+
 // One definition rule (ODR) constants
 // AUX commands use 24bit integer as a representation of angle in units of
 // fractional revolutions. Thus 2^24 steps makes full revolution.
@@ -23,7 +23,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef std::vector<unsigned char> AUXBuffer;
@@ -79,13 +81,109 @@ enum AUXTargets
 #define CAUX_DEFAULT_IP   "1.2.3.4"
 #define CAUX_DEFAULT_PORT 2000
 
+// 0x3b, length, source, destination, command, up to 252 data bytes, checksum
+#define AUX_MAX_PACKET 258
+
 void logBytes(unsigned char *buf, int n, const char *deviceName, uint32_t debugLevel);
 
+/*
+ * A packet where it was received, nothing copied: 0x3b <len> <src> <dst> <cmd> <len-3 bytes> <checksum>.
+ * Only valid as long as the bytes it points to.
+ */
+class AUXPacket
+{
+    public:
+        AUXPacket() {}
+        explicit AUXPacket(const unsigned char *b) : buf(b) {}
+
+        const unsigned char *bytes() const
+        {
+            return buf;
+        }
+        // Whole packet, preamble to checksum
+        int size() const
+        {
+            return buf[1] + 3;
+        }
+        AUXTargets src() const
+        {
+            return static_cast<AUXTargets>(buf[2]);
+        }
+        AUXTargets dst() const
+        {
+            return static_cast<AUXTargets>(buf[3]);
+        }
+        AUXCommands cmd() const
+        {
+            return static_cast<AUXCommands>(buf[4]);
+        }
+        const unsigned char *data() const
+        {
+            return buf + 5;
+        }
+        int dataSize() const
+        {
+            return buf[1] - 3;
+        }
+        unsigned char checksum() const
+        {
+            return buf[buf[1] + 2];
+        }
+
+    private:
+        const unsigned char *buf {nullptr};
+};
+
+/*
+ * Incremental framing of the received bytes, in a fixed buffer.
+ *
+ * Read into space() and commit() what was read, or feed() bytes from elsewhere, then take the
+ * packets with next() until it returns false. Lengths and checksums are checked in place, on a
+ * bad one the framer looks for the next preamble. Packets returned by next() point into the
+ * buffer: they stay valid until the next space() or feed().
+ */
+class AUXFramer
+{
+    public:
+        typedef struct Stats
+        {
+            unsigned long packets;
+            unsigned long checksum_errors;
+            unsigned long dropped_bytes;
+        } Stats;
+
+        AUXFramer();
+
+        // Room for at least one whole packet
+        unsigned char *space();
+        size_t spaceSize() const
+        {
+            return sizeof(buf) - tail;
+        }
+        void commit(size_t n);
+        // Copy in as much as fits, returns how much that was
+        size_t feed(const unsigned char *bytes, size_t n);
+
+        bool next(AUXPacket &packet);
+        void reset();
+
+        const Stats &getStats() const
+        {
+            return stats;
+        }
+
+    private:
+        unsigned char buf[4 * AUX_MAX_PACKET];
+        size_t head {0}, tail {0};
+        Stats stats;
+};
+
 class AUXCommand
 {
     public:
         AUXCommand();
         AUXCommand(const AUXBuffer &buf);
+        explicit AUXCommand(const AUXPacket &packet);
         AUXCommand(AUXCommands c, AUXTargets s, AUXTargets d, const AUXBuffer &dat);
         AUXCommand(AUXCommands c, AUXTargets s, AUXTargets d);
 
@@ -93,8 +191,10 @@ class AUXCommand
         /// Buffer Management
         ///////////////////////////////////////////////////////////////////////////////
         void fillBuf(AUXBuffer &buf);
-        void parseBuf(AUXBuffer buf);
-        void parseBuf(AUXBuffer buf, bool do_checksum);
+        void parseBuf(const AUXBuffer &buf);
+        void parseBuf(const AUXBuffer &buf, bool do_checksum);
+        // Copies the data bytes only, the packet is assumed checked
+        void parse(const AUXPacket &packet);
 
         ///////////////////////////////////////////////////////////////////////////////
         /// Position
@@ -111,7 +211,9 @@ class AUXCommand
         ///////////////////////////////////////////////////////////////////////////////
         /// Check sum
         ///////////////////////////////////////////////////////////////////////////////
-        unsigned char checksum(AUXBuffer buf);
+        unsigned char checksum(const AUXBuffer &buf);
+        // Of the packet starting at buf, whatever its checksum byte says
+        static unsigned char checksum(const unsigned char *buf);
 
         ///////////////////////////////////////////////////////////////////////////////
         /// Logging
@@ -124,6 +226,12 @@ class AUXCommand
         void logCommand();
         //void logResponse(AUXBuffer buf);
         static void setDebugInfo(const char *deviceName, uint8_t debugLevel);
+        // Packet dumps are only formatted with debug on
+        static void setDebugEnabled(bool enabled);
+        static bool isDebugEnabled()
+        {
+            return DEBUG_ENABLED;
+        }
 
         // TODO these should be private
         AUXCommands cmd;
@@ -132,6 +240,7 @@ class AUXCommand
 
         static uint8_t DEBUG_LEVEL;
         static char DEVICE_NAME[64];
+        static std::atomic<bool> DEBUG_ENABLED;
 
     private:
         int len {0};
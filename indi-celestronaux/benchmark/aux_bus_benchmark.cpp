@@ -0,0 +1,229 @@
+/*
+    Celestron AUX bus benchmark
+
+    Runs the bus reader against the simulated mount over a socketpair, no mount needed.
+
+    Throughput: position requests to both motor controllers, one at a time as the driver
+    did before the bus reader, and then several in flight. With the mount standing still
+    every reply must carry the position of the axis it was asked of, a reply matched to
+    the wrong request fails the run.
+
+    Tracking loop: every tick, like TimerHit(), the positions of both axes and the guide
+    rates for both, in one batch. Reports how long a tick takes on the bus and how late
+    the ticks start, with the hand controller talking and the losses asked for.
+
+    Usage: aux_bus_benchmark [-t seconds] [-w window] [-p tick ms] [-T timeout ms] [-b baud]
+                             [-l latency us] [-j jitter us] [-d drop ratio] [-c corrupt ratio]
+                             [-H hc poll ms] [-s seed]
+*/
+
+#include "auxbus.h"
+#include "simulator/aux-simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int32_t ALT_STEPS = 0x123456;
+static const int32_t AZM_STEPS = 0x654321;
+
+typedef struct Batch
+{
+    int answered;
+    int lost;
+    int crossed;    // replies with the position of the other axis
+} Batch;
+
+static bool send(int fd, AUXCommand cmd)
+{
+    AUXBuffer b;
+    cmd.fillBuf(b);
+    return write(fd, b.data(), b.size()) == static_cast<ssize_t>(b.size());
+}
+
+/* All in flight at once, as CelestronAUX::transactAUX() does */
+static Batch transact(AUXBus &bus, int fd, const std::vector<AUXCommand> &cmds, int timeout_ms, bool check)
+{
+    Batch batch = { 0, 0, 0 };
+    std::vector<AUXBus::Ticket> tickets;
+
+    for (const AUXCommand &c : cmds)
+    {
+        tickets.push_back(bus.expect(c));
+        send(fd, c);
+    }
+
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (size_t i = 0; i < tickets.size(); i++)
+    {
+        if (tickets[i].reply.wait_until(deadline) != std::future_status::ready)
+        {
+            bus.cancel(tickets[i].id);
+            batch.lost++;
+            continue;
+        }
+        AUXCommand reply = tickets[i].reply.get();
+        batch.answered++;
+        if (check && reply.cmd == MC_GET_POSITION &&
+                reply.getPosition() != (cmds[i].dst == ALT ? ALT_STEPS : AZM_STEPS))
+            batch.crossed++;
+    }
+    return batch;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, static_cast<size_t>(p * v.size()))];
+}
+
+int main(int argc, char *argv[])
+{
+    AUXSimulator::Options options = AUXSimulator::DefaultOptions();
+    double seconds = 3;
+    int window = 8, tick_ms = 100, timeout_ms = 1000, opt;
+
+    options.hc_poll_ms = 100;
+    while ((opt = getopt(argc, argv, "t:w:p:T:b:l:j:d:c:H:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't':
+                seconds = atof(optarg);
+                break;
+            case 'w':
+                window = std::max(1, atoi(optarg));
+                break;
+            case 'p':
+                tick_ms = std::max(1, atoi(optarg));
+                break;
+            case 'T':
+                timeout_ms = std::max(1, atoi(optarg));
+                break;
+            case 'b':
+                options.baud = strtoul(optarg, nullptr, 0);
+                break;
+            case 'l':
+                options.latency_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'j':
+                options.jitter_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'd':
+                options.drop = atof(optarg);
+                break;
+            case 'c':
+                options.corrupt = atof(optarg);
+                break;
+            case 'H':
+                options.hc_poll_ms = strtoul(optarg, nullptr, 0);
+                break;
+            case 's':
+                options.seed = strtoul(optarg, nullptr, 0);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-t seconds] [-w window] [-p tick ms] [-T timeout ms] [-b baud] [-l latency us] "
+                        "[-j jitter us] [-d drop ratio] [-c corrupt ratio] [-H hc poll ms] [-s seed]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    AUXSimulator sim(options);
+    int fd = sim.OpenSocketPair();
+    if (fd < 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+    sim.setPosition(ALT, ALT_STEPS);
+    sim.setPosition(AZM, AZM_STEPS);
+    sim.Start();
+
+    AUXBus bus;
+    std::atomic<unsigned long> unsolicited {0};
+    bus.Start(fd, [&unsolicited](AUXCommand &)
+    {
+        unsolicited++;
+    });
+
+    printf("%u baud, latency %u us, jitter %u us, %.1f%% lost, %.1f%% corrupted, hand controller polls every %u ms\n",
+           options.baud, options.latency_us, options.jitter_us, options.drop * 100.0, options.corrupt * 100.0,
+           options.hc_poll_ms);
+
+    int crossed = 0;
+    int windows[2] = { 1, window };
+    for (int w : windows)
+    {
+        std::vector<AUXCommand> cmds;
+        for (int i = 0; i < w; i++)
+            cmds.emplace_back(MC_GET_POSITION, APP, i % 2 ? AZM : ALT);
+
+        unsigned long answered = 0, lost = 0;
+        Clock::time_point start = Clock::now(), end = start + std::chrono::duration_cast<Clock::duration>
+                                  (std::chrono::duration<double>(seconds));
+        while (Clock::now() < end)
+        {
+            Batch batch = transact(bus, fd, cmds, timeout_ms, true);
+            answered += batch.answered;
+            lost     += batch.lost;
+            crossed  += batch.crossed;
+        }
+        double t = std::chrono::duration<double>(Clock::now() - start).count();
+        printf("%2d in flight: %8.1f commands/s, %lu answered, %lu lost\n", w, answered / t, answered, lost);
+    }
+
+    // Tracking, the mount moves from here on
+    std::vector<AUXCommand> tickcmds;
+    tickcmds.emplace_back(MC_GET_POSITION, APP, ALT);
+    tickcmds.emplace_back(MC_GET_POSITION, APP, AZM);
+    tickcmds.emplace_back(MC_SET_POS_GUIDERATE, APP, ALT);
+    tickcmds.emplace_back(MC_SET_POS_GUIDERATE, APP, AZM);
+    tickcmds[2].setPosition(static_cast<int32_t>(15000));
+    tickcmds[3].setPosition(static_cast<int32_t>(15000));
+
+    std::vector<double> cycle, late;
+    unsigned long lost = 0;
+    Clock::time_point start = Clock::now(), due = start;
+    while (due - start < std::chrono::duration<double>(seconds))
+    {
+        std::this_thread::sleep_until(due);
+        Clock::time_point begin = Clock::now();
+        Batch batch = transact(bus, fd, tickcmds, timeout_ms, false);
+        lost += batch.lost;
+        cycle.push_back(std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+        late.push_back(std::chrono::duration<double, std::milli>(begin - due).count());
+        // Like the INDI timer: the next tick after this one is done
+        due = std::max(due + std::chrono::milliseconds(tick_ms), Clock::now());
+    }
+    printf("tracking, %d ms ticks: %zu ticks, %lu commands lost\n", tick_ms, cycle.size(), lost);
+    printf("  tick on the bus  p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms\n", percentile(cycle, 0.5),
+           percentile(cycle, 0.99), percentile(cycle, 1.0));
+    printf("  tick start late  p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms\n", percentile(late, 0.5),
+           percentile(late, 0.99), percentile(late, 1.0));
+
+    bus.Stop();
+    sim.Stop();
+    close(fd);
+
+    AUXBus::Stats bs = bus.getStats();
+    AUXSimulator::Stats ss = sim.getStats();
+    printf("bus: %lu packets, %lu replies, %lu unsolicited, %lu echoes, %lu checksum errors\n", bs.packets, bs.replies,
+           bs.unsolicited, bs.echoes, bs.checksum_errors);
+    printf("simulator: %lu requests, %lu hand controller packets, %lu lost, %lu corrupted\n", ss.requests,
+           ss.hc_packets, ss.dropped, ss.corrupted);
+
+    if (crossed > 0)
+    {
+        fprintf(stderr, "%d replies matched to the wrong request\n", crossed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,279 @@
+/*
+    Celestron AUX parse benchmark
+
+    Frames and parses a stream of AUX bus traffic the way the driver did before, a vector
+    copy per packet, per checksum and a hex dump of each, and with AUXFramer, in place.
+    The stream is handed over in chunks the size of a serial read.
+
+    The traffic is a raw capture of what the mount sends, for instance recorded with
+        socat -r aux.bin TCP-LISTEN:2000,reuseaddr TCP:<mount>:2000
+    or, without one, a synthetic slew: position and slew done polls of both axes with their
+    echoes, hand controller moves, GPS requests, and some line noise and corrupted packets.
+
+    Usage: aux_parse_benchmark [-r repeat] [-c chunk bytes] [-n synthetic ticks] [capture files...]
+*/
+
+#include "auxproto.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+typedef struct Result
+{
+    unsigned long packets;
+    unsigned long errors;
+    unsigned long sum;      // of the parsed fields, keeps the work from being optimized away
+} Result;
+
+static void append(AUXBuffer &stream, AUXCommand cmd)
+{
+    AUXBuffer b;
+    cmd.fillBuf(b);
+    stream.insert(stream.end(), b.begin(), b.end());
+}
+
+static AUXBuffer synthetic(int ticks, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> byte(0, 255), percent(0, 99);
+    AUXBuffer stream;
+
+    for (int t = 0; t < ticks; t++)
+    {
+        AUXTargets axes[2] = { ALT, AZM };
+        for (AUXTargets axis : axes)
+        {
+            // The AUX and PC ports echo what we send
+            append(stream, AUXCommand(MC_GET_POSITION, APP, axis));
+            AUXCommand position(MC_GET_POSITION, axis, APP);
+            position.setPosition(static_cast<int32_t>(byte(gen) << 16 | byte(gen) << 8 | byte(gen)));
+            append(stream, position);
+            append(stream, AUXCommand(MC_SLEW_DONE, APP, axis));
+            append(stream, AUXCommand(MC_SLEW_DONE, axis, APP, AUXBuffer(1, 0x00)));
+        }
+        if (percent(gen) < 20)
+        {
+            AUXCommand move(MC_MOVE_POS, HC, AZM);
+            move.setRate(static_cast<unsigned char>(byte(gen) % 10));
+            append(stream, move);
+            append(stream, AUXCommand(MC_MOVE_POS, AZM, HC));
+        }
+        if (percent(gen) < 5)
+            append(stream, AUXCommand(GPS_GET_TIME, HC, GPS));
+        if (percent(gen) < 2)
+        {
+            // Line noise, and a packet with a byte lost
+            stream.push_back(static_cast<unsigned char>(byte(gen)));
+            AUXBuffer b;
+            AUXCommand(MC_GET_POSITION, AZM, APP, AUXBuffer(3, 0x42)).fillBuf(b);
+            b.erase(b.begin() + 6);
+            stream.insert(stream.end(), b.begin(), b.end());
+        }
+    }
+    return stream;
+}
+
+static bool load(const char *path, AUXBuffer &stream)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+        return false;
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        stream.insert(stream.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+/* The parse as it was: everything by value */
+static unsigned char legacyChecksum(AUXBuffer buf)
+{
+    int l  = buf[1];
+    int cs = 0;
+    for (int i = 1; i < l + 2; i++)
+        cs += buf[i];
+    return (unsigned char)(((~cs) + 1) & 0xFF);
+}
+
+static void legacyParse(AUXCommand &m, AUXBuffer buf, bool &valid)
+{
+    m.src  = (AUXTargets)buf[2];
+    m.dst  = (AUXTargets)buf[3];
+    m.cmd  = (AUXCommands)buf[4];
+    m.data = AUXBuffer(buf.begin() + 5, buf.end() - 1);
+    valid  = (legacyChecksum(buf) == buf.back());
+}
+
+static void legacyHexDump(char *out, AUXBuffer data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        sprintf(out + 3 * i, "%02X ", data[i]);
+    if (size > 0)
+        out[3 * size - 1] = '\0';
+}
+
+/* Receive buffer, scan for the preamble, a vector per packet, parsed and dumped */
+static Result legacy(const AUXBuffer &stream, size_t chunk)
+{
+    Result r = { 0, 0, 0 };
+    AUXBuffer rx;
+    AUXCommand m;
+
+    for (size_t offset = 0; offset < stream.size(); offset += chunk)
+    {
+        rx.insert(rx.end(), stream.begin() + offset, stream.begin() + std::min(stream.size(), offset + chunk));
+
+        size_t i = 0;
+        while (i < rx.size())
+        {
+            if (rx[i] != 0x3b)
+            {
+                i++;
+                continue;
+            }
+            if (i + 1 >= rx.size())
+                break;
+            size_t end = i + rx[i + 1] + 3;
+            if (rx[i + 1] < 3 || end > rx.size())
+            {
+                if (rx[i + 1] < 3)
+                {
+                    i++;
+                    continue;
+                }
+                break;
+            }
+            AUXBuffer b(rx.begin() + i, rx.begin() + end);
+            bool valid;
+            legacyParse(m, b, valid);
+            char hexbuf[3 * AUX_MAX_PACKET + 1];
+            legacyHexDump(hexbuf, b, b.size());
+            if (!valid)
+            {
+                r.errors++;
+                i++;
+                continue;
+            }
+            r.packets++;
+            r.sum += m.src + m.dst + m.cmd + m.data.size() + hexbuf[0];
+            i = end;
+        }
+        rx.erase(rx.begin(), rx.begin() + i);
+    }
+    return r;
+}
+
+/* AUXFramer, packet views only or an AUXCommand for each, as the bus reader makes for replies */
+static Result framed(const AUXBuffer &stream, size_t chunk, bool commands)
+{
+    Result r = { 0, 0, 0 };
+    AUXFramer framer;
+    AUXCommand m;
+    AUXPacket packet;
+
+    for (size_t offset = 0; offset < stream.size();)
+    {
+        size_t n = std::min(chunk, stream.size() - offset);
+        offset += framer.feed(stream.data() + offset, n);
+        while (framer.next(packet))
+        {
+            if (commands)
+            {
+                m.parse(packet);
+                r.sum += m.src + m.dst + m.cmd + m.data.size();
+            }
+            else
+                r.sum += packet.src() + packet.dst() + packet.cmd() + packet.dataSize();
+            r.packets++;
+        }
+    }
+    r.errors = framer.getStats().checksum_errors;
+    return r;
+}
+
+template <typename F>
+static double timeit(int repeat, F f, Result &result)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++)
+        result = f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = 20, ticks = 20000, opt;
+    size_t chunk = 64;
+
+    while ((opt = getopt(argc, argv, "r:c:n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r':
+                repeat = atoi(optarg);
+                break;
+            case 'c':
+                chunk = std::max(1, atoi(optarg));
+                break;
+            case 'n':
+                ticks = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-r repeat] [-c chunk bytes] [-n synthetic ticks] [capture files...]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    AUXBuffer stream;
+    for (int i = optind; i < argc; i++)
+    {
+        if (!load(argv[i], stream))
+        {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+    if (optind == argc)
+        stream = synthetic(ticks, 1);
+    if (stream.empty())
+    {
+        fprintf(stderr, "No traffic\n");
+        return 1;
+    }
+
+    printf("%zu bytes of %s traffic, %zu byte reads, %d rounds\n", stream.size(),
+           optind == argc ? "synthetic" : "captured", chunk, repeat);
+
+    Result reference = { 0, 0, 0 }, result = { 0, 0, 0 };
+    double t = timeit(repeat, [&]()
+    {
+        return legacy(stream, chunk);
+    }, reference);
+    printf("%-24s %9lu packets %6lu bad %9.1f MB/s %12.0f packets/s\n", "vector copies", reference.packets,
+           reference.errors, repeat * stream.size() / t / 1e6, repeat * reference.packets / t);
+
+    bool ok = true;
+    for (int commands = 0; commands < 2; commands++)
+    {
+        t = timeit(repeat, [&]()
+        {
+            return framed(stream, chunk, commands);
+        }, result);
+        printf("%-24s %9lu packets %6lu bad %9.1f MB/s %12.0f packets/s\n",
+               commands ? "framer + AUXCommand" : "framer, views", result.packets, result.errors,
+               repeat * stream.size() / t / 1e6, repeat * result.packets / t);
+        ok = ok && result.packets == reference.packets;
+    }
+
+    if (!ok)
+    {
+        fprintf(stderr, "Packet counts differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -22,6 +22,7 @@
 */
 
 #include <algorithm>
+#include <chrono>
 #include <math.h>
 #include <queue>
 #include <string.h>
@@ -105,6 +106,8 @@ CelestronAUX::CelestronAUX()
 /////////////////////////////////////////////////////////////////////////////////////
 CelestronAUX::~CelestronAUX()
 {
+    // The handler calls into this object
+    m_Bus.Stop();
 }
 
 
@@ -120,10 +123,7 @@ bool CelestronAUX::Abort()
     b[0] = 0;
     AUXCommand stopAlt(MC_MOVE_POS, APP, ALT, b);
     AUXCommand stopAz(MC_MOVE_POS, APP, AZM, b);
-    sendAUXCommand(stopAlt);
-    readAUXResponse(stopAlt);
-    sendAUXCommand(stopAz);
-    readAUXResponse(stopAz);
+    transactAUX({stopAlt, stopAz});
 
     LOG_INFO("Telescope motion aborted.");
     return true;
@@ -265,9 +265,14 @@ bool CelestronAUX::Handshake()
         {
             LOG_INFO("Waiting for mount connection to settle...");
             msleep(1000);
+            startBusReader();
             return true;
         }
 
+        // Everything but the HC serial port talks AUX packets
+        if (isRTSCTS || !isHC)
+            startBusReader();
+
         // read firmware version, if read ok, detected scope
         LOG_DEBUG("Communicating with mount motor controllers...");
         if (getVersion(AZM) && getVersion(ALT))
@@ -315,6 +320,8 @@ bool CelestronAUX::Handshake()
 bool CelestronAUX::Disconnect()
 {
     Abort();
+    m_Bus.Stop();
+    m_BusPackets.clear();
     return INDI::Telescope::Disconnect();
 }
 
@@ -1230,11 +1237,22 @@ bool CelestronAUX::Sync(double ra, double dec)
     return false;
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void CelestronAUX::debugTriggered(bool enable)
+{
+    AUXCommand::setDebugEnabled(enable);
+}
+
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
 void CelestronAUX::TimerHit()
 {
+    // Whatever the bus said since the last tick: hand controller, guiding, late replies
+    processBusPackets();
+
     TraceThisTickCount++;
     if (60 == TraceThisTickCount)
     {
@@ -1408,6 +1426,12 @@ bool CelestronAUX::updateLocation(double latitude, double longitude, double elev
     // Update INDI Alignment Subsystem Location
     UpdateLocation(latitude, longitude, elevation);
 
+    {
+        std::lock_guard<std::mutex> lock(m_GPSLocationMutex);
+        m_GPSLatitude  = latitude;
+        m_GPSLongitude = longitude;
+    }
+
     // check for site non null latitude/longitude
     if (!latitude)
         LOG_ERROR("Missing latitude (INDI panel > Celestron AUX > Site Management)");
@@ -1482,8 +1506,7 @@ bool CelestronAUX::Slew(AUXTargets trg, int rate)
     AUXCommand cmd((rate < 0) ? MC_MOVE_NEG : MC_MOVE_POS, APP, trg);
     cmd.setRate((unsigned char)(std::abs(rate) & 0xFF));
 
-    sendAUXCommand(cmd);
-    readAUXResponse(cmd);
+    transactAUX(cmd);
     return true;
 }
 
@@ -1519,10 +1542,7 @@ bool CelestronAUX::GoToFast(int32_t alt, int32_t az, bool track)
     AUXCommand azmcmd(MC_GOTO_FAST, APP, AZM);
     altcmd.setPosition(alt);
     azmcmd.setPosition(az);
-    sendAUXCommand(altcmd);
-    readAUXResponse(altcmd);
-    sendAUXCommand(azmcmd);
-    readAUXResponse(azmcmd);
+    transactAUX({altcmd, azmcmd});
     //DEBUG=false;
     return true;
 };
@@ -1541,10 +1561,7 @@ bool CelestronAUX::GoToSlow(int32_t alt, int32_t az, bool track)
     AUXCommand azmcmd(MC_GOTO_SLOW, APP, AZM);
     altcmd.setPosition(alt);
     azmcmd.setPosition(az);
-    sendAUXCommand(altcmd);
-    readAUXResponse(altcmd);
-    sendAUXCommand(azmcmd);
-    readAUXResponse(azmcmd);
+    transactAUX({altcmd, azmcmd});
     //DEBUG=false;
     return true;
 };
@@ -1555,11 +1572,7 @@ bool CelestronAUX::GoToSlow(int32_t alt, int32_t az, bool track)
 bool CelestronAUX::getVersion(AUXTargets trg)
 {
     AUXCommand firmver(GET_VER, APP, trg);
-    if (! sendAUXCommand(firmver))
-        return false;
-    if (! readAUXResponse(firmver))
-        return false;
-    return true;
+    return transactAUX(firmver);
 };
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -1596,8 +1609,7 @@ bool CelestronAUX::setCordwrap(bool enable)
 
     AUXCommand cwcmd(enable ? MC_ENABLE_CORDWRAP : MC_DISABLE_CORDWRAP, APP, AZM);
     LOGF_INFO("setCordWrap before %d", m_CordWrapActive);
-    sendAUXCommand(cwcmd);
-    readAUXResponse(cwcmd);
+    transactAUX(cwcmd);
     LOGF_INFO("setCordWrap after %d", m_CordWrapActive);
     return true;
 };
@@ -1606,8 +1618,7 @@ bool CelestronAUX::getCordwrap()
 {
     AUXCommand cwcmd(MC_POLL_CORDWRAP, APP, AZM);
     LOGF_INFO("getCordWrap before %d", m_CordWrapActive);
-    sendAUXCommand(cwcmd);
-    readAUXResponse(cwcmd);
+    transactAUX(cwcmd);
     LOGF_INFO("getCordWrap after %d", m_CordWrapActive);
     return m_CordWrapActive;
 };
@@ -1621,8 +1632,7 @@ bool CelestronAUX::setCordwrapPos(int32_t pos)
     AUXCommand cwcmd(MC_SET_CORDWRAP_POS, APP, AZM);
     cwcmd.setPosition(pos);
     LOGF_INFO("setCordwrapPos %.1f deg", (pos / STEPS_PER_DEGREE) );
-    sendAUXCommand(cwcmd);
-    readAUXResponse(cwcmd);
+    transactAUX(cwcmd);
     return true;
 };
 
@@ -1632,8 +1642,7 @@ bool CelestronAUX::setCordwrapPos(int32_t pos)
 long CelestronAUX::getCordwrapPos()
 {
     AUXCommand cwcmd(MC_GET_CORDWRAP_POS, APP, AZM);
-    sendAUXCommand(cwcmd);
-    readAUXResponse(cwcmd);
+    transactAUX(cwcmd);
     LOGF_INFO("getCordwrapPos %.1f deg", (m_CordWrapPosition / STEPS_PER_DEGREE) );
     return m_CordWrapPosition;
 };
@@ -1658,10 +1667,7 @@ bool CelestronAUX::Track(int32_t altRate, int32_t azRate)
     altcmd.setPosition(std::abs(m_AltRate));
     azmcmd.setPosition(std::abs(m_AzRate));
 
-    sendAUXCommand(altcmd);
-    readAUXResponse(altcmd);
-    sendAUXCommand(azmcmd);
-    readAUXResponse(azmcmd);
+    transactAUX({altcmd, azmcmd});
     return true;
 };
 
@@ -1690,10 +1696,7 @@ bool CelestronAUX::SetTrackEnabled(bool enabled)
             b[0] = 0;
             AUXCommand stopAlt(MC_MOVE_POS, APP, ALT, b);
             AUXCommand stopAz(MC_MOVE_POS, APP, AZM, b);
-            sendAUXCommand(stopAlt);
-            readAUXResponse(stopAlt);
-            sendAUXCommand(stopAz);
-            readAUXResponse(stopAz);
+            transactAUX({stopAlt, stopAz});
         }
     }
 
@@ -1759,25 +1762,15 @@ void CelestronAUX::querryStatus()
 {
     if ( isConnected() )
     {
-        AUXTargets trg[2] = { ALT, AZM };
-        for (int i = 0; i < 2; i++)
-        {
-            AUXCommand cmd(MC_GET_POSITION, APP, trg[i]);
-            sendAUXCommand(cmd);
-            readAUXResponse(cmd);
-        }
+        // With the bus reader these are all in flight at once: one round trip per tick
+        std::vector<AUXCommand> cmds;
+        cmds.emplace_back(MC_GET_POSITION, APP, ALT);
+        cmds.emplace_back(MC_GET_POSITION, APP, AZM);
         if (m_SlewingAlt && ScopeStatus != SLEWING_MANUAL)
-        {
-            AUXCommand cmd(MC_SLEW_DONE, APP, ALT);
-            sendAUXCommand(cmd);
-            readAUXResponse(cmd);
-        }
+            cmds.emplace_back(MC_SLEW_DONE, APP, ALT);
         if (m_SlewingAz && ScopeStatus != SLEWING_MANUAL)
-        {
-            AUXCommand cmd(MC_SLEW_DONE, APP, AZM);
-            sendAUXCommand(cmd);
-            readAUXResponse(cmd);
-        }
+            cmds.emplace_back(MC_SLEW_DONE, APP, AZM);
+        transactAUX(cmds);
     }
 }
 
@@ -1813,13 +1806,18 @@ void CelestronAUX::emulateGPS(AUXCommand &m)
         case GPS_GET_LAT:
         case GPS_GET_LONG:
         {
-            LOGF_DEBUG("GPS: Sending LAT/LONG Lat:%f Lon:%f\n", LocationN[LOCATION_LATITUDE].value,
-                       LocationN[LOCATION_LONGITUDE].value);
+            double latitude, longitude;
+            {
+                std::lock_guard<std::mutex> lock(m_GPSLocationMutex);
+                latitude  = m_GPSLatitude;
+                longitude = m_GPSLongitude;
+            }
+            LOGF_DEBUG("GPS: Sending LAT/LONG Lat:%f Lon:%f\n", latitude, longitude);
             AUXCommand cmd(m.cmd, GPS, m.src);
             if (m.cmd == GPS_GET_LAT)
-                cmd.setPosition(LocationN[LOCATION_LATITUDE].value);
+                cmd.setPosition(latitude);
             else
-                cmd.setPosition(LocationN[LOCATION_LONGITUDE].value);
+                cmd.setPosition(longitude);
             sendAUXCommand(cmd);
             //readAUXResponse(cmd);
             break;
@@ -1828,14 +1826,14 @@ void CelestronAUX::emulateGPS(AUXCommand &m)
         {
             LOGF_DEBUG("GPS: GET_TIME from 0x%02x", m.src);
             time_t gmt;
-            struct tm *ptm;
+            struct tm tm;
             AUXBuffer dat(3);
 
             time(&gmt);
-            ptm    = gmtime(&gmt);
-            dat[0] = unsigned(ptm->tm_hour);
-            dat[1] = unsigned(ptm->tm_min);
-            dat[2] = unsigned(ptm->tm_sec);
+            gmtime_r(&gmt, &tm);
+            dat[0] = unsigned(tm.tm_hour);
+            dat[1] = unsigned(tm.tm_min);
+            dat[2] = unsigned(tm.tm_sec);
             AUXCommand cmd(GPS_GET_TIME, GPS, m.src, dat);
             sendAUXCommand(cmd);
             //readAUXResponse(cmd);
@@ -1845,13 +1843,13 @@ void CelestronAUX::emulateGPS(AUXCommand &m)
         {
             LOGF_DEBUG("GPS: GET_DATE from 0x%02x", m.src);
             time_t gmt;
-            struct tm *ptm;
+            struct tm tm;
             AUXBuffer dat(2);
 
             time(&gmt);
-            ptm    = gmtime(&gmt);
-            dat[0] = unsigned(ptm->tm_mon + 1);
-            dat[1] = unsigned(ptm->tm_mday);
+            gmtime_r(&gmt, &tm);
+            dat[0] = unsigned(tm.tm_mon + 1);
+            dat[1] = unsigned(tm.tm_mday);
             AUXCommand cmd(GPS_GET_DATE, GPS, m.src, dat);
             sendAUXCommand(cmd);
             //readAUXResponse(cmd);
@@ -1861,14 +1859,14 @@ void CelestronAUX::emulateGPS(AUXCommand &m)
         {
             LOGF_DEBUG("GPS: GET_YEAR from 0x%02x", m.src);
             time_t gmt;
-            struct tm *ptm;
+            struct tm tm;
             AUXBuffer dat(2);
 
             time(&gmt);
-            ptm    = gmtime(&gmt);
-            dat[0] = unsigned(ptm->tm_year + 1900) >> 8;
-            dat[1] = unsigned(ptm->tm_year + 1900) & 0xFF;
-            LOGF_DEBUG("GPS: Sending: %d [%d,%d]", ptm->tm_year, dat[0], dat[1]);
+            gmtime_r(&gmt, &tm);
+            dat[0] = unsigned(tm.tm_year + 1900) >> 8;
+            dat[1] = unsigned(tm.tm_year + 1900) & 0xFF;
+            LOGF_DEBUG("GPS: Sending: %d [%d,%d]", tm.tm_year, dat[0], dat[1]);
             AUXCommand cmd(GPS_GET_YEAR, GPS, m.src, dat);
             sendAUXCommand(cmd);
             //readAUXResponse(cmd);
@@ -2061,8 +2059,8 @@ bool CelestronAUX::processResponse(AUXCommand &m)
 bool CelestronAUX::serialReadResponse(AUXCommand c)
 {
     int n;
-    unsigned char buf[32];
-    char hexbuf[24];
+    unsigned char buf[AUX_MAX_PACKET];
+    char hexbuf[3 * AUX_MAX_PACKET + 1];
     AUXCommand cmd;
 
     // We are not connected. Nothing to do.
@@ -2084,6 +2082,13 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
         if (aux_tty_read(PortFD, (char*)(buf + 1), 1, READ_TIMEOUT, &n) != TTY_OK)
             return false;
 
+        // source, destination and command at least
+        if (buf[1] < 3)
+        {
+            DEBUGF(DBG_CAUX, "Invalid packet length %d. Dropping out.", buf[1]);
+            return false;
+        }
+
         // now packet length is known, read the rest of the packet.
         if (aux_tty_read(PortFD, (char*)(buf + 2), buf[1] + 1, READ_TIMEOUT, &n)
                 != TTY_OK || n != buf[1] + 1)
@@ -2092,10 +2097,18 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
             return false;
         }
 
-        AUXBuffer b(buf, buf + (n + 2));
-        hex_dump(hexbuf, b, b.size());
-        DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
-        cmd.parseBuf(b);
+        AUXPacket packet(buf);
+        if (isDebug())
+        {
+            hex_dump(hexbuf, sizeof(hexbuf), buf, packet.size());
+            DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
+        }
+        if (AUXCommand::checksum(buf) != packet.checksum())
+        {
+            DEBUGF(DBG_CAUX, "Checksum error: %02x vs. %02x", AUXCommand::checksum(buf), packet.checksum());
+            return false;
+        }
+        cmd.parse(packet);
     }
     else
     {
@@ -2110,8 +2123,7 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
         if (buf[response_data_size + 5] != '#')
         {
             LOGF_ERROR("Resp. char %d is %2.2x ascii %c", n, buf[n + 5], (char)buf[n + 5]);
-            AUXBuffer b(buf, buf + (response_data_size + 5));
-            hex_dump(hexbuf, b, b.size());
+            hex_dump(hexbuf, sizeof(hexbuf), buf, response_data_size + 5);
             LOGF_ERROR("RES <%s>", hexbuf);
             return false;
         }
@@ -2123,8 +2135,11 @@ bool CelestronAUX::serialReadResponse(AUXCommand c)
         buf[4] = c.cmd;
 
         AUXBuffer b(buf, buf + (response_data_size + 5));
-        hex_dump(hexbuf, b, b.size());
-        DEBUGF(DBG_SERIAL, "RES (%d B): <%s>", (int)b.size(), hexbuf);
+        if (isDebug())
+        {
+            hex_dump(hexbuf, sizeof(hexbuf), buf, b.size());
+            DEBUGF(DBG_SERIAL, "RES (%d B): <%s>", (int)b.size(), hexbuf);
+        }
         cmd.parseBuf(b, false);
     }
 
@@ -2168,17 +2183,35 @@ bool CelestronAUX::tcpReadResponse()
         {
             if (buf[i] == 0x3b)
             {
+                // Not a packet, look for the next preamble as AUXFramer does
+                if (i + 1 < n && buf[i + 1] < 3)
+                {
+                    i++;
+                    continue;
+                }
+
                 int shft;
-                shft = i + buf[i + 1] + 3;
+                shft = i + (i + 1 < n ? buf[i + 1] : 0) + 3;
                 if (shft <= n)
                 {
-                    AUXBuffer b(buf + i, buf + shft);
-                    cmd.parseBuf(b);
+                    AUXPacket packet(buf + i);
 
-                    char hexbuf[32 * 3] = {0};
-                    hex_dump(hexbuf, b, b.size());
-                    DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
+                    if (isDebug())
+                    {
+                        char hexbuf[3 * AUX_MAX_PACKET + 1];
+                        hex_dump(hexbuf, sizeof(hexbuf), buf + i, packet.size());
+                        DEBUGF(DBG_SERIAL, "RES <%s>", hexbuf);
+                    }
+
+                    if (AUXCommand::checksum(buf + i) != packet.checksum())
+                    {
+                        DEBUGF(DBG_CAUX, "Checksum error: %02x vs. %02x", AUXCommand::checksum(buf + i), packet.checksum());
+                        i++;
+                        continue;
+                    }
 
+                    // In place, nothing copied but the data bytes
+                    cmd.parse(packet);
                     processResponse(cmd);
                 }
                 else
@@ -2220,24 +2253,30 @@ bool CelestronAUX::readAUXResponse(AUXCommand c)
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
-int CelestronAUX::sendBuffer(int PortFD, AUXBuffer buf)
+int CelestronAUX::sendBuffer(int PortFD, const AUXBuffer &buf)
 {
     if ( PortFD > 0 )
     {
         int n;
+        std::lock_guard<std::mutex> lock(m_WriteMutex);
 
         if (aux_tty_write(PortFD, (char*)buf.data(), buf.size(), CTS_TIMEOUT, &n) != TTY_OK)
             return 0;
 
-        msleep(50);
+        // Time for the reply to come, the bus reader does not need it
+        if (!m_Bus.isRunning())
+            msleep(50);
         if (n == -1)
             LOG_ERROR("CAUX::sendBuffer");
         if ((unsigned)n != buf.size())
             LOGF_WARN("sendBuffer: incomplete send n=%d size=%d", n, (int)buf.size());
 
-        char hexbuf[32 * 3] = {0};
-        hex_dump(hexbuf, buf, buf.size());
-        DEBUGF(DBG_SERIAL, "CMD <%s>", hexbuf);
+        if (isDebug())
+        {
+            char hexbuf[3 * AUX_MAX_PACKET + 1];
+            hex_dump(hexbuf, sizeof(hexbuf), buf.data(), buf.size());
+            DEBUGF(DBG_SERIAL, "CMD <%s>", hexbuf);
+        }
 
         return n;
     }
@@ -2272,10 +2311,126 @@ bool CelestronAUX::sendAUXCommand(AUXCommand &c)
         buf[7] = response_data_size = c.response_data_size();
     }
 
-    tcflush(PortFD, TCIOFLUSH);
+    // The bus reader may be in the middle of other replies
+    if (!m_Bus.isRunning())
+        tcflush(PortFD, TCIOFLUSH);
     return (sendBuffer(PortFD, buf) == static_cast<int>(buf.size()));
 }
 
+/////////////////////////////////////////////////////////////////////////////////////
+/// Without the bus reader one round trip after the other, as before. With it every
+/// command is registered with the reader, sent, and then the replies are waited for
+/// together: a lost reply costs READ_TIMEOUT once per call, not once per command.
+/////////////////////////////////////////////////////////////////////////////////////
+bool CelestronAUX::transactAUX(const std::vector<AUXCommand> &cmds)
+{
+    bool ok = true;
+
+    if (!m_Bus.isRunning())
+    {
+        for (AUXCommand c : cmds)
+        {
+            if (!sendAUXCommand(c) || !readAUXResponse(c))
+                ok = false;
+        }
+        return ok;
+    }
+
+    std::vector<AUXBus::Ticket> tickets;
+    tickets.reserve(cmds.size());
+    for (AUXCommand c : cmds)
+    {
+        tickets.push_back(m_Bus.expect(c));
+        if (!sendAUXCommand(c))
+        {
+            m_Bus.cancel(tickets.back().id);
+            tickets.back().reply = std::future<AUXCommand>();
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(READ_TIMEOUT);
+    for (size_t i = 0; i < tickets.size(); i++)
+    {
+        AUXBus::Ticket &ticket = tickets[i];
+        if (!ticket.reply.valid() || ticket.reply.wait_until(deadline) != std::future_status::ready)
+        {
+            DEBUGF(DBG_CAUX, "No reply to 0x%02x from %s", cmds[i].cmd, m_Bus.isRunning() ? "the mount" : "a closed bus");
+            m_Bus.cancel(ticket.id);
+            ok = false;
+            continue;
+        }
+        try
+        {
+            AUXCommand reply = ticket.reply.get();
+            processResponse(reply);
+        }
+        catch (std::future_error &)
+        {
+            // The reader stopped
+            ok = false;
+        }
+    }
+
+    processBusPackets();
+    return ok;
+}
+
+bool CelestronAUX::transactAUX(const AUXCommand &cmd)
+{
+    return transactAUX(std::vector<AUXCommand> { cmd });
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void CelestronAUX::startBusReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_BusPacketsMutex);
+        m_BusPackets.clear();
+    }
+    auto handler = [this](AUXCommand & m)
+    {
+        onBusPacket(m);
+    };
+    if (m_Bus.Start(PortFD, handler))
+        LOG_DEBUG("AUX bus reader started.");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+/// In the reader thread. The GPS emulation answers right away, the hand controller
+/// does not wait long; the rest is for the main thread.
+/////////////////////////////////////////////////////////////////////////////////////
+void CelestronAUX::onBusPacket(AUXCommand &m)
+{
+    if (m.dst == GPS)
+    {
+        m.logResponse();
+        emulateGPS(m);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_BusPacketsMutex);
+    // Nobody processes them while disconnected, keep the last ones only
+    if (m_BusPackets.size() >= 256)
+        m_BusPackets.pop_front();
+    m_BusPackets.push_back(m);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////////////
+void CelestronAUX::processBusPackets()
+{
+    std::deque<AUXCommand> packets;
+    {
+        std::lock_guard<std::mutex> lock(m_BusPacketsMutex);
+        packets.swap(m_BusPackets);
+    }
+    for (AUXCommand &m : packets)
+        processResponse(m);
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Wrap functions around the standard driver communication functions tty_read
@@ -2438,7 +2593,9 @@ int CelestronAUX::aux_tty_write(int PortFD, char *buf, int bufsiz, float timeout
         setRTS(0);
 
         // ports requiring hardware flow control echo all sent characters,
-        // verify them.
+        // verify them. The bus reader gets the echo instead, and drops it.
+        if (m_Bus.isRunning())
+            return TTY_OK;
         DEBUG(DBG_SERIAL, "aux_tty_write: verify echo");
         if ((errcode = tty_read(PortFD, errmsg, *n, READ_TIMEOUT, &ne)) != TTY_OK)
         {
@@ -2489,12 +2646,13 @@ bool CelestronAUX::tty_set_speed(int PortFD, speed_t speed)
 /////////////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////////////
-void CelestronAUX::hex_dump(char *buf, AUXBuffer data, size_t size)
+void CelestronAUX::hex_dump(char *buf, size_t bufsize, const unsigned char *data, size_t size)
 {
+    // Three characters a byte and the terminating NUL, cut short to what fits
+    size = std::min(size, (bufsize - 1) / 3);
     for (size_t i = 0; i < size; i++)
         sprintf(buf + 3 * i, "%02X ", data[i]);
 
-    if (size > 0)
-        buf[3 * size - 1] = '\0';
+    buf[size > 0 ? 3 * size - 1 : 0] = '\0';
 }
 
@@ -30,8 +30,14 @@
 #include <connectionplugins/connectiontcp.h>
 #include <alignment/AlignmentSubsystemForDrivers.h>
 
+#include "auxbus.h"
 #include "auxproto.h"
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+
 class CelestronAUX :
     public INDI::Telescope,
     public INDI::GuiderInterface,
@@ -84,6 +90,7 @@ class CelestronAUX :
 
         virtual bool ReadScopeStatus() override;
         virtual void TimerHit() override;
+        virtual void debugTriggered(bool enable) override;
 
         virtual bool updateLocation(double latitude, double longitude, double elevation) override;
 
@@ -99,6 +106,11 @@ class CelestronAUX :
         bool GoToSlow(int32_t alt, int32_t az, bool track);
         bool setCordwrap(bool enable);
         bool getCordwrap();
+        // Send the commands and process their replies, all in flight at once with the bus reader
+        bool transactAUX(const std::vector<AUXCommand> &cmds);
+        bool transactAUX(const AUXCommand &cmd);
+        // Read PortFD in the bus reader thread from now on
+        void startBusReader();
     public:
         bool setCordwrapPos(int32_t pos);
         long getCordwrapPos();
@@ -180,8 +192,19 @@ class CelestronAUX :
         bool TraceThisTick;
 
         // connection
-        bool isRTSCTS;
-        bool isHC;
+        bool isRTSCTS {false};
+        bool isHC {false};
+
+        // Reader thread for the framed AUX connections (network, USB, AUX and PC ports)
+        AUXBus m_Bus;
+        // Packets which are not replies, for the main thread
+        std::deque<AUXCommand> m_BusPackets;
+        std::mutex m_BusPacketsMutex;
+        // The GPS emulation answers from the reader thread
+        std::mutex m_WriteMutex;
+        // Site for the GPS emulation, a copy the reader thread can read while the location changes
+        std::mutex m_GPSLocationMutex;
+        double m_GPSLatitude {0}, m_GPSLongitude {0};
 
         uint32_t DBG_CAUX {0};
         uint32_t DBG_SERIAL {0};
@@ -198,8 +221,10 @@ class CelestronAUX :
         bool readAUXResponse(AUXCommand c);
         bool processResponse(AUXCommand &cmd);
         void querryStatus();
-        int sendBuffer(int PortFD, AUXBuffer buf);
+        int sendBuffer(int PortFD, const AUXBuffer &buf);
         bool sendAUXCommand(AUXCommand &c);
+        void onBusPacket(AUXCommand &m);
+        void processBusPackets();
         void formatVersionString(char *s, int n, uint8_t *verBuf);
 
         // Current steps from controller 
@@ -217,7 +242,7 @@ class CelestronAUX :
 
         bool m_Tracking {false};
         bool m_SlewingAlt {false}, m_SlewingAz {false};
-        bool gpsemu;
+        std::atomic<bool> gpsemu {false};
         bool cw_base_sky = false ;
 
 
@@ -244,7 +269,7 @@ class CelestronAUX :
         int aux_tty_read(int PortFD, char *buf, int bufsiz, int timeout, int *n);
         int aux_tty_write (int PortFD, char *buf, int bufsiz, float timeout, int *n);
         bool tty_set_speed(int PortFD, speed_t speed);
-        void hex_dump(char *buf, AUXBuffer data, size_t size);
+        void hex_dump(char *buf, size_t bufsize, const unsigned char *data, size_t size);
 
 
         ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,133 @@
+/*
+    Celestron AUX bus simulator on a pseudo terminal
+
+    Point the driver port at the printed device (or at the -L link) and connect. A pseudo
+    terminal has no RTS/CTS lines, so the driver takes it for the USB port of the mount:
+    no echo unless -e asks for it.
+
+    Usage: indi_celestronaux_pty_simulator [options]
+      -b baud     line speed of the bus, default 19200, 0 for no pacing
+      -e          echo the packets of the driver, like the AUX and PC ports
+      -l us       time a device needs to answer, default 500
+      -j us       random extra delay per reply, 0 to us, default 0
+      -d ratio    part of the requests and of the replies that are lost, default 0
+      -c ratio    part of the replies with a corrupted byte, default 0
+      -H ms       hand controller position polls every ms, default 0 for none
+      -n          no hand controller on the bus
+      -g          a GPS on the bus
+      -s seed     seed for the jitter, the losses and the corruption
+      -L path     symlink to the device, e.g. /tmp/ttyAUX
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "aux-simulator.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static AUXSimulator *simulator = nullptr;
+
+static void stop(int)
+{
+    if (simulator)
+        simulator->Stop();
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-b baud] [-e] [-l latency us] [-j jitter us] [-d drop ratio] [-c corrupt ratio] "
+            "[-H hc poll ms] [-n] [-g] [-s seed] [-L link]\n", name);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    AUXSimulator::Options options = AUXSimulator::DefaultOptions();
+    const char *link = nullptr;
+
+    options.echo = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:el:j:d:c:H:ngs:L:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                options.baud = strtoul(optarg, nullptr, 0);
+                break;
+            case 'e':
+                options.echo = true;
+                break;
+            case 'l':
+                options.latency_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'j':
+                options.jitter_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'd':
+                options.drop = atof(optarg);
+                break;
+            case 'c':
+                options.corrupt = atof(optarg);
+                break;
+            case 'H':
+                options.hc_poll_ms = strtoul(optarg, nullptr, 0);
+                break;
+            case 'n':
+                options.hc = false;
+                break;
+            case 'g':
+                options.gps = true;
+                break;
+            case 's':
+                options.seed = strtoul(optarg, nullptr, 0);
+                break;
+            case 'L':
+                link = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    AUXSimulator sim(options);
+    if (!sim.OpenPty(link))
+    {
+        fprintf(stderr, "Can not create the pseudo terminal: %s\n", strerror(errno));
+        return 1;
+    }
+    printf("AUX bus on %s%s%s, %u baud, latency %u us, jitter %u us, %.1f%% lost, %.1f%% corrupted%s%s\n",
+           sim.getDeviceName(), link ? " -> " : "", link ? link : "", options.baud, options.latency_us,
+           options.jitter_us, options.drop * 100.0, options.corrupt * 100.0, options.hc ? ", hand controller" : "",
+           options.gps ? ", GPS" : "");
+    fflush(stdout);
+
+    simulator = &sim;
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    sim.Serve();
+
+    AUXSimulator::Stats stats = sim.getStats();
+    printf("%lu requests, %lu replies, %lu hand controller packets, %lu lost, %lu corrupted, %lu bytes in, %lu bytes out\n",
+           stats.requests, stats.replies, stats.hc_packets, stats.dropped, stats.corrupted, stats.bytes_in,
+           stats.bytes_out);
+    return 0;
+}
@@ -0,0 +1,598 @@
+/*
+    Celestron AUX bus simulator
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "aux-simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static const double STEPS       = 16777216.0;
+static const double SIDEREAL    = STEPS / 86164.0905;   // steps/s
+static const double FAST_RATE   = 4.0 * STEPS / 360.0;  // steps/s, MC_GOTO_FAST
+static const double SLOW_RATE   = 0.2 * STEPS / 360.0;  // steps/s, MC_GOTO_SLOW
+// Guide rates in 1/1000 arcsec/s, as nse_telescope.py has them
+static const double GUIDE_UNIT  = STEPS / (360.0 * 3600.0 * 1000.0);
+// Hand controller rates 0 to 9, in revolutions/s
+static const double MOVE_RATES[10] =
+{
+    0.0, 1.0 / (360 * 60), 2.0 / (360 * 60), 5.0 / (360 * 60), 15.0 / (360 * 60), 30.0 / (360 * 60),
+    1.0 / 360, 2.0 / 360, 5.0 / 360, 10.0 / 360
+};
+
+static const unsigned char MC_VERSION[4]  = { 7, 11, 5100 >> 8, 5100 & 0xff };
+static const unsigned char HC_VERSION[4]  = { 5, 28, 5300 >> 8, 5300 & 0xff };
+static const unsigned char GPS_VERSION[2] = { 1, 6 };
+
+static uint32_t unpack3(const unsigned char *data)
+{
+    return static_cast<uint32_t>(data[0]) << 16 | static_cast<uint32_t>(data[1]) << 8 | data[2];
+}
+
+static void pack3(AUXBuffer &reply, int32_t value)
+{
+    uint32_t v = static_cast<uint32_t>(value) & 0xffffff;
+    reply.push_back(v >> 16);
+    reply.push_back((v >> 8) & 0xff);
+    reply.push_back(v & 0xff);
+}
+
+////////////////////////////////////////////////
+//////  AUXMotorSimulator class
+////////////////////////////////////////////////
+
+AUXMotorSimulator::AUXMotorSimulator(AUXTargets i) : id(i)
+{
+}
+
+// Azimuth goes round, altitude is signed
+double AUXMotorSimulator::wrap(double steps) const
+{
+    steps = fmod(steps, STEPS);
+    if (id == AZM)
+        return steps < 0 ? steps + STEPS : steps;
+    if (steps > STEPS / 2)
+        return steps - STEPS;
+    if (steps <= -STEPS / 2)
+        return steps + STEPS;
+    return steps;
+}
+
+void AUXMotorSimulator::tick(double dt)
+{
+    if (gotorate > 0)
+    {
+        double remaining = wrap(target - position);
+        if (id == AZM && remaining > STEPS / 2)
+            remaining -= STEPS;
+        if (fabs(remaining) <= gotorate * dt)
+        {
+            position = target;
+            gotorate = 0;
+        }
+        else
+            position += remaining > 0 ? gotorate * dt : -gotorate * dt;
+    }
+
+    position += (moverate + guiderate) * dt;
+    if (pulseleft > 0)
+    {
+        double t = std::min(dt, pulseleft);
+        position += pulserate * t;
+        pulseleft -= t;
+    }
+    position = wrap(position);
+}
+
+int32_t AUXMotorSimulator::getPosition() const
+{
+    return static_cast<int32_t>(lround(position));
+}
+
+void AUXMotorSimulator::setPosition(int32_t steps)
+{
+    position = wrap(steps);
+    gotorate = 0;
+}
+
+bool AUXMotorSimulator::isSlewing() const
+{
+    return gotorate > 0 || moverate != 0;
+}
+
+bool AUXMotorSimulator::handle(AUXCommands cmd, const unsigned char *data, int size, AUXBuffer &reply)
+{
+    reply.clear();
+    switch (cmd)
+    {
+        case MC_GET_POSITION:
+            pack3(reply, getPosition());
+            return true;
+
+        case MC_GOTO_FAST:
+        case MC_GOTO_SLOW:
+            if (size < 3)
+                return false;
+            target   = wrap(static_cast<int32_t>(unpack3(data) << 8) >> 8);
+            gotorate = cmd == MC_GOTO_FAST ? FAST_RATE : SLOW_RATE;
+            moverate = 0;
+            return true;
+
+        case MC_SET_POSITION:
+            if (size < 3)
+                return false;
+            setPosition(static_cast<int32_t>(unpack3(data) << 8) >> 8);
+            return true;
+
+        case MC_SET_POS_GUIDERATE:
+        case MC_SET_NEG_GUIDERATE:
+            if (size < 3)
+                return false;
+            guiderate = (cmd == MC_SET_POS_GUIDERATE ? 1 : -1) * GUIDE_UNIT * unpack3(data);
+            return true;
+
+        case MC_LEVEL_START:
+        case MC_SEEK_INDEX:
+            return true;
+
+        case MC_ENABLE_CORDWRAP:
+        case MC_DISABLE_CORDWRAP:
+            cordwrap = cmd == MC_ENABLE_CORDWRAP;
+            return true;
+
+        case MC_SLEW_DONE:
+            reply.push_back(gotorate > 0 ? 0x00 : 0xff);
+            return true;
+
+        case MC_MOVE_POS:
+        case MC_MOVE_NEG:
+            if (size < 1 || data[0] > 9)
+                return false;
+            moverate = (cmd == MC_MOVE_POS ? 1 : -1) * MOVE_RATES[data[0]] * STEPS;
+            gotorate = 0;
+            return true;
+
+        case MC_SET_CORDWRAP_POS:
+            if (size < 3)
+                return false;
+            cordwrappos = unpack3(data);
+            return true;
+
+        case MC_POLL_CORDWRAP:
+            reply.push_back(cordwrap ? 0xff : 0x00);
+            return true;
+
+        case MC_GET_CORDWRAP_POS:
+            pack3(reply, cordwrappos);
+            return true;
+
+        case MC_SET_AUTOGUIDE_RATE:
+            if (size < 1)
+                return false;
+            autoguiderate = data[0];
+            return true;
+
+        case MC_GET_AUTOGUIDE_RATE:
+            reply.push_back(autoguiderate);
+            return true;
+
+        case MC_AUX_GUIDE:
+            // Rate in percent of sidereal, duration in 10 ms ticks
+            if (size < 2)
+                return false;
+            pulserate = static_cast<int8_t>(data[0]) / 100.0 * SIDEREAL;
+            pulseleft = data[1] * 0.01;
+            return true;
+
+        case MC_AUX_GUIDE_ACTIVE:
+            reply.push_back(pulseleft > 0 ? 0x01 : 0x00);
+            return true;
+
+        case GET_VER:
+            reply.assign(MC_VERSION, MC_VERSION + sizeof(MC_VERSION));
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+////////////////////////////////////////////////
+//////  AUXSimulator class
+////////////////////////////////////////////////
+
+AUXSimulator::Options AUXSimulator::DefaultOptions()
+{
+    Options options;
+    options.baud       = 19200;
+    options.echo       = true;
+    options.latency_us = 500;
+    options.jitter_us  = 0;
+    options.drop       = 0.0;
+    options.corrupt    = 0.0;
+    options.hc         = true;
+    options.hc_poll_ms = 0;
+    options.gps        = false;
+    options.latitude   = 50.0;
+    options.longitude  = 20.0;
+    options.seed       = 1;
+    return options;
+}
+
+AUXSimulator::AUXSimulator(const Options &o) : options(o), azm(AZM), alt(ALT), gen(o.seed)
+{
+}
+
+AUXSimulator::~AUXSimulator()
+{
+    Stop();
+    Close();
+}
+
+bool AUXSimulator::OpenPty(const char *linkname)
+{
+    struct termios tty;
+
+    Close();
+    if ((hostfd = posix_openpt(O_RDWR | O_NOCTTY)) < 0)
+        return false;
+    if (grantpt(hostfd) < 0 || unlockpt(hostfd) < 0)
+    {
+        Close();
+        return false;
+    }
+    device = ptsname(hostfd);
+
+    // Keep the slave side open, else reading the master fails while the driver is not connected
+    if ((ptyslavefd = open(device.c_str(), O_RDWR | O_NOCTTY)) < 0)
+    {
+        Close();
+        return false;
+    }
+    tcgetattr(ptyslavefd, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(ptyslavefd, TCSANOW, &tty);
+
+    if (linkname)
+    {
+        unlink(linkname);
+        if (symlink(device.c_str(), linkname) < 0)
+        {
+            Close();
+            return false;
+        }
+        link = linkname;
+    }
+    return true;
+}
+
+int AUXSimulator::OpenSocketPair()
+{
+    int sv[2];
+
+    Close();
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+        return -1;
+    hostfd = sv[0];
+    return sv[1];
+}
+
+void AUXSimulator::Close()
+{
+    if (!link.empty())
+        unlink(link.c_str());
+    link.clear();
+    device.clear();
+    if (ptyslavefd >= 0)
+        close(ptyslavefd);
+    if (hostfd >= 0)
+        close(hostfd);
+    ptyslavefd = hostfd = -1;
+    framer.reset();
+    bus.clear();
+}
+
+AUXSimulator::Clock::duration AUXSimulator::lineTime(size_t bytes) const
+{
+    if (options.baud == 0)
+        return Clock::duration::zero();
+    // start bit, 8 data bits, stop bit
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(10LL * bytes * 1000000000LL /
+            options.baud));
+}
+
+bool AUXSimulator::chance(double probability)
+{
+    return probability > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(gen) < probability;
+}
+
+/* On the bus as soon as it is free */
+void AUXSimulator::transmit(Clock::time_point ready, const AUXBuffer &bytes, bool request, bool fromhost)
+{
+    Clock::time_point start = std::max(ready, busfree);
+    busfree = start + lineTime(bytes.size());
+
+    Packet packet;
+    packet.bytes    = bytes;
+    packet.request  = request;
+    packet.fromhost = fromhost;
+    bus.insert(std::make_pair(busfree, packet));
+}
+
+bool AUXSimulator::answer(AUXTargets dst, AUXCommands cmd, const unsigned char *data, int size, AUXBuffer &reply)
+{
+    reply.clear();
+    switch (dst)
+    {
+        case AZM:
+        case ALT:
+        {
+            std::lock_guard<std::mutex> lock(mountmutex);
+            return (dst == AZM ? azm : alt).handle(cmd, data, size, reply);
+        }
+
+        case HC:
+            if (!options.hc || cmd != GET_VER)
+                return false;
+            reply.assign(HC_VERSION, HC_VERSION + sizeof(HC_VERSION));
+            return true;
+
+        case GPS:
+        {
+            if (!options.gps)
+                return false;
+
+            time_t now = time(nullptr);
+            struct tm utc;
+            gmtime_r(&now, &utc);
+            switch (cmd)
+            {
+                case GET_VER:
+                    reply.assign(GPS_VERSION, GPS_VERSION + sizeof(GPS_VERSION));
+                    return true;
+                case GPS_GET_LAT:
+                    pack3(reply, static_cast<int32_t>(options.latitude * STEPS / 360.0));
+                    return true;
+                case GPS_GET_LONG:
+                    pack3(reply, static_cast<int32_t>(options.longitude * STEPS / 360.0));
+                    return true;
+                case GPS_GET_TIME:
+                    reply = { static_cast<unsigned char>(utc.tm_hour), static_cast<unsigned char>(utc.tm_min),
+                              static_cast<unsigned char>(utc.tm_sec)
+                            };
+                    return true;
+                case GPS_GET_DATE:
+                    reply = { static_cast<unsigned char>(utc.tm_mon + 1), static_cast<unsigned char>(utc.tm_mday) };
+                    return true;
+                case GPS_GET_YEAR:
+                    reply = { static_cast<unsigned char>((utc.tm_year + 1900) >> 8),
+                              static_cast<unsigned char>((utc.tm_year + 1900) & 0xff)
+                            };
+                    return true;
+                case GPS_TIME_VALID:
+                case GPS_LINKED:
+                    reply = { 0x01 };
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        default:
+            return false;
+    }
+}
+
+void AUXSimulator::writeHost(const AUXBuffer &bytes)
+{
+    for (size_t sent = 0; sent < bytes.size();)
+    {
+        ssize_t n = write(hostfd, bytes.data() + sent, bytes.size() - sent);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        sent += n;
+    }
+    bytes_out += bytes.size();
+}
+
+/* The last byte of the packet is on the bus: the host hears it, the destination answers */
+void AUXSimulator::deliver(const Packet &packet)
+{
+    AUXPacket p(packet.bytes.data());
+    bool hcpacket = p.src() == HC || p.dst() == HC;
+
+    if (!packet.fromhost || options.echo)
+        writeHost(packet.bytes);
+    if (hcpacket && !packet.fromhost)
+        hc_packets++;
+    else if (!packet.request)
+        replies++;
+
+    // The hand controller answers the host only
+    if (!packet.request || (p.dst() == HC && p.src() != APP))
+        return;
+
+    AUXBuffer data;
+    if (!answer(p.dst(), p.cmd(), p.data(), p.dataSize(), data))
+        return;
+    if (chance(options.drop) || chance(options.drop))
+    {
+        // The request was not heard, or the reply got lost
+        dropped++;
+        return;
+    }
+
+    AUXBuffer reply;
+    AUXCommand(p.cmd(), p.dst(), p.src(), data).fillBuf(reply);
+    if (chance(options.corrupt))
+    {
+        // Anything but the preamble and the length, the checksum shows it
+        reply[2 + std::uniform_int_distribution<size_t>(0, reply.size() - 3)(gen)] ^= 0x10;
+        corrupted++;
+    }
+
+    Clock::time_point ready = Clock::now() + std::chrono::microseconds(options.latency_us);
+    if (options.jitter_us > 0)
+        ready += std::chrono::microseconds(std::uniform_int_distribution<unsigned int>(0, options.jitter_us)(gen));
+    transmit(ready, reply, false, false);
+}
+
+/* What a hand controller does all the time: where are the motors, is the GPS there */
+void AUXSimulator::pollHC(Clock::time_point now)
+{
+    AUXBuffer b;
+
+    AUXCommand(MC_GET_POSITION, HC, AZM).fillBuf(b);
+    transmit(now, b, true, false);
+    AUXCommand(MC_GET_POSITION, HC, ALT).fillBuf(b);
+    transmit(now, b, true, false);
+    if (options.gps && hcpolls % 10 == 0)
+    {
+        AUXCommand(GPS_LINKED, HC, GPS).fillBuf(b);
+        transmit(now, b, true, false);
+    }
+    hcpolls++;
+
+    nexthcpoll += std::chrono::milliseconds(options.hc_poll_ms);
+    if (nexthcpoll < now)
+        nexthcpoll = now + std::chrono::milliseconds(options.hc_poll_ms);
+}
+
+void AUXSimulator::tick(Clock::time_point now)
+{
+    double dt = std::chrono::duration<double>(now - lasttick).count();
+    lasttick  = now;
+
+    std::lock_guard<std::mutex> lock(mountmutex);
+    azm.tick(dt);
+    alt.tick(dt);
+}
+
+void AUXSimulator::Serve()
+{
+    bool polling = options.hc && options.hc_poll_ms > 0;
+
+    lasttick = busfree = Clock::now();
+    nexthcpoll = lasttick + std::chrono::milliseconds(options.hc_poll_ms);
+
+    while (!stop)
+    {
+        Clock::time_point now = Clock::now();
+        tick(now);
+        if (polling && now >= nexthcpoll)
+            pollHC(now);
+        while (!bus.empty() && bus.begin()->first <= now)
+        {
+            Packet packet = bus.begin()->second;
+            bus.erase(bus.begin());
+            deliver(packet);
+        }
+
+        // Wake up for the next packet due, at the latest every 100ms to look at stop
+        Clock::time_point wake = now + std::chrono::milliseconds(100);
+        if (!bus.empty())
+            wake = std::min(wake, bus.begin()->first);
+        if (polling)
+            wake = std::min(wake, nexthcpoll);
+        int timeout = std::max<int>(0, std::chrono::duration_cast<std::chrono::milliseconds>(wake - now +
+                                    std::chrono::milliseconds(1) - Clock::duration(1)).count());
+
+        struct pollfd pfd;
+        pfd.fd     = hostfd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, timeout) <= 0)
+            continue;
+
+        ssize_t n = read(hostfd, framer.space(), framer.spaceSize());
+        if (n <= 0)
+        {
+            // Nobody on the other side
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        bytes_in += n;
+        framer.commit(n);
+
+        AUXPacket packet;
+        now = Clock::now();
+        while (framer.next(packet))
+        {
+            requests++;
+            transmit(now, AUXBuffer(packet.bytes(), packet.bytes() + packet.size()), true, true);
+        }
+    }
+}
+
+void AUXSimulator::Start()
+{
+    Stop();
+    stop   = false;
+    thread = std::thread(&AUXSimulator::Serve, this);
+}
+
+void AUXSimulator::Stop()
+{
+    stop = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+AUXSimulator::Stats AUXSimulator::getStats() const
+{
+    Stats stats;
+    stats.requests   = requests;
+    stats.replies    = replies;
+    stats.hc_packets = hc_packets;
+    stats.dropped    = dropped;
+    stats.corrupted  = corrupted;
+    stats.bytes_in   = bytes_in;
+    stats.bytes_out  = bytes_out;
+    return stats;
+}
+
+int32_t AUXSimulator::getPosition(AUXTargets axis)
+{
+    std::lock_guard<std::mutex> lock(mountmutex);
+    return (axis == ALT ? alt : azm).getPosition();
+}
+
+void AUXSimulator::setPosition(AUXTargets axis, int32_t steps)
+{
+    std::lock_guard<std::mutex> lock(mountmutex);
+    (axis == ALT ? alt : azm).setPosition(steps);
+}
+
+bool AUXSimulator::isSlewing(AUXTargets axis)
+{
+    std::lock_guard<std::mutex> lock(mountmutex);
+    return (axis == ALT ? alt : azm).isSlewing();
+}
@@ -0,0 +1,181 @@
+/*
+    Celestron AUX bus simulator
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "auxproto.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+/*
+ * One motor controller, MC_AZM or MC_ALT, after nse_telescope.py: positions in steps of
+ * 2^24 a revolution, gotos at a fixed rate, the hand controller move rates, guide rates
+ * and guide pulses, cordwrap.
+ */
+class AUXMotorSimulator
+{
+    public:
+        explicit AUXMotorSimulator(AUXTargets id);
+
+        AUXTargets getId() const
+        {
+            return id;
+        }
+
+        /* Move on by dt seconds */
+        void tick(double dt);
+
+        /* The data of the reply to cmd, false for a command the controller does not know */
+        bool handle(AUXCommands cmd, const unsigned char *data, int size, AUXBuffer &reply);
+
+        int32_t getPosition() const;
+        void setPosition(int32_t steps);
+        bool isSlewing() const;
+
+    private:
+        double wrap(double steps) const;
+
+        AUXTargets id;
+        double position {0};
+        double target {0};
+        double gotorate {0};        // steps/s, while a goto is on
+        double moverate {0};        // steps/s, MC_MOVE_POS and MC_MOVE_NEG
+        double guiderate {0};       // steps/s, MC_SET_POS_GUIDERATE and MC_SET_NEG_GUIDERATE
+        double pulserate {0};       // steps/s for pulseleft s, MC_AUX_GUIDE
+        double pulseleft {0};
+        bool cordwrap {false};
+        int32_t cordwrappos {0};
+        unsigned char autoguiderate {0xf0};
+};
+
+/*
+ * The AUX bus of a mount: both motor controllers, optionally a hand controller polling them
+ * and a GPS, and the host on the AUX or PC port. Connects to the driver through a pseudo
+ * terminal, or in process through a socketpair.
+ *
+ * The bus is shared and half duplex: every packet occupies it for its line time, a reply
+ * waits for the bus to be free, and the host sees all the traffic, the hand controller's
+ * included, and its own packets echoed like the real ports do. Replies can be delayed,
+ * lost or corrupted on request.
+ */
+class AUXSimulator
+{
+    public:
+        typedef struct Options
+        {
+            unsigned int baud;          // line speed of the bus, 0 for no pacing
+            bool echo;                  // the AUX and PC ports echo what the host sends
+            unsigned int latency_us;    // time a device needs to answer
+            unsigned int jitter_us;     // random extra delay, 0 to jitter_us
+            double drop;                // probability that a request or a reply is lost
+            double corrupt;             // probability that a reply has a wrong byte
+            bool hc;                    // a hand controller on the bus
+            unsigned int hc_poll_ms;    // period of its position polls, 0 for a quiet one
+            bool gps;                   // a GPS on the bus
+            double latitude, longitude; // where the GPS is, degrees
+            unsigned int seed;
+        } Options;
+
+        typedef struct Stats
+        {
+            unsigned long requests;     // from the host
+            unsigned long replies;      // to the host
+            unsigned long hc_packets;   // requests of the hand controller and their replies
+            unsigned long dropped;
+            unsigned long corrupted;
+            unsigned long bytes_in;
+            unsigned long bytes_out;
+        } Stats;
+
+        static Options DefaultOptions();
+
+        explicit AUXSimulator(const Options &options);
+        ~AUXSimulator();
+
+        /* Create a pseudo terminal, with a symlink to it if link is not null. Returns false if
+           it could not be created, errno tells why. */
+        bool OpenPty(const char *link = nullptr);
+        /* A socketpair, returns the end of the host, which the caller closes, or -1 */
+        int OpenSocketPair();
+        void Close();
+        /* Path of the pseudo terminal the driver opens */
+        const char *getDeviceName() const
+        {
+            return device.c_str();
+        }
+
+        /* Serve until Stop(), in the calling thread or in a thread of its own */
+        void Serve();
+        void Start();
+        void Stop();
+
+        Stats getStats() const;
+
+        /* The mount as it is now */
+        int32_t getPosition(AUXTargets axis);
+        void setPosition(AUXTargets axis, int32_t steps);
+        bool isSlewing(AUXTargets axis);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        typedef struct Packet
+        {
+            AUXBuffer bytes;
+            bool request;       // to be answered by its destination
+            bool fromhost;
+        } Packet;
+
+        Clock::duration lineTime(size_t bytes) const;
+        bool chance(double probability);
+        void transmit(Clock::time_point ready, const AUXBuffer &bytes, bool request, bool fromhost);
+        void deliver(const Packet &packet);
+        bool answer(AUXTargets dst, AUXCommands cmd, const unsigned char *data, int size, AUXBuffer &reply);
+        void writeHost(const AUXBuffer &bytes);
+        void pollHC(Clock::time_point now);
+        void tick(Clock::time_point now);
+
+        Options options;
+        AUXMotorSimulator azm, alt;
+        std::mutex mountmutex;
+
+        int hostfd {-1};
+        int ptyslavefd {-1};
+        std::string device;
+        std::string link;
+
+        std::thread thread;
+        std::atomic<bool> stop {false};
+        std::mt19937 gen;
+        AUXFramer framer;
+
+        /* Packets on the bus by the time their last byte is on it */
+        std::multimap<Clock::time_point, Packet> bus;
+        Clock::time_point busfree, lasttick, nexthcpoll;
+        unsigned long hcpolls {0};
+
+        std::atomic<unsigned long> requests {0}, replies {0}, hc_packets {0}, dropped {0}, corrupted {0}, bytes_in {0},
+            bytes_out {0};
+};
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include "celestronaux.h"
+#include "simulator/aux-simulator.h"
+
+#include <unistd.h>
+
+class TestCelestronAUX : public CelestronAUX
+{
+    public:
+        // As after Handshake() on the network or USB port: no passthrough, the bus reader on
+        void attach(int fd)
+        {
+            PortFD = fd;
+            startBusReader();
+        }
+
+        bool getPositions()
+        {
+            AUXCommand alt(MC_GET_POSITION, APP, ALT);
+            AUXCommand azm(MC_GET_POSITION, APP, AZM);
+            return transactAUX({alt, azm});
+        }
+
+        using CelestronAUX::GetALT;
+        using CelestronAUX::GetAZ;
+};
+
+// Both positions asked at once on a bus that loses and corrupts packets, with the hand
+// controller polling the same motor controllers: a batch is either reported as failed or
+// every position comes from the reply to its own request.
+TEST(CelestronAUXTest, transact_lossy_bus)
+{
+    AUXSimulator::Options options = AUXSimulator::DefaultOptions();
+    options.jitter_us  = 2000;
+    options.drop       = 0.01;
+    options.corrupt    = 0.01;
+    options.hc_poll_ms = 20;
+
+    AUXSimulator sim(options);
+    int fd = sim.OpenSocketPair();
+    ASSERT_GE(fd, 0);
+    sim.Start();
+
+    int answered = 0;
+    {
+        TestCelestronAUX caux;
+        caux.attach(fd);
+
+        for (int i = 0; i < 60; i++)
+        {
+            // New positions every round, a reply to an earlier round would not match them
+            int32_t alt = 0x100000 + i * 0x1000;
+            int32_t azm = 0x400000 + i * 0x1000;
+            sim.setPosition(ALT, alt);
+            sim.setPosition(AZM, azm);
+
+            if (!caux.getPositions())
+                continue;
+            answered++;
+            EXPECT_EQ(alt, caux.GetALT()) << "round " << i;
+            EXPECT_EQ(azm, caux.GetAZ()) << "round " << i;
+        }
+    }
+    sim.Stop();
+    close(fd);
+
+    AUXSimulator::Stats stats = sim.getStats();
+    EXPECT_GT(answered, 30);
+    EXPECT_GT(stats.hc_packets, 0u);
+    EXPECT_GT(stats.dropped + stats.corrupted, 0u);
+}
@@ -111,7 +111,7 @@ DSI::Device::Device(const char *devname) : readout_mode(ReadoutMode::DUAL), usb_
 {
     command_sequence_number = 0;
     eeprom_length           = -1;
-    log_commands            = true;
+    log_commands            = false;
     test_pattern            = true;
     vdd_on                  = false; /* DSI III default due to amp glow issue (gs)   */
     exposure_time           = 10;
@@ -945,8 +945,8 @@ unsigned char *DSI::Device::downloadImage()
     /* disable 2x2 binning after downloading image (gs) */
     disable2x2Binning();
 
-    unsigned char msb = 0, lsb = 0, is_odd = 0;
-    unsigned int x_ptr = 0, line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
+    unsigned char is_odd = 0;
+    unsigned int line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
     char *even = (char *)even_data;
     char *odd  = (char *)odd_data;
 
@@ -966,26 +966,15 @@ unsigned char *DSI::Device::downloadImage()
             line_start = t_read_width * ((y_ptr + t_image_offset_y) / 2);
             is_odd     = (y_ptr + t_image_offset_y) % 2;
 
-            std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
-                 << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
-                 << std::endl;
+            if (log_commands)
+                std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
+                     << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
+                     << std::endl;
 
-            for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-            {
-                read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-                if (is_odd == 1) // odd line
-                {
-                    msb = odd[read_ptr];
-                    lsb = odd[read_ptr + 1];
-                }
-                else
-                { // even line
-                    msb = even[read_ptr];
-                    lsb = even[read_ptr + 1];
-                }
-                framebuffer[write_ptr++] = msb;
-                framebuffer[write_ptr++] = lsb;
-            }
+            // Samples stay big endian, a row is a contiguous run of byte pairs
+            read_ptr = (line_start + t_image_offset_x) * 2;
+            memcpy(framebuffer + write_ptr, (is_odd == 1 ? odd : even) + read_ptr, t_image_width * 2);
+            write_ptr += t_image_width * 2;
         }
     }
     else
@@ -999,16 +988,9 @@ unsigned char *DSI::Device::downloadImage()
             //      << ", line_start=" << line_start
             //      << ", read_ptr=" << (line_start+t_image_offset_x)*2
             //      << std::endl;
-            for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-            {
-                read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-
-                msb = odd[read_ptr];
-                lsb = odd[read_ptr + 1];
-
-                framebuffer[write_ptr++] = msb;
-                framebuffer[write_ptr++] = lsb;
-            }
+            read_ptr = (line_start + t_image_offset_x) * 2;
+            memcpy(framebuffer + write_ptr, odd + read_ptr, t_image_width * 2);
+            write_ptr += t_image_width * 2;
         }
     }
 
@@ -1381,8 +1363,8 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
 
         disable2x2Binning();
 
-        unsigned char msb = 0, lsb = 0, is_odd = 0;
-        unsigned int x_ptr = 0, line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
+        unsigned char is_odd = 0;
+        unsigned int line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
         char *even = (char *)even_data;
         char *odd  = (char *)odd_data;
 
@@ -1402,25 +1384,15 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
                 line_start = t_read_width * ((y_ptr + t_image_offset_y) / 2);
                 is_odd     = (y_ptr + t_image_offset_y) % 2;
 
-                std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
-                     << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
-                     << std::endl;
-                for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-                {
-                    read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-                    if (is_odd == 1) // odd line
-                    {
-                        msb = odd[read_ptr];
-                        lsb = odd[read_ptr + 1];
-                    }
-                    else
-                    { // even line
-                        msb = even[read_ptr];
-                        lsb = even[read_ptr + 1];
-                    }
-                    framebuffer[write_ptr++] = msb;
-                    framebuffer[write_ptr++] = lsb;
-                }
+                if (log_commands)
+                    std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
+                         << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
+                         << std::endl;
+
+                // Samples stay big endian, a row is a contiguous run of byte pairs
+                read_ptr = (line_start + t_image_offset_x) * 2;
+                memcpy(framebuffer + write_ptr, (is_odd == 1 ? odd : even) + read_ptr, t_image_width * 2);
+                write_ptr += t_image_width * 2;
             }
         }
         else
@@ -1433,16 +1405,9 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
                 //     << ", write_ptr=" << write_ptr
                 //     << ", line_start=" << line_start
                 //     << ", read_ptr=" << (line_start+t_image_offset_x)*2 << std::endl;
-                for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-                {
-                    read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-
-                    msb = odd[read_ptr];
-                    lsb = odd[read_ptr + 1];
-
-                    framebuffer[write_ptr++] = msb;
-                    framebuffer[write_ptr++] = lsb;
-                }
+                read_ptr = (line_start + t_image_offset_x) * 2;
+                memcpy(framebuffer + write_ptr, odd + read_ptr, t_image_width * 2);
+                write_ptr += t_image_width * 2;
             }
         }
 
@@ -23,9 +23,10 @@
 #include "config.h"
 #include "DsiDeviceFactory.h"
 
+#include <pixelkernels.h>
+
 #include <iostream>
 #include <math.h>
-#include <arpa/inet.h>
 #include <unistd.h>
 
 std::unique_ptr<DSICCD> dsiCCD(new DSICCD());
@@ -65,6 +66,9 @@ bool DSICCD::Connect()
         return false;
     }
 
+    // The USB command trace goes to stderr, only write it while debugging
+    dsi->setDebug(isDebug());
+
     ccd = dsi->getCcdChipName();
     if (ccd == "ICX254AL")
     {
@@ -464,6 +468,14 @@ bool DSICCD::saveConfigItems(FILE *fp)
     return true;
 }
 
+void DSICCD::debugTriggered(bool enable)
+{
+    INDI::CCD::debugTriggered(enable);
+
+    if (dsi)
+        dsi->setDebug(enable);
+}
+
 /*******************************************************************************
  * Download image from DSI
 *******************************************************************************/
@@ -471,7 +483,6 @@ bool DSICCD::saveConfigItems(FILE *fp)
 void DSICCD::grabImage()
 {
     uint16_t *buf = nullptr;
-    int x = 0, y = 0;
 
     std::unique_lock<std::mutex> guard(ccdBufferLock);
     // Let's get a pointer to the frame buffer
@@ -492,13 +503,8 @@ void DSICCD::grabImage()
     }
     guard.unlock();
 
-    for (y = 0; y < height; ++y)
-    {
-        for (x = 0; x < width; ++x)
-        {
-            ((uint16_t *)image)[x + width * y] = ntohs(buf[x + width * y]);
-        }
-    }
+    // The camera sends big endian samples
+    PixelKernels::fromBigEndian(buf, reinterpret_cast<uint16_t *>(image), width * height);
 
     delete buf;
 
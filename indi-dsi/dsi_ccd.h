@@ -51,6 +51,7 @@ class DSICCD : public INDI::CCD
 
     // misc functions
     virtual bool saveConfigItems(FILE *fp) override;
+    virtual void debugTriggered(bool enable) override;
 
   private:
     // Utility functions
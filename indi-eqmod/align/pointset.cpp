@@ -160,6 +160,53 @@ PointSet::ComputeDistances(double alt, double az, PointFilter filter, bool ingot
     return distances;
 }
 
+static UnitVector unitVector(double alt, double az)
+{
+    double horangle = range360(-180.0 - az) * M_PI / 180.0;
+    double altangle = alt * M_PI / 180.0;
+    return UnitVector { { cos(altangle) * cos(horangle), cos(altangle) * sin(horangle), sin(altangle) } };
+}
+
+void PointSet::BuildIndex()
+{
+    std::map<HtmID, int> vertex;
+    std::vector<FaceIndex::Triangle> triangles;
+
+    indexIDs.clear();
+    celestialVectors.clear();
+    telescopeVectors.clear();
+    for (auto &it : *PointSetMap)
+    {
+        vertex[it.first] = indexIDs.size();
+        indexIDs.push_back(it.first);
+        celestialVectors.push_back(UnitVector { { it.second.cx, it.second.cy, it.second.cz } });
+        telescopeVectors.push_back(UnitVector { { it.second.tx, it.second.ty, it.second.tz } });
+    }
+    celestialIndex.Build(celestialVectors);
+    telescopeIndex.Build(telescopeVectors);
+
+    for (Face *face : Triangulation->getFaces())
+    {
+        if (vertex.count(face->v[0]) && vertex.count(face->v[1]) && vertex.count(face->v[2]))
+            triangles.push_back(FaceIndex::Triangle { { vertex[face->v[0]], vertex[face->v[1]], vertex[face->v[2]] } });
+    }
+    faceIndex.Build(triangles, indexIDs.size());
+
+    currentFaceIndex = -1;
+    current.clear();
+    indexValid = true;
+}
+
+PointSet::Point *PointSet::getNearestPoint(double alt, double az, bool ingoto)
+{
+    if (!indexValid)
+        BuildIndex();
+    int nearest = (ingoto ? celestialIndex : telescopeIndex).Nearest(unitVector(alt, az));
+    if (nearest < 0)
+        return nullptr;
+    return getPoint(indexIDs[nearest]);
+}
+
 void PointSet::AddPoint(AlignData aligndata, INDI::IGeographicCoordinates *pos)
 {
     Point point;
@@ -198,6 +245,7 @@ void PointSet::AddPoint(AlignData aligndata, INDI::IGeographicCoordinates *pos)
     point.index = getNbPoints();
     PointSetMap->insert(std::pair<HtmID, Point>(point.htmID, point));
     Triangulation->AddPoint(point.htmID);
+    indexValid = false;
     LOGF_INFO("Align Pointset: added point %d alt = %g az = %g\n", point.index,
               point.celestialALT, point.celestialAZ);
     LOGF_INFO("Align Triangulate: number of faces is %d\n", Triangulation->getFaces().size());
@@ -235,6 +283,7 @@ void PointSet::Init()
 void PointSet::Reset()
 {
     current.clear();
+    indexValid = false;
     if (PointSetMap)
     {
         PointSetMap->clear();
@@ -315,6 +364,7 @@ char *PointSet::LoadDataFile(const char *filename)
     lnalignpos->longitude = lon;
     lnalignpos->latitude = lat;
     PointSetMap->clear();
+    indexValid = false;
     alignxml     = nextXMLEle(sitexml, 1);
     aligndata.jd = -1.0;
     while (alignxml)
@@ -519,9 +569,7 @@ std::vector<HtmID> PointSet::findFace(double currentRA, double currentDEC, doubl
     INDI_UNUSED(pointalt);
     INDI_UNUSED(pointaz);
     Point point;
-    double horangle = 0, altangle = 0;
-    std::vector<Face *> faces;
-    std::vector<Face *>::iterator it;
+    int face, start;
 
     point.aligndata.jd        = jd;
     point.aligndata.targetRA  = currentRA;
@@ -529,27 +577,28 @@ std::vector<HtmID> PointSet::findFace(double currentRA, double currentDEC, doubl
     AltAzFromRaDec(point.aligndata.targetRA, point.aligndata.targetDEC, point.aligndata.jd, &point.celestialALT,
                    &point.celestialAZ, position);
 
-    horangle = range360(-180.0 - point.celestialAZ) * M_PI / 180.0;
-    altangle = point.celestialALT * M_PI / 180.0;
-    point.cx = cos(altangle) * cos(horangle);
-    point.cy = cos(altangle) * sin(horangle);
-    point.cz = sin(altangle);
+    if (!indexValid)
+        BuildIndex();
 
-    if (Triangulation->isValid() && isPointInside(&point, current, ingoto))
-        return current;
-    faces = Triangulation->getFaces();
-    it    = faces.begin();
-    while (it < faces.end())
+    // Walk from the previous face, or from a face of the nearest point after a change of the point set
+    UnitVector p = unitVector(point.celestialALT, point.celestialAZ);
+    start        = currentFaceIndex;
+    if (start < 0)
+        start = faceIndex.FaceOf((ingoto ? celestialIndex : telescopeIndex).Nearest(p));
+    face = faceIndex.Locate(p, ingoto ? celestialVectors : telescopeVectors, start);
+
+    if (face >= 0)
     {
-        if (isPointInside(&point, (*it)->v, ingoto))
+        if (face != currentFaceIndex || current.empty())
         {
-            currentFace = *it;
-            current     = (*it)->v;
+            current.clear();
+            for (int v : faceIndex.getFace(face))
+                current.push_back(indexIDs[v]);
             LOGF_INFO("Align: current face is {%d, %d, %d}", PointSetMap->at(current[0]).index,
                       PointSetMap->at(current[1]).index, PointSetMap->at(current[2]).index);
-            return current;
         }
-        it++;
+        currentFaceIndex = face;
+        return current;
     }
     if (current.size() > 0)
         LOG_INFO("Align: current face is empty");
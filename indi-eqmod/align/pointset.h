@@ -18,6 +18,7 @@
 #pragma once
 
 #include "htm.h"
+#include "spatialindex.h"
 
 #include <map>
 #include <set>
@@ -74,6 +75,7 @@ class PointSet
         void setTriangulationBlobData(IBLOB *blob);
         std::set<Distance, bool (*)(Distance, Distance)> *ComputeDistances(double alt, double az, PointFilter filter,
                 bool ingoto);
+        Point *getNearestPoint(double alt, double az, bool ingoto);
         std::vector<HtmID> findFace(double currentRA, double currentDEC, double jd, double pointalt, double pointaz,
                                     INDI::IGeographicCoordinates *position, bool ingoto);
         double lat, lon, alt;
@@ -89,8 +91,15 @@ class PointSet
         std::map<HtmID, Point> *PointSetMap;
         bool PointSetInitialized;
         TriangulateCHull *Triangulation;
-        Face *currentFace;
         std::vector<HtmID> current;
+        // lookup structures, rebuilt after the point set changed
+        void BuildIndex();
+        bool indexValid { false };
+        std::vector<HtmID> indexIDs;
+        std::vector<UnitVector> celestialVectors, telescopeVectors;
+        PointIndex celestialIndex, telescopeIndex;
+        FaceIndex faceIndex;
+        int currentFaceIndex { -1 };
         // to get access to lat/long data
         INDI::Telescope *telescope;
         // from align data file
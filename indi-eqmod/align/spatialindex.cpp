@@ -0,0 +1,241 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <map>
+#include <utility>
+
+static double distance2(const UnitVector &a, const UnitVector &b)
+{
+    double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/* p . (a x b), as PointSet::scalarTripleProduct() */
+static double triple(const UnitVector &p, const UnitVector &a, const UnitVector &b)
+{
+    return (p[0] * a[1] * b[2]) + (p[2] * a[0] * b[1]) + (p[1] * a[2] * b[0]) - (p[2] * a[1] * b[0]) -
+           (p[0] * a[2] * b[1]) - (p[1] * a[0] * b[2]);
+}
+
+void PointIndex::Clear()
+{
+    points.clear();
+    nodes.clear();
+    root = -1;
+}
+
+void PointIndex::Build(const std::vector<UnitVector> &p)
+{
+    Clear();
+    points = p;
+    nodes.reserve(points.size());
+    std::vector<int> order(points.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = static_cast<int>(i);
+    root = BuildNode(order, 0, static_cast<int>(order.size()));
+}
+
+int PointIndex::BuildNode(std::vector<int> &order, int first, int last)
+{
+    if (first >= last)
+        return -1;
+
+    // Split along the axis with the largest spread
+    UnitVector lo = points[order[first]], hi = lo;
+    for (int i = first + 1; i < last; i++)
+        for (int a = 0; a < 3; a++)
+        {
+            lo[a] = std::min(lo[a], points[order[i]][a]);
+            hi[a] = std::max(hi[a], points[order[i]][a]);
+        }
+    int axis = 0;
+    for (int a = 1; a < 3; a++)
+        if (hi[a] - lo[a] > hi[axis] - lo[axis])
+            axis = a;
+
+    int mid = first + (last - first) / 2;
+    std::nth_element(order.begin() + first, order.begin() + mid, order.begin() + last, [&](int a, int b)
+    {
+        return points[a][axis] < points[b][axis];
+    });
+
+    int node = static_cast<int>(nodes.size());
+    nodes.push_back({ order[mid], axis, -1, -1 });
+    int left  = BuildNode(order, first, mid);
+    int right = BuildNode(order, mid + 1, last);
+    nodes[node].left  = left;
+    nodes[node].right = right;
+    return node;
+}
+
+void PointIndex::Search(int node, const UnitVector &p, int *best, double *bestd) const
+{
+    if (node < 0)
+        return;
+    const Node &n = nodes[node];
+    double d      = distance2(p, points[n.point]);
+    if (d < *bestd || (d == *bestd && n.point < *best))
+    {
+        *bestd = d;
+        *best  = n.point;
+    }
+    double delta = p[n.axis] - points[n.point][n.axis];
+    int nearside = (delta < 0) ? n.left : n.right;
+    int farside  = (delta < 0) ? n.right : n.left;
+    Search(nearside, p, best, bestd);
+    // Equal distances are still visited for the lowest index tie break
+    if (delta * delta <= *bestd)
+        Search(farside, p, best, bestd);
+}
+
+int PointIndex::Nearest(const UnitVector &p) const
+{
+    int best     = -1;
+    double bestd = 5.0; // more than the largest chord squared
+    Search(root, p, &best, &bestd);
+    return best;
+}
+
+void FaceIndex::Clear()
+{
+    faces.clear();
+    neighbours.clear();
+    vertexface.clear();
+}
+
+void FaceIndex::Build(const std::vector<Triangle> &f, int nbvertices)
+{
+    std::map<std::pair<int, int>, std::pair<int, int>> edges;
+
+    Clear();
+    faces = f;
+    neighbours.assign(faces.size(), Triangle { { -1, -1, -1 } });
+    vertexface.assign(nbvertices, -1);
+    for (size_t i = 0; i < faces.size(); i++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            int a = faces[i][k], b = faces[i][(k + 1) % 3];
+            if (a >= 0 && a < nbvertices && vertexface[a] < 0)
+                vertexface[a] = static_cast<int>(i);
+            std::pair<int, int> key(std::min(a, b), std::max(a, b));
+            auto it = edges.find(key);
+            if (it == edges.end())
+            {
+                edges[key] = std::make_pair(static_cast<int>(i), k);
+            }
+            else
+            {
+                neighbours[i][k]                             = it->second.first;
+                neighbours[it->second.first][it->second.second] = static_cast<int>(i);
+                edges.erase(it);
+            }
+        }
+    }
+}
+
+int FaceIndex::FaceOf(int vertex) const
+{
+    if (vertex < 0 || vertex >= static_cast<int>(vertexface.size()))
+        return -1;
+    return vertexface[vertex];
+}
+
+bool FaceIndex::Contains(const UnitVector &p, const UnitVector &v0, const UnitVector &v1, const UnitVector &v2)
+{
+    bool left = false, right = false;
+    double r  = triple(p, v2, v0);
+    if (r < 0)
+        left = true;
+    else
+        right = true;
+    r = triple(p, v0, v1);
+    if (r < 0)
+        left = true;
+    else
+        right = true;
+    if (left && right)
+        return false;
+    r = triple(p, v1, v2);
+    if (r < 0)
+        left = true;
+    else
+        right = true;
+    return !(left && right);
+}
+
+int FaceIndex::Scan(const UnitVector &p, const std::vector<UnitVector> &vertices, int *steps) const
+{
+    for (size_t i = 0; i < faces.size(); i++)
+    {
+        if (steps)
+            (*steps)++;
+        if (Contains(p, vertices[faces[i][0]], vertices[faces[i][1]], vertices[faces[i][2]]))
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int FaceIndex::Locate(const UnitVector &p, const std::vector<UnitVector> &vertices, int start, int *steps) const
+{
+    if (steps)
+        *steps = 0;
+    if (faces.empty())
+        return -1;
+    if (start < 0 || start >= static_cast<int>(faces.size()))
+        start = 0;
+
+    int f = start;
+    for (size_t n = 0; n < faces.size(); n++)
+    {
+        const UnitVector &v0 = vertices[faces[f][0]];
+        const UnitVector &v1 = vertices[faces[f][1]];
+        const UnitVector &v2 = vertices[faces[f][2]];
+        if (steps)
+            (*steps)++;
+        if (Contains(p, v0, v1, v2))
+            return f;
+
+        // Leave through the edge p is farthest beyond, the inside of edge k has r[k] * orientation > 0
+        double orientation = triple(v0, v1, v2);
+        double r[3]        = { triple(p, v0, v1), triple(p, v1, v2), triple(p, v2, v0) };
+        int exit           = -1;
+        double worst       = 0.0;
+        for (int k = 0; k < 3; k++)
+        {
+            if (r[k] * orientation < worst)
+            {
+                worst = r[k] * orientation;
+                exit  = k;
+            }
+        }
+        if (exit < 0)
+            break; // degenerate face
+        if (neighbours[f][exit] < 0)
+        {
+            // Beyond the border. The triangulated area is the convex hull of the points seen from
+            // the origin, so p is outside.
+            return -1;
+        }
+        f = neighbours[f][exit];
+    }
+
+    // Walked in circles, can happen on badly shaped faces
+    return Scan(p, vertices, steps);
+}
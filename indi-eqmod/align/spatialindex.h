@@ -0,0 +1,83 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+/* Lookup structures for the alignment points, kept by PointSet between two changes of the point set.
+   They work on unit vectors, no INDI dependency so they can be tested and benchmarked on their own. */
+
+typedef std::array<double, 3> UnitVector;
+
+/* Nearest point queries with a k-d tree. On the unit sphere the chord length grows with the
+   great circle distance, so the nearest vector in 3D is also the nearest point on the sky. */
+class PointIndex
+{
+  public:
+    void Build(const std::vector<UnitVector> &points);
+    void Clear();
+    /* Index of the point nearest to p in the vector given to Build(), -1 if empty.
+       Of equally distant points the lowest index is returned. */
+    int Nearest(const UnitVector &p) const;
+    int size() const { return static_cast<int>(points.size()); }
+
+  private:
+    typedef struct Node
+    {
+        int point;
+        int axis;
+        int left, right;
+    } Node;
+    int BuildNode(std::vector<int> &order, int first, int last);
+    void Search(int node, const UnitVector &p, int *best, double *bestd) const;
+
+    std::vector<UnitVector> points;
+    std::vector<Node> nodes;
+    int root { -1 };
+};
+
+/* Point location in the alignment triangulation. The faces are linked to their neighbours and
+   a lookup walks from the face of the previous lookup towards the point, which is a few steps
+   while the mount tracks or slews instead of a scan of all faces. */
+class FaceIndex
+{
+  public:
+    typedef std::array<int, 3> Triangle;
+
+    void Build(const std::vector<Triangle> &faces, int nbvertices);
+    void Clear();
+    int size() const { return static_cast<int>(faces.size()); }
+    const Triangle &getFace(int face) const { return faces[face]; }
+    /* A face using vertex, -1 if none */
+    int FaceOf(int vertex) const;
+    /* Face containing p, -1 if the walk leaves the triangulation. vertices may be the telescope
+       instead of the celestial positions the triangulation was made with, if the walk goes in circles
+       on such faces it falls back to a scan of all faces.
+       steps returns the number of faces tested, for the benchmark. */
+    int Locate(const UnitVector &p, const std::vector<UnitVector> &vertices, int start, int *steps = nullptr) const;
+    /* Same test as PointSet::isPointInside(): p is on the same side of the three edges */
+    static bool Contains(const UnitVector &p, const UnitVector &v0, const UnitVector &v1, const UnitVector &v2);
+
+  private:
+    int Scan(const UnitVector &p, const std::vector<UnitVector> &vertices, int *steps) const;
+
+    std::vector<Triangle> faces;
+    /* neighbours[f][k] shares the edge from vertex k to vertex k + 1 of face f, -1 on the border */
+    std::vector<Triangle> neighbours;
+    std::vector<int> vertexface;
+};
@@ -0,0 +1,264 @@
+/*
+    EQMod alignment lookup benchmark
+
+    Compares the nearest point and the face lookups of the EQMod alignment with the
+    previous scans of all points and faces, on synthetic point clouds triangulated like
+    TriangulateCHull does. The queries follow the mount: sidereal tracking steps with
+    a goto to a random position now and then. Every answer is checked against the scan.
+
+    Usage: align_index_benchmark [-n queries] [-g goto every n queries] [-s seed] [sizes...]
+*/
+
+#include "align/chull.h"
+#include "align/spatialindex.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <unistd.h>
+#include <vector>
+
+struct Distance
+{
+    int index;
+    double value;
+};
+
+static bool compelt(Distance d1, Distance d2)
+{
+    return d1.value < d2.value;
+}
+
+/* PointSet::ComputeDistances() as it was: haversine to every point, sorted in a new set */
+static int scanNearest(const std::vector<double> &alt, const std::vector<double> &az, double palt, double paz)
+{
+    std::set<Distance, bool (*)(Distance, Distance)> *distances = new std::set<Distance, bool (*)(Distance, Distance)>(compelt);
+    for (size_t i = 0; i < alt.size(); i++)
+    {
+        double sqrt_haversin_lat  = sin(((alt[i] - palt) / 2) * (M_PI / 180));
+        double sqrt_haversin_long = sin(((az[i] - paz) / 2) * (M_PI / 180));
+        double d = 2 * asin(sqrt((sqrt_haversin_lat * sqrt_haversin_lat) +
+                                 cos(palt * (M_PI / 180)) * cos(alt[i] * (M_PI / 180)) * (sqrt_haversin_long * sqrt_haversin_long)));
+        distances->insert({ static_cast<int>(i), d });
+    }
+    int nearest = distances->empty() ? -1 : distances->begin()->index;
+    delete distances;
+    return nearest;
+}
+
+static UnitVector unitVector(double alt, double az)
+{
+    double horangle = (-180.0 - az) * M_PI / 180.0;
+    double altangle = alt * M_PI / 180.0;
+    return UnitVector { { cos(altangle) * cos(horangle), cos(altangle) * sin(horangle), sin(altangle) } };
+}
+
+/* Convex hull with the origin, the faces not using the origin, as in TriangulateCHull::AddPoint() */
+static std::vector<FaceIndex::Triangle> triangulate(const std::vector<UnitVector> &points)
+{
+    std::vector<FaceIndex::Triangle> triangles;
+    int vnum = 0;
+
+    vertices = nullptr;
+    edges    = nullptr;
+    faces    = nullptr;
+    tVertex v = MakeNullVertex();
+    v->v[X] = v->v[Y] = v->v[Z] = 0;
+    v->vnum = vnum++;
+    for (const UnitVector &p : points)
+    {
+        v       = MakeNullVertex();
+        v->v[X] = static_cast<int>(p[0] * 1000000);
+        v->v[Y] = static_cast<int>(p[1] * 1000000);
+        v->v[Z] = static_cast<int>(p[2] * 1000000);
+        v->vnum = vnum++;
+        if (vnum == 4)
+        {
+            DoubleTriangle();
+            ConstructHull();
+        }
+        else if (vnum > 4)
+        {
+            tVertex vnext = v->next;
+            AddOne(v);
+            CleanUp(&vnext);
+        }
+    }
+
+    tFace f = faces;
+    do
+    {
+        if (f->vertex[0]->vnum != 0 && f->vertex[1]->vnum != 0 && f->vertex[2]->vnum != 0)
+            triangles.push_back(FaceIndex::Triangle { { f->vertex[0]->vnum - 1, f->vertex[1]->vnum - 1, f->vertex[2]->vnum - 1 } });
+        f = f->next;
+    } while (f != faces);
+    return triangles;
+}
+
+static double elapsed_us(std::chrono::steady_clock::time_point start, int n)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / n;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-n queries] [-g goto every n queries] [-s seed] [sizes...]\n", name);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    int nqueries = 20000, gotoevery = 500;
+    unsigned seed = 1;
+    std::vector<int> sizes;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:g:s:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                nqueries = atoi(optarg);
+                break;
+            case 'g':
+                gotoevery = atoi(optarg);
+                break;
+            case 's':
+                seed = strtoul(optarg, nullptr, 0);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    for (int i = optind; i < argc; i++)
+        sizes.push_back(atoi(argv[i]));
+    if (sizes.empty())
+        sizes = { 20, 100, 300, 1000 };
+    if (nqueries <= 0 || gotoevery <= 0)
+        usage(argv[0]);
+
+    printf("%6s %6s | %12s %12s | %12s %12s %8s\n", "points", "faces", "nearest old", "new", "face old", "new",
+           "steps");
+    int errors = 0;
+    for (int size : sizes)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        // Uniform over the sky above 15 degrees, as plate solving runs would pick them
+        auto randomAltAz = [&](double * palt, double * paz)
+        {
+            *palt = asin(sin(15.0 * M_PI / 180.0) + uniform(gen) * (1.0 - sin(15.0 * M_PI / 180.0))) * 180.0 / M_PI;
+            *paz  = uniform(gen) * 360.0;
+        };
+
+        std::vector<double> alt(size), az(size);
+        std::vector<UnitVector> points(size);
+        for (int i = 0; i < size; i++)
+        {
+            randomAltAz(&alt[i], &az[i]);
+            points[i] = unitVector(alt[i], az[i]);
+        }
+        std::vector<FaceIndex::Triangle> triangles = triangulate(points);
+
+        auto start = std::chrono::steady_clock::now();
+        PointIndex pointindex;
+        FaceIndex faceindex;
+        pointindex.Build(points);
+        faceindex.Build(triangles, size);
+        double build_us = elapsed_us(start, 1);
+
+        // The mount path: tracking steps of 0.01 degree in azimuth, gotos to random positions
+        std::vector<double> qalt(nqueries), qaz(nqueries);
+        std::vector<UnitVector> queries(nqueries);
+        double palt = 0, paz = 0;
+        for (int i = 0; i < nqueries; i++)
+        {
+            if (i % gotoevery == 0)
+                randomAltAz(&palt, &paz);
+            else
+                paz = fmod(paz + 0.01, 360.0);
+            qalt[i]    = palt;
+            qaz[i]     = paz;
+            queries[i] = unitVector(palt, paz);
+        }
+
+        std::vector<int> oldnearest(nqueries), oldface(nqueries), newface(nqueries);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nqueries; i++)
+            oldnearest[i] = scanNearest(alt, az, qalt[i], qaz[i]);
+        double oldnearest_us = elapsed_us(start, nqueries);
+
+        volatile int sink = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nqueries; i++)
+            sink = sink + pointindex.Nearest(queries[i]);
+        double newnearest_us = elapsed_us(start, nqueries);
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < nqueries; i++)
+        {
+            oldface[i] = -1;
+            for (size_t f = 0; f < triangles.size(); f++)
+            {
+                if (FaceIndex::Contains(queries[i], points[triangles[f][0]], points[triangles[f][1]], points[triangles[f][2]]))
+                {
+                    oldface[i] = f;
+                    break;
+                }
+            }
+        }
+        double oldface_us = elapsed_us(start, nqueries);
+
+        long totalsteps = 0;
+        int current     = -1;
+        start           = std::chrono::steady_clock::now();
+        for (int i = 0; i < nqueries; i++)
+        {
+            int steps = 0;
+            int from  = (current >= 0) ? current : faceindex.FaceOf(pointindex.Nearest(queries[i]));
+            newface[i] = faceindex.Locate(queries[i], points, from, &steps);
+            if (newface[i] >= 0)
+                current = newface[i];
+            totalsteps += steps;
+        }
+        double newface_us = elapsed_us(start, nqueries);
+
+        for (int i = 0; i < nqueries; i++)
+        {
+            int nearest = pointindex.Nearest(queries[i]);
+            double dold = (points[oldnearest[i]][0] - queries[i][0]) * (points[oldnearest[i]][0] - queries[i][0]) +
+                          (points[oldnearest[i]][1] - queries[i][1]) * (points[oldnearest[i]][1] - queries[i][1]) +
+                          (points[oldnearest[i]][2] - queries[i][2]) * (points[oldnearest[i]][2] - queries[i][2]);
+            double dnew = (points[nearest][0] - queries[i][0]) * (points[nearest][0] - queries[i][0]) +
+                          (points[nearest][1] - queries[i][1]) * (points[nearest][1] - queries[i][1]) +
+                          (points[nearest][2] - queries[i][2]) * (points[nearest][2] - queries[i][2]);
+            if (nearest != oldnearest[i] && fabs(dold - dnew) > 1e-12)
+            {
+                fprintf(stderr, "%d points, query %d: nearest point %d, scan found %d\n", size, i, nearest, oldnearest[i]);
+                errors++;
+            }
+            // On a shared edge both faces are right
+            if ((newface[i] < 0) != (oldface[i] < 0) ||
+                    (newface[i] >= 0 && !FaceIndex::Contains(queries[i], points[triangles[newface[i]][0]],
+                            points[triangles[newface[i]][1]], points[triangles[newface[i]][2]])))
+            {
+                fprintf(stderr, "%d points, query %d: face %d, scan found %d\n", size, i, newface[i], oldface[i]);
+                errors++;
+            }
+        }
+
+        printf("%6d %6zu | %9.2f us %9.2f us | %9.2f us %9.2f us %8.2f   (index built in %.0f us)\n", size,
+               triangles.size(), oldnearest_us, newnearest_us, oldface_us, newface_us,
+               static_cast<double>(totalsteps) / nqueries, build_us);
+    }
+
+    if (errors)
+    {
+        printf("%d lookups differ from the scan\n", errors);
+        return 2;
+    }
+    return 0;
+}
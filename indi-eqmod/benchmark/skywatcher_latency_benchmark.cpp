@@ -0,0 +1,207 @@
+/*
+    Skywatcher serial latency benchmark
+
+    Drives the serial code of the EQMod driver (dispatch_command, tty_write_string,
+    read_eqmod, the retries and the pipelined status queries) against the Skywatcher
+    motor board simulator on a pseudo terminal, and reports commands/s and the command
+    latency. Nothing but the line in between is simulated, so changes to the serial path
+    can be measured without a mount.
+
+    Usage: skywatcher_latency_benchmark [options]
+      -n count    queries per test, default 200
+      -b baud     line speed of the simulator, default 9600, 0 for no pacing
+      -l us       processing time per command in the simulator, default 0
+      -j us       random extra delay per reply, default 0
+      -d ratio    part of the replies the simulator drops, default 0. Every drop costs
+                  the driver a read timeout of several seconds.
+      -p device   use an already running simulator (or a mount) instead
+*/
+
+#include "eqmodbase.h"
+#include "eqmoderror.h"
+#include "simulator/pty-simulator.h"
+
+#include <indicom.h>
+#include <indilogger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+class BenchmarkEQMod : public EQMod
+{
+    public:
+        BenchmarkEQMod()
+        {
+            initProperties();
+        }
+        Skywatcher *getMount()
+        {
+            return mount;
+        }
+};
+
+typedef struct Result
+{
+    const char *name;
+    int commands;
+    std::vector<double> latency_ms;
+    int errors;
+    double total_s;
+} Result;
+
+static Result run(const char *name, int commands, int count, std::function<void()> query)
+{
+    Result result;
+    result.name     = name;
+    result.commands = commands;
+    result.errors   = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        try
+        {
+            query();
+        }
+        catch (EQModError &e)
+        {
+            fprintf(stderr, "%s: %s\n", name, e.message);
+            result.errors++;
+        }
+        result.latency_ms.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    result.total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-n count] [-b baud] [-l latency us] [-j jitter us] [-d drop ratio] [-p device]\n", name);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    SkywatcherPtySimulator::Options options = SkywatcherPtySimulator::DefaultOptions();
+    const char *device = nullptr;
+    int count          = 200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:b:l:j:d:p:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'b':
+                options.baud = strtoul(optarg, nullptr, 0);
+                break;
+            case 'l':
+                options.latency_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'j':
+                options.jitter_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'd':
+                options.drop = atof(optarg);
+                break;
+            case 'p':
+                device = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (count <= 0)
+        usage(argv[0]);
+
+    INDI::Logger::getInstance().configure("", INDI::Logger::file_off, INDI::Logger::DBG_ERROR, INDI::Logger::DBG_ERROR);
+    me = strdup("indi_eqmod_benchmark");
+
+    std::unique_ptr<SkywatcherPtySimulator> simulator;
+    if (device == nullptr)
+    {
+        simulator.reset(new SkywatcherPtySimulator(options));
+        if (!simulator->Open())
+        {
+            fprintf(stderr, "Can not create the pseudo terminal: %s\n", strerror(errno));
+            return 1;
+        }
+        simulator->Start();
+        device = simulator->getDeviceName();
+        printf("Simulator on %s, %u baud, latency %u us, jitter %u us, %.1f%% dropped\n", device, options.baud,
+               options.latency_us, options.jitter_us, options.drop * 100.0);
+    }
+
+    int fd = -1;
+    if (tty_connect(device, 9600, 8, 0, 1, &fd) != TTY_OK)
+    {
+        fprintf(stderr, "Can not open %s\n", device);
+        return 1;
+    }
+
+    BenchmarkEQMod eqmod;
+    Skywatcher *mount = eqmod.getMount();
+    std::vector<Result> results;
+    mount->setPortFD(fd);
+    try
+    {
+        mount->Handshake();
+    }
+    catch (EQModError &e)
+    {
+        fprintf(stderr, "Handshake failed: %s\n", e.message);
+        mount->setPortFD(-1);
+        return 1;
+    }
+
+    results.push_back(run("encoder query", 1, count, [&]()
+    {
+        mount->GetRAEncoder();
+    }));
+    results.push_back(run("status tick, one by one", 4, count, [&]()
+    {
+        mount->SetPipelinedQueries(false);
+        mount->ReadAxesStatus();
+    }));
+    results.push_back(run("status tick, pipelined", 4, count, [&]()
+    {
+        mount->SetPipelinedQueries(true);
+        mount->ReadAxesStatus();
+    }));
+
+    // No motor stop on the way out
+    mount->setPortFD(-1);
+    tty_disconnect(fd);
+    if (simulator)
+        simulator->Stop();
+
+    printf("\n%-26s %10s %10s %9s %9s %9s %7s\n", "", "queries/s", "cmds/s", "p50 ms", "p99 ms", "max ms", "errors");
+    for (const Result &result : results)
+    {
+        printf("%-26s %10.1f %10.1f %9.2f %9.2f %9.2f %7d\n", result.name, count / result.total_s,
+               count * result.commands / result.total_s, percentile(result.latency_ms, 0.5),
+               percentile(result.latency_ms, 0.99), percentile(result.latency_ms, 1.0), result.errors);
+    }
+    if (simulator)
+    {
+        SkywatcherPtySimulator::Stats stats = simulator->getStats();
+        printf("\nsimulator: %lu commands, %lu replies dropped\n", stats.commands, stats.dropped);
+    }
+    return 0;
+}
@@ -330,6 +330,7 @@ void EQMod::ISGetProperties(const char *dev)
         defineProperty(SyncManageSP);
         defineProperty(BacklashNP);
         defineProperty(UseBacklashSP);
+        defineProperty(PipelineQueriesSP);
         defineProperty(TrackDefaultSP);
         defineProperty(ST4GuideRateNSSP);
         defineProperty(ST4GuideRateWESP);
@@ -420,6 +421,7 @@ bool EQMod::loadProperties()
     SyncManageSP        = getSwitch("SYNCMANAGE");
     BacklashNP          = getNumber("BACKLASH");
     UseBacklashSP       = getSwitch("USEBACKLASH");
+    PipelineQueriesSP   = getSwitch("PIPELINEQUERIES");
     AutoHomeSP          = getSwitch("AUTOHOME");
     AuxEncoderSP        = getSwitch("AUXENCODER");
     AuxEncoderNP        = getNumber("AUXENCODERVALUES");
@@ -489,6 +491,7 @@ bool EQMod::updateProperties()
         defineProperty(SyncManageSP);
         defineProperty(BacklashNP);
         defineProperty(UseBacklashSP);
+        defineProperty(PipelineQueriesSP);
         defineProperty(TrackDefaultSP);
         defineProperty(ST4GuideRateNSSP);
         defineProperty(ST4GuideRateWESP);
@@ -579,6 +582,7 @@ bool EQMod::updateProperties()
             mount->SetBacklashUseDE((IUFindSwitch(UseBacklashSP, "USEBACKLASHDE")->s == ISS_ON ? true : false));
             mount->SetBacklashRA((uint32_t)(IUFindNumber(BacklashNP, "BACKLASHRA")->value));
             mount->SetBacklashDE((uint32_t)(IUFindNumber(BacklashNP, "BACKLASHDE")->value));
+            mount->SetPipelinedQueries(IUFindSwitch(PipelineQueriesSP, "PIPELINEQUERIES_ON")->s == ISS_ON);
 
             if (mount->HasSnapPort1())
             {
@@ -647,6 +651,7 @@ bool EQMod::updateProperties()
         deleteProperty(TrackDefaultSP->name);
         deleteProperty(BacklashNP->name);
         deleteProperty(UseBacklashSP->name);
+        deleteProperty(PipelineQueriesSP->name);
         deleteProperty(ST4GuideRateNSSP->name);
         deleteProperty(ST4GuideRateWESP->name);
         deleteProperty(LEDBrightnessNP->name);
@@ -711,13 +716,17 @@ bool EQMod::Handshake()
 {
     try
     {
-        if (!getActiveConnection()->name().compare("CONNECTION_TCP")
-                && tcpConnection->connectionType() == Connection::TCP::TYPE_UDP)
+        bool udp = !getActiveConnection()->name().compare("CONNECTION_TCP")
+                   && tcpConnection->connectionType() == Connection::TCP::TYPE_UDP;
+        if (udp)
         {
             tty_set_generic_udp_format(1);
         }
 
         mount->setPortFD(PortFD);
+        // WiFi mounts: requests in flight on sockets of their own, retransmitted on loss
+        if (udp && !isSimulation())
+            mount->SetUDPTransport(true);
         mount->Handshake();
         // Mount initialisation is in updateProperties as it sets directly Indi properties which should be defined
     }
@@ -853,8 +862,10 @@ bool EQMod::ReadScopeStatus()
     try
     {
         TelescopePierSide pierSide;
-        currentRAEncoder = mount->GetRAEncoder();
-        currentDEEncoder = mount->GetDEEncoder();
+        // Positions and motor status of both axes in one go, the rest of the tick uses these.
+        mount->ReadAxesStatus();
+        currentRAEncoder = mount->GetRAEncoder(false);
+        currentDEEncoder = mount->GetDEEncoder(false);
         DEBUGF(DBG_SCOPE_STATUS, "Current encoders RA=%ld DE=%ld", static_cast<long>(currentRAEncoder),
                static_cast<long>(currentDEEncoder));
         EncodersToRADec(currentRAEncoder, currentDEEncoder, lst, &currentRA, &currentDEC, &currentHA, &pierSide);
@@ -950,8 +961,8 @@ bool EQMod::ReadScopeStatus()
         IUUpdateNumber(CurrentSteppersNP, steppervalues, (char **)steppernames, 2);
         IDSetNumber(CurrentSteppersNP, nullptr);
 
-        mount->GetRAMotorStatus(RAStatusLP);
-        mount->GetDEMotorStatus(DEStatusLP);
+        mount->GetRAMotorStatus(RAStatusLP, false);
+        mount->GetDEMotorStatus(DEStatusLP, false);
         IDSetLight(RAStatusLP, nullptr);
         IDSetLight(DEStatusLP, nullptr);
 
@@ -2738,6 +2749,17 @@ bool EQMod::ISNewSwitch(const char *dev, const char *name, ISState *states, char
             return true;
         }
 
+        if (strcmp(name, "PIPELINEQUERIES") == 0)
+        {
+            IUUpdateSwitch(PipelineQueriesSP, states, names, n);
+            bool enable = IUFindSwitch(PipelineQueriesSP, "PIPELINEQUERIES_ON")->s == ISS_ON;
+            mount->SetPipelinedQueries(enable);
+            LOGF_INFO("Pipelined status queries %s.", enable ? "enabled" : "disabled");
+            PipelineQueriesSP->s = IPS_IDLE;
+            IDSetSwitch(PipelineQueriesSP, nullptr);
+            return true;
+        }
+
         if (strcmp(name, "TRACKDEFAULT") == 0)
         {
             ISwitch *swbefore, *swafter;
@@ -3768,6 +3790,8 @@ bool EQMod::saveConfigItems(FILE *fp)
         IUSaveConfigNumber(fp, BacklashNP);
     if (UseBacklashSP)
         IUSaveConfigSwitch(fp, UseBacklashSP);
+    if (PipelineQueriesSP)
+        IUSaveConfigSwitch(fp, PipelineQueriesSP);
     if (GuideRateNP)
         IUSaveConfigNumber(fp, GuideRateNP);
     if (PulseLimitsNP)
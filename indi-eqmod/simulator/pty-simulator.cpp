@@ -0,0 +1,212 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pty-simulator.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+static const int MAX_CMD = 32;
+
+SkywatcherPtySimulator::Options SkywatcherPtySimulator::DefaultOptions()
+{
+    Options options;
+    options.mount      = "EQ6";
+    options.baud       = 9600;
+    options.latency_us = 0;
+    options.jitter_us  = 0;
+    options.drop       = 0.0;
+    options.seed       = 1;
+    return options;
+}
+
+SkywatcherPtySimulator::SkywatcherPtySimulator(const Options &o) : options(o), gen(o.seed)
+{
+    if (!sksim.setupMount(options.mount))
+        sksim.setupMount("EQ6");
+}
+
+SkywatcherPtySimulator::~SkywatcherPtySimulator()
+{
+    Stop();
+    Close();
+}
+
+bool SkywatcherPtySimulator::Open(const char *linkname)
+{
+    struct termios tty;
+
+    Close();
+    if ((masterfd = posix_openpt(O_RDWR | O_NOCTTY)) < 0)
+        return false;
+    if (grantpt(masterfd) < 0 || unlockpt(masterfd) < 0)
+    {
+        Close();
+        return false;
+    }
+    device = ptsname(masterfd);
+
+    // Keep the slave side open, else reading the master fails while the driver is not connected
+    if ((slavefd = open(device.c_str(), O_RDWR | O_NOCTTY)) < 0)
+    {
+        Close();
+        return false;
+    }
+    tcgetattr(slavefd, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slavefd, TCSANOW, &tty);
+
+    if (linkname)
+    {
+        unlink(linkname);
+        if (symlink(device.c_str(), linkname) < 0)
+        {
+            Close();
+            return false;
+        }
+        link = linkname;
+    }
+    rxfree = txfree = Clock::now();
+    return true;
+}
+
+void SkywatcherPtySimulator::Close()
+{
+    if (!link.empty())
+        unlink(link.c_str());
+    link.clear();
+    if (slavefd >= 0)
+        close(slavefd);
+    if (masterfd >= 0)
+        close(masterfd);
+    slavefd = masterfd = -1;
+}
+
+SkywatcherPtySimulator::Clock::duration SkywatcherPtySimulator::lineTime(int bytes) const
+{
+    if (options.baud == 0)
+        return Clock::duration::zero();
+    // start bit, 8 data bits, stop bit
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(10LL * bytes * 1000000000LL /
+            options.baud));
+}
+
+void SkywatcherPtySimulator::handleCommand(const char *cmd)
+{
+    char reply[32];
+    int received = 0, replylen = 0;
+
+    sksim.process_command(cmd, &received);
+    sksim.get_reply(reply, &replylen);
+    commands++;
+
+    std::uniform_real_distribution<double> dropdist(0.0, 1.0);
+    if (options.drop > 0.0 && dropdist(gen) < options.drop)
+    {
+        dropped++;
+        return;
+    }
+
+    // rxfree is when the last byte of the command arrived
+    Clock::time_point done = rxfree + std::chrono::microseconds(options.latency_us);
+    if (options.jitter_us > 0)
+        done += std::chrono::microseconds(std::uniform_int_distribution<unsigned int>(0, options.jitter_us)(gen));
+    txfree = std::max(done, txfree) + lineTime(replylen);
+    std::this_thread::sleep_until(txfree);
+
+    for (int sent = 0; sent < replylen;)
+    {
+        ssize_t n = write(masterfd, reply + sent, replylen - sent);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        sent += n;
+    }
+    bytes_out += replylen;
+}
+
+void SkywatcherPtySimulator::Serve()
+{
+    char cmd[MAX_CMD] = { 0 };
+    char buf[256];
+    int len = 0;
+
+    while (!stop)
+    {
+        struct pollfd pfd;
+        pfd.fd     = masterfd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+
+        ssize_t n = read(masterfd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        // The host wrote it all at once, the bytes arrive one after the other
+        rxfree = std::max(rxfree, Clock::now());
+        for (ssize_t i = 0; i < n; i++)
+        {
+            rxfree += lineTime(1);
+            bytes_in++;
+            if (len < MAX_CMD - 1)
+                cmd[len++] = buf[i];
+            if (buf[i] == '\r')
+            {
+                cmd[len] = '\0';
+                handleCommand(cmd);
+                len = 0;
+            }
+        }
+    }
+}
+
+void SkywatcherPtySimulator::Start()
+{
+    Stop();
+    stop   = false;
+    thread = std::thread(&SkywatcherPtySimulator::Serve, this);
+}
+
+void SkywatcherPtySimulator::Stop()
+{
+    stop = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+SkywatcherPtySimulator::Stats SkywatcherPtySimulator::getStats() const
+{
+    Stats stats;
+    stats.commands  = commands;
+    stats.dropped   = dropped;
+    stats.bytes_in  = bytes_in;
+    stats.bytes_out = bytes_out;
+    return stats;
+}
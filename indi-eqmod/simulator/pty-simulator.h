@@ -0,0 +1,93 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "skywatcher-simulator.h"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+/* Serves the Skywatcher motor protocol of SkywatcherSimulator on a pseudo terminal, so the
+   driver goes through its real serial code: tty_write_string(), read_eqmod(), the retries.
+   The line is paced like a UART at the given baud rate, with a processing delay, jitter and
+   dropped replies to look like a real motor board on a USB serial adapter. */
+class SkywatcherPtySimulator
+{
+  public:
+    typedef struct Options
+    {
+        const char *mount;          // EQ6, HEQ5, NEQ5, NEQ3 or GEEHALEL
+        unsigned int baud;          // 0 for no pacing
+        unsigned int latency_us;    // time the board needs per command
+        unsigned int jitter_us;     // random extra delay, 0 to jitter_us
+        double drop;                // probability that a reply is not sent
+        unsigned int seed;
+    } Options;
+
+    typedef struct Stats
+    {
+        unsigned long commands;
+        unsigned long dropped;
+        unsigned long bytes_in;
+        unsigned long bytes_out;
+    } Stats;
+
+    static Options DefaultOptions();
+
+    explicit SkywatcherPtySimulator(const Options &options);
+    ~SkywatcherPtySimulator();
+
+    /* Create the pseudo terminal, with a symlink to it if link is not null.
+       Returns false if it could not be created, errno tells why. */
+    bool Open(const char *link = nullptr);
+    void Close();
+    /* Path of the terminal the driver opens */
+    const char *getDeviceName() const { return device.c_str(); }
+
+    /* Serve until Stop(), in the calling thread or in a thread of its own */
+    void Serve();
+    void Start();
+    void Stop();
+
+    Stats getStats() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    void handleCommand(const char *cmd);
+    Clock::duration lineTime(int bytes) const;
+
+    Options options;
+    SkywatcherSimulator sksim;
+    int masterfd { -1 };
+    int slavefd { -1 };
+    std::string device;
+    std::string link;
+
+    std::thread thread;
+    std::atomic<bool> stop { false };
+    std::mt19937 gen;
+
+    /* Time at which the command being read started to arrive, and at which the line to the
+       host is free again */
+    Clock::time_point rxfree, txfree;
+
+    std::atomic<unsigned long> commands { 0 }, dropped { 0 }, bytes_in { 0 }, bytes_out { 0 };
+};
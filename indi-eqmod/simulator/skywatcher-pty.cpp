@@ -0,0 +1,150 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Skywatcher motor board on a pseudo terminal. Point the driver port at the printed device
+   (or at the -L link) and connect, the driver does not need to be in simulation mode.
+   With -u it is a WiFi mount instead, connect the AZ-GTi driver to that UDP port.
+
+   Usage: indi_eqmod_pty_simulator [options]
+     -m mount    EQ6 (default), HEQ5, NEQ5, NEQ3 or GEEHALEL
+     -b baud     line speed to pace the bytes at, default 9600, 0 for no pacing
+     -l us       processing time per command, default 0
+     -j us       random extra delay per reply, 0 to us, default 0
+     -d ratio    part of the replies that are dropped, default 0
+     -s seed     seed for the jitter and the drops
+     -L path     symlink to the device, e.g. /tmp/ttyEQMod
+     -u port     serve UDP on port, e.g. 11880, instead of the pseudo terminal. -d then
+                 drops datagrams both ways, -j reorders the replies, -b is ignored
+*/
+
+#include "pty-simulator.h"
+#include "udp-simulator.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static SkywatcherPtySimulator *simulator = nullptr;
+static SkywatcherUdpSimulator *udpsimulator = nullptr;
+
+static void stop(int)
+{
+    if (simulator)
+        simulator->Stop();
+    if (udpsimulator)
+        udpsimulator->Stop();
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-m mount] [-b baud] [-l latency us] [-j jitter us] [-d drop ratio] [-s seed] [-L link] [-u port]\n",
+            name);
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    SkywatcherPtySimulator::Options options = SkywatcherPtySimulator::DefaultOptions();
+    const char *link = nullptr;
+    int udpport      = -1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:b:l:j:d:s:L:u:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm':
+                options.mount = optarg;
+                break;
+            case 'b':
+                options.baud = strtoul(optarg, nullptr, 0);
+                break;
+            case 'l':
+                options.latency_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'j':
+                options.jitter_us = strtoul(optarg, nullptr, 0);
+                break;
+            case 'd':
+                options.drop = atof(optarg);
+                break;
+            case 's':
+                options.seed = strtoul(optarg, nullptr, 0);
+                break;
+            case 'L':
+                link = optarg;
+                break;
+            case 'u':
+                udpport = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (udpport >= 0)
+    {
+        SkywatcherUdpSimulator::Options udpoptions = SkywatcherUdpSimulator::DefaultOptions();
+        udpoptions.mount      = options.mount;
+        udpoptions.latency_us = options.latency_us;
+        udpoptions.jitter_us  = options.jitter_us;
+        udpoptions.drop       = options.drop;
+        udpoptions.seed       = options.seed;
+
+        SkywatcherUdpSimulator sim(udpoptions);
+        if (!sim.Open(udpport, false))
+        {
+            fprintf(stderr, "Can not bind UDP port %d: %s\n", udpport, strerror(errno));
+            return 1;
+        }
+        printf("%s mount on UDP port %u, latency %u us, jitter %u us, %.1f%% datagrams dropped\n", udpoptions.mount,
+               sim.getPort(), udpoptions.latency_us, udpoptions.jitter_us, udpoptions.drop * 100.0);
+        fflush(stdout);
+
+        udpsimulator = &sim;
+        signal(SIGINT, stop);
+        signal(SIGTERM, stop);
+        sim.Serve();
+
+        SkywatcherUdpSimulator::Stats stats = sim.getStats();
+        printf("%lu commands, %lu datagrams dropped\n", stats.commands, stats.dropped);
+        return 0;
+    }
+
+    SkywatcherPtySimulator sim(options);
+    if (!sim.Open(link))
+    {
+        fprintf(stderr, "Can not create the pseudo terminal: %s\n", strerror(errno));
+        return 1;
+    }
+    printf("%s mount on %s%s%s, %u baud, latency %u us, jitter %u us, %.1f%% dropped\n", options.mount,
+           sim.getDeviceName(), link ? " -> " : "", link ? link : "", options.baud, options.latency_us, options.jitter_us,
+           options.drop * 100.0);
+    fflush(stdout);
+
+    simulator = &sim;
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    sim.Serve();
+
+    SkywatcherPtySimulator::Stats stats = sim.getStats();
+    printf("%lu commands, %lu replies dropped, %lu bytes in, %lu bytes out\n", stats.commands, stats.dropped,
+           stats.bytes_in, stats.bytes_out);
+    return 0;
+}
@@ -6,6 +6,44 @@
 #include <string.h>
 #include <stdint.h>
 
+/* Same mounts as the simulation mode of the driver, see EQModSimulator::Connect() */
+bool SkywatcherSimulator::setupMount(const char *mount)
+{
+    if (!strcmp(mount, "EQ6"))
+    {
+        setupVersion("020300");
+        setupRA(180, 47, 12, 200, 64, 2);
+        setupDE(180, 47, 12, 200, 64, 2);
+    }
+    else if (!strcmp(mount, "HEQ5"))
+    {
+        setupVersion("020301");
+        setupRA(135, 47, 9, 200, 64, 2);
+        setupDE(135, 47, 9, 200, 64, 2);
+    }
+    else if (!strcmp(mount, "NEQ5"))
+    {
+        setupVersion("020302");
+        setupRA(144, 44, 9, 200, 32, 2);
+        setupDE(144, 44, 9, 200, 32, 2);
+    }
+    else if (!strcmp(mount, "NEQ3"))
+    {
+        setupVersion("020303");
+        setupRA(130, 55, 10, 200, 32, 2);
+        setupDE(130, 55, 10, 200, 32, 2);
+    }
+    else if (!strcmp(mount, "GEEHALEL"))
+    {
+        setupVersion("0203F0");
+        setupRA(144, 60, 15, 400, 8, 1);
+        setupDE(144, 60, 10, 400, 8, 1);
+    }
+    else
+        return false;
+    return true;
+}
+
 void SkywatcherSimulator::send_byte(unsigned char c)
 {
     reply[replyindex++] = c;
@@ -37,6 +37,8 @@
 class SkywatcherSimulator
 {
   public:
+    /* EQ6, HEQ5, NEQ5, NEQ3 or GEEHALEL, false for an unknown mount */
+    bool setupMount(const char *mount);
     void setupVersion(const char *mcversion);
     void setupRA(unsigned int nb_teeth, unsigned int gear_ratio_num, unsigned int gear_ratio_den, unsigned int nb_steps,
                  unsigned int nb_microsteps, unsigned int highspeed);
@@ -0,0 +1,166 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "udp-simulator.h"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const int MAX_CMD = 32;
+
+SkywatcherUdpSimulator::Options SkywatcherUdpSimulator::DefaultOptions()
+{
+    Options options;
+    options.mount      = "EQ6";
+    options.latency_us = 0;
+    options.jitter_us  = 0;
+    options.drop       = 0.0;
+    options.seed       = 1;
+    return options;
+}
+
+SkywatcherUdpSimulator::SkywatcherUdpSimulator(const Options &o) : options(o), gen(o.seed)
+{
+    if (!sksim.setupMount(options.mount))
+        sksim.setupMount("EQ6");
+}
+
+SkywatcherUdpSimulator::~SkywatcherUdpSimulator()
+{
+    Stop();
+    Close();
+}
+
+bool SkywatcherUdpSimulator::Open(unsigned short p, bool loopback)
+{
+    struct sockaddr_in addr;
+    socklen_t addrlen = sizeof(addr);
+
+    Close();
+    if ((fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0)) < 0)
+        return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(p);
+    addr.sin_addr.s_addr = htonl(loopback ? INADDR_LOOPBACK : INADDR_ANY);
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 ||
+            getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &addrlen) < 0)
+    {
+        int err = errno;
+        Close();
+        errno = err;
+        return false;
+    }
+    port = ntohs(addr.sin_port);
+    return true;
+}
+
+void SkywatcherUdpSimulator::Close()
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    replies.clear();
+}
+
+bool SkywatcherUdpSimulator::lost()
+{
+    std::uniform_real_distribution<double> dropdist(0.0, 1.0);
+    if (options.drop > 0.0 && dropdist(gen) < options.drop)
+    {
+        dropped++;
+        return true;
+    }
+    return false;
+}
+
+void SkywatcherUdpSimulator::Serve()
+{
+    while (!stop)
+    {
+        // Wake up for the next reply due, at the latest every 100ms to look at stop
+        int timeout = 100;
+        if (!replies.empty())
+            timeout = std::min<long>(timeout, std::max<long>(0, std::chrono::duration_cast<std::chrono::milliseconds>
+                                     (replies.begin()->first - Clock::now()).count()));
+
+        struct pollfd pfd;
+        pfd.fd     = fd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, timeout) > 0)
+        {
+            char cmd[MAX_CMD];
+            struct sockaddr_in from;
+            socklen_t fromlen = sizeof(from);
+            ssize_t n = recvfrom(fd, cmd, sizeof(cmd) - 1, 0, reinterpret_cast<struct sockaddr *>(&from), &fromlen);
+            if (n > 0 && !lost())
+            {
+                char reply[MAX_CMD];
+                int received = 0, replylen = 0;
+
+                cmd[n] = '\0';
+                sksim.process_command(cmd, &received);
+                sksim.get_reply(reply, &replylen);
+                commands++;
+
+                if (!lost())
+                {
+                    Clock::time_point due = Clock::now() + std::chrono::microseconds(options.latency_us);
+                    if (options.jitter_us > 0)
+                        due += std::chrono::microseconds(std::uniform_int_distribution<unsigned int>(0, options.jitter_us)(gen));
+                    replies.insert(std::make_pair(due, Reply { from, std::string(reply, replylen) }));
+                }
+            }
+        }
+
+        Clock::time_point now = Clock::now();
+        while (!replies.empty() && replies.begin()->first <= now)
+        {
+            const Reply &reply = replies.begin()->second;
+            sendto(fd, reply.data.data(), reply.data.size(), 0, reinterpret_cast<const struct sockaddr *>(&reply.to),
+                   sizeof(reply.to));
+            replies.erase(replies.begin());
+        }
+    }
+}
+
+void SkywatcherUdpSimulator::Start()
+{
+    Stop();
+    stop   = false;
+    thread = std::thread(&SkywatcherUdpSimulator::Serve, this);
+}
+
+void SkywatcherUdpSimulator::Stop()
+{
+    stop = true;
+    if (thread.joinable())
+        thread.join();
+}
+
+SkywatcherUdpSimulator::Stats SkywatcherUdpSimulator::getStats() const
+{
+    Stats stats;
+    stats.commands = commands;
+    stats.dropped  = dropped;
+    return stats;
+}
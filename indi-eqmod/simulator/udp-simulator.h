@@ -0,0 +1,92 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "skywatcher-simulator.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+
+/* Serves the Skywatcher motor protocol of SkywatcherSimulator on a UDP port, one command per
+   datagram and the reply to the sender, like the AZ-GTi on port 11880. The network is lossy
+   on request: datagrams are dropped both ways and the replies are delayed by a random amount,
+   so they can come back out of order. */
+class SkywatcherUdpSimulator
+{
+  public:
+    typedef struct Options
+    {
+        const char *mount;          // EQ6, HEQ5, NEQ5, NEQ3 or GEEHALEL
+        unsigned int latency_us;    // time the mount needs per command
+        unsigned int jitter_us;     // random extra delay, 0 to jitter_us
+        double drop;                // probability that a datagram is lost, each way
+        unsigned int seed;
+    } Options;
+
+    typedef struct Stats
+    {
+        unsigned long commands;
+        unsigned long dropped;      // requests and replies
+    } Stats;
+
+    static Options DefaultOptions();
+
+    explicit SkywatcherUdpSimulator(const Options &options);
+    ~SkywatcherUdpSimulator();
+
+    /* Bind to port on the loopback interface, or on all of them. Port 0 picks a free one,
+       see getPort(). Returns false if the socket could not be bound, errno tells why. */
+    bool Open(unsigned short port = 0, bool loopback = true);
+    void Close();
+    unsigned short getPort() const { return port; }
+
+    /* Serve until Stop(), in the calling thread or in a thread of its own */
+    void Serve();
+    void Start();
+    void Stop();
+
+    Stats getStats() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    typedef struct Reply
+    {
+        struct sockaddr_in to;
+        std::string data;
+    } Reply;
+
+    bool lost();
+
+    Options options;
+    SkywatcherSimulator sksim;
+    int fd { -1 };
+    unsigned short port { 0 };
+
+    std::thread thread;
+    std::atomic<bool> stop { false };
+    std::mt19937 gen;
+    std::multimap<Clock::time_point, Reply> replies;
+
+    std::atomic<unsigned long> commands { 0 }, dropped { 0 };
+};
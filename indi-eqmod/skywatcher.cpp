@@ -22,8 +22,12 @@
 #include <indicom.h>
 
 #include <termios.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
 #include <cmath>
 #include <cstring>
+#include <vector>
 
 Skywatcher::Skywatcher(EQMod *t)
 {
@@ -50,6 +54,7 @@ bool Skywatcher::isDebug()
 
 void Skywatcher::setPortFD(int value)
 {
+    udp.Close();
     PortFD = value;
 }
 
@@ -107,46 +112,90 @@ bool Skywatcher::Disconnect()
     //read_eqmod();
     }
     */
+    udp.Close();
     return true;
 }
 
-uint32_t Skywatcher::GetRAEncoder()
+uint32_t Skywatcher::GetRAEncoder(bool refresh)
 {
-    // Axis Position
-    dispatch_command(GetAxisPosition, Axis1, nullptr);
+    if (refresh)
+    {
+        // Axis Position
+        dispatch_command(GetAxisPosition, Axis1, nullptr);
+        ParseAxisPosition(Axis1, response);
+    }
+    return RAStep;
+}
+
+uint32_t Skywatcher::GetDEEncoder(bool refresh)
+{
+    if (refresh)
+    {
+        // Axis Position
+        dispatch_command(GetAxisPosition, Axis2, nullptr);
+        ParseAxisPosition(Axis2, response);
+    }
+    return DEStep;
+}
+
+void Skywatcher::ParseAxisPosition(SkywatcherAxis axis, char *reply)
+{
+    uint32_t steps = Revu24str2long(reply + 1);
+    uint32_t *step = (axis == Axis1) ? &RAStep : &DEStep;
+    uint32_t *laststep = (axis == Axis1) ? &lastRAStep : &lastDEStep;
 
-    uint32_t steps = Revu24str2long(response + 1);
     if (steps & 0x80000000)
-        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = Ignoring invalid response %s", __FUNCTION__, response);
+        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = Ignoring invalid response %s", __FUNCTION__, reply);
     else
-        RAStep = steps;
+        *step = steps;
 
-    gettimeofday(&lastreadmotorposition[Axis1], nullptr);
-    if (RAStep != lastRAStep)
+    gettimeofday(&lastreadmotorposition[axis], nullptr);
+    if (*step != *laststep)
     {
-        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = %ld", __FUNCTION__, static_cast<long>(RAStep));
-        lastRAStep = RAStep;
+        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() : Axis = %c = %ld", __FUNCTION__, AxisCmd[axis], static_cast<long>(*step));
+        *laststep = *step;
     }
-    return RAStep;
 }
 
-uint32_t Skywatcher::GetDEEncoder()
+void Skywatcher::ReadAxesStatus()
 {
-    // Axis Position
-    dispatch_command(GetAxisPosition, Axis2, nullptr);
+    SkywatcherQuery queries[4] =
+    {
+        { GetAxisPosition, Axis1, "" },
+        { GetAxisPosition, Axis2, "" },
+        { GetAxisStatus, Axis1, "" },
+        { GetAxisStatus, Axis2, "" },
+    };
 
-    uint32_t steps = Revu24str2long(response + 1);
-    if (steps & 0x80000000)
-        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = Ignoring invalid response %s", __FUNCTION__, response);
-    else
-        DEStep = steps;
-    gettimeofday(&lastreadmotorposition[Axis2], nullptr);
-    if (DEStep != lastDEStep)
+    // Over UDP a query may stay unanswered, the last value read is kept then
+    dispatch_queries(queries, 4);
+    if (queries[0].response[0] == '=')
+        ParseAxisPosition(Axis1, queries[0].response);
+    if (queries[1].response[0] == '=')
+        ParseAxisPosition(Axis2, queries[1].response);
+    if (queries[2].response[0] == '=')
+        ParseAxisStatus(Axis1, queries[2].response);
+    if (queries[3].response[0] == '=')
+        ParseAxisStatus(Axis2, queries[3].response);
+}
+
+void Skywatcher::SetPipelinedQueries(bool enable)
+{
+    LOGF_DEBUG("%s() : %s", __FUNCTION__, enable ? "true" : "false");
+    pipelinedqueries = enable;
+}
+
+void Skywatcher::SetUDPTransport(bool enable)
+{
+    LOGF_DEBUG("%s() : %s", __FUNCTION__, enable ? "true" : "false");
+    udpmissedreads = 0;
+    if (!enable)
     {
-        DEBUGF(telescope->DBG_SCOPE_STATUS, "%s() = %ld", __FUNCTION__, static_cast<long>(DEStep));
-        lastDEStep = DEStep;
+        udp.Close();
+        return;
     }
-    return DEStep;
+    if (!udp.Open(PortFD, SKYWATCHER_UDP_WINDOW))
+        throw EQModError(EQModError::ErrDisconnect, "Can not open the UDP sockets to the mount: %s", strerror(errno));
 }
 
 uint32_t Skywatcher::GetRAEncoderZero()
@@ -221,9 +270,10 @@ uint32_t Skywatcher::GetlastreadDEIndexer()
     return lastreadIndexer[Axis2];
 }
 
-void Skywatcher::GetRAMotorStatus(ILightVectorProperty *motorLP)
+void Skywatcher::GetRAMotorStatus(ILightVectorProperty *motorLP, bool refresh)
 {
-    ReadMotorStatus(Axis1);
+    if (refresh)
+        ReadMotorStatus(Axis1);
     if (!RAInitialized)
     {
         IUFindLight(motorLP, "RAInitialized")->s = IPS_ALERT;
@@ -242,9 +292,10 @@ void Skywatcher::GetRAMotorStatus(ILightVectorProperty *motorLP)
     }
 }
 
-void Skywatcher::GetDEMotorStatus(ILightVectorProperty *motorLP)
+void Skywatcher::GetDEMotorStatus(ILightVectorProperty *motorLP, bool refresh)
 {
-    ReadMotorStatus(Axis2);
+    if (refresh)
+        ReadMotorStatus(Axis2);
     if (!DEInitialized)
     {
         IUFindLight(motorLP, "DEInitialized")->s = IPS_ALERT;
@@ -703,36 +754,41 @@ void Skywatcher::ReadMotorStatus(SkywatcherAxis axis)
 {
     dispatch_command(GetAxisStatus, axis, nullptr);
     //read_eqmod();
+    ParseAxisStatus(axis, response);
+}
+
+void Skywatcher::ParseAxisStatus(SkywatcherAxis axis, char *reply)
+{
     switch (axis)
     {
         case Axis1:
-            RAInitialized = (response[3] & 0x01);
-            RARunning     = (response[2] & 0x01);
-            if (response[1] & 0x01)
+            RAInitialized = (reply[3] & 0x01);
+            RARunning     = (reply[2] & 0x01);
+            if (reply[1] & 0x01)
                 RAStatus.slewmode = SLEW;
             else
                 RAStatus.slewmode = GOTO;
-            if (response[1] & 0x02)
+            if (reply[1] & 0x02)
                 RAStatus.direction = BACKWARD;
             else
                 RAStatus.direction = FORWARD;
-            if (response[1] & 0x04)
+            if (reply[1] & 0x04)
                 RAStatus.speedmode = HIGHSPEED;
             else
                 RAStatus.speedmode = LOWSPEED;
             break;
         case Axis2:
-            DEInitialized = (response[3] & 0x01);
-            DERunning     = (response[2] & 0x01);
-            if (response[1] & 0x01)
+            DEInitialized = (reply[3] & 0x01);
+            DERunning     = (reply[2] & 0x01);
+            if (reply[1] & 0x01)
                 DEStatus.slewmode = SLEW;
             else
                 DEStatus.slewmode = GOTO;
-            if (response[1] & 0x02)
+            if (reply[1] & 0x02)
                 DEStatus.direction = BACKWARD;
             else
                 DEStatus.direction = FORWARD;
-            if (response[1] & 0x04)
+            if (reply[1] & 0x04)
                 DEStatus.speedmode = HIGHSPEED;
             else
                 DEStatus.speedmode = LOWSPEED;
@@ -1710,7 +1766,26 @@ bool Skywatcher::dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, ch
                      SkywatcherTrailingChar);
 
         int nbytes_written = 0;
-        if (!isSimulation())
+        if (udp.isOpen() && !isSimulation())
+        {
+            // The transport does the retries, with timeouts following the round trip time
+            SkywatcherUDP::Request request;
+            request.command = command;
+            if (udp.Transact(&request, 1, SKYWATCHER_UDP_TRIES, EQMOD_TIMEOUT * 1000) == 0)
+            {
+                command[strlen(command) - 1] = '\0';
+                throw EQModError(EQModError::ErrDisconnect, "No reply from the mount to %s after %d tries", command,
+                                 request.tries);
+            }
+            int nbytes_read = strlen(request.reply);
+            command[strlen(command) - 1] = '\0';
+            DEBUGF(telescope->DBG_COMM, "dispatch_command: \"%s\", %d tries", command, request.tries);
+            debugnextread = true;
+            strncpy(response, request.reply, SKYWATCHER_MAX_CMD - 1);
+            response[SKYWATCHER_MAX_CMD - 1] = '\0';
+            return check_eqmod(std::min(nbytes_read, SKYWATCHER_MAX_CMD - 1));
+        }
+        else if (!isSimulation())
         {
             int err_code = 0;
             tcflush(PortFD, TCIOFLUSH);
@@ -1728,7 +1803,7 @@ bool Skywatcher::dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, ch
                     struct timespec wait;
                     wait.tv_sec  = 0;
                     wait.tv_nsec = 100000000; // 100ms
-                    nanosleep(nullptr, &wait);
+                    nanosleep(&wait, nullptr);
                     continue;
                 }
             }
@@ -1762,6 +1837,114 @@ bool Skywatcher::dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, ch
     return true;
 }
 
+/* Send the queries back to back and match the CR terminated replies in order. This saves a
+   round trip per query on slow serial links. Falls back to one query at a time if the burst
+   fails, dispatch_command() then does the retries and the error reporting. */
+bool Skywatcher::dispatch_queries(SkywatcherQuery *queries, int count)
+{
+    if (udp.isOpen() && !isSimulation())
+        return dispatch_udp_queries(queries, count);
+
+    if (!pipelinedqueries || isSimulation() || count <= 1 || count > SKYWATCHER_MAX_QUERIES)
+    {
+        for (int q = 0; q < count; q++)
+        {
+            dispatch_command(queries[q].cmd, queries[q].axis, nullptr);
+            strncpy(queries[q].response, response, SKYWATCHER_MAX_CMD);
+        }
+        return true;
+    }
+
+    char burst[SKYWATCHER_MAX_QUERIES * 4 + 1];
+    int burstlen = 0;
+    for (int q = 0; q < count; q++)
+        burstlen += snprintf(burst + burstlen, sizeof(burst) - burstlen, "%c%c%c%c", SkywatcherLeadingChar,
+                             queries[q].cmd, AxisCmd[queries[q].axis], SkywatcherTrailingChar);
+
+    for (uint8_t i = 0; i < EQMOD_MAX_RETRY; i++)
+    {
+        int err_code = 0, nbytes_written = 0, q = 0;
+        tcflush(PortFD, TCIOFLUSH);
+
+        if ((err_code = tty_write(PortFD, burst, burstlen, &nbytes_written)) != TTY_OK)
+        {
+            char ttyerrormsg[ERROR_MSG_LENGTH];
+            tty_error_msg(err_code, ttyerrormsg, ERROR_MSG_LENGTH);
+            DEBUGF(telescope->DBG_COMM, "dispatch_queries: write failed: %s", ttyerrormsg);
+            break;
+        }
+        DEBUGF(telescope->DBG_COMM, "dispatch_queries: %d queries, %d bytes written", count, nbytes_written);
+
+        for (q = 0; q < count; q++)
+        {
+            int nbytes_read = 0;
+            char *reply     = queries[q].response;
+            if (tty_nread_section(PortFD, reply, SKYWATCHER_MAX_CMD, SkywatcherTrailingChar, EQMOD_TIMEOUT,
+                                  &nbytes_read) != TTY_OK || nbytes_read < 1 || reply[nbytes_read - 1] != SkywatcherTrailingChar)
+                break;
+            reply[nbytes_read - 1] = '\0';
+            DEBUGF(telescope->DBG_COMM, "dispatch_queries: :%c%c -> \"%s\"", queries[q].cmd, AxisCmd[queries[q].axis], reply);
+            // A failed query still ends with CR, but the next replies can not be trusted
+            if (reply[0] != '=')
+                break;
+        }
+        if (q == count)
+            return true;
+
+        DEBUG(telescope->DBG_COMM, "dispatch_queries: read error, will retry again...");
+    }
+
+    DEBUG(telescope->DBG_COMM, "dispatch_queries: falling back to single queries");
+    for (int q = 0; q < count; q++)
+    {
+        dispatch_command(queries[q].cmd, queries[q].axis, nullptr);
+        strncpy(queries[q].response, response, SKYWATCHER_MAX_CMD);
+    }
+    return true;
+}
+
+/* Over UDP all the queries are in flight at once, each on a socket of its own. A lost datagram
+   costs a retransmission after a few round trips instead of a read timeout, and a query still
+   unanswered at the deadline gets an empty response: the caller keeps the last value. The mount
+   is only considered gone when several reads in a row got no reply at all. */
+bool Skywatcher::dispatch_udp_queries(SkywatcherQuery *queries, int count)
+{
+    std::vector<SkywatcherUDP::Request> requests(count);
+    std::vector<std::array<char, 8>> commands(count);
+
+    for (int q = 0; q < count; q++)
+    {
+        snprintf(commands[q].data(), commands[q].size(), "%c%c%c%c", SkywatcherLeadingChar, queries[q].cmd,
+                 AxisCmd[queries[q].axis], SkywatcherTrailingChar);
+        requests[q].command = commands[q].data();
+    }
+
+    int answered = udp.Transact(requests.data(), count, SKYWATCHER_UDP_TRIES, SKYWATCHER_UDP_STATUS_MS);
+    for (int q = 0; q < count; q++)
+    {
+        char *reply = queries[q].response;
+        strncpy(reply, requests[q].reply, SKYWATCHER_MAX_CMD - 1);
+        reply[SKYWATCHER_MAX_CMD - 1] = '\0';
+        if (requests[q].answered)
+            reply[strlen(reply) - 1] = '\0';
+        DEBUGF(telescope->DBG_COMM, "dispatch_queries: :%c%c -> \"%s\", %d tries", queries[q].cmd,
+               AxisCmd[queries[q].axis], requests[q].answered ? reply : "no reply", requests[q].tries);
+    }
+
+    if (answered > 0)
+    {
+        udpmissedreads = 0;
+        return answered == count;
+    }
+    if (++udpmissedreads >= EQMOD_MAX_RETRY)
+    {
+        SkywatcherUDP::Stats stats = udp.getStats();
+        throw EQModError(EQModError::ErrDisconnect, "No reply from the mount to %d status reads (%lu of %lu requests lost)",
+                         udpmissedreads, stats.lost, stats.requests);
+    }
+    return false;
+}
+
 bool Skywatcher::read_eqmod()
 {
     int err_code = 0, nbytes_read = 0;
@@ -1785,6 +1968,11 @@ bool Skywatcher::read_eqmod()
     {
         telescope->simulator->send_reply(response, &nbytes_read);
     }
+    return check_eqmod(nbytes_read);
+}
+
+bool Skywatcher::check_eqmod(int nbytes_read)
+{
     // Remove CR
     response[nbytes_read - 1] = '\0';
 
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "eqmoderror.h"
+#include "skywatcherudp.h"
 
 #include <inditelescope.h>
 
@@ -31,7 +32,13 @@ class EQMod; // TODO
 #include "simulator/simulator.h"
 
 #define SKYWATCHER_MAX_CMD      16
+#define SKYWATCHER_MAX_QUERIES  8
 #define SKYWATCHER_MAX_TRIES    3
+
+// UDP mounts: requests in flight, tries per request and the time a status read may take
+#define SKYWATCHER_UDP_WINDOW    4
+#define SKYWATCHER_UDP_TRIES     8
+#define SKYWATCHER_UDP_STATUS_MS 500
 #define SKYWATCHER_ERROR_BUFFER 1024
 
 #define SKYWATCHER_SIDEREAL_DAY   86164.09053083288
@@ -65,8 +72,9 @@ class Skywatcher
         bool HasSnapPort2();
         bool HasPolarLed();
 
-        uint32_t GetRAEncoder();
-        uint32_t GetDEEncoder();
+        // refresh = false returns the value read by the last query, e.g. by ReadAxesStatus()
+        uint32_t GetRAEncoder(bool refresh = true);
+        uint32_t GetDEEncoder(bool refresh = true);
         uint32_t GetRAEncoderZero();
         uint32_t GetRAEncoderTotal();
         uint32_t GetRAEncoderHome();
@@ -75,8 +83,13 @@ class Skywatcher
         uint32_t GetDEEncoderHome();
         uint32_t GetRAPeriod();
         uint32_t GetDEPeriod();
-        void GetRAMotorStatus(ILightVectorProperty *motorLP);
-        void GetDEMotorStatus(ILightVectorProperty *motorLP);
+        void GetRAMotorStatus(ILightVectorProperty *motorLP, bool refresh = true);
+        void GetDEMotorStatus(ILightVectorProperty *motorLP, bool refresh = true);
+        // Position and status of both axes, in a single round trip when queries are pipelined
+        void ReadAxesStatus();
+        void SetPipelinedQueries(bool enable);
+        // Several requests in flight with retransmissions instead of serial timeouts, for UDP connections
+        void SetUDPTransport(bool enable);
         void InquireBoardVersion(ITextVectorProperty *boardTP);
         void InquireFeatures();
         void InquireRAEncoderInfo(INumberVectorProperty *encoderNP);
@@ -268,6 +281,8 @@ class Skywatcher
         uint32_t ReadEncoder(SkywatcherAxis axis);
         void ResetIndexer(SkywatcherAxis axis);
         void GetIndexer(SkywatcherAxis axis);
+        void ParseAxisPosition(SkywatcherAxis axis, char *reply);
+        void ParseAxisStatus(SkywatcherAxis axis, char *reply);
         void SetST4GuideRate(SkywatcherAxis axis, unsigned char r);
         void SetAxisPosition(SkywatcherAxis axis, uint32_t step);
         void TurnPPECTraining(SkywatcherAxis axis, bool on);
@@ -275,8 +290,19 @@ class Skywatcher
         void GetPPECStatus(SkywatcherAxis axis, bool *intraining, bool *inppec);
         void TurnSnapPort(SkywatcherAxis axis, bool on);
 
+        // An argument-less query, several are sent back to back by dispatch_queries
+        typedef struct SkywatcherQuery
+        {
+            SkywatcherCommand cmd;
+            SkywatcherAxis axis;
+            char response[SKYWATCHER_MAX_CMD];
+        } SkywatcherQuery;
+
         bool read_eqmod();
+        bool check_eqmod(int nbytes_read);
         bool dispatch_command(SkywatcherCommand cmd, SkywatcherAxis axis, char *arg);
+        bool dispatch_queries(SkywatcherQuery *queries, int count);
+        bool dispatch_udp_queries(SkywatcherQuery *queries, int count);
 
         uint32_t Revu24str2long(char *);
         uint32_t Highstr2long(char *);
@@ -324,6 +350,11 @@ class Skywatcher
         char command[SKYWATCHER_MAX_CMD];
         char response[SKYWATCHER_MAX_CMD];
 
+        bool pipelinedqueries {true};
+        SkywatcherUDP udp;
+        // Status reads in a row without any reply
+        uint8_t udpmissedreads {0};
+
         bool debug;
         bool debugnextread;
         EQMod *telescope;
@@ -0,0 +1,308 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "skywatcherudp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+// Before the first reply: the serial timeouts are far too long, a WiFi round trip is a few ms
+static const int INITIAL_RTO_MS = 250;
+static const int MIN_RTO_MS     = 20;
+static const int MAX_RTO_MS     = 2000;
+
+SkywatcherUDP::SkywatcherUDP()
+{
+    for (Slot &slot : slots)
+    {
+        slot.fd         = -1;
+        slot.request    = -1;
+        slot.command[0] = '\0';
+    }
+    rto = std::chrono::milliseconds(INITIAL_RTO_MS);
+    setTimeouts(MIN_RTO_MS, MAX_RTO_MS);
+    memset(&stats, 0, sizeof(stats));
+}
+
+SkywatcherUDP::~SkywatcherUDP()
+{
+    Close();
+}
+
+bool SkywatcherUDP::Open(int fd, int window)
+{
+    struct sockaddr_storage addr;
+    socklen_t addrlen = sizeof(addr);
+
+    if (getpeername(fd, reinterpret_cast<struct sockaddr *>(&addr), &addrlen) < 0)
+        return false;
+    return Open(reinterpret_cast<struct sockaddr *>(&addr), addrlen, window);
+}
+
+bool SkywatcherUDP::Open(const struct sockaddr *addr, socklen_t addrlen, int w)
+{
+    Close();
+    w = std::max(1, std::min(w, SKYWATCHER_UDP_MAX_SLOTS));
+    for (int s = 0; s < w; s++)
+    {
+        Slot &slot = slots[s];
+        slot.fd    = socket(addr->sa_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (slot.fd < 0 || connect(slot.fd, addr, addrlen) < 0)
+        {
+            int err = errno;
+            window  = s + 1;
+            Close();
+            errno = err;
+            return false;
+        }
+        slot.request    = -1;
+        slot.command[0] = '\0';
+        slot.lastused   = Clock::time_point();
+        slot.quiet      = Clock::time_point();
+    }
+    window = w;
+    hasrtt = false;
+    rto    = std::chrono::milliseconds(INITIAL_RTO_MS);
+    memset(&stats, 0, sizeof(stats));
+    return true;
+}
+
+void SkywatcherUDP::Close()
+{
+    for (int s = 0; s < window; s++)
+    {
+        if (slots[s].fd >= 0)
+            close(slots[s].fd);
+        slots[s].fd      = -1;
+        slots[s].request = -1;
+    }
+    window = 0;
+}
+
+void SkywatcherUDP::setTimeouts(int min_rto_ms, int max_rto_ms)
+{
+    minrto = std::chrono::milliseconds(min_rto_ms);
+    maxrto = std::chrono::milliseconds(std::max(min_rto_ms, max_rto_ms));
+    rto    = std::max(minrto, std::min(rto, maxrto));
+}
+
+SkywatcherUDP::Stats SkywatcherUDP::getStats() const
+{
+    Stats s   = stats;
+    s.srtt_ms = srtt * 1000.0;
+    s.rto_ms  = std::chrono::duration<double, std::milli>(rto).count();
+    return s;
+}
+
+/* RFC 6298, with a 1 ms clock granularity */
+void SkywatcherUDP::updateRTT(Clock::duration sample)
+{
+    double r = std::chrono::duration<double>(sample).count();
+
+    if (!hasrtt)
+    {
+        srtt   = r;
+        rttvar = r / 2.0;
+        hasrtt = true;
+    }
+    else
+    {
+        rttvar = 0.75 * rttvar + 0.25 * fabs(srtt - r);
+        srtt   = 0.875 * srtt + 0.125 * r;
+    }
+    rto = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(srtt + std::max(0.001, 4.0 * rttvar)));
+    rto = std::max(minrto, std::min(rto, maxrto));
+}
+
+/* A free slot which last carried the same command, else the least recently used free one
+   which no late reply can reach any more */
+int SkywatcherUDP::pickSlot(const char *command, Clock::time_point now)
+{
+    int best = -1;
+
+    for (int s = 0; s < window; s++)
+    {
+        if (slots[s].request >= 0)
+            continue;
+        if (!strcmp(slots[s].command, command))
+            return s;
+        if (slots[s].quiet > now)
+            continue;
+        if (best < 0 || slots[s].lastused < slots[best].lastused)
+            best = s;
+    }
+    return best;
+}
+
+/* Free the slot. A request given up may still be answered up to maxrto later, the other
+   tries of an answered one about a round trip after the reply that was taken. */
+void SkywatcherUDP::release(Slot &slot, const Request &request, Clock::time_point now)
+{
+    slot.request = -1;
+    if (!request.answered)
+        slot.quiet = std::max(slot.quiet, now + maxrto);
+    else if (request.tries > 1)
+        slot.quiet = std::max(slot.quiet, now + rto);
+}
+
+/* Late replies to requests given up earlier */
+void SkywatcherUDP::drain(Slot &slot)
+{
+    char buf[SKYWATCHER_UDP_MAX_REPLY];
+
+    while (recv(slot.fd, buf, sizeof(buf), MSG_DONTWAIT) >= 0 || errno == ECONNREFUSED)
+        stats.stale++;
+}
+
+bool SkywatcherUDP::send(Slot &slot, Request &request)
+{
+    size_t len = strlen(request.command);
+
+    request.tries++;
+    slot.sent     = Clock::now();
+    slot.due      = slot.sent + slot.rto;
+    slot.lastused = slot.sent;
+    // A refused or failed send is a lost datagram as well, it is retried when due
+    return ::send(slot.fd, request.command, len, 0) == static_cast<ssize_t>(len);
+}
+
+int SkywatcherUDP::Transact(Request *requests, int count, int maxtries, int deadline_ms)
+{
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(deadline_ms);
+    int next = 0, inflight = 0, answered = 0;
+
+    for (int r = 0; r < count; r++)
+    {
+        requests[r].reply[0] = '\0';
+        requests[r].tries    = 0;
+        requests[r].answered = false;
+    }
+    if (window == 0)
+        return 0;
+
+    while (true)
+    {
+        while (next < count)
+        {
+            int s = pickSlot(requests[next].command, Clock::now());
+            if (s < 0)
+                break;
+            Slot &slot = slots[s];
+            drain(slot);
+            strncpy(slot.command, requests[next].command, sizeof(slot.command) - 1);
+            slot.command[sizeof(slot.command) - 1] = '\0';
+            slot.request = next;
+            slot.rto     = rto;
+            send(slot, requests[next]);
+            stats.requests++;
+            inflight++;
+            next++;
+        }
+        if (inflight == 0 && next == count)
+            break;
+
+        Clock::time_point now = Clock::now();
+        if (now >= deadline)
+            break;
+
+        struct pollfd pfds[SKYWATCHER_UDP_MAX_SLOTS];
+        int busy[SKYWATCHER_UDP_MAX_SLOTS];
+        int nfds = 0;
+        Clock::time_point wake = deadline;
+        for (int s = 0; s < window; s++)
+        {
+            if (slots[s].request < 0)
+            {
+                // Requests left to send wait for a quiet slot
+                if (next < count && slots[s].quiet > now)
+                    wake = std::min(wake, slots[s].quiet);
+                continue;
+            }
+            pfds[nfds].fd      = slots[s].fd;
+            pfds[nfds].events  = POLLIN;
+            pfds[nfds].revents = 0;
+            busy[nfds++]       = s;
+            wake               = std::min(wake, slots[s].due);
+        }
+        // Rounded up, poll() must not return just before the retransmission is due
+        int timeout = std::max<int>(0, std::chrono::duration_cast<std::chrono::milliseconds>(wake - now +
+                                    std::chrono::milliseconds(1) - Clock::duration(1)).count());
+        if (poll(pfds, nfds, timeout) < 0 && errno != EINTR)
+            break;
+
+        now = Clock::now();
+        for (int p = 0; p < nfds; p++)
+        {
+            Slot &slot = slots[busy[p]];
+            Request &request = requests[slot.request];
+
+            if (pfds[p].revents & (POLLIN | POLLERR))
+            {
+                char buf[SKYWATCHER_UDP_MAX_REPLY];
+                ssize_t n = recv(slot.fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+                // Only well formed replies, anything else is left to the retransmission
+                if (n >= 2 && (buf[0] == '=' || buf[0] == '!') && buf[n - 1] == '\r')
+                {
+                    memcpy(request.reply, buf, n);
+                    request.reply[n]  = '\0';
+                    request.answered  = true;
+                    // Karn: a reply to a retransmitted request may be to any of the tries
+                    if (request.tries == 1)
+                        updateRTT(now - slot.sent);
+                    release(slot, request, now);
+                    inflight--;
+                    answered++;
+                    continue;
+                }
+            }
+
+            if (now >= slot.due)
+            {
+                if (request.tries < maxtries)
+                {
+                    // Backoff for this request only, the others in flight may well get through
+                    slot.rto = std::min(slot.rto * 2, maxrto);
+                    send(slot, request);
+                    stats.retransmits++;
+                }
+                else
+                {
+                    release(slot, request, now);
+                    inflight--;
+                    stats.lost++;
+                }
+            }
+        }
+    }
+
+    // Deadline: what is still in flight or not sent yet is lost
+    Clock::time_point now = Clock::now();
+    for (int s = 0; s < window; s++)
+    {
+        if (slots[s].request >= 0)
+        {
+            release(slots[s], requests[slots[s].request], now);
+            stats.lost++;
+        }
+    }
+    stats.lost += count - next;
+    return answered;
+}
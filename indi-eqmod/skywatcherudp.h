@@ -0,0 +1,107 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+
+#include <sys/socket.h>
+
+#define SKYWATCHER_UDP_MAX_SLOTS 8
+#define SKYWATCHER_UDP_MAX_REPLY 32
+
+/* Skywatcher protocol over UDP, for the AZ-GTi and the other WiFi mounts.
+
+   The mount answers every datagram with one datagram to the port it came from, and the
+   protocol has no sequence numbers. So each request in flight gets a socket of its own:
+   the reply is matched to the request by the port it arrives on. Up to the window size
+   requests are in flight, a request without reply is sent again after an adaptive timeout
+   (RFC 6298: smoothed round trip time and its variation, Karn's rule, exponential backoff)
+   and given up after the maximum number of tries or at the deadline of the transaction.
+   A slot is reused for the same command whenever possible, a late reply to an earlier try
+   is then still the answer to the same question. A slot that may still get such a late
+   reply, after a request was given up or retransmitted, carries no other command until
+   the maximum timeout has passed. */
+class SkywatcherUDP
+{
+  public:
+    typedef struct Request
+    {
+        const char *command;                   // CR terminated
+        char reply[SKYWATCHER_UDP_MAX_REPLY];  // CR terminated, empty if there was none
+        int tries;
+        bool answered;
+    } Request;
+
+    typedef struct Stats
+    {
+        unsigned long requests;
+        unsigned long retransmits;
+        unsigned long lost;
+        unsigned long stale;     // replies arriving on a slot with no request in flight
+        double srtt_ms;
+        double rto_ms;
+    } Stats;
+
+    SkywatcherUDP();
+    ~SkywatcherUDP();
+
+    /* One socket per slot, all connected to the peer of fd (the socket the connection
+       plugin opened) or to addr. Returns false if a socket could not be created. */
+    bool Open(int fd, int window = 4);
+    bool Open(const struct sockaddr *addr, socklen_t addrlen, int window = 4);
+    void Close();
+    bool isOpen() const { return window > 0; }
+
+    /* Sends the requests, at most window of them in flight, and waits for the replies.
+       Returns the number of requests answered; the others got no reply after maxtries
+       tries or before deadline_ms. */
+    int Transact(Request *requests, int count, int maxtries, int deadline_ms);
+
+    void setTimeouts(int min_rto_ms, int max_rto_ms);
+    Stats getStats() const;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    typedef struct Slot
+    {
+        int fd;
+        int request;           // index in the current transaction, -1 when free
+        char command[SKYWATCHER_UDP_MAX_REPLY];
+        Clock::time_point sent;
+        Clock::time_point due;
+        Clock::duration rto;
+        Clock::time_point lastused;
+        Clock::time_point quiet;  // until then late replies may arrive, only the same command may use the slot
+    } Slot;
+
+    int pickSlot(const char *command, Clock::time_point now);
+    void release(Slot &slot, const Request &request, Clock::time_point now);
+    bool send(Slot &slot, Request &request);
+    void drain(Slot &slot);
+    void updateRTT(Clock::duration sample);
+
+    Slot slots[SKYWATCHER_UDP_MAX_SLOTS];
+    int window { 0 };
+
+    // Round trip estimation, in seconds
+    bool hasrtt { false };
+    double srtt { 0.0 }, rttvar { 0.0 };
+    Clock::duration rto, minrto, maxrto;
+
+    Stats stats;
+};
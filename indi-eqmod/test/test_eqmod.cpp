@@ -3,6 +3,22 @@
 
 #include "config.h"
 #include "eqmodbase.h"
+#include "eqmoderror.h"
+#include "simulator/pty-simulator.h"
+#include "simulator/udp-simulator.h"
+#include "skywatcherudp.h"
+
+#include <indicom.h>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#ifdef WITH_ALIGN_GEEHALEL
+#include "align/spatialindex.h"
+
+#include <cmath>
+#include <random>
+#endif
 
 
 using ::testing::_;
@@ -110,6 +126,86 @@ public:
         return true;
     }
 
+    bool TestSerial(bool pipelined) {
+        // The driver talks to the simulator over a pseudo terminal, as to a mount
+        SkywatcherPtySimulator::Options options = SkywatcherPtySimulator::DefaultOptions();
+        options.baud = 0;
+        SkywatcherPtySimulator simulator(options);
+        EXPECT_TRUE(simulator.Open());
+        simulator.Start();
+
+        int fd = -1;
+        EXPECT_EQ(tty_connect(simulator.getDeviceName(), 9600, 8, 0, 1, &fd), TTY_OK);
+        mount->setPortFD(fd);
+        mount->SetPipelinedQueries(pipelined);
+        try
+        {
+            mount->Handshake();
+            EXPECT_EQ(mount->GetRAEncoder(), 0x800000u);
+            EXPECT_EQ(mount->GetDEEncoder(), 0x800000u);
+            for (int i = 0; i < 10; i++)
+            {
+                mount->ReadAxesStatus();
+                EXPECT_EQ(mount->GetRAEncoder(false), 0x800000u);
+                EXPECT_EQ(mount->GetDEEncoder(false), 0x800000u);
+            }
+        }
+        catch (EQModError &e)
+        {
+            ADD_FAILURE() << e.message;
+        }
+        mount->setPortFD(-1);
+        tty_disconnect(fd);
+        simulator.Stop();
+
+        // Handshake, two encoder queries and four per status read
+        EXPECT_EQ(simulator.getStats().commands, 43u);
+        return true;
+    }
+
+    bool TestUDP(double drop) {
+        // The driver talks to the simulator over a lossy loopback network, as to an AZ-GTi
+        SkywatcherUdpSimulator::Options options = SkywatcherUdpSimulator::DefaultOptions();
+        options.drop      = drop;
+        options.jitter_us = 2000;
+        SkywatcherUdpSimulator simulator(options);
+        EXPECT_TRUE(simulator.Open());
+        simulator.Start();
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_port        = htons(simulator.getPort());
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        EXPECT_EQ(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+
+        mount->setPortFD(fd);
+        try
+        {
+            mount->SetUDPTransport(true);
+            mount->Handshake();
+            EXPECT_EQ(mount->GetRAEncoder(), 0x800000u);
+            for (int i = 0; i < 20; i++)
+            {
+                auto start = std::chrono::steady_clock::now();
+                mount->ReadAxesStatus();
+                // A lost datagram costs a retransmission, not the serial read timeout
+                EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(SKYWATCHER_UDP_STATUS_MS + 100));
+                EXPECT_EQ(mount->GetRAEncoder(false), 0x800000u);
+                EXPECT_EQ(mount->GetDEEncoder(false), 0x800000u);
+            }
+        }
+        catch (EQModError &e)
+        {
+            ADD_FAILURE() << e.message;
+        }
+        mount->setPortFD(-1);
+        close(fd);
+        simulator.Stop();
+        return true;
+    }
+
     bool TestHemisphereSymmetry() {
 
         uint32_t destep = totalDEEncoder / 36;
@@ -156,6 +252,168 @@ TEST(EqmodTest, hemisphere_symmetry)
     eqmod.TestHemisphereSymmetry();
 }
 
+TEST(EqmodTest, serial_one_by_one)
+{
+    TestEQMod eqmod;
+    eqmod.TestSerial(false);
+}
+
+TEST(EqmodTest, serial_pipelined)
+{
+    TestEQMod eqmod;
+    eqmod.TestSerial(true);
+}
+
+TEST(EqmodTest, udp_lossless)
+{
+    TestEQMod eqmod;
+    eqmod.TestUDP(0.0);
+}
+
+TEST(EqmodTest, udp_lossy)
+{
+    TestEQMod eqmod;
+    eqmod.TestUDP(0.1);
+}
+
+static void ConnectUDP(SkywatcherUDP &transport, unsigned short port, int window)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_TRUE(transport.Open(reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr), window));
+}
+
+TEST(EqmodTest, udp_transport_matching)
+{
+    // Replies come back out of order and a tenth of the datagrams is lost each way
+    SkywatcherUdpSimulator::Options options = SkywatcherUdpSimulator::DefaultOptions();
+    options.mount     = "GEEHALEL";
+    options.drop      = 0.1;
+    options.jitter_us = 5000;
+    SkywatcherUdpSimulator simulator(options);
+    ASSERT_TRUE(simulator.Open());
+    simulator.Start();
+
+    // All different answers, RA and DE gears differ on this mount
+    const char *commands[] = { ":e1\r", ":a1\r", ":a2\r", ":b1\r", ":b2\r", ":j1\r", ":f1\r", ":D1\r" };
+    const int count = sizeof(commands) / sizeof(commands[0]);
+    SkywatcherSimulator reference;
+    reference.setupMount("GEEHALEL");
+    char expected[count][SKYWATCHER_UDP_MAX_REPLY];
+    for (int c = 0; c < count; c++)
+    {
+        int received = 0, len = 0;
+        reference.process_command(commands[c], &received);
+        reference.get_reply(expected[c], &len);
+        expected[c][len] = '\0';
+    }
+
+    SkywatcherUDP transport;
+    ConnectUDP(transport, simulator.getPort(), 4);
+    for (int round = 0; round < 30; round++)
+    {
+        SkywatcherUDP::Request requests[count];
+        for (int c = 0; c < count; c++)
+            requests[c].command = commands[(c + round) % count];
+        EXPECT_EQ(transport.Transact(requests, count, 10, 5000), count);
+        for (int c = 0; c < count; c++)
+            EXPECT_STREQ(requests[c].reply, expected[(c + round) % count]) << requests[c].command;
+    }
+
+    SkywatcherUDP::Stats stats = transport.getStats();
+    EXPECT_EQ(stats.requests, 30u * count);
+    EXPECT_GT(stats.retransmits, 0u);
+    EXPECT_EQ(stats.lost, 0u);
+    // Some ms on the loopback, far below the initial guess
+    EXPECT_LT(stats.rto_ms, 250.0);
+    simulator.Stop();
+}
+
+TEST(EqmodTest, udp_transport_late_replies)
+{
+    // Replies come up to 300 ms late, after their requests were given up
+    SkywatcherUdpSimulator::Options options = SkywatcherUdpSimulator::DefaultOptions();
+    options.mount     = "GEEHALEL";
+    options.jitter_us = 300000;
+    SkywatcherUdpSimulator simulator(options);
+    ASSERT_TRUE(simulator.Open());
+    simulator.Start();
+
+    const char *commands[] = { ":e1\r", ":a1\r", ":a2\r", ":b1\r", ":b2\r", ":j1\r", ":f1\r", ":D1\r" };
+    const int count = sizeof(commands) / sizeof(commands[0]);
+    SkywatcherSimulator reference;
+    reference.setupMount("GEEHALEL");
+    char expected[count][SKYWATCHER_UDP_MAX_REPLY];
+    for (int c = 0; c < count; c++)
+    {
+        int received = 0, len = 0;
+        reference.process_command(commands[c], &received);
+        reference.get_reply(expected[c], &len);
+        expected[c][len] = '\0';
+    }
+
+    SkywatcherUDP transport;
+    ConnectUDP(transport, simulator.getPort(), 4);
+    for (int round = 0; round < 4; round++)
+    {
+        // Timeout down to 20 ms, almost every request is given up. Its reply must not answer
+        // the next command sent on the slot.
+        transport.setTimeouts(20, 20);
+        transport.setTimeouts(20, 400);
+        SkywatcherUDP::Request requests[count / 2];
+        for (int c = 0; c < count / 2; c++)
+            requests[c].command = commands[(round % 2) * count / 2 + c];
+        transport.Transact(requests, count / 2, 1, 3000);
+        for (int c = 0; c < count / 2; c++)
+        {
+            if (!requests[c].answered)
+                continue;
+            EXPECT_STREQ(requests[c].reply, expected[(round % 2) * count / 2 + c]) << requests[c].command;
+        }
+    }
+    EXPECT_GT(transport.getStats().lost, 0u);
+    simulator.Stop();
+}
+
+TEST(EqmodTest, udp_transport_deadline)
+{
+    // A mount gone silent: the requests are given up at the deadline, not after seconds
+    SkywatcherUdpSimulator::Options options = SkywatcherUdpSimulator::DefaultOptions();
+    options.drop = 1.0;
+    SkywatcherUdpSimulator simulator(options);
+    ASSERT_TRUE(simulator.Open());
+    simulator.Start();
+
+    SkywatcherUDP transport;
+    ConnectUDP(transport, simulator.getPort(), 4);
+    SkywatcherUDP::Request requests[4];
+    const char *commands[] = { ":j1\r", ":j2\r", ":f1\r", ":f2\r" };
+    for (int c = 0; c < 4; c++)
+        requests[c].command = commands[c];
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(transport.Transact(requests, 4, 100, 300), 0);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(300));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(400));
+    for (int c = 0; c < 4; c++)
+    {
+        EXPECT_FALSE(requests[c].answered);
+        EXPECT_STREQ(requests[c].reply, "");
+        EXPECT_GT(requests[c].tries, 1);
+    }
+    EXPECT_EQ(transport.getStats().lost, 4u);
+
+    // Few tries: given up before the deadline
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(transport.Transact(requests, 4, 1, 5000), 0);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(2500));
+    simulator.Stop();
+}
+
 TEST(EqmodTest, encoders_north)
 {
     TestEQMod eqmod;
@@ -453,6 +711,88 @@ TEST(EqmodTest, scope_limits_altaz)
 }
 #endif
 
+#ifdef WITH_ALIGN_GEEHALEL
+static UnitVector AltAzVector(double alt, double az)
+{
+    return UnitVector { { cos(alt * M_PI / 180.0) * cos(az * M_PI / 180.0),
+                          cos(alt * M_PI / 180.0) * sin(az * M_PI / 180.0), sin(alt * M_PI / 180.0) } };
+}
+
+TEST(EqmodTest, align_nearest_point)
+{
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> alt(0.0, 90.0), az(0.0, 360.0);
+    std::vector<UnitVector> points;
+    for (int i = 0; i < 300; i++)
+        points.push_back(AltAzVector(alt(gen), az(gen)));
+    // Same position twice, the first one wins
+    points.push_back(points[10]);
+
+    PointIndex index;
+    EXPECT_EQ(index.Nearest(points[0]), -1);
+    index.Build(points);
+    EXPECT_EQ(index.Nearest(points[10]), 10);
+
+    for (int q = 0; q < 1000; q++)
+    {
+        UnitVector p = AltAzVector(alt(gen), az(gen));
+        int nearest  = 0;
+        double best  = 5.0;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            double d = (p[0] - points[i][0]) * (p[0] - points[i][0]) + (p[1] - points[i][1]) * (p[1] - points[i][1]) +
+                       (p[2] - points[i][2]) * (p[2] - points[i][2]);
+            if (d < best)
+            {
+                best    = d;
+                nearest = i;
+            }
+        }
+        EXPECT_EQ(index.Nearest(p), nearest);
+    }
+}
+
+TEST(EqmodTest, align_face_walk)
+{
+    // A grid over 20..80 degrees altitude and 0..120 degrees azimuth
+    std::vector<UnitVector> vertices;
+    std::vector<FaceIndex::Triangle> faces;
+    for (int i = 0; i <= 6; i++)
+        for (int j = 0; j <= 12; j++)
+            vertices.push_back(AltAzVector(20.0 + i * 10.0, j * 10.0));
+    for (int i = 0; i < 6; i++)
+        for (int j = 0; j < 12; j++)
+        {
+            int v = i * 13 + j;
+            faces.push_back(FaceIndex::Triangle { { v, v + 1, v + 14 } });
+            faces.push_back(FaceIndex::Triangle { { v, v + 14, v + 13 } });
+        }
+
+    FaceIndex index;
+    EXPECT_EQ(index.Locate(vertices[0], vertices, 0), -1);
+    index.Build(faces, vertices.size());
+    EXPECT_GE(index.FaceOf(0), 0);
+
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<double> alt(21.0, 79.0), az(1.0, 119.0);
+    int face = 0;
+    for (int q = 0; q < 1000; q++)
+    {
+        UnitVector p = AltAzVector(alt(gen), az(gen));
+        int steps    = 0;
+        face         = index.Locate(p, vertices, face, &steps);
+        ASSERT_GE(face, 0);
+        EXPECT_TRUE(FaceIndex::Contains(p, vertices[faces[face][0]], vertices[faces[face][1]], vertices[faces[face][2]]));
+        // A walk, not a scan of the 144 faces
+        EXPECT_LE(steps, 40);
+    }
+
+    // Outside the grid
+    EXPECT_EQ(index.Locate(AltAzVector(50.0, 200.0), vertices, face), -1);
+    EXPECT_EQ(index.Locate(AltAzVector(85.0, 60.0), vertices, face), -1);
+}
+#endif
+
 int main(int argc, char **argv)
 {
     INDI::Logger::getInstance().configure("", INDI::Logger::file_off,
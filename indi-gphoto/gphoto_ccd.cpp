@@ -38,6 +38,7 @@
 #include <sys/stat.h>
 
 #define FOCUS_TAB    "Focus"
+#define STREAMING_TAB "Streaming"
 #define MAX_DEVICES  5 /* Max device cameraCount */
 #define FOCUS_TIMER  50
 #define MAX_RETRIES  3
@@ -299,6 +300,19 @@ bool GPhotoCCD::initProperties()
     IUFillSwitchVector(&livePreviewSP, livePreviewS, 2, getDeviceName(), "AUX_VIDEO_STREAM", "Preview",
                        MAIN_CONTROL_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    IUFillSwitch(&liveVideoModeS[LIVE_DECODE_FULL], "LIVE_DECODE_FULL", "Decode", ISS_ON);
+    IUFillSwitch(&liveVideoModeS[LIVE_DECODE_HALF], "LIVE_DECODE_HALF", "Decode 1/2", ISS_OFF);
+    IUFillSwitch(&liveVideoModeS[LIVE_DECODE_QUARTER], "LIVE_DECODE_QUARTER", "Decode 1/4", ISS_OFF);
+    IUFillSwitch(&liveVideoModeS[LIVE_DECODE_EIGHTH], "LIVE_DECODE_EIGHTH", "Decode 1/8", ISS_OFF);
+    IUFillSwitch(&liveVideoModeS[LIVE_PASSTHROUGH], "LIVE_PASSTHROUGH", "MJPEG", ISS_OFF);
+    IUFillSwitchVector(&liveVideoModeSP, liveVideoModeS, 5, getDeviceName(), "CCD_LIVE_VIDEO_MODE", "Live Mode",
+                       STREAMING_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
+    IUFillNumber(&liveVideoStatsN[LIVE_STATS_FPS], "LIVE_FPS", "Camera FPS", "%.1f", 0, 100, 0, 0);
+    IUFillNumber(&liveVideoStatsN[LIVE_STATS_PROCESS], "LIVE_PROCESS_MS", "Process (ms)", "%.1f", 0, 1000, 0, 0);
+    IUFillNumberVector(&liveVideoStatsNP, liveVideoStatsN, 2, getDeviceName(), "CCD_LIVE_VIDEO_STATS", "Live Stats",
+                       STREAMING_TAB, IP_RO, 60, IPS_IDLE);
+
     IUFillSwitch(&captureTargetS[CAPTURE_INTERNAL_RAM], "RAM", "", ISS_ON);
     IUFillSwitch(&captureTargetS[CAPTURE_SD_CARD], "SD Card", "", ISS_OFF);
     IUFillSwitchVector(&captureTargetSP, captureTargetS, 2, getDeviceName(), "CCD_CAPTURE_TARGET", "Capture Target",
@@ -314,6 +328,18 @@ bool GPhotoCCD::initProperties()
     IUFillSwitchVector(&forceBULBSP, forceBULBS, 2, getDeviceName(), "CCD_FORCE_BLOB", "Force BULB",
                        OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    IUFillSwitch(&keepNativeS[KEEP_NATIVE_ON], "On", "On", ISS_OFF);
+    IUFillSwitch(&keepNativeS[KEEP_NATIVE_OFF], "Off", "Off", ISS_ON);
+    IUFillSwitchVector(&keepNativeSP, keepNativeS, 2, getDeviceName(), "CCD_KEEP_NATIVE", "Keep Native",
+                       OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
+    // Binned previews for framing and focusing
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_FULL], "RAW_FULL", "Full", ISS_ON);
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_BAYER_2X2], "RAW_BAYER_2X2", "Bayer 2x2", ISS_OFF);
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_MONO_2X2], "RAW_MONO_2X2", "Mono 2x2", ISS_OFF);
+    IUFillSwitchVector(&rawQualitySP, rawQualityS, 3, getDeviceName(), "CCD_RAW_QUALITY", "RAW Quality",
+                       OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
     // Upload File
     IUFillText(&UploadFileT[0], "PATH", "Path", nullptr);
     IUFillTextVector(&UploadFileTP, UploadFileT, 1, getDeviceName(), "CCD_UPLOAD_FILE", "Upload File", OPTIONS_TAB, IP_RW, 0,
@@ -405,6 +431,8 @@ bool GPhotoCCD::updateProperties()
             defineProperty(&mFormatSP);
 
         defineProperty(&livePreviewSP);
+        defineProperty(&liveVideoModeSP);
+        defineProperty(&liveVideoStatsNP);
         defineProperty(&TransferFormatSP);
         defineProperty(&autoFocusSP);
 
@@ -444,6 +472,8 @@ bool GPhotoCCD::updateProperties()
         }
 
         defineProperty(&forceBULBSP);
+        defineProperty(&keepNativeSP);
+        defineProperty(&rawQualitySP);
 
         //timerID = SetTimer(getCurrentPollingPeriod());
     }
@@ -458,6 +488,8 @@ bool GPhotoCCD::updateProperties()
 
         deleteProperty(mMirrorLockNP.name);
         deleteProperty(livePreviewSP.name);
+        deleteProperty(liveVideoModeSP.name);
+        deleteProperty(liveVideoStatsNP.name);
         deleteProperty(autoFocusSP.name);
         deleteProperty(TransferFormatSP.name);
 
@@ -475,6 +507,8 @@ bool GPhotoCCD::updateProperties()
         deleteProperty(SDCardImageSP.name);
 
         deleteProperty(forceBULBSP.name);
+        deleteProperty(keepNativeSP.name);
+        deleteProperty(rawQualitySP.name);
 
         HideExtendedOptions();
     }
@@ -595,6 +629,36 @@ bool GPhotoCCD::ISNewSwitch(const char * dev, const char * name, ISState * state
             return true;
         }
 
+        if (!strcmp(name, keepNativeSP.name))
+        {
+            if (IUUpdateSwitch(&keepNativeSP, states, names, n) < 0)
+                return false;
+
+            keepNativeSP.s = IPS_OK;
+            if (keepNativeS[KEEP_NATIVE_ON].s == ISS_ON)
+                LOGF_INFO("Native files shall be saved to %s when transferring FITS.", UploadSettingsT[UPLOAD_DIR].text);
+            else
+                LOG_INFO("Native files shall not be kept when transferring FITS.");
+
+            IDSetSwitch(&keepNativeSP, nullptr);
+            return true;
+        }
+
+        if (!strcmp(name, rawQualitySP.name))
+        {
+            if (IUUpdateSwitch(&rawQualitySP, states, names, n) < 0)
+                return false;
+
+            rawQualitySP.s = IPS_OK;
+            if (rawQualityS[RAW_QUALITY_FULL].s == ISS_ON)
+                LOG_INFO("RAW images shall be decoded at full resolution.");
+            else
+                LOGF_INFO("RAW images shall be decoded as %s previews at half resolution. Subframing is ignored.",
+                          IUFindOnSwitch(&rawQualitySP)->label);
+            IDSetSwitch(&rawQualitySP, nullptr);
+            return true;
+        }
+
         if (!strcmp(name, mExposurePresetSP.name))
         {
             if (IUUpdateSwitch(&mExposurePresetSP, states, names, n) < 0)
@@ -693,6 +757,23 @@ bool GPhotoCCD::ISNewSwitch(const char * dev, const char * name, ISState * state
             return true;
         }
 
+        // Live video mode
+        if (!strcmp(name, liveVideoModeSP.name))
+        {
+            if (Streamer->isBusy())
+            {
+                liveVideoModeSP.s = IPS_ALERT;
+                LOG_WARN("Cannot change live mode while video streaming is active.");
+                IDSetSwitch(&liveVideoModeSP, nullptr);
+                return true;
+            }
+
+            IUUpdateSwitch(&liveVideoModeSP, states, names, n);
+            liveVideoModeSP.s = IPS_OK;
+            IDSetSwitch(&liveVideoModeSP, nullptr);
+            return true;
+        }
+
         // Live preview
 #if 0
         if (!strcmp(name, livePreviewSP.name))
@@ -1042,6 +1123,8 @@ bool GPhotoCCD::Connect()
 
 bool GPhotoCCD::Disconnect()
 {
+    if (nativeWriteFuture.valid())
+        nativeWriteFuture.wait();
     if (isSimulation())
         return true;
     gphoto_close(gphotodrv);
@@ -1288,10 +1371,16 @@ bool GPhotoCCD::grabImage()
     size_t memsize = 0;
     int naxis = 2, w = 0, h = 0, bpp = 8;
 
+    frameRawQuality = RAW_QUALITY_FULL;
     if (TransferFormatS[FORMAT_FITS].s == ISS_ON)
     {
-        char filename[MAXRBUF] = "/tmp/indi_XXXXXX";
+        char filename[MAXRBUF] = {0};
         const char *extension = "unknown";
+        // Downloaded native file, decoded straight from memory
+        const char *nativeBuffer = nullptr;
+        size_t nativeSize = 0;
+        int rc = 0, rawQuality = RAW_QUALITY_FULL;
+
         if (isSimulation())
         {
             if (!UploadFileT[0].text[0])
@@ -1305,29 +1394,26 @@ bool GPhotoCCD::grabImage()
         }
         else
         {
-            int fd = mkstemp(filename);
-            int ret = gphoto_read_exposure_fd(gphotodrv, fd);
-            if (ret != GP_OK || fd == -1)
+            int ret = gphoto_read_exposure(gphotodrv);
+            if (ret != GP_OK)
             {
-                if (fd == -1)
-                    LOGF_ERROR("Exposure failed to save image. Cannot create temp file %s", tmpfile);
-                else
-                {
-                    LOGF_ERROR("Exposure failed to save image... %s", gp_result_as_string(ret));
-                    // As suggested on INDI forums, this result could be misleading.
-                    if (ret == GP_ERROR_DIRECTORY_NOT_FOUND)
-                        LOG_INFO("Make sure BULB switch is ON in the camera. Try setting AF switch to OFF.");
-                }
-                unlink(filename);
+                LOGF_ERROR("Exposure failed to save image... %s", gp_result_as_string(ret));
+                // As suggested on INDI forums, this result could be misleading.
+                if (ret == GP_ERROR_DIRECTORY_NOT_FOUND)
+                    LOG_INFO("Make sure BULB switch is ON in the camera. Try setting AF switch to OFF.");
                 return false;
             }
 
             extension = gphoto_get_file_extension(gphotodrv);
+            if (strcmp(extension, "unknown"))
+                gphoto_get_buffer(gphotodrv, &nativeBuffer, &nativeSize);
         }
 
-        if (!strcmp(extension, "unknown"))
+        if (!strcmp(extension, "unknown") || (!isSimulation() && nativeBuffer == nullptr))
         {
             LOG_ERROR("Exposure failed.");
+            if (!isSimulation())
+                gphoto_free_buffer(gphotodrv);
             return false;
         }
 
@@ -1335,13 +1421,22 @@ bool GPhotoCCD::grabImage()
         if (ExposureRequest > 3)
             LOG_INFO("Exposure done, downloading image...");
 
+        if (nativeBuffer && keepNativeS[KEEP_NATIVE_ON].s == ISS_ON)
+            saveNativeFile(reinterpret_cast<const uint8_t *>(nativeBuffer), nativeSize);
+
         if (strcasecmp(extension, "jpg") == 0 || strcasecmp(extension, "jpeg") == 0)
         {
-            if (read_jpeg(filename, &memptr, &memsize, &naxis, &w, &h))
+            if (nativeBuffer)
+                rc = read_jpeg_buffer(reinterpret_cast<const uint8_t *>(nativeBuffer), nativeSize, &memptr, &memsize, &naxis, &w, &h);
+            else
+                rc = read_jpeg(filename, &memptr, &memsize, &naxis, &w, &h);
+
+            if (!isSimulation())
+                gphoto_free_buffer(gphotodrv);
+
+            if (rc)
             {
                 LOG_ERROR("Exposure failed to parse jpeg.");
-                if (!isSimulation())
-                    unlink(filename);
                 return false;
             }
 
@@ -1352,24 +1447,35 @@ bool GPhotoCCD::grabImage()
         else
         {
             char bayer_pattern[8] = {};
+            rawQuality = frameRawQuality = IUFindOnSwitchIndex(&rawQualitySP);
 
-            if (read_libraw(filename, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
+            if (nativeBuffer)
+                rc = read_libraw_buffer(reinterpret_cast<const uint8_t *>(nativeBuffer), nativeSize, &memptr, &memsize, &naxis, &w, &h,
+                                        &bpp, bayer_pattern, rawQuality);
+            else
+                rc = read_libraw(filename, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern, rawQuality);
+
+            if (!isSimulation())
+                gphoto_free_buffer(gphotodrv);
+
+            if (rc)
             {
                 LOG_ERROR("Exposure failed to parse raw image.");
-                if (!isSimulation())
-                    unlink(filename);
                 return false;
             }
 
             LOGF_DEBUG("read_libraw: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d) bayer pattern (%s)",
                        memsize, naxis, w, h, bpp, bayer_pattern);
 
-            if (!isSimulation())
-                unlink(filename);
-
-            IUSaveText(&BayerT[2], bayer_pattern);
-            IDSetText(&BayerTP, nullptr);
-            SetCCDCapability(GetCCDCapability() | CCD_HAS_BAYER);
+            // Mono previews carry no bayer pattern
+            if (bayer_pattern[0])
+            {
+                IUSaveText(&BayerT[2], bayer_pattern);
+                IDSetText(&BayerTP, nullptr);
+                SetCCDCapability(GetCCDCapability() | CCD_HAS_BAYER);
+            }
+            else
+                SetCCDCapability(GetCCDCapability() & ~CCD_HAS_BAYER);
         }
 
         PrimaryCCD.setImageExtension("fits");
@@ -1380,7 +1486,8 @@ bool GPhotoCCD::grabImage()
         // If subframing is requested
         // If either axis is less than the image resolution
         // then we subframe, given the OTHER axis is within range as well.
-        if ( (subW > 0 && subH > 0) && ((subW < w && subH <= h) || (subH < h && subW <= w)))
+        // Subframes are in full resolution coordinates, so binned previews are always sent whole.
+        if (rawQuality == RAW_QUALITY_FULL && (subW > 0 && subH > 0) && ((subW < w && subH <= h) || (subH < h && subW <= w)))
         {
             uint16_t subX = PrimaryCCD.getSubX();
             uint16_t subY = PrimaryCCD.getSubY();
@@ -1546,6 +1653,67 @@ bool GPhotoCCD::grabImage()
     return true;
 }
 
+void GPhotoCCD::saveNativeFile(const uint8_t * buffer, size_t size)
+{
+    // Only one file is written at a time, which also bounds the memory held by pending writes.
+    if (nativeWriteFuture.valid())
+        nativeWriteFuture.wait();
+
+    std::string path = nativeFilePath(gphoto_get_file_extension(gphotodrv));
+    // The camera file is released as soon as it is decoded, so the writer gets its own copy.
+    std::vector<uint8_t> data(buffer, buffer + size);
+    nativeWriteFuture = std::async(std::launch::async, &GPhotoCCD::writeNativeFile, this, path, std::move(data));
+}
+
+std::string GPhotoCCD::nativeFilePath(const char *extension)
+{
+    std::string prefix = UploadSettingsT[UPLOAD_PREFIX].text;
+
+    char ts[32] = {0};
+    time_t now = time(nullptr);
+    struct tm utc;
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H-%M-%S", gmtime_r(&now, &utc));
+    size_t pos = prefix.find("ISO8601");
+    if (pos != std::string::npos)
+        prefix.replace(pos, strlen("ISO8601"), ts);
+
+    // Cameras reuse their file names, never overwrite an earlier native file
+    for (int index = 1; ; index++)
+    {
+        char number[16] = {0};
+        snprintf(number, sizeof(number), "%03d", index);
+
+        std::string name = prefix;
+        pos = name.find("XXX");
+        if (pos != std::string::npos)
+            name.replace(pos, strlen("XXX"), number);
+        else if (index > 1)
+            name += std::string("_") + number;
+
+        std::string path = std::string(UploadSettingsT[UPLOAD_DIR].text) + "/" + name + "." + extension;
+        struct stat buffer;
+        if (stat(path.c_str(), &buffer) != 0)
+            return path;
+    }
+}
+
+void GPhotoCCD::writeNativeFile(std::string path, std::vector<uint8_t> data)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr)
+    {
+        LOGF_ERROR("Failed to save native file %s: %s", path.c_str(), strerror(errno));
+        return;
+    }
+
+    if (fwrite(data.data(), 1, data.size(), fp) != data.size())
+        LOGF_ERROR("Failed to write native file %s: %s", path.c_str(), strerror(errno));
+    else
+        LOGF_DEBUG("Native file saved to %s", path.c_str());
+
+    fclose(fp);
+}
+
 ISwitch * GPhotoCCD::create_switch(const char * basestr, char ** options, int max_opts, int setidx)
 {
     int i;
@@ -1862,7 +2030,9 @@ bool GPhotoCCD::StartStreaming()
 
     if (gphoto_start_preview(gphotodrv) == GP_OK)
     {
-        Streamer->setPixelFormat(INDI_RGB);
+        // Preview frames are JPEGs, so passthrough hands them to the streamer untouched
+        Streamer->setPixelFormat(liveVideoModeS[LIVE_PASSTHROUGH].s == ISS_ON ? INDI_JPG : INDI_RGB);
+        liveVideoWidth = liveVideoHeight = -1;
         std::unique_lock<std::mutex> guard(liveStreamMutex);
         m_RunLiveStream = true;
         guard.unlock();
@@ -1897,6 +2067,16 @@ void GPhotoCCD::streamLiveView()
         return;
     }
 
+    // The mode cannot change while streaming
+    const int liveMode = IUFindOnSwitchIndex(&liveVideoModeSP);
+    // DCT scale denominators of the decode modes
+    const int scaleDenom[] = {1, 2, 4, 8};
+
+    // Frame rate and per frame processing time, published once per second
+    auto statsStart = std::chrono::steady_clock::now();
+    int statsFrames = 0;
+    double statsProcess = 0;
+
     char errMsg[MAXRBUF] = {0};
     while (true)
     {
@@ -1925,69 +2105,90 @@ void GPhotoCCD::streamLiveView()
         }
 
         uint8_t * inBuffer = reinterpret_cast<uint8_t *>(const_cast<char *>(previewData));
+        auto frameStart = std::chrono::steady_clock::now();
 
-        //        if (streamSubframeS[1].s == ISS_ON)
-        //        {
-        //            if (liveVideoWidth <= 0)
-        //            {
-        //                read_jpeg_size(inBuffer, previewSize, &liveVideoWidth, &liveVideoHeight);
-        //                Streamer->setSize(liveVideoWidth, liveVideoHeight);
-        //            }
-
-        //            std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
-        //            Streamer->newFrame(inBuffer, previewSize);
-        //            ccdguard.unlock();
-        //            continue;
-        //        }
-
-        uint8_t * ccdBuffer      = PrimaryCCD.getFrameBuffer();
-        size_t size             = 0;
-        int w = 0, h = 0, naxis = 0;
-
-        // Read jpeg from memory
-        std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
-        rc = read_jpeg_mem(inBuffer, previewSize, &ccdBuffer, &size, &naxis, &w, &h);
-
-        if (rc != 0)
+        if (liveMode == LIVE_PASSTHROUGH)
         {
-            LOG_ERROR("Error getting live video frame.");
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
-        }
+            // Only the header is parsed to learn the frame size
+            if (liveVideoWidth <= 0)
+            {
+                read_jpeg_size(inBuffer, previewSize, &liveVideoWidth, &liveVideoHeight);
+                Streamer->setSize(liveVideoWidth, liveVideoHeight);
+            }
 
-        if (liveVideoWidth <= 0)
-        {
-            liveVideoWidth = w;
-            liveVideoHeight = h;
-            Streamer->setSize(liveVideoWidth, liveVideoHeight);
+            Streamer->newFrame(inBuffer, previewSize);
         }
+        else
+        {
+            uint8_t * ccdBuffer      = PrimaryCCD.getFrameBuffer();
+            size_t size             = 0;
+            int w = 0, h = 0, naxis = 0;
+
+            // Read jpeg from memory
+            std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
+            rc = read_jpeg_mem(inBuffer, previewSize, &ccdBuffer, &size, &naxis, &w, &h, scaleDenom[liveMode]);
+
+            if (rc != 0)
+            {
+                LOG_ERROR("Error getting live video frame.");
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
 
-        PrimaryCCD.setFrameBuffer(ccdBuffer);
+            if (liveVideoWidth <= 0)
+            {
+                liveVideoWidth = w;
+                liveVideoHeight = h;
+                Streamer->setSize(liveVideoWidth, liveVideoHeight);
+            }
 
-        // We are done with writing to CCD buffer
-        ccdguard.unlock();
+            PrimaryCCD.setFrameBuffer(ccdBuffer);
 
-        if (naxis != PrimaryCCD.getNAxis())
-        {
-            if (naxis == 1)
-                Streamer->setPixelFormat(INDI_MONO);
+            // We are done with writing to CCD buffer
+            ccdguard.unlock();
 
-            PrimaryCCD.setNAxis(naxis);
-        }
+            if (naxis != PrimaryCCD.getNAxis())
+            {
+                if (naxis == 1)
+                    Streamer->setPixelFormat(INDI_MONO);
 
-        if (PrimaryCCD.getSubW() != w || PrimaryCCD.getSubH() != h)
-        {
-            Streamer->setSize(w, h);
-            PrimaryCCD.setFrame(0, 0, w, h);
+                PrimaryCCD.setNAxis(naxis);
+            }
+
+            if (PrimaryCCD.getSubW() != w || PrimaryCCD.getSubH() != h)
+            {
+                Streamer->setSize(w, h);
+                PrimaryCCD.setFrame(0, 0, w, h);
+            }
+
+            if (PrimaryCCD.getFrameBufferSize() != static_cast<int>(size))
+                PrimaryCCD.setFrameBufferSize(size, false);
+
+            Streamer->newFrame(ccdBuffer, size);
         }
 
-        if (PrimaryCCD.getFrameBufferSize() != static_cast<int>(size))
-            PrimaryCCD.setFrameBufferSize(size, false);
+        auto now = std::chrono::steady_clock::now();
+        statsProcess += std::chrono::duration<double, std::milli>(now - frameStart).count();
+        statsFrames++;
 
-        Streamer->newFrame(ccdBuffer, size);
+        double elapsed = std::chrono::duration<double>(now - statsStart).count();
+        if (elapsed >= 1)
+        {
+            liveVideoStatsN[LIVE_STATS_FPS].value = statsFrames / elapsed;
+            liveVideoStatsN[LIVE_STATS_PROCESS].value = statsProcess / statsFrames;
+            liveVideoStatsNP.s = IPS_OK;
+            IDSetNumber(&liveVideoStatsNP, nullptr);
+
+            statsStart = now;
+            statsFrames = 0;
+            statsProcess = 0;
+        }
     }
 
     gp_file_unref(previewFile);
+
+    liveVideoStatsNP.s = IPS_IDLE;
+    IDSetNumber(&liveVideoStatsNP, nullptr);
 }
 
 #if 0
@@ -2102,6 +2303,15 @@ bool GPhotoCCD::saveConfigItems(FILE * fp)
     // Force BULB Mode
     IUSaveConfigSwitch(fp, &forceBULBSP);
 
+    // Keep Native files
+    IUSaveConfigSwitch(fp, &keepNativeSP);
+
+    // RAW decode quality
+    IUSaveConfigSwitch(fp, &rawQualitySP);
+
+    // Live video mode
+    IUSaveConfigSwitch(fp, &liveVideoModeSP);
+
     return true;
 }
 
@@ -2126,6 +2336,8 @@ void GPhotoCCD::addFITSKeywords(fitsfile * fptr, INDI::CCDChip * targetChip)
     {
         fits_update_key_s(fptr, TDOUBLE, "CCD-TEMP", &(TemperatureN[0].value), "CCD Temperature (Celsius)", &status);
     }
+
+    raw_quality_fits_keywords(fptr, frameRawQuality);
 }
 
 bool GPhotoCCD::UpdateCCDUploadMode(CCD_UPLOAD_MODE mode)
@@ -30,6 +30,7 @@
 #include <map>
 #include <future>
 #include <string>
+#include <vector>
 
 #define MAXEXPERR 10 /* max err in exp time we allow, secs */
 #define OPENDT    5  /* open retry delay, secs */
@@ -141,6 +142,11 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
 
         double CalcTimeLeft();
         bool grabImage();
+        // Write the native file to the upload directory on a background thread
+        void saveNativeFile(const uint8_t * buffer, size_t size);
+        void writeNativeFile(std::string path, std::vector<uint8_t> data);
+        // Upload directory path from the upload prefix, XXX and ISO8601 expanded like uploaded images
+        std::string nativeFilePath(const char *extension);
 
         char name[MAXINDIDEVICE];
         char model[MAXINDINAME];
@@ -213,6 +219,26 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         ISwitch livePreviewS[2];
         ISwitchVectorProperty livePreviewSP;
 
+        // Live video decoding: full, DCT scaled or MJPEG passthrough
+        ISwitch liveVideoModeS[5];
+        ISwitchVectorProperty liveVideoModeSP;
+        enum
+        {
+            LIVE_DECODE_FULL,
+            LIVE_DECODE_HALF,
+            LIVE_DECODE_QUARTER,
+            LIVE_DECODE_EIGHTH,
+            LIVE_PASSTHROUGH
+        };
+
+        INumber liveVideoStatsN[2];
+        INumberVectorProperty liveVideoStatsNP;
+        enum
+        {
+            LIVE_STATS_FPS,
+            LIVE_STATS_PROCESS
+        };
+
         ISwitch * mExposurePresetS = nullptr;
         ISwitchVectorProperty mExposurePresetSP;
 
@@ -224,6 +250,21 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
             FORCE_BULB_OFF
         };
 
+        // Keep a copy of the native file next to uploaded images when transferring FITS
+        ISwitch keepNativeS[2];
+        ISwitchVectorProperty keepNativeSP;
+        enum
+        {
+            KEEP_NATIVE_ON,
+            KEEP_NATIVE_OFF
+        };
+
+        // Decode quality of RAW captures, switch order follows RAW_QUALITY_* in gphoto_readimage.h
+        ISwitch rawQualityS[3];
+        ISwitchVectorProperty rawQualitySP;
+        // Quality the frame being sent was decoded at, for its FITS keywords
+        int frameRawQuality {RAW_QUALITY_FULL};
+
         // Upload file, used for testing purposes under simulation under native mode
         ITextVectorProperty UploadFileTP;
         IText UploadFileT[1] {};
@@ -235,6 +276,8 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
 
         // Threading
         std::thread liveViewThread;
+        // Background write of the last native file
+        std::future<void> nativeWriteFuture;
 
         static constexpr double MINUMUM_CAMERA_TEMPERATURE = -60.0;
 
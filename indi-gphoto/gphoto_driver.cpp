@@ -39,6 +39,8 @@
 #include "gphoto_driver.h"
 #include "dsusbdriver.h"
 #include <cmath>
+#include <string>
+#include <unordered_map>
 
 #define EOS_CUSTOMFUNCEX                "customfuncex"
 #define EOS_MIRROR_LOCKUP_ENABLE        "20,1,3,14,1,60f,1,1"
@@ -169,6 +171,12 @@ struct _gphoto_driver
     gphoto_widget_list *widgets;
     gphoto_widget_list *iter;
 
+    // Name and label to widget index of the config tree, built once in gphoto_open
+    std::unordered_map<std::string, CameraWidget *> *widget_index;
+    // Widget changes are staged while a config transaction is open and sent on commit
+    int config_transaction;
+    bool config_pending;
+
     pthread_mutex_t mutex;
     pthread_t thread;
     pthread_cond_t signal;
@@ -284,12 +292,41 @@ int gphoto_read_widget(gphoto_widget *widget)
     return ret;
 }
 
+static void index_widgets(gphoto_driver *gphoto, CameraWidget *widget, bool labels)
+{
+    const char *key = nullptr;
+    int ret = labels ? gp_widget_get_label(widget, &key) : gp_widget_get_name(widget, &key);
+
+    // First match wins, same as the depth first search of gp_widget_get_child_by_name
+    if (ret == GP_OK && key && key[0])
+        gphoto->widget_index->emplace(key, widget);
+
+    int n = gp_widget_count_children(widget);
+    for (int i = 0; i < n; i++)
+    {
+        CameraWidget *child = nullptr;
+        if (gp_widget_get_child(widget, i, &child) == GP_OK)
+            index_widgets(gphoto, child, labels);
+    }
+}
+
 static gphoto_widget *find_widget(gphoto_driver *gphoto, const char *name)
 {
     gphoto_widget *widget = (gphoto_widget *)calloc(sizeof(gphoto_widget), 1);
     int ret;
 
-    widget->name = lookup_widget(gphoto->config, name, &widget->widget);
+    if (gphoto->widget_index)
+    {
+        auto entry = gphoto->widget_index->find(name);
+        if (entry != gphoto->widget_index->end())
+        {
+            widget->widget = entry->second;
+            widget->name   = widget_name(widget->widget);
+        }
+    }
+    else
+        widget->name = lookup_widget(gphoto->config, name, &widget->widget);
+
     if (!widget->name)
     {
         /*fprintf (stderr, "lookup widget failed: %d", ret);*/
@@ -372,6 +409,38 @@ int gphoto_set_config(Camera *camera, CameraWidget *config, GPContext *context)
     return ret;
 }
 
+/*
+ * Send the config tree to the camera, or stage it when a transaction is open.
+ */
+static int apply_config(gphoto_driver *gphoto)
+{
+    if (gphoto->config_transaction > 0)
+    {
+        gphoto->config_pending = true;
+        return GP_OK;
+    }
+
+    return gphoto_set_config(gphoto->camera, gphoto->config, gphoto->context);
+}
+
+void gphoto_begin_config(gphoto_driver *gphoto)
+{
+    gphoto->config_transaction++;
+}
+
+int gphoto_commit_config(gphoto_driver *gphoto)
+{
+    if (gphoto->config_transaction > 0 && --gphoto->config_transaction > 0)
+        return GP_OK;
+
+    if (!gphoto->config_pending)
+        return GP_OK;
+
+    gphoto->config_pending = false;
+    DEBUGDEVICE(device, INDI::Logger::DBG_DEBUG, "Committing staged configuration.");
+    return gphoto_set_config(gphoto->camera, gphoto->config, gphoto->context);
+}
+
 int gphoto_set_widget_num(gphoto_driver *gphoto, gphoto_widget *widget, float value)
 {
     int ret;
@@ -407,7 +476,7 @@ int gphoto_set_widget_num(gphoto_driver *gphoto, gphoto_widget *widget, float va
     }
 
     if (ret == GP_OK)
-        ret = gphoto_set_config(gphoto->camera, gphoto->config, gphoto->context);
+        ret = apply_config(gphoto);
     else
         DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Failed to set widget %s configuration (%s)", widget->name,
                      gp_result_as_string(ret));
@@ -429,7 +498,7 @@ int gphoto_set_widget_text(gphoto_driver *gphoto, gphoto_widget *widget, const c
     if (ret == GP_OK)
     {
         DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Setting text widget %s: %s", widget->name, str);
-        ret = gphoto_set_config(gphoto->camera, gphoto->config, gphoto->context);
+        ret = apply_config(gphoto);
     }
 
     return ret;
@@ -1101,6 +1170,9 @@ int gphoto_start_exposure(gphoto_driver *gphoto, uint32_t exptime_usec, int mirr
     pthread_mutex_lock(&gphoto->mutex);
     DEBUGDEVICE(device, INDI::Logger::DBG_DEBUG, "Mutex locked");
 
+    // ISO, format and exposure settings are sent to the camera in a single config update
+    gphoto_begin_config(gphoto);
+
     // Set ISO Settings
     if (gphoto->iso >= 0)
         gphoto_set_widget_num(gphoto, gphoto->iso_widget, gphoto->iso);
@@ -1178,6 +1250,10 @@ int gphoto_start_exposure(gphoto_driver *gphoto, uint32_t exptime_usec, int mirr
             //            }
         }
 
+        // Settings must reach the camera before the shutter opens
+        if (gphoto_commit_config(gphoto) != GP_OK)
+            gphoto->bulb_mode = false;
+
         // If we have mirror lock enabled, let's lock mirror. Return on failure
         if (mirror_lock)
         {
@@ -1279,6 +1355,7 @@ int gphoto_start_exposure(gphoto_driver *gphoto, uint32_t exptime_usec, int mirr
     if (optimalExposureIndex == -1)
     {
         DEBUGDEVICE(device, INDI::Logger::DBG_ERROR, "Failed to set non-bulb exposure time.");
+        gphoto_commit_config(gphoto);
         pthread_mutex_unlock(&gphoto->mutex);
         return -1;
     }
@@ -1295,6 +1372,15 @@ int gphoto_start_exposure(gphoto_driver *gphoto, uint32_t exptime_usec, int mirr
                      gphoto->exposureList[optimalExposureIndex]);
     }
 
+    // The camera would otherwise expose with its previous shutter speed
+    int ret = gphoto_commit_config(gphoto);
+    if (ret != GP_OK)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Failed to set exposure time on the camera (%s).", gp_result_as_string(ret));
+        pthread_mutex_unlock(&gphoto->mutex);
+        return -1;
+    }
+
     // Lock the mirror if required.
     if (mirror_lock && gphoto_mirrorlock(gphoto, mirror_lock * 1000))
     {
@@ -1707,6 +1793,12 @@ gphoto_driver *gphoto_open(Camera *camera, GPContext *context, const char *model
         return nullptr;
     }
 
+    gphoto->widget_index = new std::unordered_map<std::string, CameraWidget *>();
+    // Names are indexed before labels so they take precedence, as in lookup_widget
+    index_widgets(gphoto, gphoto->config, false);
+    index_widgets(gphoto, gphoto->config, true);
+    DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Indexed %zu configuration widgets.", gphoto->widget_index->size());
+
     // Set 'capture=1' for Canon DSLRs.  Won't harm other cameras
     if ((widget = find_widget(gphoto, "capture")))
     {
@@ -1941,6 +2033,8 @@ int gphoto_close(gphoto_driver *gphoto)
     {
         DEBUGDEVICE(device, INDI::Logger::DBG_DEBUG, "WARNING: Could not close camera connection.");
     }
+    delete gphoto->widget_index;
+
     // We seem to leak the context here.  libgphoto supplies no way to free it?
     free(gphoto);
     return 0;
@@ -2091,6 +2185,11 @@ const char *gphoto_get_file_extension(gphoto_driver *gphoto)
         return "unknown";
 }
 
+const char *gphoto_get_file_name(gphoto_driver *gphoto)
+{
+    return gphoto->filename;
+}
+
 int gphoto_get_dimensions(gphoto_driver *gphoto, int *width, int *height)
 {
     *width  = gphoto->width;
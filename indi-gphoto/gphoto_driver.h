@@ -92,11 +92,16 @@ int gphoto_close(gphoto_driver *gphoto);
 void gphoto_get_buffer(gphoto_driver *gphoto, const char **buffer, size_t *size);
 void gphoto_free_buffer(gphoto_driver *gphoto);
 const char *gphoto_get_file_extension(gphoto_driver *gphoto);
+const char *gphoto_get_file_name(gphoto_driver *gphoto);
 void gphoto_show_options(gphoto_driver *gphoto);
 gphoto_widget_list *gphoto_find_all_widgets(gphoto_driver *gphoto);
 gphoto_widget *gphoto_get_widget_info(gphoto_driver *gphoto, gphoto_widget_list **iter);
 int gphoto_set_widget_num(gphoto_driver *gphoto, gphoto_widget *widget, float value);
 int gphoto_set_widget_text(gphoto_driver *gphoto, gphoto_widget *widget, const char *str);
+// Stage widget changes between begin and commit and send them to the camera in one config update.
+// Transactions nest, only the outermost commit talks to the camera.
+void gphoto_begin_config(gphoto_driver *gphoto);
+int gphoto_commit_config(gphoto_driver *gphoto);
 int gphoto_read_widget(gphoto_widget *widget);
 int gphoto_widget_changed(gphoto_widget *widget);
 int gphoto_get_dimensions(gphoto_driver *gphoto, int *width, int *height);
@@ -12,6 +12,12 @@
 #pragma GCC diagnostic pop
 
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include <unistd.h>
 #include <arpa/inet.h>
 
@@ -313,40 +319,122 @@ int dcraw_parse_header_info(const char *filename, struct dcraw_header *header)
     return 0;
 }
 
-int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
-                char *bayer_pattern)
+// LibRaw keeps several MB of internal state, so a single processor is recycled between images
+// instead of constructing one per frame. The mutex serializes access to it.
+static std::mutex libraw_mutex;
+
+static LibRaw &libraw_processor()
+{
+    static LibRaw RawProcessor;
+    return RawProcessor;
+}
+
+/**
+ * Run func over [0, rows) split into contiguous row bands, one band per worker thread.
+ */
+static void parallel_rows(int rows, const std::function<void(int, int)> &func)
+{
+    // Below a few dozen rows per band the thread start up costs more than it saves
+    int threads = std::min<int>(std::max(1u, std::thread::hardware_concurrency()), std::max(1, rows / 64));
+    threads     = std::min(threads, 8);
+
+    if (threads == 1)
+    {
+        func(0, rows);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    int band = (rows + threads - 1) / threads;
+    for (int start = band; start < rows; start += band)
+        workers.emplace_back(func, start, std::min(start + band, rows));
+    func(0, std::min(band, rows));
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+/**
+ * Average each 2x2 CFA cell into a single mono pixel. Output is half the visible size.
+ */
+static void bin_raw_mono(const uint16_t *src, int stride, uint16_t *dst, int w, int h)
+{
+    parallel_rows(h, [ = ](int start, int end)
+    {
+        for (int y = start; y < end; y++)
+        {
+            const uint16_t *row0 = src + 2 * y * stride;
+            const uint16_t *row1 = row0 + stride;
+            uint16_t *out        = dst + y * w;
+            for (int x = 0; x < w; x++)
+            {
+                uint32_t sum = row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+                out[x]       = static_cast<uint16_t>((sum + 2) >> 2);
+            }
+        }
+    });
+}
+
+/**
+ * Average the four same color pixels of each 4x4 block into one 2x2 CFA cell.
+ * Output is half the visible size and keeps the original bayer pattern.
+ */
+static void bin_raw_bayer(const uint16_t *src, int stride, uint16_t *dst, int w, int h)
+{
+    parallel_rows(h, [ = ](int start, int end)
+    {
+        for (int y = start; y < end; y++)
+        {
+            const uint16_t *row0 = src + (4 * (y >> 1) + (y & 1)) * stride;
+            const uint16_t *row2 = row0 + 2 * stride;
+            uint16_t *out        = dst + y * w;
+            for (int x = 0; x < w; x++)
+            {
+                int col      = 4 * (x >> 1) + (x & 1);
+                uint32_t sum = row0[col] + row0[col + 2] + row2[col] + row2[col + 2];
+                out[x]       = static_cast<uint16_t>((sum + 2) >> 2);
+            }
+        }
+    });
+}
+
+/**
+ * Unpack an opened LibRaw image into a 16 bit frame. Name is only used for logging.
+ * Full quality copies the visible bayered area, preview qualities bin it 2x2 straight from the raw buffer.
+ */
+static int unpack_libraw(LibRaw &RawProcessor, const char *name, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                         int *h, int *bitsperpixel, char *bayer_pattern, int quality)
 {
     int ret = 0;
-    // Creation of image processing object
-    LibRaw RawProcessor;
 
-    // Let us open the file
-    if ((ret = RawProcessor.open_file(filename)) != LIBRAW_SUCCESS)
+    // Let us unpack the image
+    if ((ret = RawProcessor.unpack()) != LIBRAW_SUCCESS)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open %s: %s", filename, libraw_strerror(ret));
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack %s: %s", name, libraw_strerror(ret));
         RawProcessor.recycle();
         return -1;
     }
 
-    // Let us unpack the image
-    if ((ret = RawProcessor.unpack()) != LIBRAW_SUCCESS)
+    if (RawProcessor.imgdata.rawdata.raw_image == nullptr)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack %s: %s", filename, libraw_strerror(ret));
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot read %s: not a bayered raw image.", name);
         RawProcessor.recycle();
         return -1;
     }
 
-    // Covert to image
-    if ((ret = RawProcessor.raw2image()) != LIBRAW_SUCCESS)
+    // Previews only need the raw buffer, the full frame keeps the original conversion path
+    if (quality == RAW_QUALITY_FULL && (ret = RawProcessor.raw2image()) != LIBRAW_SUCCESS)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot convert %s : %s", filename, libraw_strerror(ret));
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot convert %s : %s", name, libraw_strerror(ret));
         RawProcessor.recycle();
         return -1;
     }
 
+    int width  = RawProcessor.imgdata.rawdata.sizes.width;
+    int height = RawProcessor.imgdata.rawdata.sizes.height;
+    int stride = RawProcessor.imgdata.rawdata.sizes.raw_width;
+
     *n_axis       = 2;
-    *w            = RawProcessor.imgdata.rawdata.sizes.width;
-    *h            = RawProcessor.imgdata.rawdata.sizes.height;
     *bitsperpixel = 16;
     // cdesc contains counter-clock wise e.g. RGBG CFA pattern while we want it sequential as RGGB
     bayer_pattern[0] = RawProcessor.imgdata.idata.cdesc[RawProcessor.COLOR(0, 0)];
@@ -355,35 +443,121 @@ int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_
     bayer_pattern[3] = RawProcessor.imgdata.idata.cdesc[RawProcessor.COLOR(1, 1)];
     bayer_pattern[4] = '\0';
 
-    int first_visible_pixel = RawProcessor.imgdata.rawdata.sizes.raw_width * RawProcessor.imgdata.sizes.top_margin +
-                              RawProcessor.imgdata.sizes.left_margin;
+    switch (quality)
+    {
+        case RAW_QUALITY_BAYER_2X2:
+            // Whole 4x4 blocks only so the bayer pattern is preserved
+            *w = (width / 4) * 2;
+            *h = (height / 4) * 2;
+            break;
+
+        case RAW_QUALITY_MONO_2X2:
+            *w = width / 2;
+            *h = height / 2;
+            bayer_pattern[0] = '\0';
+            break;
+
+        default:
+            *w = width;
+            *h = height;
+            break;
+    }
+
+    int first_visible_pixel = stride * RawProcessor.imgdata.sizes.top_margin + RawProcessor.imgdata.sizes.left_margin;
 
     DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG,
                  "read_libraw: raw_width: %d top_margin %d left_margin %d first_visible_pixel %d",
-                 RawProcessor.imgdata.rawdata.sizes.raw_width, RawProcessor.imgdata.sizes.top_margin,
+                 stride, RawProcessor.imgdata.sizes.top_margin,
                  RawProcessor.imgdata.sizes.left_margin, first_visible_pixel);
 
-    *memsize = RawProcessor.imgdata.rawdata.sizes.width * RawProcessor.imgdata.rawdata.sizes.height * sizeof(uint16_t);
+    *memsize = *w * *h * sizeof(uint16_t);
     *memptr  = (uint8_t *)realloc(*memptr, *memsize);
 
     DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG,
-                 "read_libraw: rawdata.sizes.width: %d rawdata.sizes.height %d memsize %d bayer_pattern %s",
-                 RawProcessor.imgdata.rawdata.sizes.width, RawProcessor.imgdata.rawdata.sizes.height, *memsize,
-                 bayer_pattern);
+                 "read_libraw: rawdata.sizes.width: %d rawdata.sizes.height %d memsize %d bayer_pattern %s quality %d",
+                 width, height, *memsize, bayer_pattern, quality);
 
     uint16_t *image = reinterpret_cast<uint16_t *>(*memptr);
     uint16_t *src   = RawProcessor.imgdata.rawdata.raw_image + first_visible_pixel;
 
-    for (int i = 0; i < RawProcessor.imgdata.rawdata.sizes.height; i++)
+    if (quality == RAW_QUALITY_BAYER_2X2)
+        bin_raw_bayer(src, stride, image, *w, *h);
+    else if (quality == RAW_QUALITY_MONO_2X2)
+        bin_raw_mono(src, stride, image, *w, *h);
+    else
     {
-        memcpy(image, src, RawProcessor.imgdata.rawdata.sizes.width * 2);
-        image += RawProcessor.imgdata.rawdata.sizes.width;
-        src += RawProcessor.imgdata.rawdata.sizes.raw_width;
+        for (int i = 0; i < height; i++)
+        {
+            memcpy(image, src, width * 2);
+            image += width;
+            src += stride;
+        }
     }
 
+    // Release the unpacked data now, the processor itself is kept for the next image
+    RawProcessor.recycle();
     return 0;
 }
 
+int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
+                char *bayer_pattern, int quality)
+{
+    int ret = 0;
+    std::lock_guard<std::mutex> lock(libraw_mutex);
+    LibRaw &RawProcessor = libraw_processor();
+
+    // Let us open the file
+    if ((ret = RawProcessor.open_file(filename)) != LIBRAW_SUCCESS)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open %s: %s", filename, libraw_strerror(ret));
+        RawProcessor.recycle();
+        return -1;
+    }
+
+    return unpack_libraw(RawProcessor, filename, memptr, memsize, n_axis, w, h, bitsperpixel, bayer_pattern, quality);
+}
+
+int read_libraw_buffer(const uint8_t *buffer, size_t size, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                       int *h, int *bitsperpixel, char *bayer_pattern, int quality)
+{
+    int ret = 0;
+    std::lock_guard<std::mutex> lock(libraw_mutex);
+    LibRaw &RawProcessor = libraw_processor();
+
+    // Older LibRaw versions take a non-const buffer but never write to it
+    if ((ret = RawProcessor.open_buffer(const_cast<uint8_t *>(buffer), size)) != LIBRAW_SUCCESS)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open raw buffer: %s", libraw_strerror(ret));
+        RawProcessor.recycle();
+        return -1;
+    }
+
+    return unpack_libraw(RawProcessor, "raw buffer", memptr, memsize, n_axis, w, h, bitsperpixel, bayer_pattern, quality);
+}
+
+void raw_quality_fits_keywords(fitsfile *fptr, int quality)
+{
+    if (quality == RAW_QUALITY_FULL)
+        return;
+
+    // Both previews are binned 2x2 on top of the binning the driver reports
+    const int bin = 2;
+    for (const char *key : { "XBINNING", "YBINNING" })
+    {
+        int status = 0;
+        long value = 0;
+        if (fits_read_key_lng(fptr, key, &value, nullptr, &status) == 0)
+            fits_update_key_lng(fptr, key, value * bin, nullptr, &status);
+    }
+    for (const char *key : { "XPIXSZ", "YPIXSZ", "SCALE" })
+    {
+        int status = 0;
+        double value = 0;
+        if (fits_read_key_dbl(fptr, key, &value, nullptr, &status) == 0)
+            fits_update_key_dbl(fptr, key, value * bin, 6, nullptr, &status);
+    }
+}
+
 int read_dcraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel)
 {
     struct dcraw_header header;
@@ -417,60 +591,46 @@ int read_dcraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_a
     return rc;
 }
 
-int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h)
+/**
+ * Decompress a JPEG whose source is already set up into separate R, G and B planes.
+ */
+static void decompress_jpeg_planar(struct jpeg_decompress_struct *cinfo, uint8_t **memptr, size_t *memsize, int *naxis,
+                                   int *w, int *h)
 {
     unsigned char *r_data = nullptr, *g_data = nullptr, *b_data = nullptr;
-
-    /* these are standard libjpeg structures for reading(decompression) */
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
     /* libjpeg data structure for storing one row, that is, scanline of an image */
     JSAMPROW row_pointer[1] = { nullptr };
 
-    FILE *infile = fopen(filename, "rb");
-
-    if (!infile)
-    {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Error opening jpeg file %s!", filename);
-        return -1;
-    }
-    /* here we set up the standard libjpeg error handler */
-    cinfo.err = jpeg_std_error(&jerr);
-    /* setup decompression process and source, then read JPEG header */
-    jpeg_create_decompress(&cinfo);
-    /* this makes the library read from infile */
-    jpeg_stdio_src(&cinfo, infile);
     /* reading the image header which contains image information */
-    jpeg_read_header(&cinfo, (boolean)TRUE);
+    jpeg_read_header(cinfo, (boolean)TRUE);
 
     /* Start decompression jpeg here */
-    jpeg_start_decompress(&cinfo);
+    jpeg_start_decompress(cinfo);
 
-    *memsize = cinfo.output_width * cinfo.output_height * cinfo.num_components;
+    *memsize = cinfo->output_width * cinfo->output_height * cinfo->num_components;
     *memptr  = (uint8_t *)realloc(*memptr, *memsize);
-    uint8_t *oldmem =
-        *memptr; // if you do some ugly pointer math, remember to restore the original pointer or some random crashes will happen. This is why I do not like pointers!!
-    *naxis = cinfo.num_components;
-    *w     = cinfo.output_width;
-    *h     = cinfo.output_height;
+    uint8_t *destmem = *memptr;
+    *naxis = cinfo->num_components;
+    *w     = cinfo->output_width;
+    *h     = cinfo->output_height;
 
     /* now actually read the jpeg into the raw buffer */
-    row_pointer[0] = (unsigned char *)malloc(cinfo.output_width * cinfo.num_components);
-    if (cinfo.num_components)
+    row_pointer[0] = (unsigned char *)malloc(cinfo->output_width * cinfo->num_components);
+    if (cinfo->num_components)
     {
         r_data = (unsigned char *)*memptr;
-        g_data = r_data + cinfo.output_width * cinfo.output_height;
-        b_data = r_data + 2 * cinfo.output_width * cinfo.output_height;
+        g_data = r_data + cinfo->output_width * cinfo->output_height;
+        b_data = r_data + 2 * cinfo->output_width * cinfo->output_height;
     }
     /* read one scan line at a time */
-    for (unsigned int row = 0; row < cinfo.image_height; row++)
+    for (unsigned int row = 0; row < cinfo->image_height; row++)
     {
         unsigned char *ppm8 = row_pointer[0];
-        jpeg_read_scanlines(&cinfo, row_pointer, 1);
+        jpeg_read_scanlines(cinfo, row_pointer, 1);
 
-        if (cinfo.num_components == 3)
+        if (cinfo->num_components == 3)
         {
-            for (unsigned int i = 0; i < cinfo.output_width; i++)
+            for (unsigned int i = 0; i < cinfo->output_width; i++)
             {
                 *r_data++ = *ppm8++;
                 *g_data++ = *ppm8++;
@@ -479,27 +639,68 @@ int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxi
         }
         else
         {
-            memcpy(*memptr, ppm8, cinfo.output_width);
-            *memptr += cinfo.output_width;
+            memcpy(destmem, ppm8, cinfo->output_width);
+            destmem += cinfo->output_width;
         }
     }
 
-    /* wrap up decompression, destroy objects, free pointers and close open files */
-    jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
+    /* wrap up decompression, free pointers */
+    jpeg_finish_decompress(cinfo);
 
     if (row_pointer[0])
         free(row_pointer[0]);
-    if (infile)
-        fclose(infile);
+}
 
-    *memptr = oldmem;
+int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h)
+{
+    /* these are standard libjpeg structures for reading(decompression) */
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    FILE *infile = fopen(filename, "rb");
+
+    if (!infile)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Error opening jpeg file %s!", filename);
+        return -1;
+    }
+    /* here we set up the standard libjpeg error handler */
+    cinfo.err = jpeg_std_error(&jerr);
+    /* setup decompression process and source */
+    jpeg_create_decompress(&cinfo);
+    /* this makes the library read from infile */
+    jpeg_stdio_src(&cinfo, infile);
+
+    decompress_jpeg_planar(&cinfo, memptr, memsize, naxis, w, h);
+
+    jpeg_destroy_decompress(&cinfo);
+    fclose(infile);
+
+    return 0;
+}
+
+int read_jpeg_buffer(const uint8_t *buffer, size_t size, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h)
+{
+    /* these are standard libjpeg structures for reading(decompression) */
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    /* here we set up the standard libjpeg error handler */
+    cinfo.err = jpeg_std_error(&jerr);
+    /* setup decompression process and source */
+    jpeg_create_decompress(&cinfo);
+    /* older libjpeg versions take a non-const buffer but never write to it */
+    jpeg_mem_src(&cinfo, const_cast<unsigned char *>(buffer), size);
+
+    decompress_jpeg_planar(&cinfo, memptr, memsize, naxis, w, h);
+
+    jpeg_destroy_decompress(&cinfo);
 
     return 0;
 }
 
 int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
-                  int *h)
+                  int *h, int scale_denom)
 {
     /* these are standard libjpeg structures for reading(decompression) */
     struct jpeg_decompress_struct cinfo;
@@ -517,37 +718,37 @@ int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **mempt
     /* reading the image header which contains image information */
     jpeg_read_header(&cinfo, (boolean)TRUE);
 
+    /* downscale in the DCT domain, which skips most of the IDCT and color conversion work */
+    if (scale_denom > 1)
+    {
+        cinfo.scale_num           = 1;
+        cinfo.scale_denom         = scale_denom;
+        cinfo.dct_method          = JDCT_IFAST;
+        cinfo.do_fancy_upsampling = FALSE;
+    }
+
     /* Start decompression jpeg here */
     jpeg_start_decompress(&cinfo);
 
-    *memsize = cinfo.output_width * cinfo.output_height * cinfo.num_components;
+    size_t row_size = cinfo.output_width * cinfo.output_components;
+    *memsize = row_size * cinfo.output_height;
     *memptr  = (uint8_t *)realloc(*memptr, *memsize);
 
-    uint8_t *destmem = *memptr;
-
-    *naxis = cinfo.num_components;
+    *naxis = cinfo.output_components;
     *w     = cinfo.output_width;
     *h     = cinfo.output_height;
 
-    /* now actually read the jpeg into the raw buffer */
-    row_pointer[0] = (unsigned char *)malloc(cinfo.output_width * cinfo.num_components);
-
-    /* read one scan line at a time */
-    for (unsigned int row = 0; row < cinfo.image_height; row++)
+    /* read straight into the destination buffer, one scan line at a time */
+    while (cinfo.output_scanline < cinfo.output_height)
     {
-        unsigned char *ppm8 = row_pointer[0];
+        row_pointer[0] = *memptr + cinfo.output_scanline * row_size;
         jpeg_read_scanlines(&cinfo, row_pointer, 1);
-        memcpy(destmem, ppm8, cinfo.output_width * cinfo.num_components);
-        destmem += cinfo.output_width * cinfo.num_components;
     }
 
     /* wrap up decompression, destroy objects, free pointers and close open files */
     jpeg_finish_decompress(&cinfo);
     jpeg_destroy_decompress(&cinfo);
 
-    if (row_pointer[0])
-        free(row_pointer[0]);
-
     return 0;
 }
 
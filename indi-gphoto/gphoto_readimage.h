@@ -4,11 +4,27 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <fitsio.h>
+
+/** Output quality of read_libraw. Preview qualities bin the raw frame 2x2 to half its size. */
+enum
+{
+    RAW_QUALITY_FULL = 0,
+    RAW_QUALITY_BAYER_2X2,  // Same color pixels binned, bayer pattern kept
+    RAW_QUALITY_MONO_2X2,   // Each CFA cell averaged into one mono pixel
+};
+
 int read_dcraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel);
 int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
-                char *bayer_pattern);
+                char *bayer_pattern, int quality = RAW_QUALITY_FULL);
+int read_libraw_buffer(const uint8_t *buffer, size_t size, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                       int *h, int *bitsperpixel, char *bayer_pattern, int quality = RAW_QUALITY_FULL);
+/** Scale the binning, binned pixel size and image scale keywords of a frame decoded at a preview quality */
+void raw_quality_fits_keywords(fitsfile *fptr, int quality);
 int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h);
+int read_jpeg_buffer(const uint8_t *buffer, size_t size, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h);
+// scale_denom of 2, 4 or 8 decodes a downscaled image
 int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
-                  int *h);
+                  int *h, int scale_denom = 1);
 int read_jpeg_size(unsigned char *inBuffer, unsigned long inSize, int *w, int *h);
 void gphoto_read_set_debug(const char *name);
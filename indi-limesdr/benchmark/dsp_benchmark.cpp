@@ -0,0 +1,220 @@
+/*
+    LimeSDR DSP benchmark
+
+    Kernels: the decimation filter and the filter bank on generated test tones, with each
+    supported instruction set, in Msamples/s of input and with the largest difference to
+    the scalar results.
+
+    Chain: what the reader thread of the driver does with every block, decimation and then
+    integration, on two tones of equal amplitude: one in the band that is kept, which has
+    to show in its channel, and one outside it, whose alias shows how much of it the
+    decimation filter lets through.
+
+    Usage: dsp_benchmark [-r sample rate] [-t seconds] [-d decimation] [-f taps per phase]
+                         [-c channels] [-p taps per channel]
+*/
+
+#include "decimator.h"
+#include "channelizer.h"
+#include "dspkernels.h"
+#include "iqsource.h"
+#include "spectralintegrator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <unistd.h>
+#include <vector>
+
+using namespace DSPKernels;
+
+typedef std::chrono::steady_clock Clock;
+
+#define BLOCK_SIZE (16384)
+
+static double measure(double seconds, const std::function<void()> &kernel)
+{
+    kernel(); // warm up caches and page in buffers
+
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed;
+    do
+    {
+        kernel();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    while (elapsed < seconds);
+
+    return elapsed / runs;
+}
+
+static double maxDifference(const std::vector<float> &a, const std::vector<float> &b)
+{
+    double d = 0;
+    for (size_t i = 0; i < a.size(); i++)
+        d = std::max(d, static_cast<double>(std::fabs(a[i] - b[i])));
+    return d;
+}
+
+// Channel of a frequency, in the order of SpectralIntegrator::getSpectrum()
+static int channelOf(double frequency, double samplerate, int channels)
+{
+    double f = frequency / samplerate;
+    f -= std::floor(f + 0.5);
+    return (static_cast<int>(std::lround(f * channels)) + channels + channels / 2) % channels;
+}
+
+int main(int argc, char *argv[])
+{
+    double samplerate = 10e6, seconds = 1;
+    int factor = 8, phasetaps = 16, channels = 256, taps = 4, opt;
+
+    while ((opt = getopt(argc, argv, "r:t:d:f:c:p:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r':
+                samplerate = atof(optarg);
+                break;
+            case 't':
+                seconds = atof(optarg);
+                break;
+            case 'd':
+                factor = std::max(1, atoi(optarg));
+                break;
+            case 'f':
+                phasetaps = std::max(1, atoi(optarg));
+                break;
+            case 'c':
+                channels = atoi(optarg);
+                break;
+            case 'p':
+                taps = std::max(1, atoi(optarg));
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-r sample rate] [-t seconds] [-d decimation] [-f taps per phase] "
+                        "[-c channels] [-p taps per channel]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (!FFT::isPowerOfTwo(channels))
+    {
+        fprintf(stderr, "The channels must be a power of two\n");
+        return 1;
+    }
+
+    double outrate = samplerate / factor;
+    // In the band, half way up; outside, a bit over two output bandwidths up
+    double inband  = outrate / 4;
+    double outband = factor > 1 ? 2.3 * outrate : 0;
+
+    SyntheticIQSource source(samplerate);
+    source.addTone(inband, 0.1);
+    if (factor > 1)
+        source.addTone(outband, 0.1);
+    source.setNoise(1e-4);
+    source.start();
+
+    std::vector<float> block(2 * BLOCK_SIZE);
+    source.read(block.data(), BLOCK_SIZE, 0);
+
+    // Kernels, one block at a time
+    Decimator decimator;
+    decimator.reset(factor, phasetaps);
+    Channelizer channelizer;
+    channelizer.reset(channels, taps);
+
+    printf("%d samples a block, decimation %d with %d taps, %d channels with %d taps each\n\n", BLOCK_SIZE, factor,
+           decimator.getTaps(), channels, taps);
+    printf("%-22s%10s%10s%14s\n", "Kernel", "Isa", "MS/s", "Difference");
+
+    std::vector<float> reference, decimated(2 * decimator.outputSize(BLOCK_SIZE)), spectra;
+    // Decimation by 1 is a copy, nothing to measure
+    for (int kernel = factor > 1 ? 0 : 1; kernel < 2; kernel++)
+    {
+        for (Isa isa : { ISA_SCALAR, ISA_SSE2, ISA_AVX, ISA_NEON })
+        {
+            if (!selectIsa(isa))
+                continue;
+
+            std::vector<float> result;
+            double t;
+            if (kernel == 0)
+            {
+                t = measure(seconds / 4, [&]
+                {
+                    decimator.reset(factor, phasetaps);
+                    decimator.process(block.data(), BLOCK_SIZE, decimated.data());
+                });
+                int n = decimator.process(block.data(), BLOCK_SIZE, decimated.data());
+                result.assign(decimated.begin(), decimated.begin() + 2 * n);
+            }
+            else
+            {
+                t = measure(seconds / 4, [&]
+                {
+                    channelizer.reset(channels, taps);
+                    channelizer.push(block.data(), BLOCK_SIZE);
+                    while (channelizer.next())
+                        ;
+                });
+                channelizer.reset(channels, taps);
+                channelizer.push(block.data(), BLOCK_SIZE);
+                for (const std::complex<float> *frame = channelizer.next(); frame; frame = channelizer.next())
+                    result.insert(result.end(), reinterpret_cast<const float *>(frame),
+                                  reinterpret_cast<const float *>(frame + channels));
+            }
+
+            if (isa == ISA_SCALAR)
+                reference = result;
+            printf("%-22s%10s%10.1f%14.2e\n", kernel == 0 ? "decimation" : "filter bank", toString(isa),
+                   BLOCK_SIZE / t / 1e6, maxDifference(reference, result));
+        }
+    }
+
+    // Chain, as the reader thread runs it, on the fastest instruction set
+    selectIsa(ISA_AVX) || selectIsa(ISA_NEON) || selectIsa(ISA_SSE2);
+    uint64_t total = static_cast<uint64_t>(samplerate * seconds);
+    SpectralIntegrator integrator;
+    integrator.reset(channels, 1, taps);
+    decimator.reset(factor, phasetaps);
+
+    double busy = 0;
+    for (uint64_t done = 0; done < total;)
+    {
+        int n = source.read(block.data(), static_cast<int>(std::min<uint64_t>(BLOCK_SIZE, total - done)), 0);
+        Clock::time_point begin = Clock::now();
+        int m = decimator.process(block.data(), n, decimated.data());
+        integrator.add(decimated.data(), m);
+        busy += std::chrono::duration<double>(Clock::now() - begin).count();
+        done += n;
+    }
+    integrator.finish();
+
+    std::vector<float> spectrum(channels);
+    integrator.getSpectrum(spectrum.data());
+    int peak = static_cast<int>(std::max_element(spectrum.begin(), spectrum.end()) - spectrum.begin());
+    int tone = channelOf(inband, outrate, channels);
+
+    printf("\nchain with %s at %.1f MS/s: %.1f MS/s in, %.1f%% busy, %lu spectra\n", toString(activeIsa()),
+           samplerate / 1e6, total / busy / 1e6, 100.0 * samplerate * busy / total, integrator.getSpectra());
+    printf("tone in the band in channel %d, the spectrum peaks in channel %d\n", tone, peak);
+    if (factor > 1)
+    {
+        int alias = channelOf(outband, outrate, channels);
+        printf("tone outside the band aliased to channel %d, %.1f dB down\n", alias,
+               10 * std::log10(spectrum[tone] / spectrum[alias]));
+    }
+
+    if (peak != tone)
+    {
+        fprintf(stderr, "The tone in the band is not in its channel\n");
+        return 1;
+    }
+    return 0;
+}
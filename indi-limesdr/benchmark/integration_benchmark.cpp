@@ -0,0 +1,116 @@
+/*
+    LimeSDR integration benchmark
+
+    Runs the acquisition of the driver without a receiver: the synthetic source, read in
+    blocks of SUBFRAME_SIZE samples and folded into the spectrum and the continuum as they
+    come. A tone sits in a known bin, the run fails if the spectrum does not peak there.
+
+    Reports the samples integrated per second, which has to stay above the sample rate for
+    the receiver FIFO not to overflow, and the size of the continuum, which stops growing
+    with the length of the integration once it has MAX_CONTINUUM_SIZE points.
+
+    Usage: integration_benchmark [-r sample rate] [-t seconds] [-b bins] [-B block] [-n noise rms] [-R]
+*/
+
+#include "iqsource.h"
+#include "spectralintegrator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// Same as the driver
+#define SUBFRAME_SIZE      (16384)
+#define MAX_CONTINUUM_SIZE (1 << 20)
+
+int main(int argc, char *argv[])
+{
+    double samplerate = 10e6, seconds = 10, noise = 0.05;
+    int bins = 256, blocksize = SUBFRAME_SIZE, opt;
+    bool realtime = false;
+
+    while ((opt = getopt(argc, argv, "r:t:b:B:n:R")) != -1)
+    {
+        switch (opt)
+        {
+            case 'r':
+                samplerate = atof(optarg);
+                break;
+            case 't':
+                seconds = atof(optarg);
+                break;
+            case 'b':
+                bins = atoi(optarg);
+                break;
+            case 'B':
+                blocksize = std::max(1, atoi(optarg));
+                break;
+            case 'n':
+                noise = atof(optarg);
+                break;
+            case 'R':
+                realtime = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-r sample rate] [-t seconds] [-b bins] [-B block] [-n noise rms] [-R]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    uint64_t total = static_cast<uint64_t>(samplerate * seconds);
+    SpectralIntegrator integrator;
+    if (total == 0 || !integrator.reset(bins, (total + MAX_CONTINUUM_SIZE - 1) / MAX_CONTINUUM_SIZE))
+    {
+        fprintf(stderr, "Bins must be a power of two and the integration not empty\n");
+        return 1;
+    }
+
+    // A quarter of the band up, in the middle of a bin
+    int tonebin = bins / 2 + bins / 4;
+    SyntheticIQSource source(samplerate);
+    source.addTone(samplerate / 4, 0.1);
+    source.setNoise(noise);
+    source.setRealtime(realtime);
+    source.start();
+
+    std::vector<float> block(2 * blocksize);
+    double busy = 0;
+    Clock::time_point start = Clock::now();
+    while (integrator.getSamples() < total)
+    {
+        int n = source.read(block.data(), static_cast<int>(std::min<uint64_t>(blocksize, total - integrator.getSamples())),
+                            1000);
+        Clock::time_point begin = Clock::now();
+        integrator.add(block.data(), n);
+        busy += std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+    integrator.finish();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<float> spectrum(bins);
+    integrator.getSpectrum(spectrum.data());
+    int peak = static_cast<int>(std::max_element(spectrum.begin(), spectrum.end()) - spectrum.begin());
+
+    printf("%.0f samples/s for %.1f s, %d bins, blocks of %d samples%s\n", samplerate, seconds, bins, blocksize,
+           realtime ? ", paced" : "");
+    printf("integration: %8.2f Msamples/s, busy %.1f%% of the time at this rate\n", total / busy / 1e6,
+           100.0 * samplerate * busy / total);
+    printf("end to end:  %8.2f Msamples/s, with the source\n", total / elapsed / 1e6);
+    printf("%lu spectra, %zu continuum points of %llu samples, %zu bytes\n", integrator.getSpectra(),
+           integrator.getContinuum().size(),
+           static_cast<unsigned long long>((total + MAX_CONTINUUM_SIZE - 1) / MAX_CONTINUUM_SIZE),
+           integrator.getContinuum().size() * sizeof(float));
+
+    if (peak != tonebin)
+    {
+        fprintf(stderr, "The spectrum peaks in bin %d, the tone is in bin %d\n", peak, tonebin);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "channelizer.h"
+#include "dspkernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+Channelizer::Channelizer()
+{
+    reset(1, 1);
+}
+
+bool Channelizer::reset(int channels, int t)
+{
+    if (!FFT::isPowerOfTwo(channels) || t < 1)
+        return false;
+
+    fft  = FFT(channels);
+    taps = t;
+
+    size_t length = static_cast<size_t>(channels) * taps;
+    prototype.resize(2 * length);
+    tapPower = 0;
+    for (size_t n = 0; n < length; n++)
+    {
+        double x = M_PI * (n - (length - 1) / 2.0) / channels;
+        double w = 0.5 - 0.5 * std::cos(2.0 * M_PI * (n + 0.5) / length);
+        double h = (x == 0 ? 1.0 : std::sin(x) / x) * w;
+        prototype[2 * n] = prototype[2 * n + 1] = static_cast<float>(h);
+        tapPower += h * h;
+    }
+
+    history.clear();
+    start = 0;
+    frame.resize(channels);
+    return true;
+}
+
+void Channelizer::push(const float *iq, int samples)
+{
+    history.insert(history.end(), iq, iq + 2 * samples);
+}
+
+const std::complex<float> *Channelizer::next()
+{
+    size_t channels = fft.size();
+    if (history.size() / 2 - start < channels * taps)
+    {
+        // Only what the next frame needs is kept
+        history.erase(history.begin(), history.begin() + 2 * start);
+        start = 0;
+        return nullptr;
+    }
+
+    DSPKernels::pfbWeight(&history[2 * start], prototype.data(), channels, taps, reinterpret_cast<float *>(frame.data()));
+    fft.transform(frame.data());
+    start += channels;
+    return frame.data();
+}
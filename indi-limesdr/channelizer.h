@@ -0,0 +1,64 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "fft.h"
+
+#include <complex>
+#include <vector>
+
+/*
+ * Polyphase filter bank: splits an IQ stream into channels of equal width, one frame of
+ * channels for every channels samples. Each frame is the FFT of the last taps * channels
+ * samples, weighted by a prototype low pass filter and folded into one block, so that the
+ * channels are flat and leak much less into each other than the bins of a windowed FFT.
+ *
+ * The prototype is a Hann windowed sinc as wide as one channel. With taps 1 it is
+ * little more than the window.
+ *
+ * Fed with push() and read with next(), like a framer.
+ */
+class Channelizer
+{
+  public:
+    Channelizer();
+
+    /* channels a power of two, taps of the prototype per channel. Returns false if it is not. */
+    bool reset(int channels, int taps);
+
+    int getChannels() const { return fft.size(); }
+    int getTaps() const { return taps; }
+    /* White noise of power v gives v * getTapPower() in every channel */
+    double getTapPower() const { return tapPower; }
+
+    /* samples samples, I and Q interleaved */
+    void push(const float *iq, int samples);
+    /* The next frame, channel 0 at the centre frequency and the negative ones in the upper
+       half, or nullptr until more samples are pushed. Valid until the next call. */
+    const std::complex<float> *next();
+
+  private:
+    FFT fft;
+    int taps { 1 };
+    std::vector<float> prototype;
+    double tapPower { 1 };
+    std::vector<float> history;
+    size_t start { 0 };
+    std::vector<std::complex<float>> frame;
+};
@@ -0,0 +1,72 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "decimator.h"
+#include "dspkernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Decimator::Decimator()
+{
+    reset(1);
+}
+
+void Decimator::reset(int f, int tapsPerPhase)
+{
+    factor = std::max(1, f);
+    ntaps  = factor > 1 ? static_cast<size_t>(factor * std::max(1, tapsPerPhase)) : 1;
+
+    std::vector<double> h(ntaps);
+    double sum = 0;
+    for (size_t n = 0; n < ntaps; n++)
+    {
+        double t = n - (ntaps - 1) / 2.0;
+        double x = M_PI * t / factor;
+        double w = 0.42 - 0.5 * std::cos(2.0 * M_PI * (n + 0.5) / ntaps) + 0.08 * std::cos(4.0 * M_PI * (n + 0.5) / ntaps);
+        h[n] = (x == 0 ? 1.0 : std::sin(x) / x) * w;
+        sum += h[n];
+    }
+
+    // Symmetric, the order does not matter to the kernel
+    taps.resize(2 * ntaps);
+    for (size_t n = 0; n < ntaps; n++)
+        taps[2 * n] = taps[2 * n + 1] = static_cast<float>(h[n] / sum);
+
+    history.clear();
+}
+
+int Decimator::process(const float *iq, int samples, float *out)
+{
+    if (factor == 1)
+    {
+        memcpy(out, iq, 2 * samples * sizeof(float));
+        return samples;
+    }
+
+    history.insert(history.end(), iq, iq + 2 * samples);
+    size_t available = history.size() / 2;
+    if (available < ntaps)
+        return 0;
+
+    size_t count = (available - ntaps) / factor + 1;
+    DSPKernels::firDecimate(history.data(), taps.data(), ntaps, factor, out, count);
+    history.erase(history.begin(), history.begin() + 2 * count * factor);
+    return static_cast<int>(count);
+}
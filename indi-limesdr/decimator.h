@@ -0,0 +1,53 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Low pass filter and decimation of an IQ stream, in polyphase form: the filter is only
+ * computed for the samples that are kept. Streams block by block, the samples the next
+ * output needs are kept between calls.
+ *
+ * The filter is a Blackman windowed sinc cut at the Nyquist frequency of the output,
+ * factor * tapsPerPhase taps long, with a gain of one at the centre frequency.
+ */
+class Decimator
+{
+  public:
+    Decimator();
+
+    /* factor 1 passes the samples through */
+    void reset(int factor, int tapsPerPhase = 16);
+
+    int getFactor() const { return factor; }
+    int getTaps() const { return static_cast<int>(ntaps); }
+    /* Most samples process() gives for samples in */
+    int outputSize(int samples) const { return samples / factor + 2; }
+
+    /* samples samples, I and Q interleaved, in; the decimated ones out. Returns how many. */
+    int process(const float *iq, int samples, float *out);
+
+  private:
+    int factor { 1 };
+    size_t ntaps { 1 };
+    std::vector<float> taps;
+    std::vector<float> history;
+};
@@ -0,0 +1,154 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "dspkernels_p.h"
+
+#include <kerneldispatch.h>
+
+namespace DSPKernels
+{
+
+/////////////////////////////////////////////////////////////////////////////
+/// Scalar reference implementations
+/////////////////////////////////////////////////////////////////////////////
+namespace Scalar
+{
+
+void firDecimate(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out, size_t outSamples)
+{
+    for (size_t m = 0; m < outSamples; m++)
+    {
+        const float *x = iq + 2 * m * factor;
+        float i = 0, q = 0;
+        for (size_t k = 0; k < ntaps; k++)
+        {
+            i += taps[2 * k] * x[2 * k];
+            q += taps[2 * k + 1] * x[2 * k + 1];
+        }
+        out[2 * m]     = i;
+        out[2 * m + 1] = q;
+    }
+}
+
+void pfbWeight(const float *iq, const float *taps, size_t channels, size_t segments, float *out)
+{
+    const size_t n = 2 * channels;
+    for (size_t j = 0; j < n; j++)
+        out[j] = taps[j] * iq[j];
+    for (size_t p = 1; p < segments; p++)
+        for (size_t j = 0; j < n; j++)
+            out[j] += taps[p * n + j] * iq[p * n + j];
+}
+
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Dispatcher
+/////////////////////////////////////////////////////////////////////////////
+static Kernels scalarKernels()
+{
+    Kernels k;
+    k.firDecimate = Scalar::firDecimate;
+    k.pfbWeight   = Scalar::pfbWeight;
+    return k;
+}
+
+// The CPU checks and the table selection are shared with pixelkernels
+static bool cpuSupports(Isa isa)
+{
+    switch (isa)
+    {
+        case ISA_SCALAR:
+            return true;
+        case ISA_SSE2:
+            return PixelKernels::cpuHas(PixelKernels::CPU_SSE2);
+        case ISA_AVX:
+            return PixelKernels::cpuHas(PixelKernels::CPU_AVX);
+        case ISA_NEON:
+            return PixelKernels::cpuHas(PixelKernels::CPU_NEON);
+    }
+    return false;
+}
+
+static bool buildKernels(Isa isa, Kernels &k)
+{
+    if (!cpuSupports(isa))
+        return false;
+
+    k = scalarKernels();
+    switch (isa)
+    {
+        case ISA_SCALAR:
+            return true;
+        case ISA_SSE2:
+            return initSse2(k);
+        case ISA_AVX:
+            return initAvx(k);
+        case ISA_NEON:
+            return initNeon(k);
+    }
+    return false;
+}
+
+static PixelKernels::Dispatcher<Kernels, Isa, ISA_NEON + 1> &dispatcher()
+{
+    static PixelKernels::Dispatcher<Kernels, Isa, ISA_NEON + 1> instance(buildKernels, {ISA_AVX, ISA_SSE2, ISA_NEON, ISA_SCALAR});
+    return instance;
+}
+
+static const Kernels &kernels()
+{
+    return dispatcher().get();
+}
+
+Isa activeIsa()
+{
+    return dispatcher().activeIsa();
+}
+
+const char *toString(Isa isa)
+{
+    switch (isa)
+    {
+        case ISA_SCALAR: return "Scalar";
+        case ISA_SSE2:   return "SSE2";
+        case ISA_AVX:    return "AVX";
+        case ISA_NEON:   return "NEON";
+    }
+    return "Unknown";
+}
+
+bool selectIsa(Isa isa)
+{
+    return dispatcher().select(isa);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Public API
+/////////////////////////////////////////////////////////////////////////////
+void firDecimate(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out, size_t outSamples)
+{
+    kernels().firDecimate(iq, taps, ntaps, factor, out, outSamples);
+}
+
+void pfbWeight(const float *iq, const float *taps, size_t channels, size_t segments, float *out)
+{
+    kernels().pfbWeight(iq, taps, channels, segments, out);
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Vector loops of the receiver DSP: the decimation filter and the filter bank.
+ *
+ * Every kernel has a scalar implementation and SSE2, AVX and NEON variants. The fastest
+ * variant supported by the running CPU is picked on first use by the pixelkernels
+ * dispatcher. The variants add in a different order, results agree to float rounding.
+ *
+ * Samples are complex, I and Q interleaved as 32 bit floats. Filter taps are real and
+ * given twice, once for I and once for Q, so that they line up with the samples.
+ */
+namespace DSPKernels
+{
+
+/** Instruction set used by the dispatcher */
+enum Isa
+{
+    ISA_SCALAR,
+    ISA_SSE2,
+    ISA_AVX,
+    ISA_NEON
+};
+
+/** Return the instruction set selected for this CPU */
+Isa activeIsa();
+
+/** Human readable name of an instruction set */
+const char *toString(Isa isa);
+
+/**
+ * @brief Force the dispatcher to a given instruction set, used by the benchmarks.
+ * @return false if the CPU or the build does not support it, the current selection is kept.
+ */
+bool selectIsa(Isa isa);
+
+/**
+ * @brief FIR filter computed at every @a factor-th sample only, the polyphase decimator.
+ * Output m is the sum over k of taps[2k] * iq[m * factor + k], taps[0] applying to the oldest sample.
+ * @param iq (outSamples - 1) * factor + taps samples
+ * @param taps 2 * @a ntaps floats
+ * @param out outSamples samples
+ */
+void firDecimate(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out, size_t outSamples);
+
+/**
+ * @brief Front end of the polyphase filter bank: the last @a segments blocks of @a channels samples,
+ * weighted by the prototype filter and summed into one block, ready for the FFT.
+ * out[k] = sum over p of taps[2 (p * channels + k)] * iq[p * channels + k], oldest block first.
+ * @param iq channels * segments samples
+ * @param taps 2 * channels * segments floats
+ * @param out channels samples
+ */
+void pfbWeight(const float *iq, const float *taps, size_t channels, size_t segments, float *out);
+
+}
@@ -0,0 +1,101 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "dspkernels_p.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+namespace DSPKernels
+{
+
+static void firDecimateNeon(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out,
+                            size_t outSamples)
+{
+    const size_t n = 2 * ntaps;
+    for (size_t m = 0; m < outSamples; m++)
+    {
+        const float *x = iq + 2 * m * factor;
+        float32x4_t acc0 = vdupq_n_f32(0);
+        float32x4_t acc1 = vdupq_n_f32(0);
+        size_t j = 0;
+        for (; j + 8 <= n; j += 8)
+        {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(taps + j), vld1q_f32(x + j));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(taps + j + 4), vld1q_f32(x + j + 4));
+        }
+        for (; j + 4 <= n; j += 4)
+            acc0 = vmlaq_f32(acc0, vld1q_f32(taps + j), vld1q_f32(x + j));
+
+        // I Q I Q -> I Q
+        acc0 = vaddq_f32(acc0, acc1);
+        float32x2_t acc = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0));
+        float i = vget_lane_f32(acc, 0);
+        float q = vget_lane_f32(acc, 1);
+        for (; j < n; j += 2)
+        {
+            i += taps[j] * x[j];
+            q += taps[j + 1] * x[j + 1];
+        }
+        out[2 * m]     = i;
+        out[2 * m + 1] = q;
+    }
+}
+
+static void pfbWeightNeon(const float *iq, const float *taps, size_t channels, size_t segments, float *out)
+{
+    const size_t n = 2 * channels;
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        float32x4_t acc = vmulq_f32(vld1q_f32(taps + j), vld1q_f32(iq + j));
+        for (size_t p = 1; p < segments; p++)
+            acc = vmlaq_f32(acc, vld1q_f32(taps + p * n + j), vld1q_f32(iq + p * n + j));
+        vst1q_f32(out + j, acc);
+    }
+    for (; j < n; j++)
+    {
+        out[j] = taps[j] * iq[j];
+        for (size_t p = 1; p < segments; p++)
+            out[j] += taps[p * n + j] * iq[p * n + j];
+    }
+}
+
+bool initNeon(Kernels &k)
+{
+    k.firDecimate = firDecimateNeon;
+    k.pfbWeight   = pfbWeightNeon;
+    return true;
+}
+
+}
+
+#else
+
+namespace DSPKernels
+{
+
+bool initNeon(Kernels &)
+{
+    return false;
+}
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "dspkernels.h"
+
+namespace DSPKernels
+{
+
+/** Dispatch table, each instruction set overrides the entries it implements */
+struct Kernels
+{
+    void (*firDecimate)(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out, size_t outSamples);
+    void (*pfbWeight)(const float *iq, const float *taps, size_t channels, size_t segments, float *out);
+};
+
+namespace Scalar
+{
+void firDecimate(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out, size_t outSamples);
+void pfbWeight(const float *iq, const float *taps, size_t channels, size_t segments, float *out);
+}
+
+/** Fill @a kernels with the variants of each instruction set, false if not built in */
+bool initSse2(Kernels &kernels);
+bool initAvx(Kernels &kernels);
+bool initNeon(Kernels &kernels);
+
+}
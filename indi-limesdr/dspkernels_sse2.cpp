@@ -0,0 +1,101 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "dspkernels_p.h"
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+namespace DSPKernels
+{
+
+static void firDecimateSse2(const float *iq, const float *taps, size_t ntaps, size_t factor, float *out,
+                            size_t outSamples)
+{
+    const size_t n = 2 * ntaps;
+    for (size_t m = 0; m < outSamples; m++)
+    {
+        const float *x = iq + 2 * m * factor;
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        size_t j = 0;
+        for (; j + 8 <= n; j += 8)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(taps + j), _mm_loadu_ps(x + j)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(taps + j + 4), _mm_loadu_ps(x + j + 4)));
+        }
+        for (; j + 4 <= n; j += 4)
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(taps + j), _mm_loadu_ps(x + j)));
+
+        // I Q I Q -> I Q
+        acc0 = _mm_add_ps(acc0, acc1);
+        acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+        float sum[4];
+        _mm_storeu_ps(sum, acc0);
+        for (; j < n; j += 2)
+        {
+            sum[0] += taps[j] * x[j];
+            sum[1] += taps[j + 1] * x[j + 1];
+        }
+        out[2 * m]     = sum[0];
+        out[2 * m + 1] = sum[1];
+    }
+}
+
+static void pfbWeightSse2(const float *iq, const float *taps, size_t channels, size_t segments, float *out)
+{
+    const size_t n = 2 * channels;
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4)
+    {
+        __m128 acc = _mm_mul_ps(_mm_loadu_ps(taps + j), _mm_loadu_ps(iq + j));
+        for (size_t p = 1; p < segments; p++)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(taps + p * n + j), _mm_loadu_ps(iq + p * n + j)));
+        _mm_storeu_ps(out + j, acc);
+    }
+    for (; j < n; j++)
+    {
+        out[j] = taps[j] * iq[j];
+        for (size_t p = 1; p < segments; p++)
+            out[j] += taps[p * n + j] * iq[p * n + j];
+    }
+}
+
+bool initSse2(Kernels &k)
+{
+    k.firDecimate = firDecimateSse2;
+    k.pfbWeight   = pfbWeightSse2;
+    return true;
+}
+
+}
+
+#else
+
+namespace DSPKernels
+{
+
+bool initSse2(Kernels &)
+{
+    return false;
+}
+
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "fft.h"
+
+#include <cmath>
+#include <utility>
+
+FFT::FFT(int size) : n(size), twiddles(size / 2), reversed(size)
+{
+    for (int k = 0; k < n / 2; k++)
+        twiddles[k] = std::polar(1.0f, static_cast<float>(-2.0 * M_PI * k / n));
+
+    int bits = 0;
+    while ((1 << bits) < n)
+        bits++;
+    for (int i = 0; i < n; i++)
+    {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        reversed[i] = r;
+    }
+}
+
+void FFT::transform(std::complex<float> *data) const
+{
+    for (int i = 0; i < n; i++)
+        if (i < reversed[i])
+            std::swap(data[i], data[reversed[i]]);
+
+    for (int len = 2; len <= n; len <<= 1)
+    {
+        int half = len / 2, step = n / len;
+        for (int start = 0; start < n; start += len)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                // Spelled out, std::complex multiplication checks for infinities on every call
+                const std::complex<float> &w = twiddles[k * step];
+                std::complex<float> &a = data[start + k], &b = data[start + k + half];
+                std::complex<float> t(b.real() * w.real() - b.imag() * w.imag(), b.real() * w.imag() + b.imag() * w.real());
+                b = a - t;
+                a = a + t;
+            }
+        }
+    }
+}
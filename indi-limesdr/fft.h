@@ -0,0 +1,43 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include <complex>
+#include <vector>
+
+/*
+ * In place radix-2 complex FFT of a fixed size, twiddles and bit reversal computed once.
+ * Forward transform, not normalized.
+ */
+class FFT
+{
+  public:
+    /* n must be a power of two */
+    explicit FFT(int n = 1);
+
+    int size() const { return n; }
+    void transform(std::complex<float> *data) const;
+
+    static bool isPowerOfTwo(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+  private:
+    int n;
+    std::vector<std::complex<float>> twiddles;
+    std::vector<int> reversed;
+};
@@ -18,8 +18,11 @@
 */
 
 #include "indi_limesdr_receiver.h"
+#include "dspkernels.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <indilogger.h>
 #include <memory>
@@ -36,7 +39,66 @@
 #define SUBFRAME_SIZE  (16384)
 #define MIN_FRAME_SIZE (512)
 #define MAX_FRAME_SIZE (SUBFRAME_SIZE * 16)
+// Default channels of the spectrum
 #define SPECTRUM_SIZE  (256)
+// At most this many points in the continuum, whatever the integration time
+#define MAX_CONTINUUM_SIZE (1 << 20)
+// ms to wait for a block
+#define READ_TIMEOUT   (1000)
+#define HYDROGEN_LINE  (1420405751.77)
+
+/**************************************************************************************
+** The receiver stream, no more than MAX_FRAME_SIZE samples waiting in the FIFO
+***************************************************************************************/
+class LimeIQSource : public IQSource
+{
+  public:
+    explicit LimeIQSource(lms_device_t *dev) : lime_dev(dev)
+    {
+    }
+    ~LimeIQSource()
+    {
+        stop();
+    }
+
+    bool start() override
+    {
+        lime_stream.channel             = 0;
+        lime_stream.isTx                = false;
+        lime_stream.fifoSize            = MAX_FRAME_SIZE;
+        lime_stream.dataFmt             = lms_stream_t::LMS_FMT_F32;
+        lime_stream.throughputVsLatency = 0.5;
+        if (LMS_SetupStream(lime_dev, &lime_stream) != 0)
+            return false;
+        if (LMS_StartStream(&lime_stream) != 0)
+        {
+            LMS_DestroyStream(lime_dev, &lime_stream);
+            return false;
+        }
+        running = true;
+        return true;
+    }
+
+    void stop() override
+    {
+        if (running)
+        {
+            LMS_StopStream(&lime_stream);
+            LMS_DestroyStream(lime_dev, &lime_stream);
+            running = false;
+        }
+    }
+
+    int read(float *iq, int samples, int timeout_ms) override
+    {
+        return LMS_RecvStream(&lime_stream, iq, samples, nullptr, timeout_ms);
+    }
+
+  private:
+    lms_device_t *lime_dev;
+    lms_stream_t lime_stream;
+    bool running = false;
+};
 
 static class Loader
 {
@@ -73,11 +135,22 @@ LIMESDR::LIMESDR(uint32_t index)
     setDeviceName(name);
 }
 
+LIMESDR::~LIMESDR()
+{
+    stopReading();
+}
+
 /**************************************************************************************
 ** Client is asking us to establish connection to the device
 ***************************************************************************************/
 bool LIMESDR::Connect()
 {
+    if (isSimulation())
+    {
+        LOG_INFO("LIME-SDR Receiver simulator connected successfully!");
+        return true;
+    }
+
     int r = LMS_Open(&lime_dev, loader.lime_dev_list[receiverIndex], NULL);
     if (r < 0)
     {
@@ -99,8 +172,10 @@ bool LIMESDR::Connect()
 ***************************************************************************************/
 bool LIMESDR::Disconnect()
 {
+    stopReading();
     InIntegration = false;
-    LMS_Close(lime_dev);
+    if (!isSimulation())
+        LMS_Close(lime_dev);
     setBufferSize(1);
     LOG_INFO("LIME-SDR Receiver disconnected successfully!");
     return true;
@@ -142,6 +217,17 @@ bool LIMESDR::initProperties()
     IUFillBLOB(&TFitsB[4], "TRMT", "Transmit5", "");
     IUFillBLOBVector(&TFitsBP, TFitsB, 5, getDeviceName(), "LIME_TRMT", "Transmit Data", INTEGRATION_INFO_TAB, IP_WO, 60, IPS_IDLE);
 */
+    // Decimation of the stream and channels of the spectrum, used from the next integration
+    IUFillNumber(&DSPN[DSP_DECIMATION_N], "DECIMATION", "Decimation", "%.f", 1, 256, 1, 1);
+    IUFillNumber(&DSPN[DSP_PHASE_TAPS_N], "PHASE_TAPS", "Filter taps per phase", "%.f", 1, 64, 1, 16);
+    IUFillNumber(&DSPN[DSP_CHANNELS_N], "CHANNELS", "Channels", "%.f", 16, 65536, 16, SPECTRUM_SIZE);
+    IUFillNumber(&DSPN[DSP_CHANNEL_TAPS_N], "CHANNEL_TAPS", "Filter bank taps", "%.f", 1, 16, 1, 4);
+    IUFillNumberVector(&DSPNP, DSPN, NUM_DSP_SETTINGS, getDeviceName(), "LIME_DSP", "Channelizer", MAIN_CONTROL_TAB, IP_RW, 60, IPS_IDLE);
+
+    // Mean power spectrum of the last integration, a float per channel
+    IUFillBLOB(&SpectrumB[0], "SPECTRUM", "Spectrum", "");
+    IUFillBLOBVector(&SpectrumBP, SpectrumB, 1, getDeviceName(), "LIME_SPECTRUM", "Spectrum", INTEGRATION_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
     // Add Debug, Simulator, and Configuration controls
     addAuxControls();
 
@@ -164,6 +250,9 @@ bool LIMESDR::updateProperties()
         // Inital values
         setupParams(1000000, 1420000000, 10000, 10);
         //defineProperty(&TFitsBP);
+        defineProperty(&DSPNP);
+        defineProperty(&SpectrumBP);
+        LOGF_DEBUG("DSP kernels: %s", DSPKernels::toString(DSPKernels::activeIsa()));
 
         // Start the timer
         SetTimer(getCurrentPollingPeriod());
@@ -171,6 +260,8 @@ bool LIMESDR::updateProperties()
     else
     {
         //deleteProperty(TFitsBP.name);
+        deleteProperty(DSPNP.name);
+        deleteProperty(SpectrumBP.name);
     }
 
     return true;
@@ -185,28 +276,89 @@ bool LIMESDR::StartIntegration(double duration)
 
     // Since we have only have one Receiver with one chip, we set the exposure duration of the primary Receiver
     setIntegrationTime(duration);
+    stopReading();
     b_read  = 0;
-    to_read = getSampleRate() * getIntegrationTime();
+    to_read = static_cast<uint64_t>(getSampleRate() * getIntegrationTime());
 
-    setBufferSize(to_read * sizeof(float));
+    if (to_read == 0)
+    {
+        // We're done
+        return false;
+    }
+
+    // Only the band of interest is integrated, long integrations get longer continuum points rather than more of them
+    decimator.reset(DSPN[DSP_DECIMATION_N].value, DSPN[DSP_PHASE_TAPS_N].value);
+    uint64_t decimated = to_read / decimator.getFactor();
+    integrator.reset(DSPN[DSP_CHANNELS_N].value, (decimated + MAX_CONTINUUM_SIZE - 1) / MAX_CONTINUUM_SIZE,
+                     DSPN[DSP_CHANNEL_TAPS_N].value);
 
-    if (to_read > 0)
+    if (isSimulation())
     {
-        lime_stream.channel             = 0;
-        lime_stream.isTx                = false;
-        lime_stream.fifoSize            = to_read;
-        lime_stream.dataFmt             = lms_stream_t::LMS_FMT_F32;
-        lime_stream.throughputVsLatency = 0.5;
-        LMS_SetupStream(lime_dev, &lime_stream);
-        LMS_StartStream(&lime_stream);
-        gettimeofday(&CapStart, nullptr);
-        InIntegration = true;
-        LOG_INFO("Integration started...");
-        return true;
+        SyntheticIQSource *synthetic = new SyntheticIQSource(getSampleRate());
+        // The hydrogen line in the noise, when it is in the band
+        double offset = HYDROGEN_LINE - getFrequency();
+        if (fabs(offset) < getSampleRate() / 2)
+            synthetic->addTone(offset, 0.1);
+        synthetic->setNoise(0.05);
+        synthetic->setRealtime(true);
+        source.reset(synthetic);
+    }
+    else
+        source.reset(new LimeIQSource(lime_dev));
+
+    if (!source->start())
+    {
+        LOG_ERROR("Failed to start the stream.");
+        source.reset();
+        return false;
+    }
+
+    readerStop   = false;
+    readerDone   = false;
+    readerFailed = false;
+    gettimeofday(&CapStart, nullptr);
+    InIntegration = true;
+    reader        = std::thread(&LIMESDR::readStream, this);
+    LOG_INFO("Integration started...");
+    return true;
+}
+
+/**************************************************************************************
+** Reader thread: blocks of SUBFRAME_SIZE samples, decimated and into the integrator as they come
+***************************************************************************************/
+void LIMESDR::readStream()
+{
+    std::vector<float> block(SUBFRAME_SIZE * 2);
+    std::vector<float> decimated(decimator.outputSize(SUBFRAME_SIZE) * 2);
+
+    while (!readerStop && b_read < to_read)
+    {
+        int n = source->read(block.data(), min(to_read - b_read, static_cast<uint64_t>(SUBFRAME_SIZE)), READ_TIMEOUT);
+        if (n < 0)
+        {
+            readerFailed = true;
+            break;
+        }
+        if (decimator.getFactor() > 1)
+            integrator.add(decimated.data(), decimator.process(block.data(), n, decimated.data()));
+        else
+            integrator.add(block.data(), n);
+        b_read += n;
     }
+    integrator.finish();
+    readerDone = true;
+}
 
-    // We're done
-    return false;
+void LIMESDR::stopReading()
+{
+    readerStop = true;
+    if (reader.joinable())
+        reader.join();
+    if (source)
+    {
+        source->stop();
+        source.reset();
+    }
 }
 
 /**************************************************************************************
@@ -215,6 +367,9 @@ bool LIMESDR::StartIntegration(double duration)
 void LIMESDR::setupParams(float sr, float freq, float bw, float gain)
 {
     setBPS(-32);
+    if (isSimulation())
+        return;
+
     int r = 0;
     r |= LMS_SetAntenna(lime_dev, LMS_CH_RX, 0, 0);
     r |= LMS_SetNormalizedGain(lime_dev, LMS_CH_RX, 0, gain);
@@ -245,9 +400,28 @@ bool LIMESDR::ISNewNumber(const char *dev, const char *name, double values[], ch
         }
         IDSetNumber(&ReceiverSettingsNP, nullptr);
     }
+    if (dev && !strcmp(dev, getDeviceName()) && !strcmp(name, DSPNP.name))
+    {
+        IUUpdateNumber(&DSPNP, values, names, n);
+        // The FFT of the filter bank takes a power of two
+        double channels = DSPN[DSP_CHANNELS_N].value;
+        DSPN[DSP_CHANNELS_N].value = pow(2, floor(log2(channels)));
+        if (DSPN[DSP_CHANNELS_N].value != channels)
+            LOGF_WARN("Channels set to %.f, a power of two.", DSPN[DSP_CHANNELS_N].value);
+        DSPNP.s = IPS_OK;
+        IDSetNumber(&DSPNP, nullptr);
+        return true;
+    }
     return processNumber(dev, name, values, names, n) & !r;
 }
 
+bool LIMESDR::saveConfigItems(FILE *fp)
+{
+    INDI::Receiver::saveConfigItems(fp);
+    IUSaveConfigNumber(fp, &DSPNP);
+    return true;
+}
+
 /**************************************************************************************
 ** Client is asking us to abort a capture
 ***************************************************************************************/
@@ -255,14 +429,9 @@ bool LIMESDR::AbortIntegration()
 {
     if (InIntegration)
     {
-        lms_stream_status_t status;
-        LMS_GetStreamStatus(&lime_stream, &status);
-        if (status.fifoFilledCount <= 0)
-        {
-            InIntegration = false;
-            LMS_StopStream(&lime_stream);
-            LMS_DestroyStream(lime_dev, &lime_stream);
-        }
+        stopReading();
+        InIntegration = false;
+        LOG_INFO("Integration aborted.");
     }
     return true;
 }
@@ -272,17 +441,8 @@ bool LIMESDR::AbortIntegration()
 ***************************************************************************************/
 float LIMESDR::CalcTimeLeft()
 {
-    double timesince;
-    double timeleft;
-    struct timeval now;
-    gettimeofday(&now, nullptr);
-
-    timesince = (double)(now.tv_sec * 1000.0 + now.tv_usec / 1000) -
-                (double)(CapStart.tv_sec * 1000.0 + CapStart.tv_usec / 1000);
-    timesince = timesince / 1000;
-
-    timeleft = IntegrationRequest - timesince;
-    return timeleft;
+    // By the samples still to come, the stream is the clock
+    return (to_read - b_read) / getSampleRate();
 }
 
 /**************************************************************************************
@@ -290,33 +450,19 @@ float LIMESDR::CalcTimeLeft()
 ***************************************************************************************/
 void LIMESDR::TimerHit()
 {
-    long timeleft;
-
     if (isConnected() == false)
         return; //  No need to reset timer if we are not connected anymore
 
     if (InIntegration)
     {
-        timeleft = CalcTimeLeft();
-        if (timeleft < 0.1)
+        if (readerDone)
         {
             /* We're done capturing */
-            LOG_INFO("Integration done, expecting data...");
-            lms_stream_status_t status;
-            LMS_GetStreamStatus(&lime_stream, &status);
-            if (status.active)
-            {
-                if (status.fifoFilledCount >= status.fifoSize)
-                {
-                    n_read = status.fifoFilledCount;
-                    grabData();
-                }
-            }
-            timeleft = 0.0;
+            setIntegrationLeft(0);
+            grabData();
         }
-
-        // This is an over simplified timing method, check ReceiverSimulator and limesdrReceiver for better timing checks
-        setIntegrationLeft(timeleft);
+        else
+            setIntegrationLeft(CalcTimeLeft());
     }
 
     SetTimer(getCurrentPollingPeriod());
@@ -324,20 +470,34 @@ void LIMESDR::TimerHit()
 }
 
 /**************************************************************************************
-** Create the spectrum
+** Send the continuum and the spectrum
 ***************************************************************************************/
 void LIMESDR::grabData()
 {
     if (InIntegration)
     {
-        continuum = getBuffer();
-        LOG_INFO("Downloading...");
-        LMS_RecvStream(&lime_stream, continuum, n_read, NULL, 1000);
-        LMS_StopStream(&lime_stream);
-        LMS_DestroyStream(lime_dev, &lime_stream);
+        stopReading();
         InIntegration = false;
+        if (readerFailed)
+            LOGF_ERROR("Stream error after %llu of %llu samples.", static_cast<unsigned long long>(b_read.load()),
+                       static_cast<unsigned long long>(to_read));
 
-        LOG_INFO("Download complete.");
+        // Integrated as it was read, nothing left to do but copy
+        const std::vector<float> &points = integrator.getContinuum();
+        setBufferSize(points.empty() ? 1 : points.size() * sizeof(float));
+        continuum = getBuffer();
+        if (!points.empty())
+            memcpy(continuum, points.data(), points.size() * sizeof(float));
+
+        spectrum.resize(integrator.getBins());
+        integrator.getSpectrum(spectrum.data());
+        SpectrumB[0].blob    = spectrum.data();
+        SpectrumB[0].bloblen = SpectrumB[0].size = spectrum.size() * sizeof(float);
+        strncpy(SpectrumB[0].format, ".f32", MAXINDIBLOBFMT);
+        SpectrumBP.s = IPS_OK;
+        IDSetBLOB(&SpectrumBP, nullptr);
+
+        LOGF_INFO("Integration complete, %lu spectra, %zu continuum points.", integrator.getSpectra(), points.size());
         IntegrationComplete();
     }
 }
@@ -21,6 +21,14 @@
 
 #include <lime/LimeSuite.h>
 #include "indireceiver.h"
+#include "decimator.h"
+#include "iqsource.h"
+#include "spectralintegrator.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
 
 enum Settings
 {
@@ -29,10 +37,19 @@ enum Settings
 	BANDWIDTH_N,
 	NUM_SETTINGS
 };
+enum DSPSettings
+{
+    DSP_DECIMATION_N = 0,
+    DSP_PHASE_TAPS_N,
+    DSP_CHANNELS_N,
+    DSP_CHANNEL_TAPS_N,
+    NUM_DSP_SETTINGS
+};
 class LIMESDR : public INDI::Receiver
 {
   public:
     LIMESDR(uint32_t index);
+    virtual ~LIMESDR();
 
     bool ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n) override;
 
@@ -43,6 +60,7 @@ class LIMESDR : public INDI::Receiver
 	const char *getDefaultName() override;
 	bool initProperties() override;
 	bool updateProperties() override;
+    bool saveConfigItems(FILE *fp) override;
 
     // Receiver specific functions
     bool StartIntegration(double duration) override;
@@ -53,24 +71,42 @@ class LIMESDR : public INDI::Receiver
     void grabData();
 
   private:
+    // Reader thread, folds the stream into the integrator block by block
+    void readStream();
+    void stopReading();
+
     lms_device_t *lime_dev = { nullptr };
 	// Utility functions
 	float CalcTimeLeft();
     void setupParams(float sr, float freq, float bw, float gain);
-    lms_stream_t lime_stream;
 	// Are we exposing?
     bool InIntegration;
 	// Struct to keep timing
 	struct timeval CapStart;
-    int to_read;
-    int b_read;
-    int n_read;
+    uint64_t to_read;
+    std::atomic<uint64_t> b_read { 0 };
     float IntegrationRequest;
 	uint8_t* continuum;
-    uint8_t *spectrum;
+    std::vector<float> spectrum;
+
+    // The LimeSDR stream, or the synthetic one in simulation
+    std::unique_ptr<IQSource> source;
+    // Down to the band of interest before it is integrated
+    Decimator decimator;
+    SpectralIntegrator integrator;
+    std::thread reader;
+    std::atomic<bool> readerStop { false };
+    std::atomic<bool> readerDone { false };
+    std::atomic<bool> readerFailed { false };
 
     uint32_t receiverIndex = { 0 };
 
     IBLOB TFitsB[5];
     IBLOBVectorProperty TFitsBP;
+
+    INumber DSPN[NUM_DSP_SETTINGS];
+    INumberVectorProperty DSPNP;
+
+    IBLOB SpectrumB[1];
+    IBLOBVectorProperty SpectrumBP;
 };
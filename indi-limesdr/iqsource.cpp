@@ -0,0 +1,94 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "iqsource.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+SyntheticIQSource::SyntheticIQSource(double rate, unsigned int seed) : samplerate(rate), gen(seed), gauss(0.0f, 1.0f)
+{
+}
+
+void SyntheticIQSource::addTone(double offset, double amplitude)
+{
+    Tone tone;
+    tone.phase     = 1.0;
+    tone.step      = std::polar(1.0, 2.0 * M_PI * offset / samplerate);
+    tone.amplitude = amplitude;
+    tones.push_back(tone);
+}
+
+void SyntheticIQSource::setNoise(double rms)
+{
+    noise = rms;
+}
+
+void SyntheticIQSource::setRealtime(bool enabled)
+{
+    realtime = enabled;
+}
+
+bool SyntheticIQSource::start()
+{
+    started  = Clock::now();
+    produced = 0;
+    return true;
+}
+
+void SyntheticIQSource::stop()
+{
+}
+
+int SyntheticIQSource::read(float *iq, int samples, int timeout_ms)
+{
+    if (realtime)
+    {
+        // No more than the receiver would have had by now
+        Clock::time_point ready = started + std::chrono::duration_cast<Clock::duration>
+                                  (std::chrono::duration<double>((produced + samples) / samplerate));
+        std::this_thread::sleep_until(std::min(ready, Clock::now() + std::chrono::milliseconds(timeout_ms)));
+
+        double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        int64_t due    = static_cast<int64_t>(elapsed * samplerate) - static_cast<int64_t>(produced);
+        samples        = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(samples, due)));
+    }
+
+    for (int i = 0; i < samples; i++)
+    {
+        std::complex<double> v;
+        for (Tone &tone : tones)
+        {
+            v += tone.amplitude * tone.phase;
+            tone.phase *= tone.step;
+        }
+        iq[2 * i]     = static_cast<float>(v.real());
+        iq[2 * i + 1] = static_cast<float>(v.imag());
+    }
+    if (noise > 0)
+        for (int i = 0; i < 2 * samples; i++)
+            iq[i] += noise * gauss(gen);
+
+    // Keep the rotators on the unit circle
+    for (Tone &tone : tones)
+        tone.phase /= std::abs(tone.phase);
+
+    produced += samples;
+    return samples;
+}
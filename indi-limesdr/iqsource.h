@@ -0,0 +1,81 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include <chrono>
+#include <complex>
+#include <random>
+#include <vector>
+
+/*
+ * A stream of complex samples, I and Q interleaved as 32 bit floats like LMS_FMT_F32.
+ */
+class IQSource
+{
+  public:
+    virtual ~IQSource() = default;
+
+    virtual bool start() = 0;
+    virtual void stop()  = 0;
+
+    /* Up to samples samples into iq, 2 * samples floats. Returns how many were read,
+       0 if none came within timeout_ms, -1 on error. */
+    virtual int read(float *iq, int samples, int timeout_ms) = 0;
+};
+
+/*
+ * Tones in gaussian noise, for the simulation and the benchmarks. Paced at the sample
+ * rate when realtime, as fast as it can be made otherwise.
+ */
+class SyntheticIQSource : public IQSource
+{
+  public:
+    explicit SyntheticIQSource(double samplerate, unsigned int seed = 1);
+
+    /* offset in Hz from the centre frequency, amplitude in full scale */
+    void addTone(double offset, double amplitude);
+    /* rms of the noise on I and on Q */
+    void setNoise(double rms);
+    void setRealtime(bool enabled);
+
+    bool start() override;
+    void stop() override;
+    int read(float *iq, int samples, int timeout_ms) override;
+
+  private:
+    typedef std::chrono::steady_clock Clock;
+
+    typedef struct Tone
+    {
+        std::complex<double> phase;
+        std::complex<double> step;
+        double amplitude;
+    } Tone;
+
+    double samplerate;
+    std::vector<Tone> tones;
+    double noise { 0 };
+    bool realtime { false };
+
+    std::mt19937 gen;
+    std::normal_distribution<float> gauss;
+
+    Clock::time_point started;
+    uint64_t produced { 0 };
+};
@@ -0,0 +1,98 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include "spectralintegrator.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpectralIntegrator::SpectralIntegrator()
+{
+    reset(1, 1, 1);
+}
+
+bool SpectralIntegrator::reset(int bins, uint64_t points, int taps)
+{
+    if (!channelizer.reset(bins, taps))
+        return false;
+
+    power.assign(bins, 0.0);
+    spectra = 0;
+
+    pointSamples = std::max<uint64_t>(1, points);
+    pointFill    = 0;
+    pointSum     = 0;
+    continuum.clear();
+
+    samples = 0;
+    return true;
+}
+
+void SpectralIntegrator::add(const float *iq, int count)
+{
+    const std::complex<float> *in = reinterpret_cast<const std::complex<float> *>(iq);
+
+    // Continuum, point by point
+    for (int i = 0; i < count;)
+    {
+        int take = static_cast<int>(std::min<uint64_t>(count - i, pointSamples - pointFill));
+        double sum = 0;
+        for (int j = i; j < i + take; j++)
+            sum += std::norm(in[j]);
+        pointSum  += sum;
+        pointFill += take;
+        i         += take;
+        if (pointFill == pointSamples)
+        {
+            continuum.push_back(static_cast<float>(pointSum / pointFill));
+            pointSum  = 0;
+            pointFill = 0;
+        }
+    }
+
+    // Spectrum, frame by frame
+    channelizer.push(iq, count);
+    int n = channelizer.getChannels();
+    for (const std::complex<float> *frame = channelizer.next(); frame; frame = channelizer.next())
+    {
+        for (int k = 0; k < n; k++)
+            power[k] += std::norm(frame[k]);
+        spectra++;
+    }
+
+    samples += count;
+}
+
+void SpectralIntegrator::finish()
+{
+    if (pointFill > 0)
+    {
+        continuum.push_back(static_cast<float>(pointSum / pointFill));
+        pointSum  = 0;
+        pointFill = 0;
+    }
+}
+
+void SpectralIntegrator::getSpectrum(float *out) const
+{
+    int n = getBins();
+    double scale = spectra > 0 ? 1.0 / (spectra * channelizer.getTapPower()) : 0.0;
+    // Negative frequencies first
+    for (int i = 0; i < n; i++)
+        out[i] = static_cast<float>(power[(i + n / 2) % n] * scale);
+}
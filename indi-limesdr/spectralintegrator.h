@@ -0,0 +1,70 @@
+/*
+    indi_limesdr_receiver - a software defined radio driver for INDI
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#pragma once
+
+#include "channelizer.h"
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Running power spectrum and continuum of an IQ stream, fed block by block as it is read.
+ *
+ * The spectrum is the mean power of the channels of a polyphase filter bank of bins
+ * channels, the continuum the mean power of every pointSamples samples. Neither keeps the samples, so
+ * the memory taken is the size of the spectrum and of the continuum only, whatever the
+ * length of the integration. Powers are in full scale squared: white noise of variance v
+ * on I and on Q gives 2v in every bin and in every continuum point.
+ *
+ * Not thread safe, fed by one thread and read when it is done.
+ */
+class SpectralIntegrator
+{
+  public:
+    SpectralIntegrator();
+
+    /* bins a power of two, taps of the filter bank per bin. Returns false if it is not. */
+    bool reset(int bins, uint64_t pointSamples, int taps = 4);
+
+    /* samples samples, I and Q interleaved */
+    void add(const float *iq, int samples);
+    /* Closes the last continuum point, if a part of it came */
+    void finish();
+
+    int getBins() const { return channelizer.getChannels(); }
+    /* Mean power per bin, lowest frequency first and the centre frequency at bins / 2 */
+    void getSpectrum(float *out) const;
+    const std::vector<float> &getContinuum() const { return continuum; }
+
+    uint64_t getSamples() const { return samples; }
+    unsigned long getSpectra() const { return spectra; }
+
+  private:
+    Channelizer channelizer;
+    std::vector<double> power;
+    unsigned long spectra { 0 };
+
+    uint64_t pointSamples { 1 };
+    uint64_t pointFill { 0 };
+    double pointSum { 0 };
+    std::vector<float> continuum;
+
+    uint64_t samples { 0 };
+};
@@ -0,0 +1,95 @@
+/*
+    LimeSDR DSP unit tests
+
+    The receiver chain, decimation and then integration, on tones from the synthetic
+    source: a tone in the band has to show in its channel, and a tone outside it has to
+    be suppressed by the decimation filter before it aliases into the band.
+*/
+
+#include "decimator.h"
+#include "iqsource.h"
+#include "spectralintegrator.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const int BLOCK_SIZE = 16384;
+static const double SAMPLE_RATE = 2e6;
+static const int CHANNELS = 256;
+
+// Channel of a frequency, in the order of SpectralIntegrator::getSpectrum()
+static int channelOf(double frequency, double samplerate, int channels)
+{
+    double f = frequency / samplerate;
+    f -= std::floor(f + 0.5);
+    return (static_cast<int>(std::lround(f * channels)) + channels + channels / 2) % channels;
+}
+
+// Run samples from the source through the chain as the reader thread does, return the spectrum
+static std::vector<float> integrate(SyntheticIQSource &source, int factor, uint64_t total)
+{
+    Decimator decimator;
+    decimator.reset(factor);
+    SpectralIntegrator integrator;
+    integrator.reset(CHANNELS, 1);
+
+    std::vector<float> block(2 * BLOCK_SIZE), decimated(2 * decimator.outputSize(BLOCK_SIZE));
+    source.start();
+    for (uint64_t done = 0; done < total;)
+    {
+        int n = source.read(block.data(), static_cast<int>(std::min<uint64_t>(BLOCK_SIZE, total - done)), 0);
+        int m = decimator.process(block.data(), n, decimated.data());
+        integrator.add(decimated.data(), m);
+        done += n;
+    }
+    source.stop();
+    integrator.finish();
+
+    std::vector<float> spectrum(CHANNELS);
+    integrator.getSpectrum(spectrum.data());
+    return spectrum;
+}
+
+static int peakOf(const std::vector<float> &spectrum)
+{
+    return static_cast<int>(std::max_element(spectrum.begin(), spectrum.end()) - spectrum.begin());
+}
+
+TEST(LimeSDRDSPTest, tone_in_channel)
+{
+    // Below the centre frequency, the lower half of the spectrum
+    const double offset = -SAMPLE_RATE * 0.3;
+
+    SyntheticIQSource source(SAMPLE_RATE);
+    source.addTone(offset, 0.1);
+    source.setNoise(1e-3);
+
+    std::vector<float> spectrum = integrate(source, 1, 1 << 18);
+    EXPECT_EQ(peakOf(spectrum), channelOf(offset, SAMPLE_RATE, CHANNELS));
+}
+
+TEST(LimeSDRDSPTest, decimated_alias_suppressed)
+{
+    const int factor = 8;
+    const double outrate = SAMPLE_RATE / factor;
+    // In the band, half way up; outside, a bit over two output bandwidths up
+    const double inband = outrate / 4;
+    const double outband = 2.3 * outrate;
+
+    SyntheticIQSource source(SAMPLE_RATE);
+    source.addTone(inband, 0.1);
+    source.addTone(outband, 0.1);
+    source.setNoise(1e-4);
+
+    std::vector<float> spectrum = integrate(source, factor, 1 << 20);
+    const int tone = channelOf(inband, outrate, CHANNELS);
+    const int alias = channelOf(outband, outrate, CHANNELS);
+    ASSERT_NE(tone, alias);
+
+    EXPECT_EQ(peakOf(spectrum), tone);
+    // Both tones have the same amplitude, what is left of the outer one is its stopband leak
+    EXPECT_GT(10 * std::log10(spectrum[tone] / spectrum[alias]), 60.0);
+}
@@ -69,6 +69,11 @@ bool PentaxCCD::initProperties()
     IUFillSwitch(&preserveOriginalS[0], "PRESERVE_OFF", "Keep FITS Only", ISS_ON);
     IUFillSwitchVector(&preserveOriginalSP, preserveOriginalS, 2, getDeviceName(), "PRESERVE_ORIGINAL", "Copy Option", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_FULL], "RAW_FULL", "Full", ISS_ON);
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_BAYER_2X2], "RAW_BAYER_2X2", "Bayer 2x2", ISS_OFF);
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_MONO_2X2], "RAW_MONO_2X2", "Mono 2x2", ISS_OFF);
+    IUFillSwitchVector(&rawQualitySP, rawQualityS, 3, getDeviceName(), "CCD_RAW_QUALITY", "RAW Quality", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
     PrimaryCCD.setMinMaxStep("CCD_EXPOSURE", "CCD_EXPOSURE_VALUE", 0, 30, 1, false);
 
     IUSaveText(&BayerT[2], "RGGB");
@@ -104,6 +109,7 @@ bool PentaxCCD::updateProperties()
 
         defineProperty(&transferFormatSP);
         defineProperty(&autoFocusSP);
+        defineProperty(&rawQualitySP);
         if (transferFormatS[0].s == ISS_ON) {
             defineProperty(&preserveOriginalSP);
         }
@@ -117,6 +123,7 @@ bool PentaxCCD::updateProperties()
         deleteProperty(autoFocusSP.name);
         deleteProperty(transferFormatSP.name);
         deleteProperty(preserveOriginalSP.name);
+        deleteProperty(rawQualitySP.name);
 
         rmTimer(timerID);
     }
@@ -555,6 +562,11 @@ bool PentaxCCD::ISNewSwitch(const char * dev, const char * name, ISState * state
         preserveOriginalSP.s = IPS_OK;
         IDSetSwitch(&preserveOriginalSP, nullptr);
     }
+    else if (!strcmp(name, rawQualitySP.name)) {
+        IUUpdateSwitch(&rawQualitySP, states, names, n);
+        rawQualitySP.s = IPS_OK;
+        IDSetSwitch(&rawQualitySP, nullptr);
+    }
     else if (!strcmp(name, mIsoSP.name)) {
         updateCaptureSettingSwitch(&iso,&mIsoSP,states,names,n);
     }
@@ -593,7 +605,7 @@ void PentaxCCD::updateCaptureSettingSwitch(CaptureSetting * setting, ISwitchVect
 
 bool PentaxCCD::saveConfigItems(FILE * fp) {
 
-    for (auto sw : std::vector<ISwitchVectorProperty*>{&mIsoSP,&mApertureSP,&mExpCompSP,&mWhiteBalanceSP,&mIQualitySP,&mFormatSP,&mStorageWritingSP}) {
+    for (auto sw : std::vector<ISwitchVectorProperty*>{&mIsoSP,&mApertureSP,&mExpCompSP,&mWhiteBalanceSP,&mIQualitySP,&mFormatSP,&mStorageWritingSP,&rawQualitySP}) {
         if (sw->nsp>0) IUSaveConfigSwitch(fp, sw);
     }
 
@@ -617,6 +629,8 @@ void PentaxCCD::addFITSKeywords(fitsfile * fptr, INDI::CCDChip * targetChip)
                 fits_update_key_s(fptr, TUINT, "ISOSPEED", &isoSpeed, "ISO Speed", &status);
         }
     }
+
+    raw_quality_fits_keywords(fptr, frameRawQuality);
 }
 
 void PentaxCCD::buildCaptureSettingSwitch(ISwitchVectorProperty *control, CaptureSetting *setting, const char *label, const char *name) {
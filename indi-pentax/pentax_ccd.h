@@ -32,6 +32,7 @@
 
 #include "config.h"
 #include "eventloop.h"
+#include "gphoto_readimage.h"
 #include "pentax_event_handler.h"
 
 using namespace std;
@@ -118,6 +119,12 @@ protected:
     ISwitch preserveOriginalS[2];
     ISwitchVectorProperty preserveOriginalSP;
 
+    // Decode quality of RAW captures, switch order follows RAW_QUALITY_* in gphoto_readimage.h
+    ISwitch rawQualityS[3];
+    ISwitchVectorProperty rawQualitySP;
+    // Quality the frame being sent was decoded at, for its FITS keywords
+    int frameRawQuality {RAW_QUALITY_FULL};
+
     ISwitch autoFocusS[2];
     ISwitchVectorProperty autoFocusSP;
 
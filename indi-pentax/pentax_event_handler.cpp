@@ -19,7 +19,29 @@
 
 #include "pentax_event_handler.h"
 
+#include <cerrno>
+#include <cstring>
 
+// An output stream buffer appending to a byte vector, so the SDK can hand over images without a temp file
+struct vectorbuf : std::streambuf
+{
+    explicit vectorbuf(std::vector<uint8_t> &data) : data(data) {}
+
+    virtual int_type overflow(int_type ch) override
+    {
+        if (ch != traits_type::eof())
+            data.push_back(static_cast<uint8_t>(ch));
+        return traits_type::not_eof(ch);
+    }
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        data.insert(data.end(), s, s + n);
+        return n;
+    }
+
+    std::vector<uint8_t> &data;
+};
 
 const char * getFormatFileExtension(ImageFormat format) {
     if (format==ImageFormat::JPEG) {
@@ -50,15 +72,16 @@ void PentaxEventHandler::imageStored(const std::shared_ptr<const CameraDevice>&
         size_t memsize = 0;
         int naxis = 2, w = 0, h = 0, bpp = 8;
 
-        //write image to file
-        std::ofstream o;
-        char filename[32] = "/tmp/indi_pentax_";
-        strcat(filename,image->getName().c_str());
-        o.open(filename, std::ofstream::out | std::ofstream::binary);
+        driver->frameRawQuality = RAW_QUALITY_FULL;
+
+        //transfer image to memory
+        imageData.clear();
+        imageData.reserve(image->getSize());
+        vectorbuf buf(imageData);
+        std::ostream o(&buf);
         Response response = image->getData(o);
-        o.close();
         if (response.getResult() == Result::Ok) {
-            LOGF_DEBUG("Temp Image path: %s",filename);
+            LOGF_DEBUG("Transferred %zu bytes.", imageData.size());
         } else {
             for (const auto& error : response.getErrors()) {
                 LOGF_ERROR("Error Code: %d (%s)", static_cast<int>(error->getCode()), error->getMessage().c_str());
@@ -68,7 +91,7 @@ void PentaxEventHandler::imageStored(const std::shared_ptr<const CameraDevice>&
 
         //convert it for image buffer
         if (image->getFormat()==ImageFormat::JPEG) {
-            if (read_jpeg(filename, &memptr, &memsize, &naxis, &w, &h))
+            if (read_jpeg_buffer(imageData.data(), imageData.size(), &memptr, &memsize, &naxis, &w, &h))
             {
                 LOG_ERROR("Exposure failed to parse jpeg.");
                 return;
@@ -80,7 +103,8 @@ void PentaxEventHandler::imageStored(const std::shared_ptr<const CameraDevice>&
         else {
             char bayer_pattern[8] = {};
 
-            if (read_libraw(filename, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
+            driver->frameRawQuality = IUFindOnSwitchIndex(&driver->rawQualitySP);
+            if (read_libraw_buffer(imageData.data(), imageData.size(), &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern, driver->frameRawQuality))
             {
                 LOG_ERROR("Exposure failed to parse raw image.");
                 return;
@@ -88,7 +112,8 @@ void PentaxEventHandler::imageStored(const std::shared_ptr<const CameraDevice>&
 
             LOGF_DEBUG("read_libraw: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d) bayer pattern (%s)",memsize, naxis, w, h, bpp, bayer_pattern);
 
-            driver->bufferIsBayered = true;
+            // Mono previews carry no bayer pattern
+            driver->bufferIsBayered = bayer_pattern[0] != '\0';
         }
 
         driver->PrimaryCCD.setImageExtension("fits");
@@ -103,7 +128,7 @@ void PentaxEventHandler::imageStored(const std::shared_ptr<const CameraDevice>&
         driver->PrimaryCCD.setNAxis(naxis);
         driver->PrimaryCCD.setBPP(bpp);
 
-        //(re)move image file
+        //save native file only when asked to
         if (driver->preserveOriginalS[1].s == ISS_ON) {
             char ts[32];
             struct tm * tp;
@@ -114,26 +139,34 @@ void PentaxEventHandler::imageStored(const std::shared_ptr<const CameraDevice>&
             prefix = std::regex_replace(prefix, std::regex("XXX"), string(ts));
             char newname[255];
             snprintf(newname, 255, "%s.%s",prefix.c_str(),getFormatFileExtension(image->getFormat()));
-            if (std::rename(filename, newname)) {
-                LOGF_ERROR("File system error prevented saving original image to %s.  Saved to %s instead.", newname,filename);
+            FILE* f = fopen(newname, "wb");
+            if (f == nullptr || fwrite(imageData.data(), 1, imageData.size(), f) != imageData.size()) {
+                LOGF_ERROR("File system error prevented saving original image to %s: %s", newname, strerror(errno));
             }
             else {
                 LOGF_INFO("Saved original image to %s.", newname);
             }
-        }
-        else {
-            std::remove(filename);
+            if (f != nullptr) {
+                fclose(f);
+            }
         }
     }
     else {
         driver->PrimaryCCD.setImageExtension(getFormatFileExtension(image->getFormat()));
 
-        stringstream img;
-        image->getData(img);
-        driver->PrimaryCCD.setFrameBufferSize(image->getSize());
-        char * memptr = (char *)driver->PrimaryCCD.getFrameBuffer();
-        img.read(memptr,image->getSize());
-        driver->PrimaryCCD.setFrameBuffer((unsigned char *)memptr);
+        imageData.clear();
+        imageData.reserve(image->getSize());
+        vectorbuf buf(imageData);
+        std::ostream o(&buf);
+        Response response = image->getData(o);
+        if (response.getResult() != Result::Ok) {
+            for (const auto& error : response.getErrors()) {
+                LOGF_ERROR("Error Code: %d (%s)", static_cast<int>(error->getCode()), error->getMessage().c_str());
+            }
+            return;
+        }
+        driver->PrimaryCCD.setFrameBufferSize(imageData.size());
+        memcpy(driver->PrimaryCCD.getFrameBuffer(), imageData.data(), imageData.size());
 
     }
 
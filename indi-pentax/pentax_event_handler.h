@@ -28,6 +28,7 @@
 
 #include <stream/streammanager.h>
 #include <regex>
+#include <vector>
 
 #include "gphoto_readimage.h"
 
@@ -53,6 +54,10 @@ public:
     void deviceDisconnected (const std::shared_ptr< const CameraDevice > &sender, DeviceInterface inf) override;
 
     void captureSettingsChanged(const std::shared_ptr<const CameraDevice> &sender, const std::vector<std::shared_ptr<const CaptureSetting> > &newSettings) override;
+
+private:
+    // Last image transferred from the camera, reused between frames
+    std::vector<uint8_t> imageData;
 };
 
 #endif // PENTAXEVENTLISTENER_H
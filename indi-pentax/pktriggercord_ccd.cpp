@@ -22,10 +22,15 @@
 #include "pslr.h"
 #include <indimacros.h>
 
+#include <cerrno>
+#include <cstring>
+
 #define MINISO 100
 #define MAXISO 102400
+// Seconds to wait for the image buffer after the exposure before giving up
+#define BUFFER_TIMEOUT 30
+#define BUFFER_POLL 0.1
 
-#define TMPFILEBASE (char *)"/tmp/indipentax.tmp"
 
 PkTriggerCordCCD::PkTriggerCordCCD(const char * name)
 {
@@ -43,6 +48,7 @@ PkTriggerCordCCD::PkTriggerCordCCD(const char * name)
 
 PkTriggerCordCCD::~PkTriggerCordCCD()
 {
+    free(imageBuffer);
 }
 
 const char *PkTriggerCordCCD::getDefaultName()
@@ -77,6 +83,11 @@ bool PkTriggerCordCCD::initProperties()
     IUFillSwitch(&preserveOriginalS[0], "PRESERVE_OFF", "Keep FITS Only", ISS_ON);
     IUFillSwitchVector(&preserveOriginalSP, preserveOriginalS, 2, getDeviceName(), "PRESERVE_ORIGINAL", "Copy Option", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_FULL], "RAW_FULL", "Full", ISS_ON);
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_BAYER_2X2], "RAW_BAYER_2X2", "Bayer 2x2", ISS_OFF);
+    IUFillSwitch(&rawQualityS[RAW_QUALITY_MONO_2X2], "RAW_MONO_2X2", "Mono 2x2", ISS_OFF);
+    IUFillSwitchVector(&rawQualitySP, rawQualityS, 3, getDeviceName(), "CCD_RAW_QUALITY", "RAW Quality", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
     PrimaryCCD.setMinMaxStep("CCD_EXPOSURE", "CCD_EXPOSURE_VALUE", 0.0001, 7200, 1, false);
 
     IUSaveText(&BayerT[2], "RGGB");
@@ -108,6 +119,7 @@ bool PkTriggerCordCCD::updateProperties()
 
         defineProperty(&transferFormatSP);
         defineProperty(&autoFocusSP);
+        defineProperty(&rawQualitySP);
         if (transferFormatS[0].s == ISS_ON) {
             defineProperty(&preserveOriginalSP);
         }
@@ -121,6 +133,7 @@ bool PkTriggerCordCCD::updateProperties()
         deleteProperty(autoFocusSP.name);
         deleteProperty(transferFormatSP.name);
         deleteProperty(preserveOriginalSP.name);
+        deleteProperty(rawQualitySP.name);
 
         rmTimer(timerID);
     }
@@ -273,24 +286,43 @@ bool PkTriggerCordCCD::shutterPress(pslr_rational_t shutter_speed)
 	LOG_DEBUG("Shutter pressed.");
 	pslr_get_status(device, &status);
 
-	user_file_format_t ufft = *get_file_format_t(uff);
-	char * output_file = TMPFILEBASE;
-	int fd = open_file(output_file, 1, ufft);
-	
-	int cnt = 0;
-	while ( save_buffer(device, 0, fd, &status, uff, quality ) ) {
-		LOGF_DEBUG("Saved buffer (%d)",cnt++);
-	}
-	
-	pslr_delete_buffer(device, 0);
-	if (fd != 1) {
-		close(fd);
-	}
+    pslr_buffer_type imagetype;
+    if (uff == USER_FILE_FORMAT_PEF) {
+        imagetype = PSLR_BUF_PEF;
+    } else if (uff == USER_FILE_FORMAT_DNG) {
+        imagetype = PSLR_BUF_DNG;
+    } else {
+        imagetype = pslr_get_jpeg_buffer_type(device, quality);
+    }
+
+    imageBufferLength = 0;
+
+    // Download straight into memory, the buffer only grows when a larger image comes in.
+    // PSLR_READ_ERROR means the camera has no image yet, anything else is fatal.
+    int maxTries = (ExposureRequest + BUFFER_TIMEOUT) / BUFFER_POLL;
+    int cnt = 0;
+    int ret;
+    while ( (ret = pslr_get_buffer_into(device, 0, imagetype, status.jpeg_resolution, &imageBuffer, &imageBufferCapacity, &imageBufferLength)) == PSLR_READ_ERROR && cnt < maxTries ) {
+        LOGF_DEBUG("Waiting for buffer (%d)",cnt++);
+        sleep_sec(BUFFER_POLL);
+    }
+    if (ret != PSLR_OK) {
+        LOGF_ERROR("Failed to download the image from the camera (error %d after %d tries).", ret, cnt);
+        imageBufferLength = 0;
+        pslr_delete_buffer(device, 0);
+        if (need_bulb_new_cleanup) {
+            bulb_new_cleanup(device);
+        }
+        return false;
+    }
+    LOGF_DEBUG("Downloaded %u bytes.", imageBufferLength);
+
+    pslr_delete_buffer(device, 0);
 	if (need_bulb_new_cleanup) {
 		bulb_new_cleanup(device);
 	}
 		
-    return 1;
+    return true;
 }
 
 
@@ -497,12 +529,14 @@ void PkTriggerCordCCD::TimerHit()
         std::chrono::milliseconds span (100);
         if ( shutter_result.wait_for(span)!=std::future_status::timeout) {
             bool result = shutter_result.get();
-            INDI_UNUSED(result);
             InDownload = false;
             InExposure = false;
 
-            grabImage();
-            ExposureComplete(&PrimaryCCD);
+            if (result && grabImage()) {
+                ExposureComplete(&PrimaryCCD);
+            } else {
+                PrimaryCCD.setExposureFailed();
+            }
         } else if (InDownload && isDebug()) {
             IDLog("Still waiting for download...\n");
         }
@@ -515,17 +549,11 @@ void PkTriggerCordCCD::TimerHit()
 
 bool PkTriggerCordCCD::grabImage()
 {
-    //set correct tmpfile location
-    char tmpfile[256];
-    if (uff==USER_FILE_FORMAT_JPEG) {
-        snprintf(tmpfile, 256, "%s-0001.jpg", TMPFILEBASE);
-    } else if (uff==USER_FILE_FORMAT_DNG) {
-        snprintf(tmpfile, 256, "%s-0001.dng", TMPFILEBASE);
-    } else {
-        snprintf(tmpfile, 256, "%s-0001.pef", TMPFILEBASE);
+    if (imageBufferLength == 0)
+    {
+        LOG_ERROR("No image was downloaded from the camera.");
+        return false;
     }
-	LOGF_DEBUG("Reading temp file from: %s",tmpfile);
-
 
     // fits handling code
     if (transferFormatS[0].s == ISS_ON)
@@ -535,12 +563,12 @@ bool PkTriggerCordCCD::grabImage()
         size_t memsize = 0;
         int naxis = 2, w = 0, h = 0, bpp = 8;
 
+        frameRawQuality = RAW_QUALITY_FULL;
         if (uff==USER_FILE_FORMAT_JPEG)
         {            
-            if (read_jpeg(tmpfile, &memptr, &memsize, &naxis, &w, &h))
+            if (read_jpeg_buffer(imageBuffer, imageBufferLength, &memptr, &memsize, &naxis, &w, &h))
             {
                 LOG_ERROR("Exposure failed to parse jpeg.");
-                unlink(tmpfile);
                 return false;
             }
             
@@ -554,19 +582,25 @@ bool PkTriggerCordCCD::grabImage()
         {
             char bayer_pattern[8] = {};
 
-            if (read_libraw(tmpfile, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
+            frameRawQuality = IUFindOnSwitchIndex(&rawQualitySP);
+            if (read_libraw_buffer(imageBuffer, imageBufferLength, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern, frameRawQuality))
             {
                 LOG_ERROR("Exposure failed to parse raw image.");
-                unlink(tmpfile);
                 return false;
             }
 
             LOGF_DEBUG("read_libraw: memsize (%d) naxis (%d) w (%d) h (%d) bpp (%d) bayer pattern (%s)",
                        memsize, naxis, w, h, bpp, bayer_pattern);
 
-            IUSaveText(&BayerT[2], bayer_pattern);
-            IDSetText(&BayerTP, nullptr);
-            SetCCDCapability(GetCCDCapability() | CCD_HAS_BAYER);
+            // Mono previews carry no bayer pattern
+            if (bayer_pattern[0]) {
+                IUSaveText(&BayerT[2], bayer_pattern);
+                IDSetText(&BayerTP, nullptr);
+                SetCCDCapability(GetCCDCapability() | CCD_HAS_BAYER);
+            }
+            else {
+                SetCCDCapability(GetCCDCapability() & ~CCD_HAS_BAYER);
+            }
         }
 
         if (PrimaryCCD.getSubW() != 0 && (w > PrimaryCCD.getSubW() || h > PrimaryCCD.getSubH()))
@@ -579,6 +613,7 @@ bool PkTriggerCordCCD::grabImage()
         PrimaryCCD.setNAxis(naxis);
         PrimaryCCD.setBPP(bpp);
 
+        // The native file is only written when the user asks for it
         if (preserveOriginalS[1].s == ISS_ON) {
             char ts[32];
             struct tm * tp;
@@ -590,15 +625,16 @@ bool PkTriggerCordCCD::grabImage()
             prefix = std::regex_replace(prefix, std::regex("XXX"), string(ts));
             char newname[255];
             snprintf(newname, 255, "%s.%s",prefix.c_str(),getFormatFileExtension(uff));
-            if (std::rename(tmpfile, newname)) {
-                LOGF_ERROR("File system error prevented saving original image to %s.  Saved to %s instead.", newname,tmpfile);
+            FILE* f = fopen(newname, "wb");
+            if (f == nullptr || fwrite(imageBuffer, 1, imageBufferLength, f) != imageBufferLength) {
+                LOGF_ERROR("File system error prevented saving original image to %s: %s", newname, strerror(errno));
             }
             else {
                 LOGF_INFO("Saved original image to %s.", newname);
             }
-        }
-        else {
-            std::remove(tmpfile);
+            if (f != nullptr) {
+                fclose(f);
+            }
         }
 
     }
@@ -606,25 +642,9 @@ bool PkTriggerCordCCD::grabImage()
     else
     {
         PrimaryCCD.setImageExtension(getFormatFileExtension(uff));
-
-        FILE* f = fopen(tmpfile, "r");
-        fseek(f, 0, SEEK_END);
-        size_t size = ftell(f);
-        rewind(f);
-
-        PrimaryCCD.setFrameBufferSize(size);
-        char * memptr = (char *)PrimaryCCD.getFrameBuffer();
-        size_t readSize = fread(memptr, sizeof(char), size, f);
-        if (readSize != size)
-        {
-            LOGF_ERROR("Error, %u bytes of data read instead of %u.", readSize, size);
-        }
-        PrimaryCCD.setFrameBuffer((unsigned char *)memptr);
-        fclose(f);
-		LOG_DEBUG("Copied to frame buffer.  Leaving temp file for debug purposes.");
-		if (!isDebug()) {
-			std::remove(tmpfile);
-		}
+        PrimaryCCD.setFrameBufferSize(imageBufferLength);
+        memcpy(PrimaryCCD.getFrameBuffer(), imageBuffer, imageBufferLength);
+        LOG_DEBUG("Copied to frame buffer.");
     }
 
     return true;
@@ -676,6 +696,11 @@ bool PkTriggerCordCCD::ISNewSwitch(const char * dev, const char * name, ISState
         preserveOriginalSP.s = IPS_OK;
         IDSetSwitch(&preserveOriginalSP, nullptr);
     }
+    else if (!strcmp(name, rawQualitySP.name)) {
+        IUUpdateSwitch(&rawQualitySP, states, names, n);
+        rawQualitySP.s = IPS_OK;
+        IDSetSwitch(&rawQualitySP, nullptr);
+    }
     else if (!strcmp(name, mIsoSP.name)) {
         updateCaptureSettingSwitch(&mIsoSP,states,names,n);
         pslr_set_iso(device,atoi(IUFindOnSwitch(&mIsoSP)->label),MINISO,MAXISO);
@@ -733,7 +758,7 @@ void PkTriggerCordCCD::updateCaptureSettingSwitch(ISwitchVectorProperty * sw, IS
 
 bool PkTriggerCordCCD::saveConfigItems(FILE * fp) {
 
-    for (auto sw : std::vector<ISwitchVectorProperty*>{&mIsoSP,&mApertureSP,&mExpCompSP,&mWhiteBalanceSP,&mIQualitySP,&mFormatSP}) {
+    for (auto sw : std::vector<ISwitchVectorProperty*>{&mIsoSP,&mApertureSP,&mExpCompSP,&mWhiteBalanceSP,&mIQualitySP,&mFormatSP,&rawQualitySP}) {
         if (sw->nsp>0) IUSaveConfigSwitch(fp, sw);
     }
 
@@ -757,6 +782,8 @@ void PkTriggerCordCCD::addFITSKeywords(fitsfile * fptr, INDI::CCDChip * targetCh
                 fits_update_key_s(fptr, TUINT, "ISOSPEED", &isoSpeed, "ISO Speed", &status);
         }
     }
+
+    raw_quality_fits_keywords(fptr, frameRawQuality);
 }
 
 // returns true if still connected
@@ -73,6 +73,11 @@ protected:
     bool InDownload, need_bulb_new_cleanup;
     bool bufferIsBayered;
 
+    // Last image downloaded from the camera, reused between frames
+    uint8_t *imageBuffer { nullptr };
+    uint32_t imageBufferCapacity { 0 };
+    uint32_t imageBufferLength { 0 };
+
     int timerID;
 
     INDI::CCDChip::CCD_FRAME imageFrameType;
@@ -94,6 +99,12 @@ protected:
     ISwitch preserveOriginalS[2];
     ISwitchVectorProperty preserveOriginalSP;
 
+    // Decode quality of RAW captures, switch order follows RAW_QUALITY_* in gphoto_readimage.h
+    ISwitch rawQualityS[3];
+    ISwitchVectorProperty rawQualitySP;
+    // Quality the frame being sent was decoded at, for its FITS keywords
+    int frameRawQuality {RAW_QUALITY_FULL};
+
     ISwitch autoFocusS[2];
     ISwitchVectorProperty autoFocusSP;
 
@@ -30,6 +30,9 @@
 #include <math.h>
 #include <memory>
 #include <deque>
+#include <cerrno>
+#include <cstring>
+#include <thread>
 
 #define UPDATE_THRESHOLD       0.05   /* Differential temperature threshold (C)*/
 
@@ -207,6 +210,13 @@ bool QHYCCD::initProperties()
     IUFillNumberVector(&HumidityNP, HumidityN, 1, getDeviceName(), "CCD_HUMIDITY", "Humidity", MAIN_CONTROL_TAB,
                        IP_RO, 60, IPS_IDLE);
 
+    // Stream Stats
+    IUFillNumber(&StreamStatsN[STREAM_FPS], "STREAM_FPS", "Measured FPS", "%.1f", 0, 10000, 0, 0);
+    IUFillNumber(&StreamStatsN[STREAM_LATENCY], "STREAM_LATENCY", "Latency (ms)", "%.2f", 0, 10000, 0, 0);
+    IUFillNumber(&StreamStatsN[STREAM_DROPPED], "STREAM_DROPPED", "Dropped", "%.f", 0, 1e9, 0, 0);
+    IUFillNumberVector(&StreamStatsNP, StreamStatsN, 3, getDeviceName(), "CCD_STREAM_STATS", "Stream Stats", STREAMING_TAB,
+                       IP_RO, 60, IPS_IDLE);
+
     // Cooler Mode
     IUFillSwitch(&CoolerModeS[COOLER_AUTOMATIC], "COOLER_AUTOMATIC", "Auto", ISS_ON);
     IUFillSwitch(&CoolerModeS[COOLER_MANUAL], "COOLER_MANUAL", "Manual", ISS_OFF);
@@ -275,6 +285,12 @@ bool QHYCCD::initProperties()
     IUFillSwitchVector(&GPSControlSP, GPSControlS, 2, getDeviceName(), "GPS_CONTROL", "GPS Header", GPS_CONTROL_TAB,
                        IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    // GPS binary timestamp log On/Off
+    IUFillSwitch(&GPSTimestampLogS[INDI_ENABLED], "INDI_ENABLED", "Enable", ISS_OFF);
+    IUFillSwitch(&GPSTimestampLogS[INDI_DISABLED], "INDI_DISABLED", "Disable", ISS_ON);
+    IUFillSwitchVector(&GPSTimestampLogSP, GPSTimestampLogS, 2, getDeviceName(), "GPS_TIMESTAMP_LOG", "Timestamp Log",
+                       GPS_CONTROL_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
+
     /////////////////////////////////////////////////////////////////////////////
     /// Properties: GPS Data
     /////////////////////////////////////////////////////////////////////////////
@@ -387,6 +403,7 @@ void QHYCCD::ISGetProperties(const char *dev)
             defineProperty(&GPSLEDEndPosNP);
 
             defineProperty(&GPSControlSP);
+            defineProperty(&GPSTimestampLogSP);
 
             defineProperty(&GPSStateLP);
             defineProperty(&GPSDataHeaderTP);
@@ -443,6 +460,10 @@ bool QHYCCD::updateProperties()
 
             defineProperty(&HumidityNP);
         }
+
+        if (HasStreaming())
+            defineProperty(&StreamStatsNP);
+
         double min = 0, max = 0, step = 0;
         if (HasUSBSpeed)
         {
@@ -599,6 +620,7 @@ bool QHYCCD::updateProperties()
             defineProperty(&GPSLEDStartPosNP);
             defineProperty(&GPSLEDEndPosNP);
             defineProperty(&GPSControlSP);
+            defineProperty(&GPSTimestampLogSP);
 
             defineProperty(&GPSStateLP);
             defineProperty(&GPSDataHeaderTP);
@@ -631,6 +653,9 @@ bool QHYCCD::updateProperties()
         if (HasHumidity)
             deleteProperty(HumidityNP.name);
 
+        if (HasStreaming())
+            deleteProperty(StreamStatsNP.name);
+
         if (HasUSBSpeed)
         {
             deleteProperty(SpeedNP.name);
@@ -675,6 +700,7 @@ bool QHYCCD::updateProperties()
             deleteProperty(GPSLEDStartPosNP.name);
             deleteProperty(GPSLEDEndPosNP.name);
             deleteProperty(GPSControlSP.name);
+            deleteProperty(GPSTimestampLogSP.name);
 
             deleteProperty(GPSStateLP.name);
             deleteProperty(GPSDataHeaderTP.name);
@@ -1095,6 +1121,7 @@ bool QHYCCD::Disconnect()
     pthread_cond_signal(&cv);
     pthread_mutex_unlock(&condMutex);
     pthread_join(m_ImagingThread, nullptr);
+    m_GPSTimestampLog.close();
     //tState = StateNone;
     if (isSimulation() == false)
     {
@@ -1512,7 +1539,7 @@ int QHYCCD::grabImage()
         LOG_DEBUG("Download complete.");
 
     if (HasGPS && GPSControlS[INDI_ENABLED].s == ISS_ON)
-        decodeGPSHeader();
+        decodeGPSHeader(PrimaryCCD.getFrameBuffer(), false);
 
     ExposureComplete(&PrimaryCCD);
 
@@ -1731,6 +1758,28 @@ bool QHYCCD::ISNewSwitch(const char *dev, const char *name, ISState *states, cha
             return true;
         }
 
+        //////////////////////////////////////////////////////////////////////
+        /// GPS Timestamp Log
+        //////////////////////////////////////////////////////////////////////
+        else if (!strcmp(GPSTimestampLogSP.name, name))
+        {
+            IUUpdateSwitch(&GPSTimestampLogSP, states, names, n);
+            if (GPSTimestampLogS[INDI_ENABLED].s == ISS_ON)
+            {
+                // The sidecar is opened with the next frame so it starts alongside the recording.
+                GPSTimestampLogSP.s = IPS_OK;
+                LOGF_INFO("GPS timestamps will be logged to %s.", UploadSettingsT[UPLOAD_DIR].text);
+            }
+            else
+            {
+                m_GPSTimestampLog.close();
+                GPSTimestampLogSP.s = IPS_IDLE;
+                LOG_INFO("GPS timestamp log is disabled.");
+            }
+            IDSetSwitch(&GPSTimestampLogSP, nullptr);
+            return true;
+        }
+
         //////////////////////////////////////////////////////////////////////
         /// GPS Slaving Mode
         //////////////////////////////////////////////////////////////////////
@@ -2317,6 +2366,7 @@ bool QHYCCD::saveConfigItems(FILE *fp)
     if (HasGPS)
     {
         IUSaveConfigSwitch(fp, &GPSControlSP);
+        IUSaveConfigSwitch(fp, &GPSTimestampLogSP);
         IUSaveConfigSwitch(fp, &GPSSlavingSP);
         IUSaveConfigNumber(fp, &VCOXFreqNP);
     }
@@ -2439,6 +2489,9 @@ bool QHYCCD::StartStreaming()
 
     LOGF_INFO("Starting video streaming with exposure %.f seconds (%.f FPS), w=%d h=%d", m_ExposureRequest,
               Streamer->getTargetFPS(), subW, subH);
+    m_LiveFrames.allocate(PrimaryCCD.getFrameBufferSize());
+    // Every stream gets its own timestamp sidecar
+    m_GPSTimestampLog.close();
     BeginQHYCCDLive(m_CameraHandle);
     pthread_mutex_lock(&condMutex);
     m_ThreadRequest = StateStream;
@@ -2459,6 +2512,10 @@ bool QHYCCD::StopStreaming()
     }
     pthread_mutex_unlock(&condMutex);
     StopQHYCCDLive(m_CameraHandle);
+    uint64_t droppedStamps = m_GPSTimestampLog.dropped();
+    m_GPSTimestampLog.close();
+    if (droppedStamps > 0)
+        LOGF_WARN("GPS timestamp log could not keep up, %llu stamps were dropped.", static_cast<unsigned long long>(droppedStamps));
 
     //LOG_INFO("stopped live mode"); //DEBUG
 
@@ -2535,41 +2592,111 @@ void *QHYCCD::imagingThreadEntry()
     return nullptr;
 }
 
+/*
+ * The SDK reader runs on the imaging thread without holding ccdBufferLock or
+ * condMutex, so exposures and property updates are never stuck behind a blocking
+ * GetQHYCCDLiveFrame call. Frames are handed to sendVideo() through a triple buffer.
+ */
 void QHYCCD::streamVideo()
 {
-    uint32_t ret = 0, w, h, bpp, channels;
-    //uint32_t t_start = time(NULL), frames = 0;
+    pthread_mutex_unlock(&condMutex);
+
+    std::thread sender(&QHYCCD::sendVideo, this);
+
+    auto lastFrame = std::chrono::steady_clock::now();
+    uint32_t backoff = 0;
     while (m_ThreadRequest == StateStream)
     {
-        pthread_mutex_unlock(&condMutex);
-        uint32_t retries = 0;
-        std::unique_lock<std::mutex> guard(ccdBufferLock);
-        uint8_t *buffer = PrimaryCCD.getFrameBuffer();
-        while (retries++ < 10)
-        {
+        uint32_t w = 0, h = 0, bpp = 0, channels = 0;
+        QHYTripleBuffer::Frame &frame = m_LiveFrames.back();
 
-            ret = GetQHYCCDLiveFrame(m_CameraHandle, &w, &h, &bpp, &channels, buffer);
-            if (ret == QHYCCD_ERROR)
-                usleep(1000);
-            else
-                break;
+        if (GetQHYCCDLiveFrame(m_CameraHandle, &w, &h, &bpp, &channels, frame.data.data()) != QHYCCD_SUCCESS)
+        {
+            waitLiveFrame(lastFrame, backoff);
+            continue;
         }
-        guard.unlock();
-        if (ret == QHYCCD_SUCCESS)
+
+        lastFrame = frame.captured = std::chrono::steady_clock::now();
+        frame.size = std::min<size_t>(w * h * bpp / 8 * channels, frame.data.size());
+        backoff = 0;
+        m_LiveFrames.publish();
+    }
+
+    m_LiveFrames.close();
+    sender.join();
+
+    pthread_mutex_lock(&condMutex);
+}
+
+/*
+ * Rather than polling the SDK at a fixed 1ms, sleep until the next frame is due
+ * according to the requested exposure. If it is late, poll with an exponential
+ * backoff capped at an eighth of the frame period.
+ */
+void QHYCCD::waitLiveFrame(std::chrono::steady_clock::time_point lastFrame, uint32_t &backoff)
+{
+    constexpr uint32_t minBackoff = 100, maxBackoff = 10000;
+    const auto period = std::chrono::microseconds(static_cast<int64_t>(m_ExposureRequest * 1e6));
+    const auto now = std::chrono::steady_clock::now();
+    const auto due = lastFrame + period * 9 / 10;
+
+    if (backoff == 0 && now < due)
+    {
+        backoff = minBackoff;
+        std::this_thread::sleep_for(due - now);
+        return;
+    }
+
+    const uint32_t limit = std::max(minBackoff, std::min(maxBackoff, static_cast<uint32_t>(period.count() / 8)));
+    backoff = std::min(limit, std::max(minBackoff, backoff * 2));
+    std::this_thread::sleep_for(std::chrono::microseconds(backoff));
+}
+
+void QHYCCD::sendVideo()
+{
+    auto windowStart = std::chrono::steady_clock::now();
+    uint32_t frames = 0;
+    double latency = 0;
+
+    StreamStatsN[STREAM_FPS].value = 0;
+    StreamStatsN[STREAM_LATENCY].value = 0;
+    StreamStatsN[STREAM_DROPPED].value = 0;
+    StreamStatsNP.s = IPS_BUSY;
+    IDSetNumber(&StreamStatsNP, nullptr);
+
+    while (m_ThreadRequest == StateStream)
+    {
+        const QHYTripleBuffer::Frame *frame = m_LiveFrames.wait(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+
+        if (frame != nullptr)
         {
-            Streamer->newFrame(buffer, w * h * bpp / 8 * channels);
+            Streamer->newFrame(frame->data.data(), frame->size);
 
             if (HasGPS && GPSControlS[INDI_ENABLED].s == ISS_ON)
-                decodeGPSHeader();
+                decodeGPSHeader(frame->data.data(), true);
 
-            //DEBUG
-            //if(!frames)
-            //    LOGF_DEBUG("Receiving frames ...");
-            //if(!(++frames % 30))
-            //    LOGF_DEBUG("Frames received: %d (%.1f fps)", frames, 1.0 * frames / (time(NULL) - t_start));
+            now = std::chrono::steady_clock::now();
+            latency += std::chrono::duration<double, std::milli>(now - frame->captured).count();
+            frames++;
+        }
+
+        const double elapsed = std::chrono::duration<double>(now - windowStart).count();
+        if (elapsed >= 1.0)
+        {
+            StreamStatsN[STREAM_FPS].value = frames / elapsed;
+            StreamStatsN[STREAM_LATENCY].value = frames > 0 ? latency / frames : 0;
+            StreamStatsN[STREAM_DROPPED].value = m_LiveFrames.dropped();
+            IDSetNumber(&StreamStatsNP, nullptr);
+
+            windowStart = now;
+            frames = 0;
+            latency = 0;
         }
-        pthread_mutex_lock(&condMutex);
     }
+
+    StreamStatsNP.s = IPS_IDLE;
+    IDSetNumber(&StreamStatsNP, nullptr);
 }
 
 void QHYCCD::getExposure()
@@ -2792,53 +2919,96 @@ void QHYCCD::setLEDStartPosNP(const INumberVectorProperty &value)
     GPSLEDStartPosNP = value;
 }
 
-void QHYCCD::decodeGPSHeader()
+void QHYCCD::decodeGPSHeader(const uint8_t *frame, bool throttle)
 {
-    char ts[64] = {0}, iso8601[64] = {0}, data[64] = {0};
+    const QHYGPSStamp stamp = QHYGPSStamp::decode(frame);
+
+    if (GPSTimestampLogS[INDI_ENABLED].s == ISS_ON)
+    {
+        if (!m_GPSTimestampLog.isOpen())
+            openGPSTimestampLog();
+        m_GPSTimestampLog.append(stamp);
+    }
+
+    GPSHeader.seqNumber = stamp.seqNumber;
+    GPSHeader.tempNumber = stamp.tempNumber;
+    GPSHeader.width = stamp.width;
+    GPSHeader.height = stamp.height;
+    GPSHeader.latitude = stamp.latitude;
+    GPSHeader.longitude = stamp.longitude;
+
+    // It's a 10Mhz crystal so we divide by 10 to get microseconds
+    GPSHeader.start_flag = stamp.startFlag;
+    GPSHeader.start_sec = stamp.startSec;
+    GPSHeader.start_us = stamp.startTicks / 10.0;
+
+    GPSHeader.end_flag = stamp.endFlag;
+    GPSHeader.end_sec = stamp.endSec;
+    GPSHeader.end_us = stamp.endTicks / 10.0;
+
+    GPSHeader.now_flag = stamp.nowFlag;
+    GPSHeader.now_sec = stamp.nowSec;
+    GPSHeader.now_us = stamp.nowTicks / 10.0;
+
+    GPSHeader.max_clock = stamp.maxClock;
+
+    GPSState newGPState = static_cast<GPSState>((GPSHeader.now_flag & 0xF0) >> 4);
+    if (GPSStateL[newGPState].s == IPS_IDLE)
+    {
+        GPSStateL[GPS_ON].s = IPS_IDLE;
+        GPSStateL[GPS_SEARCHING].s = IPS_IDLE;
+        GPSStateL[GPS_LOCKING].s = IPS_IDLE;
+        GPSStateL[GPS_LOCKED].s = IPS_IDLE;
+
+        GPSStateL[newGPState].s = IPS_BUSY;
+        GPSStateLP.s = IPS_OK;
+        IDSetLight(&GPSStateLP, nullptr);
+    }
+
+    // While streaming, formatting the text properties for every frame is wasted work,
+    // the full rate data is in the timestamp log.
+    auto now = std::chrono::steady_clock::now();
+    if (throttle && now - m_LastGPSUpdate < std::chrono::seconds(1))
+        return;
+
+    m_LastGPSUpdate = now;
+    m_GPSTimestampLog.flush();
+    updateGPSProperties();
+}
 
-    uint8_t gpsarray[64] = {0};
-    memcpy(gpsarray, PrimaryCCD.getFrameBuffer(), 64);
+void QHYCCD::updateGPSProperties()
+{
+    char ts[64] = {0}, iso8601[64] = {0}, data[64] = {0};
 
     // Sequence Number
-    GPSHeader.seqNumber = gpsarray[0] << 24 | gpsarray[1] << 16 | gpsarray[2] << 8 | gpsarray[3];
     snprintf(data, 64, "%u", GPSHeader.seqNumber);
     IUSaveText(&GPSDataHeaderT[GPS_DATA_SEQ_NUMBER], data);
 
-    GPSHeader.tempNumber = gpsarray[4];
-
     // Width
-    GPSHeader.width = gpsarray[5] << 8 | gpsarray[6];
     snprintf(data, 64, "%u", GPSHeader.width);
     IUSaveText(&GPSDataHeaderT[GPS_DATA_WIDTH], data);
 
     // Height
-    GPSHeader.height = gpsarray[7] << 8 | gpsarray[8];
     snprintf(data, 64, "%u", GPSHeader.height);
     IUSaveText(&GPSDataHeaderT[GPS_DATA_HEIGHT], data);
 
     // Latitude
-    GPSHeader.latitude = gpsarray[9] << 24 | gpsarray[10] << 16 | gpsarray[11] << 8 | gpsarray[12];
     snprintf(data, 64, "%u", GPSHeader.latitude);
     IUSaveText(&GPSDataHeaderT[GPS_DATA_LATITUDE], data);
 
     // Longitude
-    GPSHeader.longitude = gpsarray[13] << 24 | gpsarray[14] << 16 | gpsarray[15] << 8 | gpsarray[16];
     snprintf(data, 64, "%u", GPSHeader.longitude);
     IUSaveText(&GPSDataHeaderT[GPS_DATA_LONGITUDE], data);
 
     // Start Flag
-    GPSHeader.start_flag = gpsarray[17];
     snprintf(data, 64, "%u", GPSHeader.start_flag);
     IUSaveText(&GPSDataStartT[GPS_DATA_START_FLAG], data);
 
     // Start Seconds
-    GPSHeader.start_sec = gpsarray[18] << 24 | gpsarray[19] << 16 | gpsarray[20] << 8 | gpsarray[21];
     snprintf(data, 64, "%u", GPSHeader.start_sec);
     IUSaveText(&GPSDataStartT[GPS_DATA_START_SEC], data);
 
     // Start microseconds
-    // It's a 10Mhz crystal so we divide by 10 to get microseconds
-    GPSHeader.start_us = (gpsarray[22] << 16 | gpsarray[23] << 8 | gpsarray[24]) / 10.0;
     snprintf(data, 64, "%.1f", GPSHeader.start_us);
     IUSaveText(&GPSDataStartT[GPS_DATA_START_USEC], data);
 
@@ -2851,17 +3021,14 @@ void QHYCCD::decodeGPSHeader()
     IUSaveText(&GPSDataStartT[GPS_DATA_START_TS], ts);
 
     // End Flag
-    GPSHeader.end_flag = gpsarray[25];
     snprintf(data, 64, "%u", GPSHeader.end_flag);
     IUSaveText(&GPSDataEndT[GPS_DATA_END_FLAG], data);
 
     // End Seconds
-    GPSHeader.end_sec = gpsarray[26] << 24 | gpsarray[27] << 16 | gpsarray[28] << 8 | gpsarray[29];
     snprintf(data, 64, "%u", GPSHeader.end_sec);
     IUSaveText(&GPSDataEndT[GPS_DATA_END_SEC], data);
 
     // End Microseconds
-    GPSHeader.end_us = (gpsarray[30] << 16 | gpsarray[31] << 8 | gpsarray[32]) / 10.0;
     snprintf(data, 64, "%.1f", GPSHeader.end_us);
     IUSaveText(&GPSDataEndT[GPS_DATA_END_USEC], data);
 
@@ -2874,17 +3041,14 @@ void QHYCCD::decodeGPSHeader()
     IUSaveText(&GPSDataEndT[GPS_DATA_END_TS], ts);
 
     // Now Flag
-    GPSHeader.now_flag = gpsarray[33];
     snprintf(data, 64, "%u", GPSHeader.now_flag);
     IUSaveText(&GPSDataNowT[GPS_DATA_NOW_FLAG], data);
 
     // Now Seconds
-    GPSHeader.now_sec = gpsarray[34] << 24 | gpsarray[35] << 16 | gpsarray[36] << 8 | gpsarray[37];
     snprintf(data, 64, "%u", GPSHeader.now_sec);
     IUSaveText(&GPSDataNowT[GPS_DATA_NOW_SEC], data);
 
     // Now microseconds
-    GPSHeader.now_us = (gpsarray[38] << 16 | gpsarray[39] << 8 | gpsarray[40]) / 10.0;
     snprintf(data, 64, "%.1f", GPSHeader.now_us);
     IUSaveText(&GPSDataNowT[GPS_DATA_NOW_USEC], data);
 
@@ -2897,7 +3061,6 @@ void QHYCCD::decodeGPSHeader()
     IUSaveText(&GPSDataNowT[GPS_DATA_NOW_TS], ts);
 
     // PPS
-    GPSHeader.max_clock = gpsarray[41] << 16 | gpsarray[42] << 8 | gpsarray[43];
     snprintf(data, 64, "%u", GPSHeader.max_clock);
     IUSaveText(&GPSDataHeaderT[GPS_DATA_MAX_CLOCK], data);
 
@@ -2905,19 +3068,58 @@ void QHYCCD::decodeGPSHeader()
     IDSetText(&GPSDataStartTP, nullptr);
     IDSetText(&GPSDataEndTP, nullptr);
     IDSetText(&GPSDataNowTP, nullptr);
+}
 
-    GPSState newGPState = static_cast<GPSState>((GPSHeader.now_flag & 0xF0) >> 4);
-    if (GPSStateL[newGPState].s == IPS_IDLE)
+void QHYCCD::openGPSTimestampLog()
+{
+    time_t now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+
+    // Named like the recorder names the SER file, so the log sits beside it
+    std::string dir = UploadSettingsT[UPLOAD_DIR].text;
+    std::string name = std::string(getDeviceName()) + "__T_";
+    ITextVectorProperty *recordFileTP = getText("RECORD_FILE");
+    if (recordFileTP != nullptr)
     {
-        GPSStateL[GPS_ON].s = IPS_IDLE;
-        GPSStateL[GPS_SEARCHING].s = IPS_IDLE;
-        GPSStateL[GPS_LOCKING].s = IPS_IDLE;
-        GPSStateL[GPS_LOCKED].s = IPS_IDLE;
+        IText *recordDir = IUFindText(recordFileTP, "RECORD_FILE_DIR");
+        IText *recordName = IUFindText(recordFileTP, "RECORD_FILE_NAME");
+        if (recordDir != nullptr && recordName != nullptr)
+        {
+            dir = recordDir->text;
+            name = recordName->text;
+        }
+    }
 
-        GPSStateL[newGPState].s = IPS_BUSY;
-        GPSStateLP.s = IPS_OK;
-        IDSetLight(&GPSStateLP, nullptr);
+    // Same date and time patterns as the stream recorder, in UTC
+    const std::pair<const char *, const char *> patterns[] =
+    {
+        {"_D_", "%Y-%m-%d"}, {"_H_", "%H-%M-%S"}, {"_T_", "%Y-%m-%d@%H-%M-%S"}
+    };
+    for (const auto &pattern : patterns)
+    {
+        char value[32] = {0};
+        strftime(value, sizeof(value), pattern.second, &utc);
+        for (std::string *text : {&dir, &name})
+        {
+            size_t pos;
+            while ((pos = text->find(pattern.first)) != std::string::npos)
+                text->replace(pos, strlen(pattern.first), value);
+        }
     }
+
+    std::string path = dir + "/" + name + ".gps";
+    if (m_GPSTimestampLog.open(path))
+    {
+        LOGF_INFO("Logging GPS timestamps to %s", path.c_str());
+        return;
+    }
+
+    LOGF_ERROR("Failed to open GPS timestamp log %s: %s", path.c_str(), strerror(errno));
+    IUResetSwitch(&GPSTimestampLogSP);
+    GPSTimestampLogS[INDI_DISABLED].s = ISS_ON;
+    GPSTimestampLogSP.s = IPS_ALERT;
+    IDSetSwitch(&GPSTimestampLogSP, nullptr);
 }
 
 double QHYCCD::JStoJD(uint32_t JS, double us)
@@ -21,10 +21,14 @@
 
 #pragma once
 
+#include "qhy_gpsstamp.h"
+#include "qhy_triplebuffer.h"
+
 #include <qhyccd.h>
 #include <indiccd.h>
 #include <indifilterinterface.h>
 #include <unistd.h>
+#include <atomic>
 #include <functional>
 #include <pthread.h>
 
@@ -166,6 +170,16 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         // Humidity Readout
         INumber HumidityN[1];
         INumberVectorProperty HumidityNP;
+
+        // Measured streaming performance
+        INumber StreamStatsN[3];
+        INumberVectorProperty StreamStatsNP;
+        enum
+        {
+            STREAM_FPS,
+            STREAM_LATENCY,
+            STREAM_DROPPED,
+        };
         /////////////////////////////////////////////////////////////////////////////
         /// Properties: Utility Controls
         /////////////////////////////////////////////////////////////////////////////
@@ -226,6 +240,10 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         ISwitchVectorProperty GPSControlSP;
         ISwitch GPSControlS[2];
 
+        // Binary timestamp sidecar On/Off
+        ISwitchVectorProperty GPSTimestampLogSP;
+        ISwitch GPSTimestampLogS[2];
+
         // GPS Status
         ILightVectorProperty GPSStateLP;
         ILight GPSStateL[4];
@@ -376,6 +394,9 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         static void *imagingHelper(void *context);
         void *imagingThreadEntry();
         void streamVideo();
+        void sendVideo();
+        // Sleep before polling the SDK again for a live frame
+        void waitLiveFrame(std::chrono::steady_clock::time_point lastFrame, uint32_t &backoff);
         void getExposure();
         void exposureSetRequest(ImageState request);
         int grabImage();
@@ -401,8 +422,11 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         bool isQHY5PIIC();
         // Call when max filter count is known
         bool updateFilterProperties();
-        // Decode GPS Header
-        void decodeGPSHeader();
+        // Decode GPS Header, text properties are refreshed at most once per second if throttled
+        void decodeGPSHeader(const uint8_t *frame, bool throttle);
+        void updateGPSProperties();
+        // Start a new binary timestamp sidecar beside the stream recording
+        void openGPSTimestampLog();
         /**
          * @brief JStoJD Convert Julian Second to Julian Date
          * @param JS Julian Second
@@ -465,16 +489,21 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         uint32_t currentQHYReadMode;
         // dynamic array to hold read mode information
         QHYReadModeInfo *readModeInfo = nullptr;
+        // Binary per-frame GPS timestamps
+        QHYGPSStampLog m_GPSTimestampLog;
+        std::chrono::steady_clock::time_point m_LastGPSUpdate;
 
 
         /////////////////////////////////////////////////////////////////////////////
         /// Threading
         /////////////////////////////////////////////////////////////////////////////
-        ImageState m_ThreadRequest;
+        std::atomic<ImageState> m_ThreadRequest;
         ImageState m_ThreadState;
         pthread_t m_ImagingThread;
         pthread_cond_t cv         = PTHREAD_COND_INITIALIZER;
         pthread_mutex_t condMutex = PTHREAD_MUTEX_INITIALIZER;
+        // Live frames between the SDK reader and the streamer
+        QHYTripleBuffer m_LiveFrames;
 
         void logQHYMessages(const std::string &message);
         std::function<void(const std::string &)> m_QHYLogCallback;
@@ -484,4 +513,5 @@ class QHYCCD : public INDI::CCD, public INDI::FilterInterface
         /////////////////////////////////////////////////////////////////////////////
         static constexpr const char * GPS_CONTROL_TAB = "GPS Control";
         static constexpr const char * GPS_DATA_TAB = "GPS Data";
+        static constexpr const char * STREAMING_TAB = "Streaming";
 };
@@ -0,0 +1,197 @@
+/*
+ QHY INDI Driver
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "qhy_gpsstamp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static inline uint32_t readBE32(const uint8_t *data)
+{
+    return static_cast<uint32_t>(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+static inline uint32_t readBE24(const uint8_t *data)
+{
+    return data[0] << 16 | data[1] << 8 | data[2];
+}
+
+static inline uint16_t readBE16(const uint8_t *data)
+{
+    return data[0] << 8 | data[1];
+}
+
+QHYGPSStamp QHYGPSStamp::decode(const uint8_t *header)
+{
+    QHYGPSStamp stamp;
+
+    stamp.hostTimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::system_clock::now().time_since_epoch()).count();
+
+    stamp.seqNumber  = readBE32(header + 0);
+    stamp.tempNumber = header[4];
+    stamp.width      = readBE16(header + 5);
+    stamp.height     = readBE16(header + 7);
+    stamp.latitude   = readBE32(header + 9);
+    stamp.longitude  = readBE32(header + 13);
+
+    stamp.startFlag  = header[17];
+    stamp.startSec   = readBE32(header + 18);
+    stamp.startTicks = readBE24(header + 22);
+
+    stamp.endFlag    = header[25];
+    stamp.endSec     = readBE32(header + 26);
+    stamp.endTicks   = readBE24(header + 30);
+
+    stamp.nowFlag    = header[33];
+    stamp.nowSec     = readBE32(header + 34);
+    stamp.nowTicks   = readBE24(header + 38);
+
+    stamp.maxClock   = readBE24(header + 41);
+
+    return stamp;
+}
+
+QHYGPSStampLog::~QHYGPSStampLog()
+{
+    close();
+}
+
+bool QHYGPSStampLog::open(const std::string &path)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_File = fopen(path.c_str(), "wb");
+    if (m_File == nullptr)
+        return false;
+
+    const uint32_t version = Version, recordSize = sizeof(QHYGPSStamp);
+    fwrite("QHYGPSTS", 1, 8, m_File);
+    fwrite(&version, sizeof(version), 1, m_File);
+    fwrite(&recordSize, sizeof(recordSize), 1, m_File);
+
+    m_Head = 0;
+    m_Count = 0;
+    m_FlushRequested = false;
+    m_Stop = false;
+    m_FrameIndex = 0;
+    m_Dropped = 0;
+    m_Writer = std::thread(&QHYGPSStampLog::writerLoop, this);
+    return true;
+}
+
+void QHYGPSStampLog::append(QHYGPSStamp stamp)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_File == nullptr)
+        return;
+
+    stamp.frameIndex = m_FrameIndex++;
+    if (m_Count == m_Ring.size())
+    {
+        m_Dropped++;
+        return;
+    }
+
+    m_Ring[(m_Head + m_Count) % m_Ring.size()] = stamp;
+    if (++m_Count == BatchSize)
+        m_Wake.notify_one();
+}
+
+void QHYGPSStampLog::flush()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_File == nullptr || m_Count == 0)
+        return;
+
+    m_FlushRequested = true;
+    m_Wake.notify_one();
+}
+
+void QHYGPSStampLog::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    while (true)
+    {
+        m_Wake.wait(lock, [this]()
+        {
+            return m_Stop || m_FlushRequested || m_Count >= BatchSize;
+        });
+
+        if (m_Count == 0)
+        {
+            m_FlushRequested = false;
+            if (m_Stop)
+                return;
+            continue;
+        }
+
+        // Up to the end of the ring, the rest comes with the next round
+        const size_t first = m_Head;
+        const size_t count = std::min(m_Count, m_Ring.size() - first);
+        lock.unlock();
+
+        fwrite(&m_Ring[first], sizeof(QHYGPSStamp), count, m_File);
+        fflush(m_File);
+
+        lock.lock();
+        m_Head = (m_Head + count) % m_Ring.size();
+        m_Count -= count;
+    }
+}
+
+void QHYGPSStampLog::close()
+{
+    std::thread writer;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // Only the caller that takes the writer joins it and closes the file
+        if (m_File == nullptr || !m_Writer.joinable())
+            return;
+
+        writer = std::move(m_Writer);
+        m_Stop = true;
+        m_Wake.notify_one();
+    }
+
+    // The writer empties the ring before it returns
+    writer.join();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    fclose(m_File);
+    m_File = nullptr;
+}
+
+bool QHYGPSStampLog::isOpen()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_File != nullptr;
+}
+
+uint64_t QHYGPSStampLog::dropped()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Dropped;
+}
@@ -0,0 +1,108 @@
+/*
+ QHY INDI Driver
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief The QHYGPSStamp struct is the binary form of the 64-byte GPS header QHY
+ * GPS cameras embed at the start of every frame.
+ *
+ * Shutter times are kept as raw seconds and ticks of the camera's 10MHz clock so no
+ * precision is lost. Records are written in host byte order.
+ */
+struct QHYGPSStamp
+{
+    // Host wall clock when the frame was decoded, in nanoseconds since the Unix epoch
+    uint64_t hostTimeNs { 0 };
+    // Frame index within the current log file
+    uint32_t frameIndex { 0 };
+    uint32_t seqNumber { 0 };
+    uint32_t latitude { 0 };
+    uint32_t longitude { 0 };
+    uint32_t startSec { 0 };
+    uint32_t startTicks { 0 };
+    uint32_t endSec { 0 };
+    uint32_t endTicks { 0 };
+    uint32_t nowSec { 0 };
+    uint32_t nowTicks { 0 };
+    uint32_t maxClock { 0 };
+    uint16_t width { 0 };
+    uint16_t height { 0 };
+    uint8_t startFlag { 0 };
+    uint8_t endFlag { 0 };
+    uint8_t nowFlag { 0 };
+    uint8_t tempNumber { 0 };
+    uint32_t reserved { 0 };
+
+    /** Decode the big-endian header at the start of a frame. */
+    static QHYGPSStamp decode(const uint8_t *header);
+};
+
+static_assert(sizeof(QHYGPSStamp) == 64, "QHYGPSStamp records must stay 64 bytes");
+
+/**
+ * @brief The QHYGPSStampLog class writes GPS stamps to a binary sidecar file.
+ *
+ * The file starts with the 8-byte magic "QHYGPSTS", a uint32 version and a uint32
+ * record size, followed by one QHYGPSStamp per frame. Stamps are queued in a fixed
+ * ring and written in batches by a writer thread, so the frame path never waits on
+ * the disk. If the disk cannot keep up and the ring is full, stamps are dropped and
+ * show up as gaps in the frame index.
+ */
+class QHYGPSStampLog
+{
+    public:
+        ~QHYGPSStampLog();
+
+        bool open(const std::string &path);
+        void append(QHYGPSStamp stamp);
+        /** Have the writer write out the queued stamps, does not wait for it. */
+        void flush();
+        /** Write out the queued stamps and close the file. */
+        void close();
+        bool isOpen();
+        uint64_t dropped();
+
+        static constexpr uint32_t Version = 1;
+
+    private:
+        void writerLoop();
+
+        static constexpr size_t BatchSize = 256;
+
+        std::mutex m_Mutex;
+        std::condition_variable m_Wake;
+        std::thread m_Writer;
+        FILE *m_File { nullptr };
+        // Queued stamps are m_Count entries from m_Head on, the writer reads them without the lock
+        std::array<QHYGPSStamp, 16 * BatchSize> m_Ring;
+        size_t m_Head { 0 };
+        size_t m_Count { 0 };
+        bool m_FlushRequested { false };
+        bool m_Stop { false };
+        uint32_t m_FrameIndex { 0 };
+        uint64_t m_Dropped { 0 };
+};
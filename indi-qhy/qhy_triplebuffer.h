@@ -0,0 +1,139 @@
+/*
+ QHY INDI Driver
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief The QHYTripleBuffer class hands live frames from the SDK reader to the streamer.
+ *
+ * Three preallocated slots rotate between a single producer and a single consumer.
+ * The producer always owns the back slot and the consumer the front slot, the middle
+ * slot is exchanged atomically, so neither side ever waits for the other to copy a
+ * frame. The producer only holds the wait mutex to publish and wake up the consumer.
+ * When the consumer falls behind, the newest frame replaces the unconsumed one and
+ * the replaced frame is counted as dropped.
+ */
+class QHYTripleBuffer
+{
+    public:
+        struct Frame
+        {
+            std::vector<uint8_t> data;
+            size_t size { 0 };
+            std::chrono::steady_clock::time_point captured;
+        };
+
+    public:
+        /** Allocate all three slots. Must not be called while either side is running. */
+        void allocate(size_t size)
+        {
+            for (auto &frame : m_Frames)
+            {
+                frame.data.resize(size);
+                frame.size = 0;
+            }
+            m_Back   = 0;
+            m_Front  = 1;
+            m_Middle = 2;
+            m_Closed = false;
+            m_Dropped = 0;
+        }
+
+        /** Producer: slot to fill with the next frame. */
+        Frame &back()
+        {
+            return m_Frames[m_Back];
+        }
+
+        /** Producer: make the back slot available to the consumer. */
+        void publish()
+        {
+            // Under the mutex, or the notification could fall between the check of the
+            // consumer and its wait, and the frame would only be seen after the timeout.
+            uint8_t previous;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                previous = m_Middle.exchange(m_Back | FreshFlag, std::memory_order_acq_rel);
+                m_Condition.notify_one();
+            }
+            if (previous & FreshFlag)
+                m_Dropped++;
+            m_Back = previous & IndexMask;
+        }
+
+        /**
+         * Consumer: wait up to timeout for a fresh frame.
+         * @return pointer to the front slot, or nullptr on timeout or once closed.
+         */
+        const Frame *wait(std::chrono::microseconds timeout)
+        {
+            if (!(m_Middle.load(std::memory_order_acquire) & FreshFlag))
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait_for(lock, timeout, [this]()
+                {
+                    return m_Closed || (m_Middle.load(std::memory_order_acquire) & FreshFlag);
+                });
+            }
+
+            if (m_Closed || !(m_Middle.load(std::memory_order_acquire) & FreshFlag))
+                return nullptr;
+
+            m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & IndexMask;
+            return &m_Frames[m_Front];
+        }
+
+        /** Wake up the consumer and make every further wait() return nullptr. */
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Closed = true;
+            }
+            m_Condition.notify_all();
+        }
+
+        /** Frames overwritten before the consumer picked them up. */
+        uint64_t dropped() const
+        {
+            return m_Dropped;
+        }
+
+    private:
+        static constexpr uint8_t IndexMask = 0x03;
+        static constexpr uint8_t FreshFlag = 0x04;
+
+        std::array<Frame, 3> m_Frames;
+        uint8_t m_Back { 0 };
+        uint8_t m_Front { 1 };
+        std::atomic<uint8_t> m_Middle { 2 };
+        std::atomic<uint64_t> m_Dropped { 0 };
+
+        // Parks the consumer, the producer takes it only to publish.
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        std::atomic_bool m_Closed { false };
+};
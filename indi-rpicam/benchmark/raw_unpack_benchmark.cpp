@@ -0,0 +1,184 @@
+/*
+    Raw unpack benchmark
+
+    Decodes a recorded raw frame through the Broadcom and Raw10/Raw12 pipelines, in 80k
+    buffers like MMAL delivers them, with each instruction set the CPU supports and
+    compares against the decoder loops the pipelines had before.
+
+    The recording is a raspistill --raw file (JPEG with the raw data appended) or the raw
+    part of it, starting at the BRCM header. Without a file a random IMX477 frame is used.
+
+    Usage: raw_unpack_benchmark [file.jpg [iterations]]
+*/
+
+#include "broadcompipeline.h"
+#include "chipwrapper.h"
+#include "raw10tobayer16pipeline.h"
+#include "raw12tobayer16pipeline.h"
+
+#include <pixelkernels.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+static const size_t HEADER_SIZE = 32768;
+static const uint32_t BUFFER_SIZE = 81920;
+
+class FrameChip : public ChipWrapper
+{
+public:
+    FrameChip(int w, int h) : w(w), h(h), frame(w * h + 8) {}
+
+    virtual int getFrameBufferSize() override { return w * h * 2; }
+    virtual uint8_t* getFrameBuffer() override { return reinterpret_cast<uint8_t *>(frame.data()); }
+    virtual int getSubX() override { return 0; }
+    virtual int getSubY() override { return 0; }
+    virtual int getSubW() override { return w; }
+    virtual int getSubH() override { return h; }
+    virtual int getXRes() override { return w; }
+    virtual int getYRes() override { return h; }
+
+    int w, h;
+    std::vector<uint16_t> frame;
+};
+
+// The loops the pipelines used before, for a full frame.
+static void legacyRaw12(const uint8_t *raw, int raw_width, FrameChip &chip)
+{
+    for (int y = 0; y < chip.h; y++) {
+        const uint8_t *data = raw + y * raw_width;
+        uint16_t *cur_row = chip.frame.data() + y * chip.w;
+        int x = 0, state = 0;
+        for (int raw_x = 0; raw_x < raw_width && x < chip.w; raw_x++) {
+            uint8_t byte = data[raw_x];
+            switch(state)
+            {
+            case 0: cur_row[x] = byte << 8; state = 1; break;
+            case 1: cur_row[x+1] = byte << 8; state = 2; break;
+            case 2:
+                cur_row[x+0] |= static_cast<uint16_t>((byte & 0x0F) << 4);
+                cur_row[x+1] |= static_cast<uint16_t>((byte & 0xF0) << 0);
+                x += 2;
+                state = 0;
+                break;
+            }
+        }
+    }
+}
+
+static void legacyRaw10(const uint8_t *raw, int raw_width, FrameChip &chip)
+{
+    const uint32_t u32Magic = 0x4001;
+    const uint32_t u32Mask = 0x30003;
+    for (int y = 0; y < chip.h; y++) {
+        const uint8_t *data = raw + y * raw_width;
+        uint32_t *pu32 = reinterpret_cast<uint32_t *>(chip.frame.data() + y * chip.w);
+        for (int x = 0; x < chip.w; x += 4) {
+            uint32_t u32_01 = (*data++ << 2);
+            u32_01 |= (*data++ << 18);
+            uint32_t u32_23 = (*data++ << 2);
+            u32_23 |= (*data++ << 18);
+            uint32_t u32Temp = *data++ * u32Magic;
+            u32_01 |= (u32Temp & u32Mask);
+            u32Temp >>= 4;
+            u32_23 |= (u32Temp & u32Mask);
+            *pu32++ = u32_01 << (16-10);
+            *pu32++ = u32_23 << (16-10);
+        }
+    }
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+    std::vector<uint8_t> stream;
+
+    if (argc > 1) {
+        std::ifstream in(argv[1], std::ios::binary);
+        std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        static const char brcm[] = "BRCMo";
+        auto start = std::search(file.begin(), file.end(), brcm, brcm + 5);
+        if (start == file.end()) {
+            std::fprintf(stderr, "%s: no BRCM raw data found\n", argv[1]);
+            return 1;
+        }
+        stream.assign(start, file.end());
+    }
+    else {
+        // IMX477 full frame of random data
+        BroadcomHeader header;
+        memset(&header, 0, sizeof header);
+        header.omx_data.raw_width = 6112;
+        stream.resize(HEADER_SIZE + 6112 * 3040);
+        memcpy(stream.data(), "BRCMo", 5);
+        memcpy(stream.data() + 8, &header.omx_data, sizeof header.omx_data);
+        std::mt19937 gen(1);
+        for (size_t i = HEADER_SIZE; i < stream.size(); i++) {
+            stream[i] = static_cast<uint8_t>(gen());
+        }
+    }
+
+    BroadcomHeader header;
+    memcpy(&header.omx_data, stream.data() + 8, sizeof header.omx_data);
+    const int raw_width = header.omx_data.raw_width;
+    const bool raw12 = raw_width == 6112;
+    FrameChip chip(raw12 ? 4056 : raw_width == 4128 ? 3280 : 2592, raw12 ? 3040 : raw_width == 4128 ? 2464 : 1944);
+
+    if (stream.size() < HEADER_SIZE + static_cast<size_t>(raw_width) * chip.h) {
+        std::fprintf(stderr, "Raw data too short for %dx%d\n", chip.w, chip.h);
+        return 1;
+    }
+
+    std::printf("%s frame %dx%d, %d iterations, times in ms per frame\n\n", raw12 ? "RAW12" : "RAW10", chip.w, chip.h,
+                iterations);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        if (raw12)
+            legacyRaw12(stream.data() + HEADER_SIZE, raw_width, chip);
+        else
+            legacyRaw10(stream.data() + HEADER_SIZE, raw_width, chip);
+    }
+    std::printf("%-24s%10.2f\n", "old decoder", elapsedMs(start) / iterations);
+    std::vector<uint16_t> reference = chip.frame;
+
+    for (PixelKernels::Isa isa : { PixelKernels::ISA_SCALAR, PixelKernels::ISA_SSE2, PixelKernels::ISA_AVX2, PixelKernels::ISA_NEON }) {
+        if (!PixelKernels::selectIsa(isa))
+            continue;
+
+        BroadcomPipeline bcm_pipe;
+        if (raw12)
+            bcm_pipe.daisyChain(new Raw12ToBayer16Pipeline(&bcm_pipe, &chip));
+        else
+            bcm_pipe.daisyChain(new Raw10ToBayer16Pipeline(&bcm_pipe, &chip));
+
+        std::fill(chip.frame.begin(), chip.frame.end(), 0);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            bcm_pipe.reset_pipe();
+            for (size_t pos = 0; pos < stream.size(); pos += BUFFER_SIZE) {
+                bcm_pipe.data_received(stream.data() + pos, std::min<size_t>(BUFFER_SIZE, stream.size() - pos));
+            }
+        }
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "pipeline %s", PixelKernels::toString(isa));
+        std::printf("%-24s%10.2f%s\n", name, elapsedMs(start) / iterations,
+                    std::equal(reference.begin(), reference.begin() + chip.w * chip.h, chip.frame.begin()) ? "" : "  MISMATCH");
+    }
+
+    return 0;
+}
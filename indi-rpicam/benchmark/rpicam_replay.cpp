@@ -0,0 +1,265 @@
+/*
+    rpicam replay
+
+    Plays recorded camera buffers through the same pipeline the driver uses
+    (JPEG, Broadcom header, Raw10/Raw12 to Bayer16), without a Pi or a camera, and
+    reports the decode throughput and the latency per frame.
+
+    Input is a buffer dump recorded by the driver (Options tab, Record buffers), which
+    keeps the MMAL buffer sizes and arrival times, or a raspistill --raw file. Without
+    a file synthetic IMX477 frames are used.
+
+    Usage: rpicam_replay [options] [file]
+      -c bytes   bytes per buffer, default as recorded (80k for raspistill files)
+      -t timing  full (default), recorded, or a rate in MB/s
+      -n count   play the frames count times, default 5
+      -T         decode on a worker thread like the driver does
+      -m MB/s    exit with status 2 when the throughput is below this
+      -v         print every frame
+*/
+
+#include "broadcompipeline.h"
+#include "bufferdump.h"
+#include "bufferreplay.h"
+#include "chipwrapper.h"
+#include "jpegpipeline.h"
+#include "raw10tobayer16pipeline.h"
+#include "raw12tobayer16pipeline.h"
+#include "threadedpipeline.h"
+
+#include <pixelkernels.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static const size_t HEADER_SIZE = 32768;
+
+class FrameChip : public ChipWrapper
+{
+public:
+    FrameChip(int w, int h) : w(w), h(h), frame(w * h + 8) {}
+
+    virtual int getFrameBufferSize() override { return w * h * 2; }
+    virtual uint8_t* getFrameBuffer() override { return reinterpret_cast<uint8_t *>(frame.data()); }
+    virtual int getSubX() override { return 0; }
+    virtual int getSubY() override { return 0; }
+    virtual int getSubW() override { return w; }
+    virtual int getSubH() override { return h; }
+    virtual int getXRes() override { return w; }
+    virtual int getYRes() override { return h; }
+
+    int w, h;
+    std::vector<uint16_t> frame;
+};
+
+/**
+ * JPEG preview with an EXIF block and entropy coded data, then the BRCM header and the raw
+ * IMX477 lines, like raspistill --raw.
+ */
+static std::vector<uint8_t> syntheticFrame(unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> frame = { 0xFF, 0xD8, 0xFF, 0xE1, 0xFF, 0xFF };
+    frame.resize(frame.size() + 0xFFFF - 2);
+    frame.insert(frame.end(), { 0xFF, 0xDA, 0x00, 0x0C });
+    frame.resize(frame.size() + 10);
+    for (int i = 0; i < 2000000; i++) {
+        uint8_t byte = static_cast<uint8_t>(gen());
+        frame.push_back(byte);
+        if (byte == 0xFF) {
+            frame.push_back(0x00);
+        }
+    }
+    frame.insert(frame.end(), { 0xFF, 0xD9 });
+
+    size_t brcm = frame.size();
+    frame.resize(brcm + HEADER_SIZE + 6112 * 3040);
+    memcpy(frame.data() + brcm, "BRCMo", 5);
+    BroadcomHeader header;
+    memset(&header, 0, sizeof header);
+    header.omx_data.raw_width = 6112;
+    memcpy(frame.data() + brcm + 8, &header.omx_data, sizeof header.omx_data);
+    for (size_t i = brcm + HEADER_SIZE; i < frame.size(); i++) {
+        frame[i] = static_cast<uint8_t>(gen());
+    }
+    return frame;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+}
+
+static void usage(const char *name)
+{
+    std::fprintf(stderr, "Usage: %s [-c bytes] [-t full|recorded|MB/s] [-n count] [-T] [-m MB/s] [-v] [file]\n", name);
+    std::exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    BufferReplay::Options options;
+    uint32_t buffer_size = 0;
+    int repeat = 5;
+    bool threaded = false;
+    bool verbose = false;
+    double min_rate = 0;
+
+    int opt;
+    while((opt = getopt(argc, argv, "c:t:n:Tm:v")) != -1) {
+        switch(opt)
+        {
+        case 'c': buffer_size = std::strtoul(optarg, nullptr, 0); break;
+        case 'n': repeat = std::atoi(optarg); break;
+        case 'T': threaded = true; break;
+        case 'm': min_rate = std::atof(optarg); break;
+        case 'v': verbose = true; break;
+        case 't':
+            if (!strcmp(optarg, "full")) {
+                options.timing = BufferReplay::Timing::FULL_SPEED;
+            }
+            else if (!strcmp(optarg, "recorded")) {
+                options.timing = BufferReplay::Timing::RECORDED;
+            }
+            else {
+                options.timing = BufferReplay::Timing::RATE;
+                options.rate = std::atof(optarg);
+                if (options.rate <= 0) {
+                    usage(argv[0]);
+                }
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    options.chunk_size = buffer_size;
+
+    BufferDump dump;
+    try {
+        if (optind < argc) {
+            dump.load(argv[optind], buffer_size ? buffer_size : 81920);
+        }
+        else {
+            for (unsigned i = 0; i < 2; i++) {
+                dump.add_frame(syntheticFrame(i), 81920);
+            }
+        }
+    }
+    catch (std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    if (dump.frames.empty()) {
+        std::fprintf(stderr, "No frames to replay\n");
+        return 1;
+    }
+
+    // The sensor follows from the raw line length in the Broadcom header.
+    const std::vector<uint8_t> &first = dump.frames.front().data;
+    static const char brcm[] = "BRCMo";
+    auto header_pos = std::search(first.begin(), first.end(), brcm, brcm + 5);
+    if (first.end() - header_pos < static_cast<std::ptrdiff_t>(HEADER_SIZE)) {
+        std::fprintf(stderr, "No BRCM raw data found\n");
+        return 1;
+    }
+    BroadcomHeader header;
+    memcpy(&header.omx_data, &*header_pos + 8, sizeof header.omx_data);
+    const int raw_width = header.omx_data.raw_width;
+    const bool raw12 = raw_width == 6112;
+    if (!raw12 && raw_width != 4128 && raw_width != 3264) {
+        std::fprintf(stderr, "Unknown raw line length %d\n", raw_width);
+        return 1;
+    }
+    FrameChip chip(raw12 ? 4056 : raw_width == 4128 ? 3280 : 2592, raw12 ? 3040 : raw_width == 4128 ? 2464 : 1944);
+
+    Pipeline *pipe = new JpegPipeline();
+    ThreadedPipeline *decode_stage = nullptr;
+    if (threaded) {
+        decode_stage = new ThreadedPipeline();
+        decode_stage->daisyChain(pipe);
+        pipe = decode_stage;
+    }
+    std::unique_ptr<Pipeline> raw_pipe(pipe);
+    BroadcomPipeline *brcm_pipe = new BroadcomPipeline();
+    raw_pipe->daisyChain(brcm_pipe);
+    if (raw12) {
+        brcm_pipe->daisyChain(new Raw12ToBayer16Pipeline(brcm_pipe, &chip));
+    }
+    else {
+        brcm_pipe->daisyChain(new Raw10ToBayer16Pipeline(brcm_pipe, &chip));
+    }
+
+    std::printf("%s %dx%d, %zu frame(s) x %d, %s, %s buffers, %s timing, %s\n", raw12 ? "RAW12" : "RAW10", chip.w, chip.h,
+                dump.frames.size(), repeat, PixelKernels::toString(PixelKernels::activeIsa()),
+                buffer_size ? std::to_string(buffer_size).c_str() : "recorded",
+                options.timing == BufferReplay::Timing::FULL_SPEED ? "full speed" :
+                options.timing == BufferReplay::Timing::RECORDED ? "recorded" : "fixed rate",
+                threaded ? "decode thread" : "in caller");
+
+    BufferReplay replay(options);
+    BufferReplay::Report report;
+    for (int i = 0; i < repeat; i++) {
+        for (const BufferDump::Frame &frame : dump.frames) {
+            // A pipeline that loses track of the stream does not always throw, it may just never find the raw data.
+            memset(&brcm_pipe->header, 0, sizeof brcm_pipe->header);
+            try {
+                report.frames.push_back(replay.play(*raw_pipe, frame));
+            }
+            catch (std::exception &e) {
+                std::fprintf(stderr, "Pipeline failed: %s\n", e.what());
+                return 1;
+            }
+            if (decode_stage && !decode_stage->last_error().empty()) {
+                std::fprintf(stderr, "Pipeline failed: %s\n", decode_stage->last_error().c_str());
+                return 1;
+            }
+            if (brcm_pipe->header.omx_data.raw_width != raw_width) {
+                std::fprintf(stderr, "Frame %zu: raw data was not decoded\n", report.frames.size() - 1);
+                return 1;
+            }
+        }
+    }
+
+    std::vector<double> latency, tail;
+    double late = 0;
+    for (size_t i = 0; i < report.frames.size(); i++) {
+        const BufferReplay::FrameResult &frame = report.frames[i];
+        latency.push_back(frame.latency_ms);
+        tail.push_back(frame.tail_ms);
+        late = std::max(late, frame.late_ms);
+        if (verbose) {
+            std::printf("frame %3zu: %9llu bytes %5u buffers, latency %8.2f ms, after last buffer %7.2f ms\n", i,
+                        static_cast<unsigned long long>(frame.bytes), frame.chunks, frame.latency_ms, frame.tail_ms);
+        }
+    }
+
+    std::printf("\n%-24s%10.1f MB/s\n", "throughput", report.mb_per_s());
+    std::printf("%-24s%10.2f %10.2f %10.2f ms (min, median, max)\n", "frame latency",
+                percentile(latency, 0), percentile(latency, 0.5), percentile(latency, 1));
+    std::printf("%-24s%10.2f %10.2f %10.2f ms\n", "after last buffer", percentile(tail, 0), percentile(tail, 0.5),
+                percentile(tail, 1));
+    if (options.timing != BufferReplay::Timing::FULL_SPEED) {
+        std::printf("%-24s%10.2f ms\n", "max buffer lateness", late);
+    }
+    if (decode_stage) {
+        ThreadedPipeline::Stats stats = decode_stage->get_stats();
+        std::printf("%-24s%10.2f ms (last frame)\n", "max queue wait", stats.max_queue_ms);
+        std::printf("%-24s%10llu (last frame)\n", "stalls", static_cast<unsigned long long>(stats.stalls));
+    }
+
+    if (min_rate > 0 && report.mb_per_s() < min_rate) {
+        std::printf("\nThroughput below %.1f MB/s\n", min_rate);
+        return 2;
+    }
+    return 0;
+}
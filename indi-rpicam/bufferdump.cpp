@@ -0,0 +1,164 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "bufferdump.h"
+#include "inditest.h"
+
+static const char MAGIC[8] = { 'R', 'P', 'I', 'B', 'U', 'F', 'D', '1' };
+
+BufferDumpPipeline::~BufferDumpPipeline()
+{
+    close();
+}
+
+bool BufferDumpPipeline::open(const std::string &filename)
+{
+    close();
+
+    fp = fopen(filename.c_str(), "wb");
+    if (!fp) {
+        return false;
+    }
+
+    fwrite(MAGIC, 1, sizeof(MAGIC), fp);
+    frame_start = std::chrono::steady_clock::now();
+    return true;
+}
+
+void BufferDumpPipeline::close()
+{
+    if (fp) {
+        fclose(fp);
+        fp = nullptr;
+    }
+}
+
+void BufferDumpPipeline::write_record(uint32_t type, const uint8_t *data, uint32_t length)
+{
+    BufferDumpRecord record;
+    record.type = type;
+    record.length = length;
+    record.time_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frame_start).count();
+
+    if (fwrite(&record, sizeof(record), 1, fp) != 1 || (length && fwrite(data, 1, length, fp) != length)) {
+        LOG_TEST("buffer dump write failed, recording stopped");
+        close();
+    }
+}
+
+void BufferDumpPipeline::data_received(uint8_t *data,  uint32_t length)
+{
+    if (fp) {
+        write_record(BufferDumpRecord::RECORD_BUFFER, data, length);
+    }
+    forward(data, length);
+}
+
+void BufferDumpPipeline::reset()
+{
+    if (fp) {
+        frame_start = std::chrono::steady_clock::now();
+        write_record(BufferDumpRecord::RECORD_FRAME, nullptr, 0);
+    }
+}
+
+void BufferDumpPipeline::flush()
+{
+    // End of the capture, get the frame to disk.
+    if (fp) {
+        fflush(fp);
+    }
+}
+
+void BufferDump::add_frame(std::vector<uint8_t> data, uint32_t buffer_size)
+{
+    Frame frame;
+    frame.data = std::move(data);
+    for (size_t pos = 0; pos < frame.data.size(); pos += buffer_size) {
+        frame.buffers.push_back({0, pos, static_cast<uint32_t>(std::min<size_t>(buffer_size, frame.data.size() - pos))});
+    }
+    frames.push_back(std::move(frame));
+}
+
+void BufferDump::load(const std::string &filename, uint32_t default_buffer)
+{
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + filename);
+    }
+    std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (file.size() < sizeof(MAGIC) || memcmp(file.data(), MAGIC, sizeof(MAGIC))) {
+        add_frame(std::move(file), default_buffer);
+        return;
+    }
+
+    size_t pos = sizeof(MAGIC);
+    while(pos < file.size()) {
+        BufferDumpRecord record;
+        if (file.size() - pos < sizeof(record)) {
+            throw std::runtime_error(filename + ": truncated record");
+        }
+        memcpy(&record, file.data() + pos, sizeof(record));
+        pos += sizeof(record);
+
+        if (record.length > file.size() - pos) {
+            throw std::runtime_error(filename + ": truncated buffer");
+        }
+
+        switch(record.type)
+        {
+        case BufferDumpRecord::RECORD_FRAME:
+            frames.emplace_back();
+            break;
+
+        case BufferDumpRecord::RECORD_BUFFER:
+            if (record.length == 0) {
+                break;
+            }
+            if (frames.empty()) {
+                // Recording started in the middle of an exposure.
+                frames.emplace_back();
+            }
+            frames.back().buffers.push_back({record.time_us, frames.back().data.size(), record.length});
+            frames.back().data.insert(frames.back().data.end(), file.begin() + pos, file.begin() + pos + record.length);
+            break;
+
+        default:
+            throw std::runtime_error(filename + ": unknown record type");
+        }
+        pos += record.length;
+    }
+
+    // Exposures that were aborted before any data arrived.
+    frames.erase(std::remove_if(frames.begin(), frames.end(), [](const Frame &frame) { return frame.data.empty(); }), frames.end());
+
+    // The first buffer comes after the exposure time, replay from there.
+    for (Frame &frame : frames) {
+        uint64_t first = frame.buffers.front().time_us;
+        for (Buffer &buffer : frame.buffers) {
+            buffer.time_us -= first;
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef BUFFERDUMP_H
+#define BUFFERDUMP_H
+
+#include <chrono>
+#include <cstdint>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "pipeline.h"
+
+/**
+ * Buffer dump file format, all integers in host byte order (little endian on the Pi and on x86):
+ *
+ *   "RPIBUFD1"                                   8 byte magic
+ *   records, each starting with BufferDumpRecord:
+ *     RECORD_FRAME   length 0                    reset_pipe(), a new exposure starts
+ *     RECORD_BUFFER  length bytes of data follow one buffer as MMAL delivered it
+ *
+ * time_us is the time since the start of the frame.
+ */
+struct BufferDumpRecord
+{
+    enum : uint32_t { RECORD_FRAME = 1, RECORD_BUFFER = 2 };
+
+    uint32_t type;
+    uint32_t length;
+    uint64_t time_us;
+};
+
+/**
+ * @brief The BufferDumpPipeline class records the buffers passing through it to a dump file.
+ *
+ * Put it first in the pipeline to record exactly what the camera sends, with buffer sizes and
+ * arrival times. The recording can be played back with BufferReplay, without a camera.
+ * When no file is open the stage only forwards.
+ */
+class BufferDumpPipeline : public Pipeline
+{
+public:
+    BufferDumpPipeline() {}
+    virtual ~BufferDumpPipeline();
+
+    virtual void data_received(uint8_t *data,  uint32_t length) override;
+    virtual void reset() override;
+    virtual void flush() override;
+
+    /**
+     * Start recording to filename, any previous recording is closed.
+     * @return false if the file could not be created, errno tells why.
+     */
+    bool open(const std::string &filename);
+    void close();
+    bool is_open() const { return fp != nullptr; }
+
+private:
+    void write_record(uint32_t type, const uint8_t *data, uint32_t length);
+
+    FILE *fp {};
+    std::chrono::steady_clock::time_point frame_start;
+};
+
+/**
+ * @brief The BufferDump class holds recorded camera frames in memory for replay.
+ */
+class BufferDump
+{
+public:
+    struct Buffer
+    {
+        uint64_t time_us;   //! Arrival time relative to the first buffer of the frame.
+        size_t offset;      //! Position in Frame::data.
+        uint32_t length;
+    };
+
+    struct Frame
+    {
+        std::vector<uint8_t> data;
+        std::vector<Buffer> buffers;
+    };
+
+    /**
+     * Load a dump recorded by BufferDumpPipeline. Anything else is taken as the data of a single
+     * frame without buffer boundaries, like a raspistill --raw file, and gets split into
+     * buffers of default_buffer bytes.
+     * Throws std::runtime_error if the file cannot be read or is truncated.
+     */
+    void load(const std::string &filename, uint32_t default_buffer = 81920);
+
+    /**
+     * Add a frame without timing, split into buffers of buffer_size bytes.
+     */
+    void add_frame(std::vector<uint8_t> data, uint32_t buffer_size);
+
+    std::vector<Frame> frames;
+};
+
+#endif // BUFFERDUMP_H
@@ -0,0 +1,126 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "bufferreplay.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double ms_between(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+BufferReplay::FrameResult BufferReplay::play(Pipeline &pipe, const BufferDump::Frame &frame)
+{
+    FrameResult result;
+    if (frame.buffers.empty()) {
+        return result;
+    }
+
+    // The data is copied once up front, the pipeline stages may write to the buffers they get.
+    std::vector<uint8_t> data(frame.data);
+    size_t buffer = 0;
+
+    pipe.reset_pipe();
+    Clock::time_point start = Clock::now();
+
+    for (size_t pos = 0; pos < data.size();) {
+        // Recorded buffer holding the first byte of this chunk, for its arrival time.
+        while(buffer + 1 < frame.buffers.size() && frame.buffers[buffer + 1].offset <= pos) {
+            buffer++;
+        }
+
+        uint32_t length;
+        if (options.chunk_size) {
+            length = static_cast<uint32_t>(std::min<size_t>(options.chunk_size, data.size() - pos));
+        }
+        else {
+            length = frame.buffers[buffer].length;
+        }
+
+        if (options.timing != Timing::FULL_SPEED) {
+            Clock::time_point due = start;
+            if (options.timing == Timing::RECORDED) {
+                due += std::chrono::microseconds(frame.buffers[buffer].time_us);
+            }
+            else if (options.rate > 0) {
+                due += std::chrono::microseconds(static_cast<int64_t>(pos / options.rate));
+            }
+            Clock::time_point now = Clock::now();
+            if (due > now) {
+                std::this_thread::sleep_until(due);
+            }
+            else {
+                result.late_ms = std::max(result.late_ms, ms_between(due, now));
+            }
+        }
+
+        pipe.data_received(data.data() + pos, length);
+        pos += length;
+        result.chunks++;
+    }
+
+    Clock::time_point fed = Clock::now();
+    pipe.flush_pipe();
+    Clock::time_point done = Clock::now();
+
+    result.bytes = data.size();
+    result.feed_ms = ms_between(start, fed);
+    result.latency_ms = ms_between(start, done);
+    result.tail_ms = ms_between(fed, done);
+    return result;
+}
+
+BufferReplay::Report BufferReplay::play(Pipeline &pipe, const BufferDump &dump, int repeat)
+{
+    Report report;
+    for (int i = 0; i < repeat; i++) {
+        for (const BufferDump::Frame &frame : dump.frames) {
+            report.frames.push_back(play(pipe, frame));
+        }
+    }
+    return report;
+}
+
+uint64_t BufferReplay::Report::bytes() const
+{
+    uint64_t total = 0;
+    for (const FrameResult &frame : frames) {
+        total += frame.bytes;
+    }
+    return total;
+}
+
+double BufferReplay::Report::busy_ms() const
+{
+    double total = 0;
+    for (const FrameResult &frame : frames) {
+        total += frame.latency_ms;
+    }
+    return total;
+}
+
+double BufferReplay::Report::mb_per_s() const
+{
+    double ms = busy_ms();
+    return ms > 0 ? bytes() / (ms * 1000.0) : 0;
+}
@@ -0,0 +1,88 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef BUFFERREPLAY_H
+#define BUFFERREPLAY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "bufferdump.h"
+#include "pipeline.h"
+
+/**
+ * @brief The BufferReplay class plays recorded frames through a pipeline like the camera would.
+ *
+ * Each frame is sent as reset_pipe(), the buffers, flush_pipe(), so a ThreadedPipeline stage
+ * in the pipeline is included in the measurement. No camera or MMAL is needed.
+ */
+class BufferReplay
+{
+public:
+    enum class Timing
+    {
+        FULL_SPEED,     //! Send the next buffer as soon as the pipeline returns.
+        RECORDED,       //! Send the buffers at their recorded arrival times.
+        RATE,           //! Send the buffers at a fixed data rate.
+    };
+
+    struct Options
+    {
+        uint32_t chunk_size {0};            //! Bytes per data_received() call, 0 for the recorded buffer sizes.
+        Timing timing {Timing::FULL_SPEED};
+        double rate {0};                    //! MB/s for Timing::RATE.
+    };
+
+    struct FrameResult
+    {
+        uint64_t bytes {0};
+        uint32_t chunks {0};
+        double feed_ms {0};         //! First buffer sent until the last one was accepted.
+        double latency_ms {0};      //! First buffer sent until the frame was decoded.
+        double tail_ms {0};         //! Last buffer accepted until the frame was decoded.
+        double late_ms {0};         //! Longest time a buffer was sent after its due time.
+    };
+
+    struct Report
+    {
+        std::vector<FrameResult> frames;
+
+        uint64_t bytes() const;
+        double busy_ms() const;     //! Sum of the frame latencies.
+        double mb_per_s() const;    //! Bytes per busy time, the decode throughput at full speed.
+    };
+
+    BufferReplay() {}
+    explicit BufferReplay(const Options &options) : options(options) {}
+
+    /**
+     * Play one frame through pipe, returns when every stage has processed it.
+     * Exceptions from the pipeline are passed on.
+     */
+    FrameResult play(Pipeline &pipe, const BufferDump::Frame &frame);
+
+    /**
+     * Play all frames, repeated repeat times.
+     */
+    Report play(Pipeline &pipe, const BufferDump &dump, int repeat = 1);
+
+private:
+    Options options;
+};
+
+#endif // BUFFERREPLAY_H
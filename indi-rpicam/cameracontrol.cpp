@@ -141,6 +141,14 @@ void CameraControl::signal_complete()
 {
     std::chrono::duration<double> diff = std::chrono::steady_clock::now() - start_time;
     LOGF_TEST("all buffers received after %f s", diff.count());
+
+    // Stages running on their own thread may still be decoding, the image is only complete after that.
+    for(auto p : pipelines) {
+        p->flush_pipe();
+    }
+    diff = std::chrono::steady_clock::now() - start_time;
+    LOGF_TEST("all buffers processed after %f s", diff.count());
+
     for(auto p : capture_listeners) {
         p->capture_complete();
     }
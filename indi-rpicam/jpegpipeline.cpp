@@ -82,9 +82,9 @@ void JpegPipeline::reset()
 	    }
 	    else
 	    {
-		length = 0;
 		data += length;
 		skip_bytes -= length;
+		length = 0;
 	    }
             if (skip_bytes == 0) {
                 if (entropy_data_follows) {
@@ -21,6 +21,7 @@
 #ifndef _JPEGPIPELINE_H
 #define _JPEGPIPELINE_H
 
+#include <stdexcept>
 #include "pipeline.h"
 
 /**
@@ -31,6 +31,7 @@
 #include <assert.h>
 #include <cstdint>
 #include <cstdlib>
+#include <errno.h>
 #include <bcm_host.h>
 
 #include "mmalexception.h"
@@ -41,6 +42,7 @@
 #include "raw10tobayer16pipeline.h"
 #include "raw12tobayer16pipeline.h"
 #include "pipetee.h"
+#include "threadedpipeline.h"
 #include "inditest.h"
 
 VCOS_LOG_CAT_T indi_rpicam_log_category;
@@ -94,6 +96,8 @@ bool MMALDriver::saveConfigItems(FILE * fp)
     // Gain Settings
     IUSaveConfigNumber(fp, &mGainNP);
 
+    IUSaveConfigSwitch(fp, &mDecodeThreadSP);
+
     return true;
 }
 
@@ -229,6 +233,22 @@ bool MMALDriver::initProperties()
     IUFillNumber(&mGainN[0], "GAIN", "Gain", "%.f", 1, 16.0, 1, 1);
     IUFillNumberVector(&mGainNP, mGainN, 1, getDeviceName(), "CCD_GAIN", "Gain", IMAGE_SETTINGS_TAB, IP_RW, 60, IPS_IDLE);
 
+    // Decode thread
+    IUFillSwitch(&mDecodeThreadS[0], "INDI_ENABLED", "Enabled", ISS_ON);
+    IUFillSwitch(&mDecodeThreadS[1], "INDI_DISABLED", "Disabled", ISS_OFF);
+    IUFillSwitchVector(&mDecodeThreadSP, mDecodeThreadS, 2, getDeviceName(), "DECODE_THREAD", "Decode thread", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 60, IPS_IDLE);
+
+    IUFillNumber(&mDecodeStatsN[DECODE_QUEUE_MAX], "QUEUE_MAX", "Max queue wait (ms)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&mDecodeStatsN[DECODE_CHUNK_MAX], "CHUNK_MAX", "Max buffer decode (ms)", "%.1f", 0, 1e6, 0, 0);
+    IUFillNumber(&mDecodeStatsN[DECODE_TOTAL], "TOTAL", "Decode time (ms)", "%.1f", 0, 1e9, 0, 0);
+    IUFillNumber(&mDecodeStatsN[DECODE_STALLS], "STALLS", "Buffer stalls", "%.f", 0, 1e9, 0, 0);
+    IUFillNumber(&mDecodeStatsN[DECODE_STALL_TIME], "STALL_TIME", "Stall time (ms)", "%.1f", 0, 1e9, 0, 0);
+    IUFillNumberVector(&mDecodeStatsNP, mDecodeStatsN, 5, getDeviceName(), "DECODE_STATS", "Decode stats", OPTIONS_TAB, IP_RO, 60, IPS_IDLE);
+
+    // Buffer recording, empty file name when not recording.
+    IUFillText(&mBufferDumpT[0], "FILE", "File", "");
+    IUFillTextVector(&mBufferDumpTP, mBufferDumpT, 1, getDeviceName(), "BUFFER_DUMP", "Record buffers", OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
+
     addDebugControl();
 
     SetCCDCapability(0
@@ -274,6 +294,9 @@ bool MMALDriver::updateProperties()
         }
 #endif
         defineProperty(&mGainNP);
+        defineProperty(&mDecodeThreadSP);
+        defineProperty(&mDecodeStatsNP);
+        defineProperty(&mBufferDumpTP);
     }
     else
     {
@@ -285,6 +308,9 @@ bool MMALDriver::updateProperties()
 #endif
 
         deleteProperty(mGainNP.name);
+        deleteProperty(mDecodeThreadSP.name);
+        deleteProperty(mDecodeStatsNP.name);
+        deleteProperty(mBufferDumpTP.name);
     }
 
     return true;
@@ -434,6 +460,37 @@ double MMALDriver::CalcTimeLeft()
     return timeleft;
 }
 
+/**************************************************************************************
+ * Publish how the decode stage kept up with the camera during the last exposure.
+ **************************************************************************************/
+void MMALDriver::updateDecodeStats()
+{
+    if (!decode_stage)
+    {
+        return;
+    }
+
+    ThreadedPipeline::Stats stats = decode_stage->get_stats();
+    mDecodeStatsN[DECODE_QUEUE_MAX].value = stats.max_queue_ms;
+    mDecodeStatsN[DECODE_CHUNK_MAX].value = stats.max_process_ms;
+    mDecodeStatsN[DECODE_TOTAL].value = stats.total_process_ms;
+    mDecodeStatsN[DECODE_STALLS].value = stats.stalls;
+    mDecodeStatsN[DECODE_STALL_TIME].value = stats.stall_ms;
+    mDecodeStatsNP.s = stats.stalls > 0 ? IPS_BUSY : IPS_OK;
+
+    std::string error = decode_stage->last_error();
+    if (!error.empty())
+    {
+        LOGF_ERROR("Decoding the camera data failed: %s", error.c_str());
+        mDecodeStatsNP.s = IPS_ALERT;
+    }
+
+    LOGF_DEBUG("Decoded %llu buffers (%llu bytes) in %.1f ms, max queue wait %.1f ms, %llu stalls",
+               static_cast<unsigned long long>(stats.chunks), static_cast<unsigned long long>(stats.bytes),
+               stats.total_process_ms, stats.max_queue_ms, static_cast<unsigned long long>(stats.stalls));
+    IDSetNumber(&mDecodeStatsNP, nullptr);
+}
+
 /**************************************************************************************
  * Main device loop. We check for exposure
  **************************************************************************************/
@@ -470,6 +527,8 @@ void MMALDriver::TimerHit()
             // Stop capturing (must be done from main thread).
             camera_control->stopCapture();
 
+            updateDecodeStats();
+
             // Let INDI::CCD know we're done filling the image buffer
             LOG_DEBUG("Exposure complete.");
             ExposureComplete(&PrimaryCCD);
@@ -516,6 +575,26 @@ bool MMALDriver::ISNewSwitch(const char *dev, const char *name, ISState *states,
     }
 #endif
 
+    if (!strcmp(name, mDecodeThreadSP.name))
+    {
+        if (InExposure)
+        {
+            mDecodeThreadSP.s = IPS_ALERT;
+            IDSetSwitch(&mDecodeThreadSP, "Cannot change decode thread while exposing.");
+            // Handled, the property keeps its previous state
+            return true;
+        }
+
+        IUUpdateSwitch(&mDecodeThreadSP, states, names, n);
+        if (decode_stage)
+        {
+            decode_stage->set_threaded(mDecodeThreadS[0].s == ISS_ON);
+        }
+        mDecodeThreadSP.s = IPS_OK;
+        IDSetSwitch(&mDecodeThreadSP, nullptr);
+        return true;
+    }
+
     return false;
 }
 
@@ -557,6 +636,42 @@ bool MMALDriver::ISNewText(const char *dev, const char *name, char *texts[], cha
     }
     LOG_DEBUG(")\n");
 
+    // ignore if not ours
+    if (dev != nullptr && strcmp(dev, getDeviceName()) != 0)
+        return false;
+
+    if (!strcmp(name, mBufferDumpTP.name))
+    {
+        if (InExposure)
+        {
+            mBufferDumpTP.s = IPS_ALERT;
+            IDSetText(&mBufferDumpTP, "Cannot change buffer recording while exposing.");
+            return true;
+        }
+
+        IUUpdateText(&mBufferDumpTP, texts, names, n);
+        mBufferDumpTP.s = IPS_IDLE;
+        if (dump_stage)
+        {
+            dump_stage->close();
+            if (mBufferDumpT[0].text[0] != '\0')
+            {
+                if (dump_stage->open(mBufferDumpT[0].text))
+                {
+                    LOGF_INFO("Recording camera buffers to %s", mBufferDumpT[0].text);
+                    mBufferDumpTP.s = IPS_OK;
+                }
+                else
+                {
+                    LOGF_ERROR("Cannot record buffers to %s: %s", mBufferDumpT[0].text, strerror(errno));
+                    mBufferDumpTP.s = IPS_ALERT;
+                }
+            }
+        }
+        IDSetText(&mBufferDumpTP, nullptr);
+        return true;
+    }
+
     return INDI::CCD::ISNewText(dev, name, texts, names, n);
 }
 
@@ -579,9 +694,20 @@ void MMALDriver::setupPipeline()
 
     assert(camera_control->get_camera());
 
+    // Records the buffers as MMAL delivers them, before the decode thread changes their timing.
+    dump_stage = new BufferDumpPipeline();
+    raw_pipe.reset(dump_stage);
+    IUSaveText(&mBufferDumpT[0], "");
+    mBufferDumpTP.s = IPS_IDLE;
+
+    // Everything after this stage runs on the decode thread, so the MMAL callback returns right away.
+    decode_stage = new ThreadedPipeline();
+    decode_stage->set_threaded(mDecodeThreadS[0].s == ISS_ON);
+    raw_pipe->daisyChain(decode_stage);
+
     if (!strcmp(camera_control->get_camera()->getModel(), "imx477"))
     {
-        raw_pipe.reset(new JpegPipeline());
+        raw_pipe->daisyChain(new JpegPipeline());
 
         BroadcomPipeline *brcm_pipe = new BroadcomPipeline();
         raw_pipe->daisyChain(brcm_pipe);
@@ -592,7 +718,7 @@ void MMALDriver::setupPipeline()
     else if (!strcmp(camera_control->get_camera()->getModel(), "ov5647")) {
         
 
-        raw_pipe.reset(new JpegPipeline());
+        raw_pipe->daisyChain(new JpegPipeline());
 
         BroadcomPipeline *brcm_pipe = new BroadcomPipeline();
         raw_pipe->daisyChain(brcm_pipe);
@@ -603,7 +729,7 @@ void MMALDriver::setupPipeline()
     }    
     else if (!strcmp(camera_control->get_camera()->getModel(), "imx219"))
     {
-        raw_pipe.reset(new JpegPipeline());
+        raw_pipe->daisyChain(new JpegPipeline());
 
         BroadcomPipeline *brcm_pipe = new BroadcomPipeline();
         raw_pipe->daisyChain(brcm_pipe);
@@ -614,6 +740,9 @@ void MMALDriver::setupPipeline()
     else
     {
         LOGF_WARN("%s: Unknown camera type: %s\n", __FUNCTION__, camera_control->get_camera()->getModel());
+        raw_pipe.reset();
+        dump_stage = nullptr;
+        decode_stage = nullptr;
         return;
     }
 }
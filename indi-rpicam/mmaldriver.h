@@ -29,6 +29,8 @@
 #include "jpegpipeline.h"
 #include "broadcompipeline.h"
 #include "raw12tobayer16pipeline.h"
+#include "threadedpipeline.h"
+#include "bufferdump.h"
 #include "capturelistener.h"
 #include "chipwrapper.h"
 #include "config.h"
@@ -92,9 +94,31 @@ private:
   INumber mGainN[1];
   INumberVectorProperty mGainNP;
 
+  // Decode the camera buffers on a worker thread instead of the MMAL callback.
+  ISwitch mDecodeThreadS[2];
+  ISwitchVectorProperty mDecodeThreadSP;
+
+  enum
+  {
+      DECODE_QUEUE_MAX,
+      DECODE_CHUNK_MAX,
+      DECODE_TOTAL,
+      DECODE_STALLS,
+      DECODE_STALL_TIME,
+  };
+  INumber mDecodeStatsN[5];
+  INumberVectorProperty mDecodeStatsNP;
+  void updateDecodeStats();
+
+  // Record the camera buffers to a file, for replay with rpicam_replay.
+  IText mBufferDumpT[1] {};
+  ITextVectorProperty mBufferDumpTP;
+
   std::unique_ptr<CameraControl> camera_control; // Controller object for the camera communication.
 
   std::unique_ptr<Pipeline> raw_pipe; // Start of pipeline that recieved raw data from camera.
+  BufferDumpPipeline *dump_stage {nullptr}; // First stage of raw_pipe, records the buffers when asked to.
+  ThreadedPipeline *decode_stage {nullptr}; // Hands the data over to the decode thread.
 
   ChipWrapper chipWrapper;
 
@@ -60,3 +60,12 @@ void Pipeline::reset_pipe()
         pipe = pipe->nextPipeline;
     }
 }
+
+void Pipeline::flush_pipe()
+{
+    Pipeline *pipe = this;
+    while(pipe != nullptr) {
+        pipe->flush();
+        pipe = pipe->nextPipeline;
+    }
+}
@@ -41,6 +41,11 @@ public:
      */
     void reset_pipe();
 
+    /**
+     * Cascading flush of whole pipeline, returns when every stage has processed all data received so far.
+     */
+    void flush_pipe();
+
     virtual void data_received(uint8_t  *data,  uint32_t length) = 0;
 
     /**
@@ -51,6 +56,12 @@ public:
      */
     virtual void reset() = 0;
 
+    /**
+     * Wait until all data received by this object has been processed. Only stages that
+     * hand data over to another thread need to do anything here.
+     */
+    virtual void flush() {}
+
 protected:
     void forward(uint8_t *data,  uint32_t length);
 
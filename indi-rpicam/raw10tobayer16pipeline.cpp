@@ -26,6 +26,8 @@
 #include "broadcompipeline.h"
 #include "chipwrapper.h"
 
+#include <pixelkernels.h>
+
 /**
  * Decoding the RAW11 format which is rows of:
  * [ B1h ] [ G1h ] [ B2h ] [ G2h ] [ B1l | G1l | B2l | G2l ] ...
@@ -103,37 +105,22 @@ void Raw10ToBayer16Pipeline::data_received(uint8_t *data,  uint32_t length)
     }
 
     uint8_t byte;
-    const uint32_t u32Magic = 0x4001; // bit expansion multiplier (2 pairs of bits at a time)
-    const uint32_t u32Mask = 0x30003; // mask to preserve lower 2 bits of expanded values
-    uint32_t u32Temp, u32_01, u32_23, *pu32;
     cur_row = frame_buffer + y * maxX;
     
     //At this point we are for sure at y > startRawY
     while(length > 0 && bytes_consumed < offset_end)
     {  
-        //If we are aligned to the 4 pixel stride (state 0), try to do some bulk conversion 
-        if(state == 0)
+        //If we are aligned to the 4 pixel stride (state 0), convert all whole 5 byte groups of this row at once
+        if(state == 0 && x < maxX && raw_x >= startRawX)
         {
-            //Use 32bit aligned pixel chunks to convert 4 pixels  at the same time
-            while(length >= 5 && x < maxX && raw_x >= startRawX)
-            {
-                assert(x % 4 == 0);
-                pu32 = (uint32_t *)(&cur_row[x]);
-                u32_01 = (*data++ << 2);
-                u32_01 |= (*data++ << 18); // each 32-bit value will hold 2 source bytes spread out to 16-bits
-                u32_23 = (*data++ << 2); // and shifted over 2 to make room for lower 2 bits
-                u32_23 |= (*data++ << 18);
-                u32Temp = *data++ * u32Magic; // 5th byte contains 4 pairs of bits (0/1) for the 4 pixels
-                u32_01 |= (u32Temp & u32Mask); // combine lower 2 bits to bytes 0 and 1
-                u32Temp >>= 4; // shift down to access bits for bytes 2/3
-                u32_23 |= (u32Temp & u32Mask);
-                *pu32++ = u32_01 << (16-10); // store 4 16-bit pixels (10 significant bits). Upshifted so bit 9 -> bit 15.
-                *pu32++ = u32_23 << (16-10);
-          	    length -= 5;
-            	x += 4;
-                raw_x += 5;
-                bytes_consumed += 5;
-            }
+            assert(x % 4 == 0);
+            uint32_t groups = std::min(length / 5, (maxX - x + 3) / 4);
+            PixelKernels::unpackRaw10(data, &cur_row[x], groups);
+            data += groups * 5;
+            length -= groups * 5;
+            x += groups * 4;
+            raw_x += groups * 5;
+            bytes_consumed += groups * 5;
             if(length == 0)
             {
                 return;
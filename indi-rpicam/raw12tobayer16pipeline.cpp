@@ -20,11 +20,14 @@
 
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 
 #include "raw12tobayer16pipeline.h"
 #include "broadcompipeline.h"
 #include "chipwrapper.h"
 
+#include <pixelkernels.h>
+
 #include <fstream>
 
 /**
@@ -59,54 +62,81 @@ void Raw12ToBayer16Pipeline::data_received(uint8_t *data,  uint32_t length)
 {
     uint8_t byte;
 
-    assert(bcm_pipe->header.omx_data.raw_width == 6112); 
+    const int raw_width = bcm_pipe->header.omx_data.raw_width;
+    assert(raw_width == 6112);
     assert(ccd->getXRes() == 4056);
     assert(ccd->getYRes() == 3040);
 
     int maxX = ccd->getSubW();
     int maxY = ccd->getSubH();
+    int subY = ccd->getSubY();
+    uint16_t *frame_buffer = reinterpret_cast<uint16_t *>(ccd->getFrameBuffer());
 
-    for(;length; data++, length--)
+    while(length)
     {
-        byte = *data;
-
-        if (raw_x >= bcm_pipe->header.omx_data.raw_width) {
+        if (raw_x >= raw_width) {
             x = 0;
             raw_x = 0;
             state = 0;
 
             raw_y++;
-            if (raw_y > ccd->getSubY()) {
+            if (raw_y > subY) {
                 y += 1;
             }
         }
 
-        if (raw_x >= startRawX && raw_y >= ccd->getSubY() && x < maxX && y < maxY) {
-            uint16_t *cur_row = reinterpret_cast<uint16_t *>(ccd->getFrameBuffer()) + y * ccd->getSubW();
-
-            // RAW according to experiment.
-            switch(state)
-            {
-            case 0:
-                // FIXME: Optimize, if at least 3 bytes remaining here, all data can be calculated faster in one step.
-                cur_row[x] = byte << 8;
-                state = 1;
-                break;
-
-            case 1:
-                cur_row[x+1] = byte << 8;
-                state = 2;
-                break;
-
-            case 2:
-                cur_row[x+0] |= static_cast<uint16_t>((byte & 0x0F) << 4);
-                cur_row[x+1] |= static_cast<uint16_t>((byte & 0xF0) << 0);
-                x += 2;
-                state = 0;
-                break;
+        // Outside the subframe, skip ahead to where it starts on this line or to the end of the line.
+        if (raw_y < subY || y >= maxY || x >= maxX || raw_x < startRawX) {
+            uint32_t skip = raw_width - raw_x;
+            if (raw_y >= subY && y < maxY && raw_x < startRawX) {
+                skip = startRawX - raw_x;
+            }
+            skip = std::min(skip, length);
+            data += skip;
+            length -= skip;
+            raw_x += skip;
+            continue;
+        }
+
+        uint16_t *cur_row = frame_buffer + y * maxX;
+
+        // Aligned to a group, unpack all whole groups of this line at once.
+        if (state == 0) {
+            uint32_t groups = std::min({length / 3, static_cast<uint32_t>(raw_width - raw_x) / 3, static_cast<uint32_t>(maxX - x + 1) / 2});
+            if (groups > 0) {
+                PixelKernels::unpackRaw12(data, cur_row + x, groups);
+                data += groups * 3;
+                length -= groups * 3;
+                raw_x += groups * 3;
+                x += groups * 2;
+                continue;
             }
         }
 
+        // Partial group at the end of a buffer or a line, RAW according to experiment.
+        byte = *data;
+        switch(state)
+        {
+        case 0:
+            cur_row[x] = byte << 8;
+            state = 1;
+            break;
+
+        case 1:
+            cur_row[x+1] = byte << 8;
+            state = 2;
+            break;
+
+        case 2:
+            cur_row[x+0] |= static_cast<uint16_t>((byte & 0x0F) << 4);
+            cur_row[x+1] |= static_cast<uint16_t>((byte & 0xF0) << 0);
+            x += 2;
+            state = 0;
+            break;
+        }
+
+        data++;
+        length--;
         raw_x++;
     }
 }
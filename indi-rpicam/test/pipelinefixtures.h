@@ -0,0 +1,78 @@
+#ifndef PIPELINEFIXTURES_H
+#define PIPELINEFIXTURES_H
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <chipwrapper.h>
+#include <pipeline.h>
+
+// {{{ FrameChip: In memory CCDChip for the raw pipelines, no camera needed.
+class FrameChip : public ChipWrapper
+{
+public:
+    FrameChip(int xres, int yres, int x, int y, int w, int h) : xres(xres), yres(yres), subx(x), suby(y), subw(w), subh(h)
+    {
+        // Some slack after the frame, the byte wise decoder may touch one pixel past the subframe.
+        frame.assign(w * h + 8, 0);
+    }
+
+    // Subframe at 0,0 of the IMX477 sensor.
+    FrameChip(int w, int h) : FrameChip(4056, 3040, 0, 0, w, h) {}
+
+    virtual int getFrameBufferSize() override { return subw * subh * 2; }
+    virtual uint8_t* getFrameBuffer() override { return reinterpret_cast<uint8_t *>(frame.data()); }
+    virtual int getSubX() override { return subx; }
+    virtual int getSubY() override { return suby; }
+    virtual int getSubW() override { return subw; }
+    virtual int getSubH() override { return subh; }
+    virtual int getXRes() override { return xres; }
+    virtual int getYRes() override { return yres; }
+
+    std::vector<uint16_t> frame;
+
+private:
+    int xres, yres;
+    int subx, suby, subw, subh;
+};
+// }}}
+
+// {{{ Collector: Last stage that records what it receives and on which thread.
+class Collector : public Pipeline
+{
+public:
+    explicit Collector(int delay_ms = 0, size_t fail_after = 0) : delay_ms(delay_ms), fail_after(fail_after) {}
+
+    virtual void data_received(uint8_t *data,  uint32_t length) override
+    {
+        thread = std::this_thread::get_id();
+        if (fail_after && received.size() + length > fail_after) {
+            throw std::runtime_error("bad data");
+        }
+        received.insert(received.end(), data, data + length);
+        chunks++;
+        if (delay_ms) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+        }
+    }
+
+    virtual void reset() override
+    {
+        received.clear();
+        chunks = 0;
+    }
+
+    std::vector<uint8_t> received;
+    size_t chunks {0};
+    std::thread::id thread;
+
+private:
+    int delay_ms;
+    size_t fail_after;
+};
+// }}}
+
+#endif // PIPELINEFIXTURES_H
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <unistd.h>
+
+#include <broadcompipeline.h>
+#include <bufferdump.h>
+#include <bufferreplay.h>
+#include <jpegpipeline.h>
+#include <raw12tobayer16pipeline.h>
+#include <threadedpipeline.h>
+
+#include "pipelinefixtures.h"
+
+static const int WIDTH = 64;
+static const int HEIGHT = 16;
+static const int RAW_WIDTH = 6112;  // IMX477 RAW12 line, 4056 * 3 / 2 plus padding
+
+/**
+ * A raspistill --raw like frame: JPEG with a segment and entropy data, BRCM header, RAW12 lines.
+ * Only the first HEIGHT lines of the sensor, the subframe decoded from them is all the tests look at.
+ */
+static std::vector<uint8_t> makeFrame(unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> frame = { 0xFF, 0xD8, 0xFF, 0xE1, 0x10, 0x00 };
+    frame.resize(frame.size() + 0x1000 - 2);
+    frame.insert(frame.end(), { 0xFF, 0xDA, 0x00, 0x04, 0x00, 0x00, 0x12, 0xFF, 0x00, 0x34, 0xFF, 0xD9 });
+
+    size_t brcm = frame.size();
+    frame.resize(brcm + 32768 + RAW_WIDTH * HEIGHT);
+    memcpy(frame.data() + brcm, "BRCMo", 5);
+    BroadcomHeader header;
+    memset(&header, 0, sizeof header);
+    header.omx_data.raw_width = RAW_WIDTH;
+    memcpy(frame.data() + brcm + 8, &header.omx_data, sizeof header.omx_data);
+    for (size_t i = brcm + 32768; i < frame.size(); i++) {
+        frame[i] = static_cast<uint8_t>(gen());
+    }
+    return frame;
+}
+
+static void checkDecoded(const std::vector<uint8_t> &frame, const FrameChip &chip)
+{
+    const uint8_t *raw = frame.data() + frame.size() - RAW_WIDTH * HEIGHT;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            const uint8_t *group = raw + y * RAW_WIDTH + (x / 2) * 3;
+            uint16_t expected = static_cast<uint16_t>(((group[x % 2] << 4) | ((group[2] >> (4 * (x % 2))) & 0x0F)) << 4);
+            ASSERT_EQ(chip.frame[y * WIDTH + x], expected) << "x=" << x << " y=" << y;
+        }
+    }
+}
+
+static std::string tempFile()
+{
+    char name[] = "/tmp/test_bufferreplay_XXXXXX";
+    int fd = mkstemp(name);
+    EXPECT_GE(fd, 0);
+    close(fd);
+    return name;
+}
+
+TEST(BufferReplay, records_and_loads_buffers)
+{
+    std::string filename = tempFile();
+    BufferDumpPipeline dump_pipe;
+    Collector *collector = new Collector();
+    dump_pipe.daisyChain(collector);
+    ASSERT_TRUE(dump_pipe.open(filename));
+
+    std::vector<uint8_t> frames[2] = { makeFrame(1), makeFrame(2) };
+    const uint32_t sizes[2] = { 8192, 1000 };
+    for (int i = 0; i < 2; i++) {
+        dump_pipe.reset_pipe();
+        for (size_t pos = 0; pos < frames[i].size(); pos += sizes[i]) {
+            dump_pipe.data_received(frames[i].data() + pos, std::min<size_t>(sizes[i], frames[i].size() - pos));
+        }
+        EXPECT_EQ(collector->received, frames[i]);
+    }
+    dump_pipe.close();
+
+    BufferDump dump;
+    dump.load(filename);
+    remove(filename.c_str());
+
+    ASSERT_EQ(dump.frames.size(), 2u);
+    for (int i = 0; i < 2; i++) {
+        const BufferDump::Frame &frame = dump.frames[i];
+        EXPECT_EQ(frame.data, frames[i]);
+        ASSERT_EQ(frame.buffers.size(), (frames[i].size() + sizes[i] - 1) / sizes[i]);
+        EXPECT_EQ(frame.buffers[0].time_us, 0u);
+        for (size_t b = 0; b < frame.buffers.size(); b++) {
+            EXPECT_EQ(frame.buffers[b].offset, b * sizes[i]);
+            if (b > 0) {
+                EXPECT_GE(frame.buffers[b].time_us, frame.buffers[b - 1].time_us);
+            }
+        }
+    }
+}
+
+TEST(BufferReplay, loads_plain_raw_file)
+{
+    std::string filename = tempFile();
+    std::vector<uint8_t> frame = makeFrame(3);
+    FILE *fp = fopen(filename.c_str(), "wb");
+    fwrite(frame.data(), 1, frame.size(), fp);
+    fclose(fp);
+
+    BufferDump dump;
+    dump.load(filename, 4096);
+    remove(filename.c_str());
+
+    ASSERT_EQ(dump.frames.size(), 1u);
+    EXPECT_EQ(dump.frames[0].data, frame);
+    EXPECT_EQ(dump.frames[0].buffers.size(), (frame.size() + 4095) / 4096);
+    EXPECT_EQ(dump.frames[0].buffers.back().length, frame.size() % 4096);
+}
+
+TEST(BufferReplay, decodes_frames_in_any_chunk_size)
+{
+    BufferDump dump;
+    dump.add_frame(makeFrame(4), 81920);
+    dump.add_frame(makeFrame(5), 81920);
+
+    for (uint32_t chunk : { 0u, 1u, 7u, 4099u, 1000000u }) {
+        for (bool threaded : { false, true }) {
+            FrameChip chip(WIDTH, HEIGHT);
+            std::unique_ptr<Pipeline> pipe(new JpegPipeline());
+            if (threaded) {
+                Pipeline *jpeg_pipe = pipe.release();
+                pipe.reset(new ThreadedPipeline(4, 1024));
+                pipe->daisyChain(jpeg_pipe);
+            }
+            BroadcomPipeline *brcm_pipe = new BroadcomPipeline();
+            pipe->daisyChain(brcm_pipe);
+            brcm_pipe->daisyChain(new Raw12ToBayer16Pipeline(brcm_pipe, &chip));
+
+            BufferReplay::Options options;
+            options.chunk_size = chunk;
+            BufferReplay replay(options);
+
+            for (const BufferDump::Frame &frame : dump.frames) {
+                BufferReplay::FrameResult result = replay.play(*pipe, frame);
+                EXPECT_EQ(result.bytes, frame.data.size());
+                EXPECT_EQ(result.chunks, chunk ? (frame.data.size() + chunk - 1) / chunk : frame.buffers.size());
+                EXPECT_GE(result.latency_ms, result.feed_ms);
+                checkDecoded(frame.data, chip);
+            }
+        }
+    }
+}
+
+TEST(BufferReplay, paces_buffers)
+{
+    BufferDump dump;
+    dump.add_frame(makeFrame(6), 4096);
+    const size_t bytes = dump.frames[0].data.size();
+
+    Collector *collector = new Collector();
+    std::unique_ptr<Pipeline> pipe(collector);
+
+    // Fixed rate, the last buffer is due after (bytes - last buffer) at 10 MB/s.
+    BufferReplay::Options options;
+    options.timing = BufferReplay::Timing::RATE;
+    options.rate = 10;
+    BufferReplay::Report report = BufferReplay(options).play(*pipe, dump);
+    ASSERT_EQ(report.frames.size(), 1u);
+    EXPECT_GE(report.frames[0].feed_ms, (bytes - dump.frames[0].buffers.back().length) / 10000.0);
+    EXPECT_EQ(report.bytes(), bytes);
+    EXPECT_GT(report.mb_per_s(), 0);
+    EXPECT_LE(report.mb_per_s(), 10.5);
+
+    // Recorded times, 2 ms between the buffers, re-chunked in smaller pieces.
+    for (size_t i = 0; i < dump.frames[0].buffers.size(); i++) {
+        dump.frames[0].buffers[i].time_us = i * 2000;
+    }
+    options.timing = BufferReplay::Timing::RECORDED;
+    options.chunk_size = 1000;
+    report = BufferReplay(options).play(*pipe, dump, 2);
+    ASSERT_EQ(report.frames.size(), 2u);
+    for (const BufferReplay::FrameResult &result : report.frames) {
+        EXPECT_GE(result.feed_ms, (dump.frames[0].buffers.size() - 1) * 2.0);
+        EXPECT_EQ(result.chunks, (bytes + 999) / 1000);
+    }
+    EXPECT_EQ(collector->received, dump.frames[0].data);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <broadcompipeline.h>
+#include <raw10tobayer16pipeline.h>
+#include <raw12tobayer16pipeline.h>
+#include <threadedpipeline.h>
+#include <pixelkernels.h>
+
+#include "pipelinefixtures.h"
+
+/**
+ * Broadcom header followed by random raw lines, as the camera sends it after the JPEG.
+ */
+static std::vector<uint8_t> makeStream(uint16_t raw_width, int rows, unsigned seed)
+{
+    const size_t header_size = 32768;
+    std::vector<uint8_t> stream(header_size + raw_width * rows);
+
+    memcpy(stream.data(), "BRCMo", 5);
+    BroadcomHeader header;
+    memset(&header, 0, sizeof header);
+    header.omx_data.raw_width = raw_width;
+    memcpy(stream.data() + 8, &header.omx_data, sizeof header.omx_data);
+
+    std::mt19937 gen(seed);
+    for (size_t i = header_size; i < stream.size(); i++) {
+        stream[i] = static_cast<uint8_t>(gen());
+    }
+    return stream;
+}
+
+// Straight from the format description, pixel x of every group is left aligned to bit 15.
+static uint16_t raw10Pixel(const uint8_t *raw, int raw_width, int raw_y, int startRawX, int x)
+{
+    const uint8_t *group = raw + raw_y * raw_width + startRawX + (x / 4) * 5;
+    int shift = 2 * (x % 4);
+    return static_cast<uint16_t>(((group[x % 4] << 2) | ((group[4] >> shift) & 0x03)) << 6);
+}
+
+static uint16_t raw12Pixel(const uint8_t *raw, int raw_width, int raw_y, int startRawX, int x)
+{
+    const uint8_t *group = raw + raw_y * raw_width + startRawX + (x / 2) * 3;
+    int shift = 4 * (x % 2);
+    return static_cast<uint16_t>(((group[x % 2] << 4) | ((group[2] >> shift) & 0x0F)) << 4);
+}
+
+/**
+ * Feed the stream in chunks of the given size (0 for random sizes) and compare every subframe pixel.
+ * If threaded, the pipeline runs behind a ThreadedPipeline stage like in the driver.
+ */
+template <typename RawPipeline>
+static void checkPipeline(FrameChip &chip, std::vector<uint8_t> &stream, uint32_t chunk,
+                          uint16_t (*pixel)(const uint8_t *, int, int, int, int), int startRawX, bool threaded = false)
+{
+    BroadcomPipeline *bcm_pipe = new BroadcomPipeline();
+    bcm_pipe->daisyChain(new RawPipeline(bcm_pipe, &chip));
+
+    std::unique_ptr<Pipeline> first_stage(bcm_pipe);
+    ThreadedPipeline *decode_stage = nullptr;
+    if (threaded) {
+        decode_stage = new ThreadedPipeline(8, 16384);
+        decode_stage->daisyChain(first_stage.release());
+        first_stage.reset(decode_stage);
+    }
+    first_stage->reset_pipe();
+    std::fill(chip.frame.begin(), chip.frame.end(), 0);
+
+    std::mt19937 gen(chunk);
+    std::uniform_int_distribution<uint32_t> sizes(1, 40000);
+    for (size_t pos = 0; pos < stream.size();) {
+        uint32_t length = std::min<size_t>(chunk ? chunk : sizes(gen), stream.size() - pos);
+        first_stage->data_received(stream.data() + pos, length);
+        pos += length;
+    }
+    first_stage->flush_pipe();
+    if (decode_stage) {
+        EXPECT_EQ(decode_stage->last_error(), "");
+    }
+
+    const uint8_t *raw = stream.data() + 32768;
+    const int raw_width = bcm_pipe->header.omx_data.raw_width;
+    int mismatches = 0;
+    for (int y = 0; y < chip.getSubH(); y++) {
+        for (int x = 0; x < chip.getSubW(); x++) {
+            uint16_t expected = pixel(raw, raw_width, chip.getSubY() + y, startRawX, x);
+            uint16_t actual = chip.frame[y * chip.getSubW() + x];
+            if (expected != actual && mismatches++ < 5) {
+                ADD_FAILURE() << "chunk " << chunk << " x=" << x << " y=" << y << " expected " << expected << " got " << actual;
+            }
+        }
+    }
+    EXPECT_EQ(mismatches, 0) << "chunk " << chunk;
+}
+
+class RawPipelineTest : public ::testing::TestWithParam<PixelKernels::Isa>
+{
+protected:
+    void SetUp() override
+    {
+        if (!PixelKernels::selectIsa(GetParam())) {
+            GTEST_SKIP() << PixelKernels::toString(GetParam()) << " not supported here";
+        }
+    }
+};
+
+// Chunk sizes that split groups and lines everywhere, MMAL delivers 80k buffers.
+// Byte sized chunks are only used for subframes, the skipped lines keep those tests fast.
+static const uint32_t chunks[] = { 4099, 81920, 0 };
+static const uint32_t subframe_chunks[] = { 1, 2, 3, 7, 4099, 81920, 0 };
+
+TEST_P(RawPipelineTest, raw10_full_frame)
+{
+    FrameChip chip(3280, 2464, 0, 0, 3280, 2464);
+    auto stream = makeStream(4128, 2464, 10);
+    for (uint32_t chunk : chunks) {
+        checkPipeline<Raw10ToBayer16Pipeline>(chip, stream, chunk, raw10Pixel, 0);
+    }
+}
+
+TEST_P(RawPipelineTest, raw10_subframe)
+{
+    FrameChip chip(3280, 2464, 100, 60, 640, 480);
+    auto stream = makeStream(4128, 2464, 11);
+    for (uint32_t chunk : subframe_chunks) {
+        checkPipeline<Raw10ToBayer16Pipeline>(chip, stream, chunk, raw10Pixel, (100 / 4) * 5);
+    }
+}
+
+TEST_P(RawPipelineTest, raw12_full_frame)
+{
+    FrameChip chip(4056, 3040, 0, 0, 4056, 3040);
+    auto stream = makeStream(6112, 3040, 12);
+    for (uint32_t chunk : chunks) {
+        checkPipeline<Raw12ToBayer16Pipeline>(chip, stream, chunk, raw12Pixel, 0);
+    }
+}
+
+TEST_P(RawPipelineTest, raw12_subframe)
+{
+    FrameChip chip(4056, 3040, 100, 100, 640, 480);
+    auto stream = makeStream(6112, 3040, 13);
+    for (uint32_t chunk : subframe_chunks) {
+        checkPipeline<Raw12ToBayer16Pipeline>(chip, stream, chunk, raw12Pixel, (100 / 2) * 3);
+    }
+}
+
+TEST_P(RawPipelineTest, raw12_threaded)
+{
+    FrameChip chip(4056, 3040, 100, 100, 640, 480);
+    auto stream = makeStream(6112, 3040, 14);
+    for (uint32_t chunk : chunks) {
+        checkPipeline<Raw12ToBayer16Pipeline>(chip, stream, chunk, raw12Pixel, (100 / 2) * 3, true);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsas, RawPipelineTest,
+                         ::testing::Values(PixelKernels::ISA_SCALAR, PixelKernels::ISA_SSE2, PixelKernels::ISA_AVX2, PixelKernels::ISA_NEON),
+                         [](const ::testing::TestParamInfo<PixelKernels::Isa> &info)
+{
+    return std::string(PixelKernels::toString(info.param));
+});
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
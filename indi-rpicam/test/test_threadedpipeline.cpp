@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <threadedpipeline.h>
+
+#include "pipelinefixtures.h"
+
+static std::vector<uint8_t> randomBytes(size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<uint8_t> data(count);
+    for (auto &b : data) {
+        b = static_cast<uint8_t>(gen());
+    }
+    return data;
+}
+
+TEST(ThreadedPipeline, forwards_all_data_in_order)
+{
+    ThreadedPipeline stage(4, 1000);
+    Collector *collector = new Collector();
+    stage.daisyChain(collector);
+    stage.reset_pipe();
+
+    // Chunks both smaller and larger than a slot.
+    auto data = randomBytes(200000, 1);
+    std::mt19937 gen(2);
+    std::uniform_int_distribution<uint32_t> sizes(1, 3000);
+    for (size_t pos = 0; pos < data.size();) {
+        uint32_t length = std::min<size_t>(sizes(gen), data.size() - pos);
+        stage.data_received(data.data() + pos, length);
+        pos += length;
+    }
+    stage.flush_pipe();
+
+    EXPECT_EQ(collector->received, data);
+    EXPECT_NE(collector->thread, std::this_thread::get_id());
+
+    ThreadedPipeline::Stats stats = stage.get_stats();
+    EXPECT_EQ(stats.bytes, data.size());
+    EXPECT_EQ(stats.chunks, collector->chunks);
+    EXPECT_TRUE(stage.last_error().empty());
+}
+
+TEST(ThreadedPipeline, blocks_when_ring_is_full)
+{
+    ThreadedPipeline stage(2, 100);
+    Collector *collector = new Collector(2);
+    stage.daisyChain(collector);
+    stage.reset_pipe();
+
+    auto data = randomBytes(2000, 3);
+    for (size_t pos = 0; pos < data.size(); pos += 100) {
+        stage.data_received(data.data() + pos, 100);
+    }
+    stage.flush_pipe();
+
+    EXPECT_EQ(collector->received, data);
+
+    ThreadedPipeline::Stats stats = stage.get_stats();
+    EXPECT_EQ(stats.chunks, 20u);
+    EXPECT_GT(stats.stalls, 0u);
+    EXPECT_GT(stats.stall_ms, 0);
+    EXPECT_GE(stats.max_process_ms, 1.5);
+    EXPECT_GE(stats.total_process_ms, 20 * 1.5);
+}
+
+TEST(ThreadedPipeline, reset_drops_queued_data)
+{
+    ThreadedPipeline stage(8, 100);
+    Collector *collector = new Collector(5);
+    stage.daisyChain(collector);
+    stage.reset_pipe();
+
+    auto data = randomBytes(800, 4);
+    stage.data_received(data.data(), data.size());
+    stage.reset_pipe();
+
+    EXPECT_TRUE(collector->received.empty());
+    EXPECT_EQ(stage.get_stats().chunks, 0u);
+
+    // Still usable after the reset.
+    stage.data_received(data.data(), 100);
+    stage.flush_pipe();
+    EXPECT_EQ(collector->received, std::vector<uint8_t>(data.begin(), data.begin() + 100));
+}
+
+TEST(ThreadedPipeline, downstream_error_is_kept_until_reset)
+{
+    ThreadedPipeline stage(4, 100);
+    Collector *collector = new Collector(0, 250);
+    stage.daisyChain(collector);
+    stage.reset_pipe();
+
+    auto data = randomBytes(1000, 5);
+    stage.data_received(data.data(), data.size());
+    stage.flush_pipe();
+
+    EXPECT_EQ(stage.last_error(), "bad data");
+    EXPECT_EQ(collector->received.size(), 200u);
+
+    stage.reset_pipe();
+    EXPECT_TRUE(stage.last_error().empty());
+}
+
+TEST(ThreadedPipeline, unthreaded_runs_in_caller)
+{
+    ThreadedPipeline stage(4, 100);
+    Collector *collector = new Collector();
+    stage.daisyChain(collector);
+    stage.set_threaded(false);
+    stage.reset_pipe();
+
+    auto data = randomBytes(1000, 6);
+    stage.data_received(data.data(), data.size());
+
+    EXPECT_EQ(collector->received, data);
+    EXPECT_EQ(collector->thread, std::this_thread::get_id());
+    EXPECT_EQ(stage.get_stats().chunks, 1u);
+
+    stage.set_threaded(true);
+    stage.reset_pipe();
+    stage.data_received(data.data(), data.size());
+    stage.flush_pipe();
+    EXPECT_EQ(collector->received, data);
+    EXPECT_NE(collector->thread, std::this_thread::get_id());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
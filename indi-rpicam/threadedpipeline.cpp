@@ -0,0 +1,214 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <exception>
+
+#include "threadedpipeline.h"
+#include "inditest.h"
+
+static double ms_between(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+ThreadedPipeline::ThreadedPipeline(uint32_t slots, uint32_t slot_size) : slots(std::max(slots, 2u)), slot_size(slot_size)
+{
+    for(auto &slot : this->slots) {
+        slot.data.reset(new uint8_t[slot_size]);
+    }
+    set_threaded(true);
+}
+
+ThreadedPipeline::~ThreadedPipeline()
+{
+    stop();
+}
+
+void ThreadedPipeline::set_threaded(bool threaded)
+{
+    if (threaded && !worker.joinable()) {
+        stopping = false;
+        worker = std::thread(&ThreadedPipeline::run, this);
+    }
+    else if (!threaded) {
+        stop();
+    }
+    this->threaded = threaded;
+}
+
+void ThreadedPipeline::stop()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    data_available.notify_one();
+    worker.join();
+}
+
+void ThreadedPipeline::wake(std::atomic<bool> &waiting, std::condition_variable &cond)
+{
+    // The waiter sets its flag before checking the positions, so either it sees the new
+    // position or we see the flag. Taking the mutex makes sure it is really asleep.
+    if (waiting.load()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_all();
+    }
+}
+
+void ThreadedPipeline::data_received(uint8_t *data,  uint32_t length)
+{
+    if (!threaded) {
+        auto start = std::chrono::steady_clock::now();
+        forward(data, length);
+        double process_ms = ms_between(start, std::chrono::steady_clock::now());
+
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        stats.chunks++;
+        stats.bytes += length;
+        stats.total_process_ms += process_ms;
+        stats.max_process_ms = std::max(stats.max_process_ms, process_ms);
+        return;
+    }
+
+    while(length > 0) {
+        uint64_t pos = head.load(std::memory_order_relaxed);
+
+        // Backpressure, wait for the worker to free a slot.
+        if (pos - tail.load() >= slots.size()) {
+            auto start = std::chrono::steady_clock::now();
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                producer_waiting = true;
+                space_available.wait(lock, [&]() { return pos - tail.load() < slots.size(); });
+                producer_waiting = false;
+            }
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            stats.stalls++;
+            stats.stall_ms += ms_between(start, std::chrono::steady_clock::now());
+        }
+
+        Slot &slot = slots[pos % slots.size()];
+        slot.length = std::min(length, slot_size);
+        memcpy(slot.data.get(), data, slot.length);
+        slot.queued = std::chrono::steady_clock::now();
+
+        data += slot.length;
+        length -= slot.length;
+
+        head.store(pos + 1);
+        wake(worker_waiting, data_available);
+    }
+}
+
+void ThreadedPipeline::run()
+{
+    for(;;) {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+
+        if (head.load() == pos) {
+            std::unique_lock<std::mutex> lock(mutex);
+            worker_waiting = true;
+            data_available.wait(lock, [&]() { return stopping || head.load() != pos; });
+            worker_waiting = false;
+            if (head.load() == pos) {
+                return; // Stopping and nothing left.
+            }
+        }
+
+        Slot &slot = slots[pos % slots.size()];
+        bool failed;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            failed = !error.empty();
+        }
+
+        if (!discarding && !failed) {
+            auto start = std::chrono::steady_clock::now();
+            std::string what;
+            try {
+                forward(slot.data.get(), slot.length);
+            }
+            catch (std::exception &e) {
+                what = e.what();
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            if (!what.empty()) {
+                LOGF_TEST("pipeline worker stopped: %s", what.c_str());
+                error = what;
+            }
+            double queue_ms = ms_between(slot.queued, start);
+            double process_ms = ms_between(start, end);
+            stats.chunks++;
+            stats.bytes += slot.length;
+            stats.total_queue_ms += queue_ms;
+            stats.max_queue_ms = std::max(stats.max_queue_ms, queue_ms);
+            stats.total_process_ms += process_ms;
+            stats.max_process_ms = std::max(stats.max_process_ms, process_ms);
+        }
+
+        tail.store(pos + 1);
+        wake(producer_waiting, space_available);
+        wake(flush_waiting, drained);
+    }
+}
+
+void ThreadedPipeline::flush()
+{
+    if (!worker.joinable()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    flush_waiting = true;
+    drained.wait(lock, [&]() { return tail.load() == head.load(std::memory_order_relaxed); });
+    flush_waiting = false;
+}
+
+void ThreadedPipeline::reset()
+{
+    discarding = true;
+    flush();
+    discarding = false;
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats = Stats();
+    error.clear();
+}
+
+ThreadedPipeline::Stats ThreadedPipeline::get_stats()
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
+
+std::string ThreadedPipeline::last_error()
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return error;
+}
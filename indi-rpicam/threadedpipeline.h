@@ -0,0 +1,126 @@
+/*
+ Raspberry Pi High Quality Camera CCD Driver for Indi.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef THREADEDPIPELINE_H
+#define THREADEDPIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline.h"
+
+/**
+ * @brief The ThreadedPipeline class is a stage boundary, the rest of the pipeline runs on a worker thread.
+ *
+ * data_received() copies the chunk into a preallocated slot of a single producer / single consumer
+ * ring and returns, so the MMAL callback can hand its buffer back to the camera right away. The worker
+ * forwards the slots in order and recycles them. When all slots are in use data_received() waits for
+ * the worker (backpressure), that time is counted as a stall.
+ *
+ * When disabled the stage just forwards in the calling thread, like before.
+ */
+class ThreadedPipeline : public Pipeline
+{
+public:
+    struct Stats
+    {
+        uint64_t chunks {0};         //! Chunks forwarded by the worker.
+        uint64_t bytes {0};
+        uint64_t stalls {0};         //! Times data_received() had to wait for a free slot.
+        double stall_ms {0};         //! Total time spent waiting for free slots.
+        double max_queue_ms {0};     //! Longest time a chunk waited in the ring.
+        double total_queue_ms {0};
+        double max_process_ms {0};   //! Longest time the downstream stages took for one chunk.
+        double total_process_ms {0};
+    };
+
+    /**
+     * @param slots number of chunks the ring holds.
+     * @param slot_size bytes per slot, larger chunks are split over several slots.
+     */
+    explicit ThreadedPipeline(uint32_t slots = 32, uint32_t slot_size = 128 * 1024);
+    virtual ~ThreadedPipeline();
+
+    virtual void data_received(uint8_t *data,  uint32_t length) override;
+
+    /**
+     * Drops all chunks still waiting in the ring and clears the statistics and the last error.
+     */
+    virtual void reset() override;
+    virtual void flush() override;
+
+    /**
+     * Run the downstream stages on the worker thread or in the caller.
+     * Must not be called while data is being received.
+     */
+    void set_threaded(bool threaded);
+    bool is_threaded() const { return threaded; }
+
+    Stats get_stats();
+
+    /**
+     * Exception message from a downstream stage, chunks are dropped until the next reset() after one.
+     */
+    std::string last_error();
+
+private:
+    void run();
+    void stop();
+    void wake(std::atomic<bool> &waiting, std::condition_variable &cond);
+
+    struct Slot
+    {
+        std::unique_ptr<uint8_t[]> data;
+        uint32_t length {0};
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    std::vector<Slot> slots;
+    uint32_t slot_size;
+
+    // Monotonic positions, slot index is position % slots.size().
+    // head is only written by the producer, tail only by the worker.
+    std::atomic<uint64_t> head {0};
+    std::atomic<uint64_t> tail {0};
+
+    // Sleeping is done on the mutex, the fast path only touches the atomics.
+    std::mutex mutex;
+    std::condition_variable data_available;
+    std::condition_variable space_available;
+    std::condition_variable drained;
+    std::atomic<bool> worker_waiting {false};
+    std::atomic<bool> producer_waiting {false};
+    std::atomic<bool> flush_waiting {false};
+    std::atomic<bool> discarding {false};
+    bool stopping {false};
+
+    bool threaded {true};
+    std::thread worker;
+
+    std::mutex stats_mutex;
+    Stats stats;
+    std::string error;
+};
+
+#endif // THREADEDPIPELINE_H
@@ -33,6 +33,7 @@
 #include "indidevapi.h"
 #include "eventloop.h"
 #include "stream/streammanager.h"
+#include "pixelkernels.h"
 
 #include "libsv305/SVBCameraSDK.h"
 
@@ -721,11 +722,7 @@ void* Sv305CCD::streamVideo()
         // stretching 12bits depth to 16bits depth
         if(bitDepth==16 && (bitStretch != 0))
         {
-            u_int16_t* tmp=(u_int16_t*)imageBuffer;
-            for(int i=0; i<PrimaryCCD.getFrameBufferSize()/2; i++)
-            {
-                tmp[i]<<=bitStretch;
-            }
+            PixelKernels::shiftLeft(reinterpret_cast<uint16_t*>(imageBuffer), PrimaryCCD.getFrameBufferSize()/2, bitStretch);
         }
 
         if(binning)
@@ -889,11 +886,7 @@ void Sv305CCD::TimerHit()
                     // stretching 12bits depth to 16bits depth
                     if(bitDepth==16 && (bitStretch != 0))
                     {
-                        u_int16_t* tmp=(u_int16_t*)imageBuffer;
-                        for(int i=0; i<PrimaryCCD.getFrameBufferSize()/2; i++)
-                        {
-                                tmp[i]<<=bitStretch;
-                        }
+                        PixelKernels::shiftLeft(reinterpret_cast<uint16_t*>(imageBuffer), PrimaryCCD.getFrameBufferSize()/2, bitStretch);
                     }
 
                     // binning if needed
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <stream/streammanager.h>
+#include <pixelkernels.h>
 
 #include <math.h>
 #include <unistd.h>
@@ -35,6 +36,7 @@
 #define TEMP_TIMER_MS           1000 /* Temperature polling time (ms) */
 #define TEMP_THRESHOLD          .25  /* Differential temperature threshold (C)*/
 #define MAX_DEVICES             4    /* Max device cameraCount */
+#define BURST_IDLE_MS           5000 /* Burst frames are kept this long after the exposure they were taken for (ms) */
 
 #define CONTROL_TAB "Controls"
 #define LEVEL_TAB "Levels"
@@ -124,11 +126,19 @@ ToupBase::ToupBase(const XP(DeviceV2) *instance) : m_Instance(instance)
 
     m_CaptureTimeout.callOnTimeout(std::bind(&ToupBase::captureTimeoutHandler, this));
     m_CaptureTimeout.setSingleShot(true);
+
+    m_BurstDelivery.callOnTimeout(std::bind(&ToupBase::deliverBurstFrame, this));
+    m_BurstDelivery.setSingleShot(true);
+
+    m_BurstIdle.callOnTimeout(std::bind(&ToupBase::burstIdleHandler, this));
+    m_BurstIdle.setSingleShot(true);
 }
 
 ToupBase::~ToupBase()
 {
     m_CaptureTimeout.stop();
+    m_BurstDelivery.stop();
+    m_BurstIdle.stop();
 }
 
 const char *ToupBase::getDefaultName()
@@ -305,6 +315,15 @@ bool ToupBase::initProperties()
     IUFillSwitchVector(&VideoFormatSP, VideoFormatS, 2, getDeviceName(), "CCD_VIDEO_FORMAT", "Format", CONTROL_TAB, IP_RW,
                        ISR_1OFMANY, 60, IPS_IDLE);
 
+    ///////////////////////////////////////////////////////////////////////////////////
+    /// Trigger Burst
+    ///////////////////////////////////////////////////////////////////////////////////
+    /// Frames armed by a single software trigger, 1 disables bursts. Not saved, every session starts with single frames.
+    IUFillNumber(&BurstN[TC_BURST_FRAMES], "TC_BURST_FRAMES", "Frames", "%.f", 1, 1000, 1, 1);
+    /// Preallocated frames to queue while the client processes the previous one
+    IUFillNumber(&BurstN[TC_BURST_SLOTS], "TC_BURST_SLOTS", "Queue", "%.f", 1, 32, 1, 4);
+    IUFillNumberVector(&BurstNP, BurstN, 2, getDeviceName(), "CCD_BURST", "Burst", CONTROL_TAB, IP_RW, 60, IPS_IDLE);
+
     ///////////////////////////////////////////////////////////////////////////////////
     /// Resolution
     ///////////////////////////////////////////////////////////////////////////////////
@@ -366,6 +385,8 @@ bool ToupBase::updateProperties()
         defineProperty(&AutoControlSP);
         defineProperty(&AutoExposureSP);
         defineProperty(&VideoFormatSP);
+        if (!(m_Instance->model->flag & CP(FLAG_TRIGGER_SINGLE)))
+            defineProperty(&BurstNP);
         defineProperty(&ResolutionSP);
         defineProperty(&ADCNP);
         if (m_HasLowNoise)
@@ -416,6 +437,8 @@ bool ToupBase::updateProperties()
         deleteProperty(AutoControlSP.name);
         deleteProperty(AutoExposureSP.name);
         deleteProperty(VideoFormatSP.name);
+        if (!(m_Instance->model->flag & CP(FLAG_TRIGGER_SINGLE)))
+            deleteProperty(BurstNP.name);
         deleteProperty(ResolutionSP.name);
         deleteProperty(ADCNP.name);
         if (m_HasLowNoise)
@@ -546,6 +569,9 @@ bool ToupBase::Disconnect()
 {
     stopTimerNS();
     stopTimerWE();
+    m_BurstDelivery.stop();
+    m_BurstIdle.stop();
+    resetBurst();
 
     FP(Close(m_CameraHandle));
 
@@ -981,6 +1007,8 @@ void ToupBase::allocateFrameBuffer()
     }
 
     Streamer->setSize(PrimaryCCD.getXRes(), PrimaryCCD.getYRes());
+
+    allocateBurstSlots();
 }
 
 bool ToupBase::ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n)
@@ -1059,11 +1087,34 @@ bool ToupBase::ISNewNumber(const char *dev, const char *name, double values[], c
                 }
             }
 
+            // Queued burst frames were taken with the old settings
+            resetBurst();
+
             ControlNP.s = IPS_OK;
             IDSetNumber(&ControlNP, nullptr);
             return true;
         }
 
+        //////////////////////////////////////////////////////////////////////
+        /// Trigger Burst
+        //////////////////////////////////////////////////////////////////////
+        if (!strcmp(name, BurstNP.name))
+        {
+            IUUpdateNumber(&BurstNP, values, names, n);
+            resetBurst();
+            allocateBurstSlots();
+
+            if (burstEnabled())
+                LOGF_INFO("Each trigger arms %.f frames, up to %.f are queued.", BurstN[TC_BURST_FRAMES].value,
+                          BurstN[TC_BURST_SLOTS].value);
+            else
+                LOG_INFO("Trigger burst is disabled.");
+
+            BurstNP.s = IPS_OK;
+            IDSetNumber(&BurstNP, nullptr);
+            return true;
+        }
+
         if (!strcmp(name, GainConversionNP.name))
         {
             double oldValues[2] = {0};
@@ -1522,6 +1573,7 @@ bool ToupBase::ISNewSwitch(const char *dev, const char *name, ISState * states,
 
             }
 
+            resetBurst();
             m_CurrentVideoFormat = currentIndex;
             m_BitsPerPixel = (m_BitsPerPixel > 8) ? 16 : 8;
 
@@ -1777,6 +1829,8 @@ bool ToupBase::StartStreaming()
     //        return false;
     //    }
 
+    resetBurst();
+
     // Always disable Auto-Exposure on streaming
     FP(put_AutoExpoEnable(m_CameraHandle, 0));
 
@@ -1883,6 +1937,34 @@ bool ToupBase::StartExposure(float duration)
 
     uint32_t uSecs = static_cast<uint32_t>(duration * 1000000.0f);
 
+    struct timeval exposure_time, current_time;
+    gettimeofday(&current_time, nullptr);
+    exposure_time.tv_sec = uSecs / 1000000;
+    exposure_time.tv_usec = uSecs % 1000000;
+
+    // A running burst with the same duration already has this frame queued or on its way
+    m_BurstIdle.stop();
+    dropStaleBurstFrames();
+    {
+        std::unique_lock<std::mutex> lock(m_BurstMutex);
+        if (burstEnabled() && duration == m_BurstExposure && (m_BurstCount > 0 || m_BurstArmed > 0))
+        {
+            timeradd(&current_time, &exposure_time, &ExposureEnd);
+            InExposure = true;
+            LOGF_DEBUG("Exposure served by trigger burst: %zu queued, %u armed.", m_BurstCount, m_BurstArmed);
+
+            // ExposureComplete must not be called before the exposure property is set busy.
+            if (m_BurstCount > 0)
+                m_BurstDelivery.start(0);
+            else
+                m_CaptureTimeout.start(duration * 1000 + m_DownloadEstimation * 1.2);
+            m_BurstIdle.start(duration * 1000 + m_DownloadEstimation * 1.2 + BURST_IDLE_MS);
+            return true;
+        }
+    }
+
+    resetBurst();
+
     LOGF_DEBUG("Starting exposure: %d us @ %s", uSecs, IUFindOnSwitch(&ResolutionSP)->label);
 
     // Only update exposure when necessary
@@ -1909,10 +1991,6 @@ bool ToupBase::StartExposure(float duration)
     }
     */
 
-    struct timeval exposure_time, current_time;
-    gettimeofday(&current_time, nullptr);
-    exposure_time.tv_sec = uSecs / 1000000;
-    exposure_time.tv_usec = uSecs % 1000000;
     timeradd(&current_time, &exposure_time, &ExposureEnd);
 
     if (ExposureRequest > VERBOSE_EXPOSURE)
@@ -1933,7 +2011,7 @@ bool ToupBase::StartExposure(float duration)
     bool capturedStarted = false;
 
     // Snap still image
-    if (m_CanSnap)
+    if (m_CanSnap && !burstEnabled())
     {
         if (SUCCEEDED(rc = FP(Snap(m_CameraHandle, IUFindOnSwitchIndex(&ResolutionSP)))))
             capturedStarted = true;
@@ -1946,10 +2024,21 @@ bool ToupBase::StartExposure(float duration)
 
     if (!capturedStarted)
     {
-        // Trigger an exposure
-        if (FAILED(rc = FP(Trigger(m_CameraHandle, 1))))
+        uint16_t frames = 1;
+        if (burstEnabled())
+        {
+            std::lock_guard<std::mutex> lock(m_BurstMutex);
+            frames = static_cast<uint16_t>(BurstN[TC_BURST_FRAMES].value);
+            m_BurstArmed = frames;
+            m_BurstExposure = duration;
+        }
+
+        // Trigger an exposure, or arm all frames of the burst at once
+        if (FAILED(rc = FP(Trigger(m_CameraHandle, frames))))
         {
             LOGF_ERROR("Failed to trigger exposure. Error: %s", errorCodes[rc].c_str());
+            std::lock_guard<std::mutex> lock(m_BurstMutex);
+            m_BurstArmed = 0;
             return false;
         }
     }
@@ -1957,12 +2046,18 @@ bool ToupBase::StartExposure(float duration)
     // Timeout 500ms after expected duration
     m_CaptureTimeout.start(duration * 1000 + m_DownloadEstimation * 1.2);
 
+    if (burstEnabled())
+        m_BurstIdle.start(duration * 1000 + m_DownloadEstimation * 1.2 + BURST_IDLE_MS);
+
     return true;
 }
 
 bool ToupBase::AbortExposure()
 {
     FP(Trigger(m_CameraHandle, 0));
+    m_BurstDelivery.stop();
+    m_BurstIdle.stop();
+    resetBurst();
     InExposure = false;
     m_TimeoutRetries = 0;
     m_CaptureTimeoutCounter = 0;
@@ -1987,6 +2082,9 @@ void ToupBase::captureTimeoutHandler()
         return;
     }
 
+    // Whatever the burst had armed is lost, fall back to single frames
+    resetBurst();
+
     // Snap still image
     if (m_CanSnap && FAILED(rc = FP(Snap(m_CameraHandle, IUFindOnSwitchIndex(&ResolutionSP)))))
     {
@@ -2038,6 +2136,8 @@ bool ToupBase::UpdateCCDFrame(int x, int y, int w, int h)
     // Set UNBINNED coords
     PrimaryCCD.setFrame(x, y, w, h);
 
+    resetBurst();
+
 
     // Total bytes required for image buffer
     uint32_t nbuf = (w * h * PrimaryCCD.getBPP() / 8) * m_Channels;
@@ -2382,6 +2482,190 @@ void ToupBase::AutoExposureChanged()
     // TODO
 }
 
+bool ToupBase::burstEnabled() const
+{
+    return BurstN[TC_BURST_FRAMES].value > 1 && !(m_Instance->model->flag & CP(FLAG_TRIGGER_SINGLE));
+}
+
+void ToupBase::allocateBurstSlots()
+{
+    std::lock_guard<std::mutex> lock(m_BurstMutex);
+
+    size_t count = 0;
+    if (burstEnabled())
+        count = static_cast<size_t>(BurstN[TC_BURST_SLOTS].value);
+    else if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
+        count = 1;
+
+    // Slots hold a full resolution frame so ROI changes do not reallocate them.
+    const size_t size = PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * m_Channels * (m_BitsPerPixel > 8 ? 2 : 1);
+    m_BurstSlots.resize(count);
+    for (auto &slot : m_BurstSlots)
+        slot.resize(size);
+    m_BurstSlots.shrink_to_fit();
+    m_BurstStamps.resize(count);
+    m_BurstDiscard.resize(burstEnabled() ? size : 0);
+    m_BurstDiscard.shrink_to_fit();
+
+    m_BurstHead = 0;
+    m_BurstCount = 0;
+
+    LOGF_DEBUG("Allocated %zu frame slots of %zu bytes.", count, size);
+}
+
+void ToupBase::resetBurst()
+{
+    uint32_t armed;
+    {
+        std::lock_guard<std::mutex> lock(m_BurstMutex);
+        armed = m_BurstArmed;
+        m_BurstArmed = 0;
+        m_BurstHead = 0;
+        m_BurstCount = 0;
+    }
+
+    // Not under the lock, the SDK callback thread takes it in captureFrame
+    if (armed > 0)
+    {
+        FP(Trigger(m_CameraHandle, 0));
+        LOGF_DEBUG("Cancelled trigger burst with %u frames left.", armed);
+    }
+}
+
+void ToupBase::dropStaleBurstFrames()
+{
+    std::lock_guard<std::mutex> lock(m_BurstMutex);
+
+    const auto oldest = std::chrono::steady_clock::now() - std::chrono::milliseconds(BURST_IDLE_MS);
+    size_t dropped = 0;
+    while (m_BurstCount > 0 && m_BurstStamps[m_BurstHead] < oldest)
+    {
+        m_BurstHead = (m_BurstHead + 1) % m_BurstSlots.size();
+        m_BurstCount--;
+        dropped++;
+    }
+
+    if (dropped > 0)
+        LOGF_DEBUG("Dropped %zu stale burst frames.", dropped);
+}
+
+void ToupBase::burstIdleHandler()
+{
+    // Still waiting for the frame, check again once it had time to arrive
+    if (InExposure)
+    {
+        m_BurstIdle.start(BURST_IDLE_MS);
+        return;
+    }
+
+    LOG_DEBUG("No exposure followed the trigger burst, disarming.");
+    resetBurst();
+}
+
+bool ToupBase::captureFrame(const std::function<bool(uint8_t *)> &read, const uint8_t *pushed)
+{
+    const bool rgb = (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB);
+    std::unique_lock<std::mutex> lock(m_BurstMutex);
+
+    const bool armed = m_BurstArmed > 0;
+    if (armed)
+        m_BurstArmed--;
+
+    // With nothing queued ahead of it, the frame belongs to the pending exposure.
+    if (InExposure && m_BurstCount == 0)
+    {
+        InExposure = false;
+        PrimaryCCD.setExposureLeft(0);
+
+        bool ok = true;
+        if (rgb && pushed != nullptr)
+        {
+            // Split pushed RGB frames straight from the SDK buffer.
+            completeExposure(pushed);
+        }
+        else if (rgb)
+        {
+            // The head slot is free while the queue is empty, stage the RGB frame there.
+            uint8_t *buffer = m_BurstSlots[m_BurstHead].data();
+            if ((ok = read(buffer)))
+                completeExposure(buffer);
+        }
+        else
+        {
+            std::unique_lock<std::mutex> guard(ccdBufferLock);
+            ok = read(PrimaryCCD.getFrameBuffer());
+        }
+        lock.unlock();
+
+        if (ok)
+            ExposureComplete(&PrimaryCCD);
+        else
+            PrimaryCCD.setExposureFailed();
+        return true;
+    }
+
+    if (!armed)
+        return false;
+
+    if (m_BurstCount == m_BurstSlots.size())
+    {
+        // Only this frame is lost, flushing would also drop the frames still armed
+        LOGF_DEBUG("Burst queue is full (%zu frames), dropping frame.", m_BurstCount);
+        read(m_BurstDiscard.data());
+        return true;
+    }
+
+    const size_t tail = (m_BurstHead + m_BurstCount) % m_BurstSlots.size();
+    if (read(m_BurstSlots[tail].data()))
+    {
+        m_BurstStamps[tail] = std::chrono::steady_clock::now();
+        m_BurstCount++;
+    }
+
+    LOGF_DEBUG("Burst frame queued: %zu queued, %u armed.", m_BurstCount, m_BurstArmed);
+    return true;
+}
+
+void ToupBase::completeExposure(const uint8_t *frame)
+{
+    std::unique_lock<std::mutex> guard(ccdBufferLock);
+    uint8_t *image = PrimaryCCD.getFrameBuffer();
+
+    if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
+    {
+        uint32_t width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * (PrimaryCCD.getBPP() / 8);
+        uint32_t height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY() * (PrimaryCCD.getBPP() / 8);
+
+        uint8_t *subR = image;
+        uint8_t *subG = image + width * height;
+        uint8_t *subB = image + width * height * 2;
+
+        // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
+        PixelKernels::deinterleave3(frame, subR, subG, subB, width * height);
+    }
+    else if (frame != image)
+        memcpy(image, frame, PrimaryCCD.getFrameBufferSize());
+}
+
+void ToupBase::deliverBurstFrame()
+{
+    std::unique_lock<std::mutex> lock(m_BurstMutex);
+    if (!InExposure || m_BurstCount == 0)
+        return;
+
+    InExposure = false;
+    m_CaptureTimeoutCounter = 0;
+    m_CaptureTimeout.stop();
+    PrimaryCCD.setExposureLeft(0);
+
+    completeExposure(m_BurstSlots[m_BurstHead].data());
+    m_BurstHead = (m_BurstHead + 1) % m_BurstSlots.size();
+    m_BurstCount--;
+    lock.unlock();
+
+    ExposureComplete(&PrimaryCCD);
+}
+
 void ToupBase::pushCB(const void* pData, const XP(FrameInfoV2)* pInfo, int bSnap, void* pCallbackCtx)
 {
     static_cast<ToupBase*>(pCallbackCtx)->pushCallback(pData, pInfo, bSnap);
@@ -2394,8 +2678,10 @@ void ToupBase::pushCallback(const void* pData, const XP(FrameInfoV2)* pInfo, int
     if (Streamer->isStreaming() || Streamer->isRecording())
     {
         Streamer->newFrame(reinterpret_cast<const uint8_t*>(pData), PrimaryCCD.getFrameBufferSize());
+        return;
     }
-    else if (InExposure)
+
+    if (InExposure)
     {
         m_CaptureTimeoutCounter = 0;
         m_CaptureTimeout.stop();
@@ -2406,61 +2692,24 @@ void ToupBase::pushCallback(const void* pData, const XP(FrameInfoV2)* pInfo, int
         timersub(&curtime, &ExposureEnd, &diff);
         m_DownloadEstimation = diff.tv_sec * 1000 + diff.tv_usec / 1e3;
         LOGF_DEBUG("New download estimate %.f ms", m_DownloadEstimation);
+    }
 
-        InExposure  = false;
-        PrimaryCCD.setExposureLeft(0);
-        uint8_t *buffer = PrimaryCCD.getFrameBuffer();
-        uint32_t size = PrimaryCCD.getFrameBufferSize();
-
-        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-        {
-            size = PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3;
-            buffer = static_cast<uint8_t*>(malloc(size));
-        }
-
+    captureFrame([&](uint8_t * buffer)
+    {
         if (pData == nullptr)
         {
             LOG_ERROR("Failed to push image.");
-            PrimaryCCD.setExposureFailed();
-            if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                free(buffer);
+            return false;
         }
-        else
-        {
-            memcpy(buffer, pData, size);
-
-            if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-            {
-                std::unique_lock<std::mutex> guard(ccdBufferLock);
-                uint8_t *image  = PrimaryCCD.getFrameBuffer();
-                uint32_t width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * (PrimaryCCD.getBPP() / 8);
-                uint32_t height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY() * (PrimaryCCD.getBPP() / 8);
-
-                uint8_t *subR = image;
-                uint8_t *subG = image + width * height;
-                uint8_t *subB = image + width * height * 2;
-                int size      = width * height * 3 - 3;
-
-                // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
-                for (int i = 0; i <= size; i += 3)
-                {
-                    *subR++ = buffer[i];
-                    *subG++ = buffer[i + 1];
-                    *subB++ = buffer[i + 2];
-                }
 
-                guard.unlock();
-                free(buffer);
-            }
-
-            LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld"
-                       , pInfo->width,
-                       pInfo->height,
-                       pInfo->flag,
-                       pInfo->timestamp);
-            ExposureComplete(&PrimaryCCD);
-        }
-    }
+        memcpy(buffer, pData, PrimaryCCD.getFrameBufferSize());
+        LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld"
+                   , pInfo->width,
+                   pInfo->height,
+                   pInfo->flag,
+                   pInfo->timestamp);
+        return true;
+    }, reinterpret_cast<const uint8_t*>(pData));
 }
 
 void ToupBase::eventCB(unsigned event, void* pCtx)
@@ -2504,70 +2753,37 @@ void ToupBase::eventPullCallBack(unsigned event)
                     if (SUCCEEDED(rc))
                         Streamer->newFrame(PrimaryCCD.getFrameBuffer(), PrimaryCCD.getFrameBufferSize());
                 }
-                else if (InExposure)
+                else
                 {
-                    InExposure = false;
-                    PrimaryCCD.setExposureLeft(0);
-                    uint8_t *buffer = PrimaryCCD.getFrameBuffer();
-
-                    if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                        buffer = static_cast<uint8_t*>(malloc(PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3));
-
-                    std::unique_lock<std::mutex> guard(ccdBufferLock);
-                    HRESULT rc = FP(PullImageV2(m_CameraHandle, buffer, captureBits * m_Channels, &info));
-                    guard.unlock();
-                    if (FAILED(rc))
+                    bool captured = captureFrame([&](uint8_t * buffer)
                     {
-                        LOGF_ERROR("Failed to pull image. %s", errorCodes[rc].c_str());
-                        PrimaryCCD.setExposureFailed();
-                        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                            free(buffer);
-                    }
-                    else
-                    {
-                        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
+                        HRESULT rc = FP(PullImageV2(m_CameraHandle, buffer, captureBits * m_Channels, &info));
+                        if (FAILED(rc))
                         {
-                            std::unique_lock<std::mutex> guard(ccdBufferLock);
-                            uint8_t *image  = PrimaryCCD.getFrameBuffer();
-                            uint32_t width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * (PrimaryCCD.getBPP() / 8);
-                            uint32_t height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY() * (PrimaryCCD.getBPP() / 8);
-
-                            uint8_t *subR = image;
-                            uint8_t *subG = image + width * height;
-                            uint8_t *subB = image + width * height * 2;
-                            int size      = width * height * 3 - 3;
-
-                            // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
-                            for (int i = 0; i <= size; i += 3)
-                            {
-                                *subR++ = buffer[i];
-                                *subG++ = buffer[i + 1];
-                                *subB++ = buffer[i + 2];
-                            }
-
-                            guard.unlock();
-                            free(buffer);
+                            LOGF_ERROR("Failed to pull image. %s", errorCodes[rc].c_str());
+                            return false;
                         }
 
                         LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld", info.width, info.height, info.flag,
                                    info.timestamp);
-                        ExposureComplete(&PrimaryCCD);
-                    }
-                }
-                else
-                {
-                    // Fix proposed by Seven Watt
-                    // Check https://github.com/indilib/indi-3rdparty/issues/112
-                    //
-                    // Starshootg_Flush is deprecated but there are no alternativess
+                        return true;
+                    });
+
+                    if (!captured)
+                    {
+                        // Fix proposed by Seven Watt
+                        // Check https://github.com/indilib/indi-3rdparty/issues/112
+                        //
+                        // Starshootg_Flush is deprecated but there are no alternativess
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-                    HRESULT rc = FP(Flush(m_CameraHandle));
+                        HRESULT rc = FP(Flush(m_CameraHandle));
 #pragma GCC diagnostic pop
-                    LOG_DEBUG("Image event received after CCD is stopped. Image flushed");
-                    if (FAILED(rc))
-                    {
-                        LOGF_ERROR("Failed to flush image. %s", errorCodes[rc].c_str());
+                        LOG_DEBUG("Image event received after CCD is stopped. Image flushed");
+                        if (FAILED(rc))
+                        {
+                            LOGF_ERROR("Failed to flush image. %s", errorCodes[rc].c_str());
+                        }
                     }
                 }
             }
@@ -2590,70 +2806,37 @@ void ToupBase::eventPullCallBack(unsigned event)
                     if (SUCCEEDED(rc))
                         Streamer->newFrame(PrimaryCCD.getFrameBuffer(), PrimaryCCD.getFrameBufferSize());
                 }
-                else if (InExposure)
+                else
                 {
-                    InExposure = false;
-                    PrimaryCCD.setExposureLeft(0);
-                    uint8_t *buffer = PrimaryCCD.getFrameBuffer();
-
-                    if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                        buffer = static_cast<uint8_t*>(malloc(PrimaryCCD.getXRes() * PrimaryCCD.getYRes() * 3));
-
-                    std::unique_lock<std::mutex> guard(ccdBufferLock);
-                    HRESULT rc = FP(PullStillImageV2(m_CameraHandle, buffer, captureBits * m_Channels, &info));
-                    guard.unlock();
-                    if (FAILED(rc))
+                    bool captured = captureFrame([&](uint8_t * buffer)
                     {
-                        LOGF_ERROR("Failed to pull image. %s", errorCodes[rc].c_str());
-                        PrimaryCCD.setExposureFailed();
-                        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
-                            free(buffer);
-                    }
-                    else
-                    {
-                        if (m_MonoCamera == false && m_CurrentVideoFormat == TC_VIDEO_COLOR_RGB)
+                        HRESULT rc = FP(PullStillImageV2(m_CameraHandle, buffer, captureBits * m_Channels, &info));
+                        if (FAILED(rc))
                         {
-                            std::unique_lock<std::mutex> guard(ccdBufferLock);
-                            uint8_t *image  = PrimaryCCD.getFrameBuffer();
-                            uint32_t width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * (PrimaryCCD.getBPP() / 8);
-                            uint32_t height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY() * (PrimaryCCD.getBPP() / 8);
-
-                            uint8_t *subR = image;
-                            uint8_t *subG = image + width * height;
-                            uint8_t *subB = image + width * height * 2;
-                            int size      = width * height * 3 - 3;
-
-                            // RGB to three sepearate R-frame, G-frame, and B-frame for color FITS
-                            for (int i = 0; i <= size; i += 3)
-                            {
-                                *subR++ = buffer[i];
-                                *subG++ = buffer[i + 1];
-                                *subB++ = buffer[i + 2];
-                            }
-
-                            guard.unlock();
-                            free(buffer);
+                            LOGF_ERROR("Failed to pull image. %s", errorCodes[rc].c_str());
+                            return false;
                         }
 
                         LOGF_DEBUG("Image received. Width: %d Height: %d flag: %d timestamp: %ld", info.width, info.height, info.flag,
                                    info.timestamp);
-                        ExposureComplete(&PrimaryCCD);
-                    }
-                }
-                else
-                {
-                    // Fix proposed by Seven Watt
-                    // Check https://github.com/indilib/indi-3rdparty/issues/112
-                    //
-                    // Starshootg_Flush is deprecated but there are no alternativess
+                        return true;
+                    });
+
+                    if (!captured)
+                    {
+                        // Fix proposed by Seven Watt
+                        // Check https://github.com/indilib/indi-3rdparty/issues/112
+                        //
+                        // Starshootg_Flush is deprecated but there are no alternativess
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-                    HRESULT rc = FP(Flush(m_CameraHandle));
+                        HRESULT rc = FP(Flush(m_CameraHandle));
 #pragma GCC diagnostic pop
-                    LOG_DEBUG("Image event received after CCD is stopped. Image flushed");
-                    if (FAILED(rc))
-                    {
-                        LOGF_ERROR("Failed to flush image. %s", errorCodes[rc].c_str());
+                        LOG_DEBUG("Image event received after CCD is stopped. Image flushed");
+                        if (FAILED(rc))
+                        {
+                            LOGF_ERROR("Failed to flush image. %s", errorCodes[rc].c_str());
+                        }
                     }
                 }
             }
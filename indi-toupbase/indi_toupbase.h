@@ -21,7 +21,11 @@
 
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <vector>
 #include <indiccd.h>
 #include <inditimer.h>
 
@@ -352,6 +356,24 @@ class ToupBase : public INDI::CCD
         struct timeval ExposureEnd;
         double ExposureRequest;
 
+        //#############################################################################
+        // Trigger Burst
+        //#############################################################################
+        // Route an arrived frame to the pending exposure or the burst queue. Returns false if nobody wants it.
+        bool captureFrame(const std::function<bool(uint8_t *)> &read, const uint8_t *pushed = nullptr);
+        // Copy or deinterleave a captured frame into the CCD buffer and complete the exposure.
+        void completeExposure(const uint8_t *frame);
+        // Complete the pending exposure from the oldest queued burst frame.
+        void deliverBurstFrame();
+        // Cancel the armed trigger and drop all queued frames.
+        void resetBurst();
+        // Drop queued frames older than the idle time, the client stopped asking for them.
+        void dropStaleBurstFrames();
+        // Disarm the burst when no exposure followed the last one.
+        void burstIdleHandler();
+        void allocateBurstSlots();
+        bool burstEnabled() const;
+
         //#############################################################################
         // Video Format & Streaming
         //#############################################################################
@@ -458,6 +480,15 @@ class ToupBase : public INDI::CCD
             TC_COOLER_OFF,
         };
 
+        // Trigger Burst
+        INumberVectorProperty BurstNP;
+        INumber BurstN[2];
+        enum
+        {
+            TC_BURST_FRAMES,
+            TC_BURST_SLOTS,
+        };
+
         INumberVectorProperty ControlNP;
         INumber ControlN[8];
         enum
@@ -642,6 +673,22 @@ class ToupBase : public INDI::CCD
         bool m_HasHeatUp { false };
 
         INDI::Timer m_CaptureTimeout;
+
+        // Preallocated frames queued by a trigger burst, a ring of m_BurstCount ready frames starting at m_BurstHead.
+        // With bursts disabled a single slot stages RGB frames before they are split into planes.
+        std::vector<std::vector<uint8_t>> m_BurstSlots;
+        size_t m_BurstHead { 0 };
+        size_t m_BurstCount { 0 };
+        // When each slot was filled
+        std::vector<std::chrono::steady_clock::time_point> m_BurstStamps;
+        // A burst frame arriving with the queue full is pulled here and dropped, the SDK keeps the rest armed
+        std::vector<uint8_t> m_BurstDiscard;
+        // Frames still expected from the last trigger
+        uint32_t m_BurstArmed { 0 };
+        float m_BurstExposure { 0 };
+        std::mutex m_BurstMutex;
+        INDI::Timer m_BurstDelivery;
+        INDI::Timer m_BurstIdle;
         uint32_t m_CaptureTimeoutCounter {0};
         // Download estimation in ms after exposure duration finished.
         double m_DownloadEstimation {5000};
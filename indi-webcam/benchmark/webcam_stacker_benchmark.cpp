@@ -0,0 +1,154 @@
+/*
+    Webcam stacker benchmark
+
+    Stacks synthetic noisy frames with the old per pixel loop of indi_webcam::addToStack
+    and with WebcamStacker for 1..N threads, then checks how well sigma clipping
+    removes a satellite trail compared to a plain average.
+
+    Usage: webcam_stacker_benchmark [width height [frames]]
+*/
+
+#include "webcam_stacker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+static const uint16_t SKY_LEVEL = 1000;
+
+// Sky, a few stars and gaussian noise, frame trailFrame also gets a bright diagonal trail
+static void makeFrames(std::vector<std::vector<uint16_t>> &frames, size_t width, size_t rows, size_t trailFrame)
+{
+    std::mt19937 gen(42);
+    std::normal_distribution<float> noise(0.0f, 20.0f);
+
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        auto &frame = frames[f];
+        frame.resize(width * rows);
+        for (size_t y = 0; y < rows; y++)
+            for (size_t x = 0; x < width; x++)
+            {
+                float v = SKY_LEVEL + noise(gen);
+                if ((x % 97) == 13 && (y % 89) == 7)
+                    v += 20000;
+                frame[y * width + x] = static_cast<uint16_t>(std::min(std::max(v, 0.0f), 65535.0f));
+            }
+
+        if (f == trailFrame)
+            for (size_t y = 0; y < rows; y++)
+            {
+                size_t x = y * width / rows;
+                for (size_t dx = 0; dx < 3 && x + dx < width; dx++)
+                    frame[y * width + x + dx] = 60000;
+            }
+    }
+}
+
+// The loop indi_webcam used before WebcamStacker: one call per pixel, branching on the
+// sample size and recovering x, y with / and %.
+struct LegacyStack
+{
+    size_t width;
+    size_t rows;
+    int bpp;
+    std::vector<float> stack;
+
+    float get(const uint8_t *buffer, int x, int y)
+    {
+        if (bpp == 8)
+            return buffer[y * width + x];
+        else if (bpp == 16)
+            return reinterpret_cast<const uint16_t *>(buffer)[y * width + x];
+        return 0;
+    }
+
+    void add(const uint8_t *buffer, bool first)
+    {
+        int w = width, h = rows;
+        for (int i = 0; i < w * h; i++)
+        {
+            int x = i % w;
+            int y = i / w;
+            if (x >= 0 && y >= 0 && x < w && y < h)
+            {
+                if (first)
+                    stack[i] = get(buffer, x, y);
+                else
+                    stack[i] += get(buffer, x, y);
+            }
+        }
+    }
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Mean absolute error against the noise free sky, measured along the trail only
+static double trailError(const std::vector<uint16_t> &result, size_t width, size_t rows)
+{
+    double error = 0;
+    for (size_t y = 0; y < rows; y++)
+    {
+        size_t x = y * width / rows;
+        error += std::fabs(static_cast<double>(result[y * width + x]) - SKY_LEVEL);
+    }
+    return error / rows;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t width  = argc > 2 ? std::strtoul(argv[1], nullptr, 10) : 1920;
+    size_t height = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1080;
+    size_t count  = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 30;
+    count = std::max<size_t>(count, 4);
+
+    // An RGB frame is three planes of width x height
+    const size_t rows = height * 3;
+    const double megapixels = width * rows / 1e6;
+
+    std::vector<std::vector<uint16_t>> frames(count);
+    makeFrames(frames, width, rows, count / 2);
+
+    std::printf("Frame %zux%zu RGB 16 bit, %zu frames, times in ms per frame\n\n", width, height, count);
+
+    LegacyStack legacy { width, rows, 16, std::vector<float>(width * rows) };
+    auto start = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < count; f++)
+        legacy.add(reinterpret_cast<const uint8_t *>(frames[f].data()), f == 0);
+    double legacyMs = elapsedMs(start) / count;
+    std::printf("%-24s%10.3f%10.1f MP/s\n", "per pixel loop", legacyMs, megapixels / legacyMs * 1000);
+
+    const unsigned maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    WebcamStacker stacker;
+    std::vector<uint16_t> result(width * rows);
+
+    for (WebcamStacker::Mode mode : { WebcamStacker::STACK_AVERAGE, WebcamStacker::STACK_SIGMA_CLIP })
+    {
+        for (unsigned threads = 1; threads <= std::min(maxThreads, 8u); threads *= 2)
+        {
+            stacker.setThreads(threads);
+            stacker.reset(mode, width, rows, 16);
+            for (size_t f = 0; f < count; f++)
+                stacker.add(reinterpret_cast<const uint8_t *>(frames[f].data()));
+
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s, %u thread%s", mode == WebcamStacker::STACK_AVERAGE ? "average" : "sigma clip",
+                          threads, threads > 1 ? "s" : "");
+            double ms = megapixels * 1000 / stacker.megapixelsPerSecond();
+            std::printf("%-24s%10.3f%10.1f MP/s\n", name, ms, stacker.megapixelsPerSecond());
+        }
+
+        stacker.finish(reinterpret_cast<uint8_t *>(result.data()));
+        std::printf("  trail residual %.1f ADU over the sky\n\n", trailError(result, width, rows));
+    }
+
+    return 0;
+}
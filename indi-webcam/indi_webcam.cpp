@@ -39,6 +39,11 @@ extern "C" {
 
 #include "config.h"
 
+#include <algorithm>
+#include <chrono>
+
+#define STREAMING_TAB "Streaming"
+
 static std::unique_ptr<indi_webcam> webcam(new indi_webcam());
 
 //Note this is how we get information about AVFoundation Devices
@@ -97,6 +102,7 @@ void indi_webcam::findAVFoundationVideoSources()
     //Need to disconnect the source to probe the streams
     if(isConnected())
     {
+        stopDecoding();
         avcodec_close(pCodecCtx);
         avformat_close_input(&pFormatCtx);
     }
@@ -177,7 +183,7 @@ indi_webcam::indi_webcam()
   frameRate = 30;
   videoSize = "640x480";
   webcamStacking = false;
-  averaging = false;
+  stackingMode = WebcamStacker::STACK_INTEGRATE;
   outputFormat = "8 bit RGB";
 
   IPAddress = "xxx.xxx.x.xxx";
@@ -195,6 +201,7 @@ indi_webcam::indi_webcam()
 
 indi_webcam::~indi_webcam()
 {
+    stopDecoding();
     if(pFormatCtx)
         free(pFormatCtx);
 }
@@ -232,10 +239,17 @@ bool indi_webcam::ConnectToSource(std::string device, std::string source, int fr
     snprintf(stringFrameRate,16,"%u",framerate);
     if(isConnected())
     {
+        stopDecoding();
         avcodec_close(pCodecCtx);
         avformat_close_input(&pFormatCtx);
     }
 
+    //The interrupt callback lets stopDecoding break out of a blocking av_read_frame
+    if(pFormatCtx == nullptr)
+        pFormatCtx = avformat_alloc_context();
+    pFormatCtx->interrupt_callback.callback = decodeInterrupt;
+    pFormatCtx->interrupt_callback.opaque = this;
+
     AVDictionary* options = nullptr;
     av_dict_set(&options, "timeout", ffmpegTimeout.c_str(), 0); //Timeout for open_input and for read_frame.  VERY important.
     AVInputFormat *iformat = nullptr;
@@ -323,6 +337,7 @@ bool indi_webcam::reconnectSource()
         std::string htmlSourceString = "http://" + username + ":" + password + "@" + IPAddress + ":" + port;
         if(ConnectToSource(videoDevice, videoSource, frameRate, videoSize, htmlSourceString))
             return true;
+        attempt++;
     }
     //All 10 attempts resulted in failure.
     return false;
@@ -442,6 +457,8 @@ bool indi_webcam::ChangeHTMLSource(std::string newIPAddress, std::string newPort
 bool indi_webcam::Disconnect()
 {
     if (isConnected()) {
+      stopDecoding();
+
       // Close the codecs
       avcodec_close(pCodecCtx);
 
@@ -471,15 +488,34 @@ bool indi_webcam::initProperties()
     // Must init parent properties first!
     INDI::CCD::initProperties();
 
-    RapidStacking = new ISwitch[3];
+    RapidStacking = new ISwitch[4];
     IUFillSwitch(&RapidStacking[0], "Integration", "Integration", ISS_OFF);
     IUFillSwitch(&RapidStacking[1], "Average", "Average", ISS_OFF);
-    IUFillSwitch(&RapidStacking[2], "Off", "Off", ISS_ON);
+    IUFillSwitch(&RapidStacking[2], "Sigma Clip", "Sigma Clip", ISS_OFF);
+    IUFillSwitch(&RapidStacking[3], "Off", "Off", ISS_ON);
 
-    IUFillSwitchVector(&RapidStackingSelection, RapidStacking, 3, getDeviceName(), "RAPID_STACKING_OPTION", "Rapid Stacking",
+    IUFillSwitchVector(&RapidStackingSelection, RapidStacking, 4, getDeviceName(), "RAPID_STACKING_OPTION", "Rapid Stacking",
                        MAIN_CONTROL_TAB, IP_RW, ISR_ATMOST1, 60, IPS_IDLE);
     defineProperty(&RapidStackingSelection);
 
+    //Sigma clip rejection threshold and stacking throughput, defined while connected
+    IUFillNumber(&StackingSigmaN[0], "SIGMA", "Sigma", "%.1f", 1, 10, 0.5, 2.5);
+    IUFillNumberVector(&StackingSigmaNP, StackingSigmaN, 1, getDeviceName(), "STACKING_SIGMA", "Sigma Clip",
+                       MAIN_CONTROL_TAB, IP_RW, 60, IPS_IDLE);
+
+    IUFillNumber(&StackingStatsN[STACKING_STATS_FRAMES], "FRAMES", "Frames", "%.0f", 0, 1e6, 0, 0);
+    IUFillNumber(&StackingStatsN[STACKING_STATS_FRAME_MS], "FRAME_MS", "Per frame (ms)", "%.2f", 0, 1e4, 0, 0);
+    IUFillNumber(&StackingStatsN[STACKING_STATS_THROUGHPUT], "THROUGHPUT", "Throughput (MP/s)", "%.1f", 0, 1e5, 0, 0);
+    IUFillNumberVector(&StackingStatsNP, StackingStatsN, 3, getDeviceName(), "STACKING_STATS", "Stacking Stats",
+                       MAIN_CONTROL_TAB, IP_RO, 60, IPS_IDLE);
+
+    //Frames decoded from the camera, dropped before they could be used, and sent out as images or stream frames
+    IUFillNumber(&FrameCountersN[FRAME_COUNTER_DECODED], "DECODED", "Decoded", "%.0f", 0, 1e12, 0, 0);
+    IUFillNumber(&FrameCountersN[FRAME_COUNTER_DROPPED], "DROPPED", "Dropped", "%.0f", 0, 1e12, 0, 0);
+    IUFillNumber(&FrameCountersN[FRAME_COUNTER_SENT], "SENT", "Sent", "%.0f", 0, 1e12, 0, 0);
+    IUFillNumberVector(&FrameCountersNP, FrameCountersN, 3, getDeviceName(), "FRAME_COUNTERS", "Frame Counters",
+                       STREAMING_TAB, IP_RO, 60, IPS_IDLE);
+
     OutputFormats = new ISwitch[3];
     IUFillSwitch(&OutputFormats[0], "16 bit Grayscale", "16 bit Grayscale", ISS_OFF);
     IUFillSwitch(&OutputFormats[1], "16 bit RGB", "16 bit RGB", ISS_OFF);
@@ -711,6 +747,19 @@ bool indi_webcam::updateProperties()
     // Call parent update properties first
     INDI::CCD::updateProperties();
 
+    if (isConnected())
+    {
+        defineProperty(&StackingSigmaNP);
+        defineProperty(&StackingStatsNP);
+        defineProperty(&FrameCountersNP);
+    }
+    else
+    {
+        deleteProperty(StackingSigmaNP.name);
+        deleteProperty(StackingStatsNP.name);
+        deleteProperty(FrameCountersNP.name);
+    }
+
     return true;
 }
 
@@ -720,7 +769,16 @@ bool indi_webcam::ISNewNumber (const char *dev, const char *name, double values[
     if (dev && strcmp (getDeviceName(), dev))
       return true;
     DEBUGF(INDI::Logger::DBG_SESSION, "Setting number %s", name);
-    
+
+    if (!strcmp(name, StackingSigmaNP.name))
+    {
+        IUUpdateNumber(&StackingSigmaNP, values, names, n);
+        stacker.setSigma(StackingSigmaN[0].value);
+        StackingSigmaNP.s = IPS_OK;
+        IDSetNumber(&StackingSigmaNP, nullptr);
+        return true;
+    }
+
     return INDI::CCD::ISNewNumber(dev,name,values,names,n);
 }
 
@@ -833,17 +891,21 @@ bool indi_webcam::ISNewSwitch (const char *dev, const char *name, ISState *state
            if(!strcmp(sp->name, "Integration"))
            {
                webcamStacking = true;
-               averaging = false;
+               stackingMode = WebcamStacker::STACK_INTEGRATE;
            }
            if(!strcmp(sp->name, "Average"))
            {
                webcamStacking = true;
-               averaging = true;
+               stackingMode = WebcamStacker::STACK_AVERAGE;
+           }
+           if(!strcmp(sp->name, "Sigma Clip"))
+           {
+               webcamStacking = true;
+               stackingMode = WebcamStacker::STACK_SIGMA_CLIP;
            }
            if(!strcmp(sp->name, "Off"))
            {
                webcamStacking = false;
-               averaging = false;
            }
                 RapidStackingSelection.s = IPS_OK;
                 IDSetSwitch(&RapidStackingSelection, nullptr);
@@ -964,23 +1026,21 @@ bool indi_webcam::StartExposure(float duration)
         return 0;
     }
 
-    //This resets the stack buffer
-    if(webcamStacking){
-        if(stackBuffer)
-            free(stackBuffer);
-        stackBuffer = nullptr;
-    }
+    //This resets the stack, it is sized on the first frame once the stream is set up
+    if(webcamStacking)
+        stackNeedsReset = true;
 
     //This sets up the output format for the exposure
+    //RGB is converted to planar GBRP so swscale writes the FITS colour planes directly
     if(outputFormat == "16 bit RGB")
     {
-        out_pix_fmt=AV_PIX_FMT_RGB48LE;
+        out_pix_fmt=AV_PIX_FMT_GBRP16LE;
         PrimaryCCD.setBPP(16);
         PrimaryCCD.setNAxis(3);
     }
     else if(outputFormat == "8 bit RGB")
     {
-        out_pix_fmt=AV_PIX_FMT_RGB24;
+        out_pix_fmt=AV_PIX_FMT_GBRP;
         PrimaryCCD.setBPP(8);
         PrimaryCCD.setNAxis(3);
     }
@@ -992,6 +1052,8 @@ bool indi_webcam::StartExposure(float duration)
     }
     else
         return -1;
+    outputToFrameBuffer = true;
+    resetFrameCounters();
 
     //This sets up the exposure time settings
     ExposureRequest = duration;
@@ -1011,8 +1073,7 @@ bool indi_webcam::StartExposure(float duration)
 
 bool indi_webcam::AbortExposure()
 {
-    if(stackBuffer)
-        free(stackBuffer);
+    stacker.release();
     InExposure = false;
     return true;
 }
@@ -1073,6 +1134,7 @@ void indi_webcam::TimerHit()
             LOG_INFO("Download complete.");
             finishExposure();
             freeMemory();
+            updateFrameCounters();
         }
         else
         {
@@ -1088,17 +1150,13 @@ void indi_webcam::TimerHit()
 }
 
 // Downloads the image from the Webcam.
-//If the image is an RGB, it converts it to Fits RGB
 //If rapid stacking is happening, it adds the image to the stack.
 
 bool indi_webcam::grabImage()
 {
+    //The frame is converted straight into the primary frame buffer
     if(getStreamFrame())
     {
-        if(PrimaryCCD.getNAxis()==3)
-            convertINDI_RGBtoFITS_RGB(pFrameOUT->data[0], PrimaryCCD.getFrameBuffer());
-        else
-            memcpy(PrimaryCCD.getFrameBuffer(), pFrameOUT->data[0], numBytes);
         if(webcamStacking)
             addToStack();
     }
@@ -1112,96 +1170,33 @@ bool indi_webcam::grabImage()
 }
 
 //This adds each image to the running stack
+//The frame buffer holds one plane for grayscale and three planes for RGB, so it is stacked as height * planes rows.
 bool indi_webcam::addToStack()
 {
-    if(!stackBuffer)
+    if(stackNeedsReset)
     {
-        stackBuffer = (float *)malloc(numBytes*sizeof(float_t));
-        numberOfFramesInStack = 0;
+        int planes = (PrimaryCCD.getNAxis() == 3) ? 3 : 1;
+        stacker.reset(stackingMode, pCodecCtx->width, pCodecCtx->height * planes, PrimaryCCD.getBPP());
+        stackNeedsReset = false;
     }
 
-    int w = pCodecCtx->width  * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    int h = pCodecCtx->height;
-
-    for (int i = 0; i < w * h; i++)
-       {
-           int x = i % w;
-           int y = i / w;
-           if(x >= 0 && y >= 0 && x < w && y < h)
-           {
-                   if(numberOfFramesInStack == 0)
-                       stackBuffer[i]=getImageDataFloatValue(x, y);
-                   else
-                       stackBuffer[i]+=getImageDataFloatValue(x, y);
-           }
-       }
-    numberOfFramesInStack++;
+    stacker.add(PrimaryCCD.getFrameBuffer());
     return true;
 }
 
-//This gets the pixel value at an x, y position in the image
-float indi_webcam::getImageDataFloatValue(int x, int y){
-    int w = pCodecCtx->width  * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    uint8_t *primaryBuffer = PrimaryCCD.getFrameBuffer();
-    if(PrimaryCCD.getBPP()==8)
-        return (float) primaryBuffer[y * w + x];
-    else if(PrimaryCCD.getBPP()==16)
-    {
-        uint16_t *newBuffer = reinterpret_cast<uint16_t *>(primaryBuffer);
-        return (float) newBuffer[y * w + x];
-    }
-    else
-        return 0;
-}
-//This sets the pixel value at an x, y position in the image
-void indi_webcam::setImageDataValueFromFloat(int x, int y, float value, bool roundAnswer)
-{
-    uint8_t *primaryBuffer = PrimaryCCD.getFrameBuffer();
-    int w = pCodecCtx->width * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    if(!stackBuffer)
-        return;
-    if(PrimaryCCD.getBPP()==8)
-    {
-        int max = std::numeric_limits<uint8_t>::max();
-        if (value > max)
-            value = max;
-        if(roundAnswer)
-            primaryBuffer[y * w + x] = round(value);
-        else
-            primaryBuffer[y * w + x] = value;
-    }
-    else if(PrimaryCCD.getBPP()==16)
-    {
-        int max = std::numeric_limits<uint16_t>::max();
-        if (value > max)
-            value = max;
-        uint16_t *newBuffer = reinterpret_cast<uint16_t *>(primaryBuffer);
-        if(roundAnswer)
-            newBuffer[y * w + x] = round(value);
-        else
-            newBuffer[y * w + x] = value;
-    }
-}
-
 //This will take the final image stack and copy it back to the primary buffer for final download.
 void indi_webcam::copyFinalStackToPrimaryFrameBuffer()
 {
-    int w = pCodecCtx->width  * ((PrimaryCCD.getNAxis() == 3) ? 3 : 1);
-    int h = pCodecCtx->height;
-    for (int i = 0; i < w*h; i++)
-        {
-            int x = i % w;
-            int y = i / w;
-            if(x >= 0 && y >= 0 && x < w && y < h)
-            {
-                if(averaging)
-                    setImageDataValueFromFloat(x, y, round(stackBuffer[i]/numberOfFramesInStack), true);
-                else //Integrating
-                    setImageDataValueFromFloat(x, y, round(stackBuffer[i]), true);
-            }
-        }
+    stacker.finish(PrimaryCCD.getFrameBuffer());
+
+    StackingStatsN[STACKING_STATS_FRAMES].value = stacker.frames();
+    StackingStatsN[STACKING_STATS_FRAME_MS].value = stacker.lastAddMs();
+    StackingStatsN[STACKING_STATS_THROUGHPUT].value = stacker.megapixelsPerSecond();
+    StackingStatsNP.s = IPS_OK;
+    IDSetNumber(&StackingStatsNP, nullptr);
 
-    LOGF_INFO("Final Image is a stack of %u exposures.", numberOfFramesInStack);
+    LOGF_INFO("Final Image is a stack of %u exposures.", stacker.frames());
+    stacker.release();
 }
 
 //This will crop the image to a subframe if desired.
@@ -1359,6 +1354,8 @@ void indi_webcam::run_capture()
     }
     else
         return;
+    outputToFrameBuffer = false;
+    resetFrameCounters();
 
   if(!setupStreaming())
       return;
@@ -1372,6 +1369,7 @@ void indi_webcam::run_capture()
   if(!flush_frame_buffer())
       return;
 
+  auto lastCounterUpdate = std::chrono::steady_clock::now();
   while (is_capturing && is_streaming) {
 
     if(getStreamFrame())
@@ -1381,72 +1379,49 @@ void indi_webcam::run_capture()
         is_capturing = false;
         is_streaming = false;
     }
+
+    auto now = std::chrono::steady_clock::now();
+    if(now - lastCounterUpdate >= std::chrono::seconds(1))
+    {
+        updateFrameCounters();
+        lastCounterUpdate = now;
+    }
   }
 
   freeMemory();
+  updateFrameCounters();
 
   DEBUG(INDI::Logger::DBG_SESSION,"Capture thread releasing device.");
 }
 
-//This converts an image from INDI_RGB to FITS_RGB so the FITSViewer can read it.
-bool indi_webcam::convertINDI_RGBtoFITS_RGB(uint8_t *originalImage, uint8_t *convertedImage)
-{
-    if(PrimaryCCD.getBPP() == 8)
-    {
-        int size =  numBytes / 3;
-        uint8_t *r,*g,*b;
-        r = (convertedImage);
-        g = (convertedImage + size);
-        b = (convertedImage + size * 2);
-        for(int i=0; i < numBytes; i+=3)
-        {
-            *r++ = *originalImage++;
-            *g++ = *originalImage++;
-            *b++ = *originalImage++;
-        }
-    }
-    else if(PrimaryCCD.getBPP() == 16)
-    {
-        uint16_t *bigOriginalImage = reinterpret_cast<uint16_t *>(originalImage);
-        uint16_t *bigConvertedImage = reinterpret_cast<uint16_t *>(convertedImage);
-        int size =  numBytes / 2 / 3;
-        uint16_t *r,*g,*b;
-        r = (bigConvertedImage);
-        g = (bigConvertedImage + size);
-        b = (bigConvertedImage + size * 2);
-        for(int i=0; i < numBytes / 2; i+=3)
-        {
-            *r++ = *bigOriginalImage++;
-            *g++ = *bigOriginalImage++;
-            *b++ = *bigOriginalImage++;
-        }
-    }
-    return true;
-}
-
 //This sets up the webcam to get images
 //It is used for both the streaming and exposing algorithms
 bool indi_webcam::setupStreaming()
 {
-    // Determine required buffer size and allocate buffer for pframeRGB
+    // Determine required buffer size
     numBytes = av_image_get_buffer_size(out_pix_fmt, pCodecCtx->width, pCodecCtx->height, 1);
 
-    // Allocate video frame
+    // Allocate the frame the decode thread decodes into
     pFrame=av_frame_alloc();
     if(pFrame==nullptr)
       return false;
-    // Allocate an AVFrame structure
-    pFrameOUT=av_frame_alloc();
-    if(pFrameOUT==nullptr)
-      return false;
-
-    // Assign appropriate parts of buffer to image planes in pFrameRGB
-    buffer = (uint8_t *)av_malloc(numBytes*sizeof(uint8_t));
-    if(buffer==nullptr)
-      return false;
 
-    av_image_fill_arrays (pFrameOUT->data, pFrameOUT->linesize, buffer, out_pix_fmt,
-              pCodecCtx->width, pCodecCtx->height, 1);
+    // Exposures are converted straight into the frame buffer, see getStreamFrame
+    if(!outputToFrameBuffer)
+    {
+        // Allocate an AVFrame structure
+        pFrameOUT=av_frame_alloc();
+        if(pFrameOUT==nullptr)
+          return false;
+
+        // Assign appropriate parts of buffer to image planes in pFrameRGB
+        buffer = (uint8_t *)av_malloc(numBytes*sizeof(uint8_t));
+        if(buffer==nullptr)
+          return false;
+
+        av_image_fill_arrays (pFrameOUT->data, pFrameOUT->linesize, buffer, out_pix_fmt,
+                  pCodecCtx->width, pCodecCtx->height, 1);
+    }
 
     // initialize SWS context for software scaling
     sws_ctx = sws_getContext( pCodecCtx->width, pCodecCtx->height,
@@ -1459,138 +1434,213 @@ bool indi_webcam::setupStreaming()
     PrimaryCCD.setFrameBufferSize(numBytes);
     PrimaryCCD.setResolution(pCodecCtx->width, pCodecCtx->height);
 
+    startDecoding();
     return true;
 }
 
 //This gets one image from the camera.
 //It is used for both the streaming and exposing algorithms
+//The decode thread has already read and decoded it, this only converts it to the output format.
 bool indi_webcam::getStreamFrame()
 {
-    AVPacket packet;
-    //If at first you don't succees to get a frame, try again.
-    int ret = -1;
-    while(ret < 0)
+    AVFrame *frame = frameQueue.pop();
+    while(frame == nullptr)
     {
-        ret = av_read_frame(pFormatCtx, &packet);
-        char errbuff[200];
-        av_make_error_string(errbuff, 200, ret);
-        if(ret < 0) // Negative return value means stream stopped
+        //The queue is only closed without a frame if decoding stopped
+        if(!decodeFailed)
+            return false;
+
+        DEBUG(INDI::Logger::DBG_SESSION, "Stream stopped, attempting to reconnect.");
+        stopDecoding();
+        if(!reconnectSource())
         {
-            DEBUGF(INDI::Logger::DBG_SESSION, "FFMPEG Error:%s, attempting to reconnect.", errbuff);
-            if(reconnectSource())
-            {
-                DEBUG(INDI::Logger::DBG_SESSION, "Device successfully reconnected.");
-                freeMemory();
-                //Try to set up streaming again, if there is an error, return
-                if(!setupStreaming())
-                {
-                    DEBUG(INDI::Logger::DBG_SESSION, "Error on Stream Setup.");
-                    return false;
-                }
-                //Flush it one more time because of the disconnect.
-                flush_frame_buffer();
-            }
-            else
-            {
-                DEBUG(INDI::Logger::DBG_SESSION, "Device did not reconnect after 10 tries.");
-                av_packet_unref(&packet);
-                return false;
-            }
-        }
-    }
-    if(packet.stream_index==videoStream) {
-        int ret;
-        ret = avcodec_send_packet(pCodecCtx, &packet);
-        char errbuff[200];
-        av_make_error_string(errbuff, 200, ret);
-        if (ret < 0) {
-            DEBUGF(INDI::Logger::DBG_SESSION, "Error sending a packet for decoding:%s",errbuff);
-            av_packet_unref(&packet);
+            DEBUG(INDI::Logger::DBG_SESSION, "Device did not reconnect after 10 tries.");
             return false;
         }
-        while (ret >= 0) {
-            ret = avcodec_receive_frame(pCodecCtx, pFrame);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
-                continue;
-            else if (ret < 0) {
-                DEBUG(INDI::Logger::DBG_SESSION, "Error during decoding");
-                av_packet_unref(&packet);
-                return false;
-            }
-            // We have a frame at that point
-            // Convert the image from its native format to our output format
-           sws_scale(sws_ctx, (uint8_t const * const *)pFrame->data,
-                pFrame->linesize, 0, pCodecCtx->height,
-                pFrameOUT->data, pFrameOUT->linesize);
-           av_packet_unref(&packet);
-           return true;
+        DEBUG(INDI::Logger::DBG_SESSION, "Device successfully reconnected.");
+        freeMemory();
+        //Try to set up streaming again, if there is an error, return
+        if(!setupStreaming())
+        {
+            DEBUG(INDI::Logger::DBG_SESSION, "Error on Stream Setup.");
+            return false;
         }
+        frame = frameQueue.pop();
+    }
 
+    uint8_t *dstData[4] = { nullptr };
+    int dstLinesize[4] = { 0 };
+    if(outputToFrameBuffer)
+    {
+        //GBRP planes are G, B, R while FITS wants R, G, B, so point each plane at its FITS position
+        uint8_t *frameBuffer = PrimaryCCD.getFrameBuffer();
+        int lineSize = pCodecCtx->width * PrimaryCCD.getBPP() / 8;
+        if(PrimaryCCD.getNAxis() == 3)
+        {
+            int planeSize = numBytes / 3;
+            dstData[0] = frameBuffer + planeSize;
+            dstData[1] = frameBuffer + planeSize * 2;
+            dstData[2] = frameBuffer;
+            dstLinesize[0] = dstLinesize[1] = dstLinesize[2] = lineSize;
+        }
+        else
+        {
+            dstData[0] = frameBuffer;
+            dstLinesize[0] = lineSize;
+        }
     }
-    return false;
+    else
+    {
+        std::copy(pFrameOUT->data, pFrameOUT->data + 4, dstData);
+        std::copy(pFrameOUT->linesize, pFrameOUT->linesize + 4, dstLinesize);
+    }
+
+    // Convert the image from its native format to our output format
+    sws_scale(sws_ctx, (uint8_t const * const *)frame->data,
+         frame->linesize, 0, pCodecCtx->height,
+         dstData, dstLinesize);
+    av_frame_free(&frame);
+    framesSent++;
+    return true;
 }
 
-//This will clear out the frame buffer of any unread frames.
+//This will clear out the frames decoded so far.
 //That way we are sure to get the latest frames when exposing
+//The decode thread already skipped the frames the device had buffered when it started.
 bool indi_webcam::flush_frame_buffer() {
 
-    int packetReceiveTime = -1;
+    size_t stale = frameQueue.drain();
+    framesDropped += stale;
+    DEBUGF(INDI::Logger::DBG_DEBUG, "Buffer Cleared of %zu stale frames.", stale);
+    return true;  //Buffer Cleared
+
+}
+
+//This is the decode thread, it reads packets at the rate of the camera and queues the decoded frames.
+void indi_webcam::run_decode()
+{
     //If the packet takes longer than this to receive, then it is probably not in the buffer.
-    //So at that point we want to stop dumping the buffer.
+    //Until then, packets are stale frames that were waiting in the device and are dropped.
     int timeout = atoi(bufferTimeout.c_str());
+    bool skippingStale = true;
+    int stale = 0;
 
-    int num = 0;
-    while(packetReceiveTime < timeout)
+    AVPacket packet;
+    while(decodeRunning)
     {
-        num++;
-        struct timeval then;
-        gettimeofday(&then, nullptr);
-
-        AVPacket packet;    
-
+        auto then = std::chrono::steady_clock::now();
         int ret = av_read_frame(pFormatCtx, &packet);
-        char errbuff[200];
-        av_make_error_string(errbuff, 200, ret);
-        if(ret < 0) // Return value less than 0 means stream stopped
+        if(ret < 0) // Negative return value means stream stopped, or stopDecoding interrupted the read
         {
-            DEBUGF(INDI::Logger::DBG_SESSION, "FFMPEG Error:%s, attempting to reconnect.", errbuff);
-            if(reconnectSource())
+            if(!interruptDecode)
             {
-                DEBUG(INDI::Logger::DBG_SESSION, "Device successfully reconnected.");
-                av_packet_unref(&packet);
-                freeMemory();
-                //Set up the stream, if there is an error, return
-                if(!setupStreaming())
-                {
-                    DEBUG(INDI::Logger::DBG_SESSION, "Error on Stream Setup.");
-                    freeMemory();
-                    return false;
-                }
-                //Need to flush the buffer again because of the reconnection.
-                if(flush_frame_buffer())
-                    return true;
-                return false;
+                char errbuff[200];
+                av_make_error_string(errbuff, 200, ret);
+                DEBUGF(INDI::Logger::DBG_SESSION, "FFMPEG Error:%s", errbuff);
+                decodeFailed = true;
             }
-            else
+            break;
+        }
+
+        if(skippingStale)
+        {
+            auto packetReceiveTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - then);
+            if(packetReceiveTime.count() < timeout)
             {
-                DEBUG(INDI::Logger::DBG_SESSION, "Device did not reconnect after 10 tries.");
+                stale++;
                 av_packet_unref(&packet);
-                return false;  //Buffer cleared but encountered connection error.
+                continue;
+            }
+            skippingStale = false;
+            framesDropped += stale;
+            DEBUGF(INDI::Logger::DBG_SESSION, "Buffer Cleared of %u stale frames.", stale);
+        }
+
+        if(packet.stream_index==videoStream) {
+            ret = avcodec_send_packet(pCodecCtx, &packet);
+            if (ret < 0) {
+                char errbuff[200];
+                av_make_error_string(errbuff, 200, ret);
+                DEBUGF(INDI::Logger::DBG_SESSION, "Error sending a packet for decoding:%s",errbuff);
+            }
+            while (ret >= 0) {
+                ret = avcodec_receive_frame(pCodecCtx, pFrame);
+                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                    break;
+                else if (ret < 0) {
+                    DEBUG(INDI::Logger::DBG_SESSION, "Error during decoding");
+                    break;
+                }
+                // We have a frame at that point, hand it over to the queue without copying the image
+                AVFrame *frame = av_frame_alloc();
+                av_frame_move_ref(frame, pFrame);
+                framesDecoded++;
+                if(frameQueue.push(frame))
+                    framesDropped++;
             }
         }
-        struct timeval now;
-        gettimeofday(&now, nullptr);
-        packetReceiveTime = now.tv_usec - then.tv_usec;
         av_packet_unref(&packet);
     }
-    DEBUGF(INDI::Logger::DBG_SESSION, "Buffer Cleared of %u stale frames.", num);
-    return true;  //Buffer Cleared
 
+    frameQueue.close();
+}
+
+void indi_webcam::startDecoding()
+{
+    std::lock_guard<std::mutex> lock(decodeThreadMutex);
+    if(decodeRunning)
+        return;
+
+    decodeFailed = false;
+    interruptDecode = false;
+    frameQueue.drain();
+    frameQueue.open();
+    decodeRunning = true;
+    decode_thread = std::thread(&indi_webcam::run_decode, this);
+}
+
+void indi_webcam::stopDecoding()
+{
+    std::lock_guard<std::mutex> lock(decodeThreadMutex);
+    if(decode_thread.joinable())
+    {
+        decodeRunning = false;
+        interruptDecode = true;
+        decode_thread.join();
+    }
+    decodeRunning = false;
+    interruptDecode = false;
+    framesDropped += frameQueue.drain();
+}
+
+//FFMpeg calls this while it blocks in av_read_frame, a non zero return aborts the read.
+int indi_webcam::decodeInterrupt(void *opaque)
+{
+    return static_cast<indi_webcam *>(opaque)->interruptDecode ? 1 : 0;
+}
+
+void indi_webcam::resetFrameCounters()
+{
+    framesDecoded = 0;
+    framesDropped = 0;
+    framesSent = 0;
+}
+
+void indi_webcam::updateFrameCounters()
+{
+    FrameCountersN[FRAME_COUNTER_DECODED].value = framesDecoded;
+    FrameCountersN[FRAME_COUNTER_DROPPED].value = framesDropped;
+    FrameCountersN[FRAME_COUNTER_SENT].value = framesSent;
+    FrameCountersNP.s = IPS_OK;
+    IDSetNumber(&FrameCountersNP, nullptr);
 }
 
 //This frees up the resources used for streaming/exposing
 void indi_webcam::freeMemory()
 {
+    // Stop the decode thread first, it uses pFrame
+    stopDecoding();
+
     // Free the sws_context
     if(sws_ctx)
         sws_freeContext(sws_ctx);
@@ -1618,6 +1668,7 @@ bool indi_webcam::saveConfigItems(FILE *fp)
     INDI::CCD::saveConfigItems(fp);
     IUSaveConfigSwitch(fp, &CaptureDeviceSelection);
     IUSaveConfigSwitch(fp, &RapidStackingSelection);
+    IUSaveConfigNumber(fp, &StackingSigmaNP);
     IUSaveConfigSwitch(fp, &OutputFormatSelection);
     IUSaveConfigText(fp, &HTTPInputOptionsP);
     IUSaveConfigText(fp, &InputOptionsTP);
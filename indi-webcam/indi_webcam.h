@@ -28,6 +28,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <indiccd.h>
 #include <stream/streammanager.h>
 
+#include "webcam_framequeue.h"
+#include "webcam_stacker.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,6 +44,8 @@ extern "C" {
 }
 #endif
 //#include <ctime>
+#include <atomic>
+#include <mutex>
 #include <thread>
 
 //These are required to check for AVFoundation Devices
@@ -94,7 +99,6 @@ private:
     //Related to exposures
     struct timeval ExpStart { 0, 0 };
     float ExposureRequest { 0 };
-    bool convertINDI_RGBtoFITS_RGB(uint8_t *originalImage, uint8_t *convertedImage);
 
     //These are related to how we change sources
     bool ConnectToSource(std::string device, std::string source, int framerate, std::string videosize, std::string htmlSource);
@@ -112,15 +116,21 @@ private:
 
     //webcam stacking.
     bool webcamStacking;
-    bool averaging;
-    float *stackBuffer;
-    int numberOfFramesInStack;
+    WebcamStacker::Mode stackingMode;
+    WebcamStacker stacker;
+    bool stackNeedsReset = false;
     bool addToStack();
     void copyFinalStackToPrimaryFrameBuffer();
-    void setImageDataValueFromFloat(int x, int y, float value, bool roundAnswer);
-    void setRGBImageDataValueFromFloat(int x, int y, int channel, float value, bool roundAnswer);
-    float getImageDataFloatValue(int x, int y);
-    float getRGBImageDataFloatValue(int x, int y, int channel);
+    INumber StackingSigmaN[1];
+    INumberVectorProperty StackingSigmaNP;
+    INumber StackingStatsN[3];
+    INumberVectorProperty StackingStatsNP;
+    enum
+    {
+        STACKING_STATS_FRAMES,
+        STACKING_STATS_FRAME_MS,
+        STACKING_STATS_THROUGHPUT
+    };
 
     //These are our device capture settings
     bool use16Bit = true;
@@ -167,6 +177,38 @@ private:
     bool getStreamFrame();
     bool flush_frame_buffer();
 
+    //Demuxing and decoding run on their own thread and feed the frame queue,
+    //conversion and sending happen on the thread that calls getStreamFrame.
+    WebcamFrameQueue frameQueue;
+    std::thread decode_thread;
+    //Disconnect and the capture thread can both stop decoding, only one of them joins
+    std::mutex decodeThreadMutex;
+    std::atomic_bool decodeRunning { false };
+    std::atomic_bool decodeFailed { false };
+    std::atomic_bool interruptDecode { false };
+    void startDecoding();
+    void stopDecoding();
+    void run_decode();
+    static int decodeInterrupt(void *opaque);
+
+    //Exposures convert straight into the CCD frame buffer, streaming into buffer
+    bool outputToFrameBuffer = false;
+
+    //Frame counters
+    std::atomic<uint64_t> framesDecoded { 0 };
+    std::atomic<uint64_t> framesDropped { 0 };
+    std::atomic<uint64_t> framesSent { 0 };
+    void resetFrameCounters();
+    void updateFrameCounters();
+    INumber FrameCountersN[3];
+    INumberVectorProperty FrameCountersNP;
+    enum
+    {
+        FRAME_COUNTER_DECODED,
+        FRAME_COUNTER_DROPPED,
+        FRAME_COUNTER_SENT
+    };
+
     //Related to streaming
     std::thread capture_thread;
     static void RunCaptureThread(indi_webcam *webcam);
@@ -0,0 +1,123 @@
+/*
+    Webcam stacker unit tests
+
+    Small synthetic stacks with a known result, split over several bands and threads.
+*/
+
+#include "webcam_stacker.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+// Enough rows for three bands of the minimum band height
+static const size_t WIDTH = 37;
+static const size_t ROWS = 96;
+
+static uint16_t basePixel(size_t i)
+{
+    return static_cast<uint16_t>(1000 + (i * 7) % 3000);
+}
+
+// Frame k of a stack around basePixel, +/- noise alternating per frame and per pixel
+static std::vector<uint16_t> noisyFrame(size_t k, int noise)
+{
+    std::vector<uint16_t> frame(WIDTH * ROWS);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = static_cast<uint16_t>(basePixel(i) + (((i + k) % 2) ? noise : -noise));
+    return frame;
+}
+
+TEST(WebcamStackerTest, average_16bit)
+{
+    WebcamStacker stacker;
+    stacker.setThreads(3);
+    stacker.reset(WebcamStacker::STACK_AVERAGE, WIDTH, ROWS, 16);
+
+    // base + k for k = 0..4 averages to base + 2
+    for (size_t k = 0; k < 5; k++)
+    {
+        std::vector<uint16_t> frame(WIDTH * ROWS);
+        for (size_t i = 0; i < frame.size(); i++)
+            frame[i] = static_cast<uint16_t>(basePixel(i) + k);
+        stacker.add(reinterpret_cast<const uint8_t *>(frame.data()));
+    }
+    EXPECT_EQ(stacker.frames(), 5u);
+
+    std::vector<uint16_t> result(WIDTH * ROWS, 0);
+    stacker.finish(reinterpret_cast<uint8_t *>(result.data()));
+    for (size_t i = 0; i < result.size(); i++)
+        ASSERT_EQ(result[i], basePixel(i) + 2) << "sample " << i;
+}
+
+TEST(WebcamStackerTest, integrate_8bit_clamps)
+{
+    WebcamStacker stacker;
+    stacker.setThreads(2);
+    stacker.reset(WebcamStacker::STACK_INTEGRATE, WIDTH, ROWS, 8);
+
+    std::vector<uint8_t> frame(WIDTH * ROWS);
+    for (size_t i = 0; i < frame.size(); i++)
+        frame[i] = static_cast<uint8_t>(i % 100);
+    for (int k = 0; k < 3; k++)
+        stacker.add(frame.data());
+
+    std::vector<uint8_t> result(WIDTH * ROWS, 0);
+    stacker.finish(result.data());
+    for (size_t i = 0; i < result.size(); i++)
+        ASSERT_EQ(result[i], std::min<int>(3 * (i % 100), 255)) << "sample " << i;
+}
+
+// A satellite crossing one frame is left out of the sigma clip mean, the average keeps it
+TEST(WebcamStackerTest, sigma_clip_rejects_outlier)
+{
+    const size_t satelliteFrame = 6;
+    const size_t satelliteRow = 50;
+
+    WebcamStacker clipped, averaged;
+    clipped.setThreads(3);
+    clipped.setSigma(2.5f);
+    clipped.reset(WebcamStacker::STACK_SIGMA_CLIP, WIDTH, ROWS, 16);
+    averaged.setThreads(3);
+    averaged.reset(WebcamStacker::STACK_AVERAGE, WIDTH, ROWS, 16);
+
+    for (size_t k = 0; k < 10; k++)
+    {
+        std::vector<uint16_t> frame = noisyFrame(k, 2);
+        if (k == satelliteFrame)
+            std::fill(frame.begin() + satelliteRow * WIDTH, frame.begin() + (satelliteRow + 1) * WIDTH, 60000);
+        clipped.add(reinterpret_cast<const uint8_t *>(frame.data()));
+        averaged.add(reinterpret_cast<const uint8_t *>(frame.data()));
+    }
+
+    std::vector<uint16_t> clipResult(WIDTH * ROWS, 0), averageResult(WIDTH * ROWS, 0);
+    clipped.finish(reinterpret_cast<uint8_t *>(clipResult.data()));
+    averaged.finish(reinterpret_cast<uint8_t *>(averageResult.data()));
+
+    for (size_t i = 0; i < clipResult.size(); i++)
+        ASSERT_LE(std::abs(clipResult[i] - basePixel(i)), 1) << "sample " << i;
+
+    // Without rejection the satellite row is far off
+    for (size_t i = satelliteRow * WIDTH; i < (satelliteRow + 1) * WIDTH; i++)
+        ASSERT_GT(averageResult[i] - basePixel(i), 5000) << "sample " << i;
+}
+
+// Without outliers the sigma clip result is the plain mean
+TEST(WebcamStackerTest, sigma_clip_matches_mean)
+{
+    WebcamStacker clipped;
+    clipped.setThreads(1);
+    clipped.reset(WebcamStacker::STACK_SIGMA_CLIP, WIDTH, ROWS, 16);
+
+    for (size_t k = 0; k < 8; k++)
+    {
+        std::vector<uint16_t> frame = noisyFrame(k, 3);
+        clipped.add(reinterpret_cast<const uint8_t *>(frame.data()));
+    }
+
+    std::vector<uint16_t> result(WIDTH * ROWS, 0);
+    clipped.finish(reinterpret_cast<uint8_t *>(result.data()));
+    for (size_t i = 0; i < result.size(); i++)
+        ASSERT_EQ(result[i], basePixel(i)) << "sample " << i;
+}
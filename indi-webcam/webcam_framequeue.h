@@ -0,0 +1,126 @@
+/*
+INDI Webcam CCD Driver
+
+This driver is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavutil/frame.h>
+#ifdef __cplusplus
+}
+#endif
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief The WebcamFrameQueue class hands decoded frames from the decode thread to the
+ * thread that converts and sends them.
+ *
+ * The queue owns the frames it holds. It is bounded: pushing onto a full queue frees the
+ * oldest frame, so the camera is always read at its own rate and a slow consumer only
+ * ever sees the newest frames.
+ */
+class WebcamFrameQueue
+{
+    public:
+        explicit WebcamFrameQueue(size_t capacity = 4) : m_Capacity(capacity) {}
+        ~WebcamFrameQueue()
+        {
+            drain();
+        }
+
+        /** Reopen the queue after close(), must not be called while a consumer is waiting */
+        void open()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Closed = false;
+        }
+
+        /**
+         * @brief Producer: take ownership of @a frame.
+         * @return true if the oldest queued frame had to be dropped to make room.
+         */
+        bool push(AVFrame *frame)
+        {
+            bool dropped = false;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (m_Frames.size() >= m_Capacity)
+                {
+                    av_frame_free(&m_Frames.front());
+                    m_Frames.pop_front();
+                    dropped = true;
+                }
+                m_Frames.push_back(frame);
+            }
+            m_Condition.notify_one();
+            return dropped;
+        }
+
+        /**
+         * @brief Consumer: wait for the next frame, the caller owns it and frees it with av_frame_free.
+         * @return nullptr once the queue is closed and empty.
+         */
+        AVFrame *pop()
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this]()
+            {
+                return m_Closed || !m_Frames.empty();
+            });
+            if (m_Frames.empty())
+                return nullptr;
+
+            AVFrame *frame = m_Frames.front();
+            m_Frames.pop_front();
+            return frame;
+        }
+
+        /** Free every queued frame, returns how many were dropped */
+        size_t drain()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            size_t count = m_Frames.size();
+            for (AVFrame *frame : m_Frames)
+                av_frame_free(&frame);
+            m_Frames.clear();
+            return count;
+        }
+
+        /** Wake up the consumer, pop() returns nullptr once the remaining frames are taken */
+        void close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Closed = true;
+            }
+            m_Condition.notify_all();
+        }
+
+    private:
+        size_t m_Capacity;
+        std::deque<AVFrame *> m_Frames;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Closed { false };
+};
@@ -0,0 +1,238 @@
+/*
+INDI Webcam CCD Driver
+
+This driver is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "webcam_stacker.h"
+
+#include <pixelkernels.h>
+
+#include <algorithm>
+#include <chrono>
+
+// Frames always accepted by the sigma clip before there is a variance to test against.
+// Past that, the variance has a floor of one ADU so a perfectly flat pixel is not frozen.
+static const uint32_t SIGMA_CLIP_WARMUP_FRAMES = 3;
+// Below this many rows per band the thread handoff costs more than it saves
+static const size_t MIN_ROWS_PER_BAND = 32;
+
+WebcamStacker::WebcamStacker()
+{
+    setThreads(0);
+}
+
+WebcamStacker::~WebcamStacker()
+{
+    stopWorkers();
+}
+
+void WebcamStacker::setThreads(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::min(std::max(std::thread::hardware_concurrency(), 1u), 8u);
+
+    stopWorkers();
+
+    m_StopWorkers = false;
+    m_Bands = threads;
+    for (unsigned band = 1; band < threads; band++)
+        m_Workers.emplace_back(&WebcamStacker::workerLoop, this, band, m_JobGeneration);
+}
+
+void WebcamStacker::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_PoolMutex);
+        m_StopWorkers = true;
+    }
+    m_JobCondition.notify_all();
+
+    for (auto &worker : m_Workers)
+        worker.join();
+    m_Workers.clear();
+}
+
+void WebcamStacker::workerLoop(size_t band, uint64_t seenGeneration)
+{
+    for (;;)
+    {
+        std::function<void(size_t, size_t)> job;
+        {
+            std::unique_lock<std::mutex> lock(m_PoolMutex);
+            m_JobCondition.wait(lock, [&]()
+            {
+                return m_StopWorkers || m_JobGeneration != seenGeneration;
+            });
+            if (m_StopWorkers)
+                return;
+            seenGeneration = m_JobGeneration;
+            job = m_Job;
+        }
+
+        job(m_Rows * band / m_Bands, m_Rows * (band + 1) / m_Bands);
+
+        {
+            std::lock_guard<std::mutex> lock(m_PoolMutex);
+            if (--m_JobsPending == 0)
+                m_DoneCondition.notify_one();
+        }
+    }
+}
+
+void WebcamStacker::runBands(const std::function<void(size_t, size_t)> &job)
+{
+    if (m_Bands == 1 || m_Rows < m_Bands * MIN_ROWS_PER_BAND)
+    {
+        job(0, m_Rows);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_PoolMutex);
+        m_Job = job;
+        m_JobsPending = m_Workers.size();
+        m_JobGeneration++;
+    }
+    m_JobCondition.notify_all();
+
+    job(0, m_Rows / m_Bands);
+
+    std::unique_lock<std::mutex> lock(m_PoolMutex);
+    m_DoneCondition.wait(lock, [this]()
+    {
+        return m_JobsPending == 0;
+    });
+}
+
+void WebcamStacker::reset(Mode mode, size_t width, size_t rows, int bpp)
+{
+    m_Mode   = mode;
+    m_Width  = width;
+    m_Rows   = rows;
+    m_BPP    = bpp;
+    m_Frames = 0;
+    m_LastAddMs  = 0;
+    m_TotalAddMs = 0;
+
+    const size_t samples = width * rows;
+    m_Stack.assign(samples, 0.0f);
+    if (mode == STACK_SIGMA_CLIP)
+    {
+        m_M2.assign(samples, 0.0f);
+        m_Count.assign(samples, 0.0f);
+    }
+    else
+    {
+        std::vector<float>().swap(m_M2);
+        std::vector<float>().swap(m_Count);
+    }
+}
+
+void WebcamStacker::release()
+{
+    std::vector<float>().swap(m_Stack);
+    std::vector<float>().swap(m_M2);
+    std::vector<float>().swap(m_Count);
+    m_Frames = 0;
+}
+
+template <typename T>
+void WebcamStacker::addBand(const T *frame, size_t firstRow, size_t lastRow)
+{
+    const size_t offset = firstRow * m_Width;
+    const size_t samples = (lastRow - firstRow) * m_Width;
+
+    if (m_Mode != STACK_SIGMA_CLIP)
+    {
+        PixelKernels::accumulate(frame + offset, m_Stack.data() + offset, samples);
+        return;
+    }
+
+    PixelKernels::sigmaClip(frame + offset, m_Stack.data() + offset, m_M2.data() + offset, m_Count.data() + offset, samples,
+                            m_Sigma * m_Sigma, m_Frames < SIGMA_CLIP_WARMUP_FRAMES);
+}
+
+template <typename T>
+void WebcamStacker::finishBand(T *frame, size_t firstRow, size_t lastRow)
+{
+    const size_t offset = firstRow * m_Width;
+    const size_t samples = (lastRow - firstRow) * m_Width;
+
+    // The sigma clip stack already holds the mean
+    float scale = 1.0f;
+    if (m_Mode == STACK_AVERAGE && m_Frames > 0)
+        scale = 1.0f / m_Frames;
+
+    PixelKernels::storeScaled(m_Stack.data() + offset, scale, frame + offset, samples);
+}
+
+void WebcamStacker::add(const uint8_t *frame)
+{
+    if (m_Stack.empty())
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+
+    if (m_BPP == 16)
+    {
+        const uint16_t *samples = reinterpret_cast<const uint16_t *>(frame);
+        runBands([this, samples](size_t firstRow, size_t lastRow)
+        {
+            addBand(samples, firstRow, lastRow);
+        });
+    }
+    else
+    {
+        runBands([this, frame](size_t firstRow, size_t lastRow)
+        {
+            addBand(frame, firstRow, lastRow);
+        });
+    }
+
+    m_Frames++;
+    m_LastAddMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_TotalAddMs += m_LastAddMs;
+}
+
+void WebcamStacker::finish(uint8_t *frame)
+{
+    if (m_Stack.empty() || m_Frames == 0)
+        return;
+
+    if (m_BPP == 16)
+    {
+        uint16_t *samples = reinterpret_cast<uint16_t *>(frame);
+        runBands([this, samples](size_t firstRow, size_t lastRow)
+        {
+            finishBand(samples, firstRow, lastRow);
+        });
+    }
+    else
+    {
+        runBands([this, frame](size_t firstRow, size_t lastRow)
+        {
+            finishBand(frame, firstRow, lastRow);
+        });
+    }
+}
+
+double WebcamStacker::megapixelsPerSecond() const
+{
+    if (m_TotalAddMs <= 0)
+        return 0;
+    return (static_cast<double>(m_Width) * m_Rows * m_Frames) / (m_TotalAddMs * 1000.0);
+}
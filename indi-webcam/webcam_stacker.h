@@ -0,0 +1,134 @@
+/*
+INDI Webcam CCD Driver
+
+This driver is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The WebcamStacker class adds frames into a running stack for rapid stacking.
+ *
+ * Frames are contiguous 8 or 16 bit samples (mono, or the three planes of a FITS RGB
+ * frame one after the other). Every frame is split into row bands that are added on a
+ * small pool of worker threads, each band using the vectorized pixel kernels.
+ *
+ * Sigma clipping keeps a running mean and variance per sample (Welford), so memory
+ * stays at three floats per sample no matter how many frames go into the stack.
+ * A sample more than sigma standard deviations away from the running mean of that
+ * pixel is left out, which drops satellites, planes and hot flashes.
+ */
+class WebcamStacker
+{
+    public:
+        enum Mode
+        {
+            STACK_INTEGRATE,
+            STACK_AVERAGE,
+            STACK_SIGMA_CLIP
+        };
+
+        WebcamStacker();
+        ~WebcamStacker();
+
+        /** Number of threads used per frame, 0 picks one per core (up to 8). Call before reset(). */
+        void setThreads(unsigned threads);
+        unsigned threads() const
+        {
+            return m_Bands;
+        }
+
+        /** Rejection threshold of the sigma clip mode, in standard deviations */
+        void setSigma(float sigma)
+        {
+            m_Sigma = sigma;
+        }
+
+        /**
+         * @brief Start a new stack.
+         * @param width samples per row
+         * @param rows rows in the frame, height times the number of planes for RGB
+         * @param bpp 8 or 16
+         */
+        void reset(Mode mode, size_t width, size_t rows, int bpp);
+
+        /** Add a frame, the buffer holds width * rows samples of the size given to reset() */
+        void add(const uint8_t *frame);
+
+        /** Write the stack result over @a frame, same layout as add() */
+        void finish(uint8_t *frame);
+
+        /** Drop the stack buffers */
+        void release();
+
+        uint32_t frames() const
+        {
+            return m_Frames;
+        }
+
+        /** Time add() took for the last frame, in milliseconds */
+        double lastAddMs() const
+        {
+            return m_LastAddMs;
+        }
+
+        /** Average stacking throughput over the current stack, in megapixels (samples) per second */
+        double megapixelsPerSecond() const;
+
+    private:
+        /** Run job(firstRow, lastRow) for every band, the calling thread takes the first band */
+        void runBands(const std::function<void(size_t, size_t)> &job);
+        void workerLoop(size_t band, uint64_t seenGeneration);
+        void stopWorkers();
+
+        template <typename T> void addBand(const T *frame, size_t firstRow, size_t lastRow);
+        template <typename T> void finishBand(T *frame, size_t firstRow, size_t lastRow);
+
+        Mode m_Mode { STACK_INTEGRATE };
+        size_t m_Width { 0 };
+        size_t m_Rows { 0 };
+        int m_BPP { 8 };
+        float m_Sigma { 2.5f };
+
+        // Sum, or running mean for sigma clip
+        std::vector<float> m_Stack;
+        // Sigma clip only: sum of squared deviations and accepted sample count
+        std::vector<float> m_M2;
+        std::vector<float> m_Count;
+
+        uint32_t m_Frames { 0 };
+        double m_LastAddMs { 0 };
+        double m_TotalAddMs { 0 };
+
+        // Worker pool, band 0 always runs on the caller
+        size_t m_Bands { 1 };
+        std::vector<std::thread> m_Workers;
+        std::mutex m_PoolMutex;
+        std::condition_variable m_JobCondition;
+        std::condition_variable m_DoneCondition;
+        std::function<void(size_t, size_t)> m_Job;
+        uint64_t m_JobGeneration { 0 };
+        size_t m_JobsPending { 0 };
+        bool m_StopWorkers { false };
+};
@@ -689,6 +689,55 @@ int pslr_get_buffer(pslr_handle_t h, int bufno, pslr_buffer_type type, int resol
     return PSLR_OK;
 }
 
+/*
+ * Same as pslr_get_buffer, but downloads into a caller owned buffer which is only
+ * reallocated when the image does not fit, so it can be reused between frames.
+ * Blocks are read straight into place without an intermediate copy.
+ */
+int pslr_get_buffer_into(pslr_handle_t h, int bufno, pslr_buffer_type type, int resolution,
+                         uint8_t **ppData, uint32_t *pCapacity, uint32_t *pLen) {
+    DPRINT("[C]\tpslr_get_buffer_into()\n");
+    int ret;
+    ret = pslr_buffer_open(h, bufno, type, resolution);
+    if ( ret != PSLR_OK ) {
+        return ret;
+    }
+
+    uint32_t size = pslr_buffer_get_size(h);
+    if (size == 0) {
+        // nothing stored yet
+        pslr_buffer_close(h);
+        return PSLR_READ_ERROR;
+    }
+    if (*ppData == NULL || *pCapacity < size) {
+        uint8_t *buf = realloc(*ppData, size);
+        if (!buf) {
+            pslr_buffer_close(h);
+            return PSLR_NO_MEMORY;
+        }
+        *ppData = buf;
+        *pCapacity = size;
+    }
+
+    uint32_t bufpos = 0;
+    while (bufpos < size) {
+        uint32_t bytes = pslr_buffer_read(h, *ppData + bufpos, size - bufpos);
+        if (bytes == 0) {
+            break;
+        }
+        bufpos += bytes;
+    }
+    pslr_buffer_close(h);
+    if ( bufpos != size ) {
+        return PSLR_READ_ERROR;
+    }
+    if (pLen) {
+        *pLen = size;
+    }
+
+    return PSLR_OK;
+}
+
 int pslr_set_progress_callback(pslr_handle_t h, pslr_progress_callback_t cb, uintptr_t user_data) {
     INDI_UNUSED(h);
     INDI_UNUSED(user_data);
@@ -138,6 +138,8 @@ char *collect_settings_info( pslr_handle_t h, pslr_settings settings );
 
 int pslr_get_buffer(pslr_handle_t h, int bufno, pslr_buffer_type type, int resolution,
                     uint8_t **pdata, uint32_t *pdatalen);
+int pslr_get_buffer_into(pslr_handle_t h, int bufno, pslr_buffer_type type, int resolution,
+                         uint8_t **pdata, uint32_t *pcapacity, uint32_t *pdatalen);
 
 int pslr_set_progress_callback(pslr_handle_t h, pslr_progress_callback_t cb,
                                uintptr_t user_data);
@@ -0,0 +1,106 @@
+/*
+    Pixel Kernels benchmark
+
+    Runs every kernel on a frame of the given size with each supported instruction set.
+
+    Usage: pixelkernels_benchmark [width height [iterations]]
+*/
+
+#include "pixelkernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace PixelKernels;
+
+static double measure(int iterations, const std::function<void()> &kernel)
+{
+    kernel(); // warm up caches and page in buffers
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        kernel();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::milli>(elapsed).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t width  = argc > 2 ? std::strtoul(argv[1], nullptr, 10) : 4144;
+    size_t height = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2822;
+    int iterations = argc > 3 ? std::atoi(argv[3]) : 20;
+    size_t pixels = width * height;
+
+    std::vector<uint8_t> rgb8(pixels * 3), planar8(pixels * 3);
+    std::vector<uint16_t> rgb16(pixels * 3), planar16(pixels * 3);
+    std::vector<uint16_t> mono16(pixels), binned16(pixels / 4 + 1);
+    std::vector<uint8_t> mono8(pixels), binned8(pixels / 4 + 1);
+    std::vector<float> stack(pixels), m2(pixels), count(pixels);
+    std::vector<uint8_t> packed(pixels * 3 / 2 + 5);
+
+    for (size_t i = 0; i < rgb16.size(); i++)
+    {
+        rgb8[i]  = static_cast<uint8_t>(i * 7);
+        rgb16[i] = static_cast<uint16_t>(i * 13);
+    }
+    for (size_t i = 0; i < pixels; i++)
+    {
+        mono8[i]  = static_cast<uint8_t>(i);
+        mono16[i] = static_cast<uint16_t>(i & 0x0FFF);
+    }
+    for (size_t i = 0; i < packed.size(); i++)
+        packed[i] = static_cast<uint8_t>(i * 31);
+
+    std::printf("Frame %zux%zu, %d iterations, times in ms per frame\n\n", width, height, iterations);
+    std::printf("%-20s", "Kernel");
+    std::vector<Isa> isas;
+    for (Isa isa : { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_NEON })
+        if (selectIsa(isa))
+        {
+            isas.push_back(isa);
+            std::printf("%10s", toString(isa));
+        }
+    std::printf("\n");
+
+    struct Case
+    {
+        const char *name;
+        std::function<void()> run;
+    };
+
+    const Case cases[] =
+    {
+        { "deinterleave3 u8",  [&] { deinterleave3(rgb8.data(), &planar8[0], &planar8[pixels], &planar8[pixels * 2], pixels); } },
+        { "deinterleave3 u16", [&] { deinterleave3(rgb16.data(), &planar16[0], &planar16[pixels], &planar16[pixels * 2], pixels); } },
+        { "swapChannels02",    [&] { swapChannels02(rgb8.data(), pixels); } },
+        { "shiftLeft 4",       [&] { shiftLeft(mono16.data(), pixels, 4); } },
+        { "fromBigEndian",     [&] { fromBigEndian(mono16.data(), mono16.data(), pixels); } },
+        { "bin 2x2 u8",        [&] { bin(mono8.data(), binned8.data(), width, height, 2, 2); } },
+        { "bin 2x2 u16",       [&] { bin(mono16.data(), binned16.data(), width, height, 2, 2); } },
+        { "bin 3x3 u16",       [&] { bin(mono16.data(), binned16.data(), width, height, 3, 3); } },
+        { "accumulate u8",     [&] { accumulate(mono8.data(), stack.data(), pixels); } },
+        { "accumulate u16",    [&] { accumulate(mono16.data(), stack.data(), pixels); } },
+        { "storeScaled u8",    [&] { storeScaled(stack.data(), 1.0f / 64, mono8.data(), pixels); } },
+        { "storeScaled u16",   [&] { storeScaled(stack.data(), 1.0f / 64, mono16.data(), pixels); } },
+        { "sigmaClip u16",     [&] { sigmaClip(mono16.data(), stack.data(), m2.data(), count.data(), pixels, 6.25f, false); } },
+        { "unpackRaw10",       [&] { unpackRaw10(packed.data(), mono16.data(), pixels / 4); } },
+        { "unpackRaw12",       [&] { unpackRaw12(packed.data(), mono16.data(), pixels / 2); } },
+    };
+
+    for (const auto &c : cases)
+    {
+        std::printf("%-20s", c.name);
+        for (Isa isa : isas)
+        {
+            selectIsa(isa);
+            std::printf("%10.3f", measure(iterations, c.run));
+        }
+        std::printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+    Pixel Kernels
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "kerneldispatch.h"
+
+#if defined(__arm__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace PixelKernels
+{
+
+bool cpuHas(CpuFeature feature)
+{
+    switch (feature)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case CPU_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case CPU_SSSE3:
+            return __builtin_cpu_supports("ssse3");
+        case CPU_AVX:
+            return __builtin_cpu_supports("avx");
+        case CPU_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__aarch64__)
+        case CPU_NEON:
+            return true;
+#elif defined(__arm__) && defined(__linux__)
+        // Only the NEON translation units are built with -mfpu=neon, ask the kernel what the CPU has
+        case CPU_NEON:
+            return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
+        default:
+            return false;
+    }
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+    Pixel Kernels
+
+    Runtime selection of vectorized kernels, shared by the kernel libraries.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <mutex>
+#include <vector>
+
+namespace PixelKernels
+{
+
+/** CPU features a kernel variant can depend on */
+enum CpuFeature
+{
+    CPU_SSE2,
+    CPU_SSSE3,
+    CPU_AVX,
+    CPU_AVX2,
+    CPU_NEON
+};
+
+/**
+ * @brief Check the running CPU, not the compiler flags of the caller.
+ * NEON is always there on aarch64 and read from AT_HWCAP on 32 bit ARM Linux.
+ */
+bool cpuHas(CpuFeature feature);
+
+/**
+ * @brief Picks a table of kernel function pointers for the running CPU.
+ *
+ * Every table is built once and never modified after it was published, so get() is a
+ * single atomic load after the first call and select() can switch tables while kernels run.
+ *
+ * @tparam Table struct of function pointers
+ * @tparam Isa enum of the instruction sets, numbered 0 to Count - 1
+ */
+template <typename Table, typename Isa, size_t Count>
+class Dispatcher
+{
+    public:
+        /** Fill the table of an instruction set, false if the CPU or the build lacks it */
+        typedef bool (*Builder)(Isa isa, Table &table);
+
+        /** @param preference instruction sets to try on first use, best first, the last one must always build */
+        Dispatcher(Builder build, std::initializer_list<Isa> preference) : m_Build(build), m_Preference(preference) {}
+
+        const Table &get()
+        {
+            std::call_once(m_Once, &Dispatcher::selectBest, this);
+            return *m_Active.load(std::memory_order_acquire);
+        }
+
+        Isa activeIsa()
+        {
+            get();
+            return m_ActiveIsa.load();
+        }
+
+        /** Force an instruction set, false if it is not available and the current one is kept */
+        bool select(Isa isa)
+        {
+            // Let the automatic choice run first so it cannot override this one later
+            std::call_once(m_Once, &Dispatcher::selectBest, this);
+
+            const Table *table = tableFor(isa);
+            if (table == nullptr)
+                return false;
+
+            m_ActiveIsa = isa;
+            m_Active.store(table, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        const Table *tableFor(Isa isa)
+        {
+            std::lock_guard<std::mutex> lock(m_BuildMutex);
+            if (!m_Built[isa])
+            {
+                if (!m_Build(isa, m_Tables[isa]))
+                    return nullptr;
+                m_Built[isa] = true;
+            }
+            return &m_Tables[isa];
+        }
+
+        void selectBest()
+        {
+            for (Isa isa : m_Preference)
+            {
+                const Table *table = tableFor(isa);
+                if (table != nullptr)
+                {
+                    m_ActiveIsa = isa;
+                    m_Active.store(table, std::memory_order_release);
+                    return;
+                }
+            }
+        }
+
+        Builder m_Build;
+        std::vector<Isa> m_Preference;
+        Table m_Tables[Count];
+        bool m_Built[Count] {};
+        std::mutex m_BuildMutex;
+        std::once_flag m_Once;
+        std::atomic<const Table *> m_Active { nullptr };
+        std::atomic<Isa> m_ActiveIsa { Isa() };
+};
+
+}
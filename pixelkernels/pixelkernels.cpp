@@ -0,0 +1,394 @@
+/*
+    Pixel Kernels
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pixelkernels_p.h"
+#include "kerneldispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace PixelKernels
+{
+
+/////////////////////////////////////////////////////////////////////////////
+/// Scalar reference implementations
+/////////////////////////////////////////////////////////////////////////////
+namespace Scalar
+{
+
+void deinterleave3_u8(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; i++)
+    {
+        *c0++ = *src++;
+        *c1++ = *src++;
+        *c2++ = *src++;
+    }
+}
+
+void deinterleave3_u16(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; i++)
+    {
+        *c0++ = *src++;
+        *c1++ = *src++;
+        *c2++ = *src++;
+    }
+}
+
+void swapChannels02(uint8_t *buffer, size_t pixels)
+{
+    for (size_t i = 0; i < pixels * 3; i += 3)
+        std::swap(buffer[i], buffer[i + 2]);
+}
+
+void shiftLeft(uint16_t *buffer, size_t count, unsigned bits)
+{
+    for (size_t i = 0; i < count; i++)
+        buffer[i] <<= bits;
+}
+
+void byteSwap(const uint16_t *src, uint16_t *dst, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        dst[i] = static_cast<uint16_t>((src[i] << 8) | (src[i] >> 8));
+}
+
+template <typename T>
+static void binT(const T *src, T *dst, size_t width, size_t height, unsigned binX, unsigned binY)
+{
+    const size_t outW = width / binX;
+    const size_t outH = height / binY;
+    const uint32_t maxValue = std::numeric_limits<T>::max();
+
+    for (size_t y = 0; y < outH; y++)
+    {
+        const T *row = src + y * binY * width;
+        for (size_t x = 0; x < outW; x++)
+        {
+            uint32_t sum = 0;
+            for (unsigned by = 0; by < binY; by++)
+                for (unsigned bx = 0; bx < binX; bx++)
+                    sum += row[by * width + x * binX + bx];
+
+            dst[y * outW + x] = static_cast<T>(std::min(sum, maxValue));
+        }
+    }
+}
+
+void bin_u8(const uint8_t *src, uint8_t *dst, size_t width, size_t height, unsigned binX, unsigned binY)
+{
+    binT(src, dst, width, height, binX, binY);
+}
+
+void bin_u16(const uint16_t *src, uint16_t *dst, size_t width, size_t height, unsigned binX, unsigned binY)
+{
+    binT(src, dst, width, height, binX, binY);
+}
+
+void bin2x2_u8(const uint8_t *src, uint8_t *dst, size_t width, size_t height)
+{
+    binT(src, dst, width, height, 2, 2);
+}
+
+void bin2x2_u16(const uint16_t *src, uint16_t *dst, size_t width, size_t height)
+{
+    binT(src, dst, width, height, 2, 2);
+}
+
+void accumulate_u8(const uint8_t *src, float *acc, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        acc[i] += src[i];
+}
+
+void accumulate_u16(const uint16_t *src, float *acc, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        acc[i] += src[i];
+}
+
+// std::nearbyint follows the default rounding mode, the same round to nearest even
+// the vector conversions use.
+template <typename T>
+static void storeScaledT(const float *acc, float scale, T *dst, size_t count)
+{
+    const float maxValue = std::numeric_limits<T>::max();
+    for (size_t i = 0; i < count; i++)
+    {
+        float v = std::min(std::max(acc[i] * scale, 0.0f), maxValue);
+        dst[i] = static_cast<T>(std::nearbyint(v));
+    }
+}
+
+void storeScaled_u8(const float *acc, float scale, uint8_t *dst, size_t count)
+{
+    storeScaledT(acc, scale, dst, count);
+}
+
+void storeScaled_u16(const float *acc, float scale, uint16_t *dst, size_t count)
+{
+    storeScaledT(acc, scale, dst, count);
+}
+
+// The vector variants compute every step in this order and blend the accepted lanes
+template <typename T>
+static void sigmaClipT(const T *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup)
+{
+    for (size_t i = 0; i < samples; i++)
+    {
+        const float x = src[i];
+        const float delta = x - mean[i];
+        const float variance = std::max(m2[i] / std::max(count[i], 1.0f), 1.0f);
+        if (warmup || delta * delta <= sigma2 * variance)
+        {
+            const float n = count[i] + 1.0f;
+            const float newMean = mean[i] + delta / n;
+            m2[i] += delta * (x - newMean);
+            mean[i] = newMean;
+            count[i] = n;
+        }
+    }
+}
+
+void sigmaClip_u8(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup)
+{
+    sigmaClipT(src, mean, m2, count, samples, sigma2, warmup);
+}
+
+void sigmaClip_u16(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup)
+{
+    sigmaClipT(src, mean, m2, count, samples, sigma2, warmup);
+}
+
+void unpackRaw10(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    for (size_t i = 0; i < groups; i++, src += 5, dst += 4)
+    {
+        const unsigned low = src[4];
+        dst[0] = static_cast<uint16_t>(src[0] << 8 | ((low << 6) & 0xC0));
+        dst[1] = static_cast<uint16_t>(src[1] << 8 | ((low << 4) & 0xC0));
+        dst[2] = static_cast<uint16_t>(src[2] << 8 | ((low << 2) & 0xC0));
+        dst[3] = static_cast<uint16_t>(src[3] << 8 | (low & 0xC0));
+    }
+}
+
+void unpackRaw12(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    for (size_t i = 0; i < groups; i++, src += 3, dst += 2)
+    {
+        const unsigned low = src[2];
+        dst[0] = static_cast<uint16_t>(src[0] << 8 | ((low << 4) & 0xF0));
+        dst[1] = static_cast<uint16_t>(src[1] << 8 | (low & 0xF0));
+    }
+}
+
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Dispatcher
+/////////////////////////////////////////////////////////////////////////////
+static Kernels scalarKernels()
+{
+    Kernels k;
+    k.deinterleave3_u8  = Scalar::deinterleave3_u8;
+    k.deinterleave3_u16 = Scalar::deinterleave3_u16;
+    k.swapChannels02    = Scalar::swapChannels02;
+    k.shiftLeft         = Scalar::shiftLeft;
+    k.byteSwap          = Scalar::byteSwap;
+    k.bin2x2_u8         = Scalar::bin2x2_u8;
+    k.bin2x2_u16        = Scalar::bin2x2_u16;
+    k.accumulate_u8     = Scalar::accumulate_u8;
+    k.accumulate_u16    = Scalar::accumulate_u16;
+    k.storeScaled_u8    = Scalar::storeScaled_u8;
+    k.storeScaled_u16   = Scalar::storeScaled_u16;
+    k.sigmaClip_u8      = Scalar::sigmaClip_u8;
+    k.sigmaClip_u16     = Scalar::sigmaClip_u16;
+    k.unpackRaw10       = Scalar::unpackRaw10;
+    k.unpackRaw12       = Scalar::unpackRaw12;
+    return k;
+}
+
+static bool cpuSupports(Isa isa)
+{
+    switch (isa)
+    {
+        case ISA_SCALAR:
+            return true;
+        case ISA_SSE2:
+            return cpuHas(CPU_SSE2);
+        case ISA_AVX2:
+            return cpuHas(CPU_AVX2) && cpuHas(CPU_SSSE3);
+        case ISA_NEON:
+            return cpuHas(CPU_NEON);
+    }
+    return false;
+}
+
+static bool buildKernels(Isa isa, Kernels &k)
+{
+    if (!cpuSupports(isa))
+        return false;
+
+    k = scalarKernels();
+    switch (isa)
+    {
+        case ISA_SCALAR:
+            return true;
+        case ISA_SSE2:
+            return initSse2(k);
+        case ISA_AVX2:
+            // AVX2 only covers some kernels, SSE2 fills the rest
+            return initSse2(k) && initAvx2(k);
+        case ISA_NEON:
+            return initNeon(k);
+    }
+    return false;
+}
+
+static Dispatcher<Kernels, Isa, ISA_NEON + 1> &dispatcher()
+{
+    static Dispatcher<Kernels, Isa, ISA_NEON + 1> instance(buildKernels, {ISA_AVX2, ISA_SSE2, ISA_NEON, ISA_SCALAR});
+    return instance;
+}
+
+static const Kernels &kernels()
+{
+    return dispatcher().get();
+}
+
+Isa activeIsa()
+{
+    return dispatcher().activeIsa();
+}
+
+const char *toString(Isa isa)
+{
+    switch (isa)
+    {
+        case ISA_SCALAR: return "Scalar";
+        case ISA_SSE2:   return "SSE2";
+        case ISA_AVX2:   return "AVX2";
+        case ISA_NEON:   return "NEON";
+    }
+    return "Unknown";
+}
+
+bool selectIsa(Isa isa)
+{
+    return dispatcher().select(isa);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Public API
+/////////////////////////////////////////////////////////////////////////////
+void deinterleave3(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels)
+{
+    kernels().deinterleave3_u8(src, c0, c1, c2, pixels);
+}
+
+void deinterleave3(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels)
+{
+    kernels().deinterleave3_u16(src, c0, c1, c2, pixels);
+}
+
+void swapChannels02(uint8_t *buffer, size_t pixels)
+{
+    kernels().swapChannels02(buffer, pixels);
+}
+
+void shiftLeft(uint16_t *buffer, size_t count, unsigned bits)
+{
+    if (bits == 0)
+        return;
+    kernels().shiftLeft(buffer, count, bits);
+}
+
+void byteSwap(const uint16_t *src, uint16_t *dst, size_t count)
+{
+    kernels().byteSwap(src, dst, count);
+}
+
+void fromBigEndian(const uint16_t *src, uint16_t *dst, size_t count)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if (src != dst)
+        std::copy(src, src + count, dst);
+#else
+    byteSwap(src, dst, count);
+#endif
+}
+
+void bin(const uint8_t *src, uint8_t *dst, size_t width, size_t height, unsigned binX, unsigned binY)
+{
+    if (binX == 2 && binY == 2)
+        kernels().bin2x2_u8(src, dst, width, height);
+    else
+        Scalar::bin_u8(src, dst, width, height, binX, binY);
+}
+
+void bin(const uint16_t *src, uint16_t *dst, size_t width, size_t height, unsigned binX, unsigned binY)
+{
+    if (binX == 2 && binY == 2)
+        kernels().bin2x2_u16(src, dst, width, height);
+    else
+        Scalar::bin_u16(src, dst, width, height, binX, binY);
+}
+
+void accumulate(const uint8_t *src, float *acc, size_t count)
+{
+    kernels().accumulate_u8(src, acc, count);
+}
+
+void accumulate(const uint16_t *src, float *acc, size_t count)
+{
+    kernels().accumulate_u16(src, acc, count);
+}
+
+void storeScaled(const float *acc, float scale, uint8_t *dst, size_t count)
+{
+    kernels().storeScaled_u8(acc, scale, dst, count);
+}
+
+void storeScaled(const float *acc, float scale, uint16_t *dst, size_t count)
+{
+    kernels().storeScaled_u16(acc, scale, dst, count);
+}
+
+void sigmaClip(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup)
+{
+    kernels().sigmaClip_u8(src, mean, m2, count, samples, sigma2, warmup);
+}
+
+void sigmaClip(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup)
+{
+    kernels().sigmaClip_u16(src, mean, m2, count, samples, sigma2, warmup);
+}
+
+void unpackRaw10(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    kernels().unpackRaw10(src, dst, groups);
+}
+
+void unpackRaw12(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    kernels().unpackRaw12(src, dst, groups);
+}
+
+}
@@ -0,0 +1,118 @@
+/*
+    Pixel Kernels
+
+    Vectorized pixel format conversions shared by the camera drivers.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Pixel loops used by several camera drivers.
+ *
+ * Every kernel has a scalar implementation and, where it pays off, SSE2, AVX2 or NEON
+ * variants. The fastest variant supported by the running CPU is picked on first use.
+ * All variants produce bit-identical results.
+ */
+namespace PixelKernels
+{
+
+/** Instruction set used by the dispatcher */
+enum Isa
+{
+    ISA_SCALAR,
+    ISA_SSE2,
+    ISA_AVX2,
+    ISA_NEON
+};
+
+/** Return the instruction set selected for this CPU */
+Isa activeIsa();
+
+/** Human readable name of an instruction set */
+const char *toString(Isa isa);
+
+/**
+ * @brief Force the dispatcher to a given instruction set, used by tests and benchmarks.
+ * @return false if the CPU or the build does not support it, the current selection is kept.
+ */
+bool selectIsa(Isa isa);
+
+/**
+ * @brief Split interleaved 3 channel pixels into planes.
+ * Pixel i is read from src[3i], src[3i+1], src[3i+2] and written to c0[i], c1[i], c2[i].
+ * Pass the planes in swapped order to convert BGR to planar RGB.
+ */
+void deinterleave3(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels);
+void deinterleave3(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels);
+
+/** Swap the first and third channel of packed 3 byte pixels in place (RGB24 <-> BGR24) */
+void swapChannels02(uint8_t *buffer, size_t pixels);
+
+/** Shift each 16 bit sample left by @a bits, used to stretch 12/14 bit data to 16 bit */
+void shiftLeft(uint16_t *buffer, size_t count, unsigned bits);
+
+/** Swap the two bytes of each 16 bit sample, @a src and @a dst may be the same buffer */
+void byteSwap(const uint16_t *src, uint16_t *dst, size_t count);
+
+/** Convert big endian 16 bit samples to host order, a copy on big endian hosts */
+void fromBigEndian(const uint16_t *src, uint16_t *dst, size_t count);
+
+/**
+ * @brief Software binning, sums binX x binY blocks and saturates at the type maximum.
+ * @param width source width in pixels, the trailing columns that do not fill a block are ignored
+ * @param height source height in pixels, the trailing rows that do not fill a block are ignored
+ * @note @a dst must hold (width / binX) * (height / binY) pixels and may be the same buffer as @a src.
+ */
+void bin(const uint8_t *src, uint8_t *dst, size_t width, size_t height, unsigned binX, unsigned binY);
+void bin(const uint16_t *src, uint16_t *dst, size_t width, size_t height, unsigned binX, unsigned binY);
+
+/** Add each sample to a float accumulator, acc[i] += src[i], used for frame stacking */
+void accumulate(const uint8_t *src, float *acc, size_t count);
+void accumulate(const uint16_t *src, float *acc, size_t count);
+
+/**
+ * @brief Store acc[i] * scale back as integer samples.
+ * Values are rounded to nearest, halves to even, and clamped to the range of the type.
+ */
+void storeScaled(const float *acc, float scale, uint8_t *dst, size_t count);
+void storeScaled(const float *acc, float scale, uint16_t *dst, size_t count);
+
+/**
+ * @brief One running sigma clip step (Welford) per sample.
+ * A sample is accepted if @a warmup is set or (src - mean)^2 <= sigma2 * max(m2 / count, 1), in which
+ * case count is incremented and mean and m2 are updated. Rejected samples leave the state untouched.
+ * @note Start from zeroed state, and pass warmup for at least the first frame.
+ */
+void sigmaClip(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup);
+void sigmaClip(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup);
+
+/**
+ * @brief Unpack MIPI RAW10, 5 bytes per group of 4 pixels: 4 high bytes, then the 2 low bits of each pixel
+ * starting at bit 0. Output is left aligned to 16 bits, (high << 8) | (low << 6).
+ */
+void unpackRaw10(const uint8_t *src, uint16_t *dst, size_t groups);
+
+/**
+ * @brief Unpack Broadcom RAW12, 3 bytes per group of 2 pixels: 2 high bytes, then the low nibbles
+ * (first pixel in bits 0-3). Output is left aligned to 16 bits, (high << 8) | (low << 4).
+ */
+void unpackRaw12(const uint8_t *src, uint16_t *dst, size_t groups);
+
+}
@@ -0,0 +1,357 @@
+/*
+    Pixel Kernels
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pixelkernels_p.h"
+
+// This file is built with -mavx2 and only entered after the dispatcher checked the CPU.
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+#include <mutex>
+
+namespace PixelKernels
+{
+
+// Shuffle masks, mask[channel][register] gathers one channel out of three 16 byte registers
+static uint8_t deinterleaveU8Masks[3][3][16];
+static uint8_t deinterleaveU16Masks[3][3][16];
+static uint8_t swapMasks[3][3][16];
+
+static void buildDeinterleaveMasks(uint8_t masks[3][3][16], unsigned sampleSize)
+{
+    for (unsigned channel = 0; channel < 3; channel++)
+        for (unsigned reg = 0; reg < 3; reg++)
+            for (unsigned j = 0; j < 16; j++)
+            {
+                unsigned sample = j / sampleSize;
+                unsigned srcByte = (3 * sample + channel) * sampleSize + j % sampleSize;
+                masks[channel][reg][j] = (srcByte / 16 == reg) ? srcByte % 16 : 0x80;
+            }
+}
+
+static void buildMasks()
+{
+    buildDeinterleaveMasks(deinterleaveU8Masks, 1);
+    buildDeinterleaveMasks(deinterleaveU16Masks, 2);
+
+    // 16 pixels span three registers, output register r gathers its bytes from all three
+    for (unsigned r = 0; r < 3; r++)
+        for (unsigned reg = 0; reg < 3; reg++)
+            for (unsigned j = 0; j < 16; j++)
+            {
+                unsigned dstByte = 16 * r + j;
+                unsigned srcByte = (dstByte / 3) * 3 + (2 - dstByte % 3);
+                swapMasks[r][reg][j] = (srcByte / 16 == reg) ? srcByte % 16 : 0x80;
+            }
+}
+
+static inline __m128i gather3(const uint8_t mask[3][16], __m128i a, __m128i b, __m128i c)
+{
+    __m128i r = _mm_shuffle_epi8(a, _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask[0])));
+    r = _mm_or_si128(r, _mm_shuffle_epi8(b, _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask[1]))));
+    return _mm_or_si128(r, _mm_shuffle_epi8(c, _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask[2]))));
+}
+
+static void deinterleave3U8Avx2(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        const __m128i *p = reinterpret_cast<const __m128i *>(src + 3 * i);
+        __m128i a = _mm_loadu_si128(p);
+        __m128i b = _mm_loadu_si128(p + 1);
+        __m128i c = _mm_loadu_si128(p + 2);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c0 + i), gather3(deinterleaveU8Masks[0], a, b, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c1 + i), gather3(deinterleaveU8Masks[1], a, b, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c2 + i), gather3(deinterleaveU8Masks[2], a, b, c));
+    }
+    Scalar::deinterleave3_u8(src + 3 * i, c0 + i, c1 + i, c2 + i, pixels - i);
+}
+
+static void deinterleave3U16Avx2(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        const __m128i *p = reinterpret_cast<const __m128i *>(src + 3 * i);
+        __m128i a = _mm_loadu_si128(p);
+        __m128i b = _mm_loadu_si128(p + 1);
+        __m128i c = _mm_loadu_si128(p + 2);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c0 + i), gather3(deinterleaveU16Masks[0], a, b, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c1 + i), gather3(deinterleaveU16Masks[1], a, b, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(c2 + i), gather3(deinterleaveU16Masks[2], a, b, c));
+    }
+    Scalar::deinterleave3_u16(src + 3 * i, c0 + i, c1 + i, c2 + i, pixels - i);
+}
+
+static void swapChannels02Avx2(uint8_t *buffer, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        __m128i *p = reinterpret_cast<__m128i *>(buffer + 3 * i);
+        __m128i a = _mm_loadu_si128(p);
+        __m128i b = _mm_loadu_si128(p + 1);
+        __m128i c = _mm_loadu_si128(p + 2);
+
+        _mm_storeu_si128(p,     gather3(swapMasks[0], a, b, c));
+        _mm_storeu_si128(p + 1, gather3(swapMasks[1], a, b, c));
+        _mm_storeu_si128(p + 2, gather3(swapMasks[2], a, b, c));
+    }
+    Scalar::swapChannels02(buffer + 3 * i, pixels - i);
+}
+
+static void shiftLeftAvx2(uint16_t *buffer, size_t count, unsigned bits)
+{
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(bits));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(buffer + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(buffer + i), _mm256_sll_epi16(v, shift));
+    }
+    Scalar::shiftLeft(buffer + i, count - i, bits);
+}
+
+static void byteSwapAvx2(const uint16_t *src, uint16_t *dst, size_t count)
+{
+    const __m256i mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    Scalar::byteSwap(src + i, dst + i, count - i);
+}
+
+static void accumulateU8Avx2(const uint8_t *src, float *acc, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m256 s0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+        __m256 s1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+
+        _mm256_storeu_ps(acc + i,     _mm256_add_ps(_mm256_loadu_ps(acc + i),     s0));
+        _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), s1));
+    }
+    Scalar::accumulate_u8(src + i, acc + i, count - i);
+}
+
+static void accumulateU16Avx2(const uint16_t *src, float *acc, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8));
+        __m256 s0 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v0));
+        __m256 s1 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v1));
+
+        _mm256_storeu_ps(acc + i,     _mm256_add_ps(_mm256_loadu_ps(acc + i),     s0));
+        _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), s1));
+    }
+    Scalar::accumulate_u16(src + i, acc + i, count - i);
+}
+
+static void storeScaledU8Avx2(const float *acc, float scale, uint8_t *dst, size_t count)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vmin   = _mm256_setzero_ps();
+    const __m256 vmax   = _mm256_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256 v0 = _mm256_mul_ps(_mm256_loadu_ps(acc + i), vscale);
+        __m256 v1 = _mm256_mul_ps(_mm256_loadu_ps(acc + i + 8), vscale);
+        __m256i q0 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v0, vmin), vmax));
+        __m256i q1 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v1, vmin), vmax));
+
+        // Packs work per 128 bit lane, narrow each half separately to keep the order
+        __m128i w0 = _mm_packs_epi32(_mm256_castsi256_si128(q0), _mm256_extracti128_si256(q0, 1));
+        __m128i w1 = _mm_packs_epi32(_mm256_castsi256_si128(q1), _mm256_extracti128_si256(q1, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(w0, w1));
+    }
+    Scalar::storeScaled_u8(acc + i, scale, dst + i, count - i);
+}
+
+static void storeScaledU16Avx2(const float *acc, float scale, uint16_t *dst, size_t count)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 vmin   = _mm256_setzero_ps();
+    const __m256 vmax   = _mm256_set1_ps(65535.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256 v0 = _mm256_mul_ps(_mm256_loadu_ps(acc + i), vscale);
+        __m256 v1 = _mm256_mul_ps(_mm256_loadu_ps(acc + i + 8), vscale);
+        __m256i q0 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v0, vmin), vmax));
+        __m256i q1 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v1, vmin), vmax));
+
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(q0, q1), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), packed);
+    }
+    Scalar::storeScaled_u16(acc + i, scale, dst + i, count - i);
+}
+
+// Eight samples of the Scalar::sigmaClip step
+static inline void sigmaClipStepAvx2(__m256 x, float *mean, float *m2, float *count, __m256 sigma2, __m256 warmup)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 mu = _mm256_loadu_ps(mean);
+    __m256 sq = _mm256_loadu_ps(m2);
+    __m256 n  = _mm256_loadu_ps(count);
+
+    __m256 delta = _mm256_sub_ps(x, mu);
+    __m256 variance = _mm256_max_ps(_mm256_div_ps(sq, _mm256_max_ps(n, one)), one);
+    __m256 accept = _mm256_or_ps(warmup, _mm256_cmp_ps(_mm256_mul_ps(delta, delta), _mm256_mul_ps(sigma2, variance), _CMP_LE_OQ));
+
+    __m256 newN = _mm256_add_ps(n, one);
+    __m256 newMu = _mm256_add_ps(mu, _mm256_div_ps(delta, newN));
+    __m256 newSq = _mm256_add_ps(sq, _mm256_mul_ps(delta, _mm256_sub_ps(x, newMu)));
+
+    _mm256_storeu_ps(mean,  _mm256_blendv_ps(mu, newMu, accept));
+    _mm256_storeu_ps(m2,    _mm256_blendv_ps(sq, newSq, accept));
+    _mm256_storeu_ps(count, _mm256_blendv_ps(n, newN, accept));
+}
+
+static void sigmaClipU8Avx2(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2,
+                            bool warmup)
+{
+    const __m256 vsigma2 = _mm256_set1_ps(sigma2);
+    const __m256 vwarmup = _mm256_castsi256_ps(_mm256_set1_epi32(warmup ? -1 : 0));
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i));
+        sigmaClipStepAvx2(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)), mean + i, m2 + i, count + i, vsigma2, vwarmup);
+    }
+    Scalar::sigmaClip_u8(src + i, mean + i, m2 + i, count + i, samples - i, sigma2, warmup);
+}
+
+static void sigmaClipU16Avx2(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2,
+                             bool warmup)
+{
+    const __m256 vsigma2 = _mm256_set1_ps(sigma2);
+    const __m256 vwarmup = _mm256_castsi256_ps(_mm256_set1_epi32(warmup ? -1 : 0));
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        sigmaClipStepAvx2(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(v)), mean + i, m2 + i, count + i, vsigma2, vwarmup);
+    }
+    Scalar::sigmaClip_u16(src + i, mean + i, m2 + i, count + i, samples - i, sigma2, warmup);
+}
+
+// Byte shuffles for the raw unpackers, 0x80 clears the byte. Each 128 bit lane unpacks 8 pixels:
+// the high byte of every pixel goes to the top of its word, the low bits byte to the bottom.
+static void unpackRaw10Avx2(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    const __m256i highShuffle = _mm256_setr_epi8(
+                                    -128, 0, -128, 1, -128, 2, -128, 3, -128, 5, -128, 6, -128, 7, -128, 8,
+                                    -128, 0, -128, 1, -128, 2, -128, 3, -128, 5, -128, 6, -128, 7, -128, 8);
+    const __m256i lowShuffle = _mm256_setr_epi8(
+                                   4, -128, 4, -128, 4, -128, 4, -128, 9, -128, 9, -128, 9, -128, 9, -128,
+                                   4, -128, 4, -128, 4, -128, 4, -128, 9, -128, 9, -128, 9, -128, 9, -128);
+    const __m256i lowScale = _mm256_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1);
+    const __m256i lowMask = _mm256_set1_epi16(0x00C0);
+
+    // Four groups per step, the second 16 byte load reads 6 bytes past them
+    size_t i = 0;
+    for (; i + 6 <= groups; i += 4, src += 20, dst += 16)
+    {
+        __m256i v = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 10)), 1);
+
+        __m256i high = _mm256_shuffle_epi8(v, highShuffle);
+        __m256i low = _mm256_and_si256(_mm256_mullo_epi16(_mm256_shuffle_epi8(v, lowShuffle), lowScale), lowMask);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_or_si256(high, low));
+    }
+    Scalar::unpackRaw10(src, dst, groups - i);
+}
+
+static void unpackRaw12Avx2(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    const __m256i highShuffle = _mm256_setr_epi8(
+                                    -128, 0, -128, 1, -128, 3, -128, 4, -128, 6, -128, 7, -128, 9, -128, 10,
+                                    -128, 0, -128, 1, -128, 3, -128, 4, -128, 6, -128, 7, -128, 9, -128, 10);
+    const __m256i lowShuffle = _mm256_setr_epi8(
+                                   2, -128, 2, -128, 5, -128, 5, -128, 8, -128, 8, -128, 11, -128, 11, -128,
+                                   2, -128, 2, -128, 5, -128, 5, -128, 8, -128, 8, -128, 11, -128, 11, -128);
+    const __m256i lowScale = _mm256_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1);
+    const __m256i lowMask = _mm256_set1_epi16(0x00F0);
+
+    // Eight groups per step, the second 16 byte load reads 4 bytes past them
+    size_t i = 0;
+    for (; i + 10 <= groups; i += 8, src += 24, dst += 16)
+    {
+        __m256i v = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))),
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 12)), 1);
+
+        __m256i high = _mm256_shuffle_epi8(v, highShuffle);
+        __m256i low = _mm256_and_si256(_mm256_mullo_epi16(_mm256_shuffle_epi8(v, lowShuffle), lowScale), lowMask);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_or_si256(high, low));
+    }
+    Scalar::unpackRaw12(src, dst, groups - i);
+}
+
+bool initAvx2(Kernels &k)
+{
+    static std::once_flag masksBuilt;
+    std::call_once(masksBuilt, buildMasks);
+
+    k.deinterleave3_u8  = deinterleave3U8Avx2;
+    k.deinterleave3_u16 = deinterleave3U16Avx2;
+    k.swapChannels02    = swapChannels02Avx2;
+    k.shiftLeft         = shiftLeftAvx2;
+    k.byteSwap          = byteSwapAvx2;
+    k.accumulate_u8     = accumulateU8Avx2;
+    k.accumulate_u16    = accumulateU16Avx2;
+    k.storeScaled_u8    = storeScaledU8Avx2;
+    k.storeScaled_u16   = storeScaledU16Avx2;
+    k.sigmaClip_u8      = sigmaClipU8Avx2;
+    k.sigmaClip_u16     = sigmaClipU16Avx2;
+    k.unpackRaw10       = unpackRaw10Avx2;
+    k.unpackRaw12       = unpackRaw12Avx2;
+    return true;
+}
+
+}
+
+#else
+
+namespace PixelKernels
+{
+
+bool initAvx2(Kernels &)
+{
+    return false;
+}
+
+}
+
+#endif
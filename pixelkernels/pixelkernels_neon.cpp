@@ -0,0 +1,348 @@
+/*
+    Pixel Kernels
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pixelkernels_p.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+namespace PixelKernels
+{
+
+static void deinterleave3U8Neon(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        uint8x16x3_t v = vld3q_u8(src + 3 * i);
+        vst1q_u8(c0 + i, v.val[0]);
+        vst1q_u8(c1 + i, v.val[1]);
+        vst1q_u8(c2 + i, v.val[2]);
+    }
+    Scalar::deinterleave3_u8(src + 3 * i, c0 + i, c1 + i, c2 + i, pixels - i);
+}
+
+static void deinterleave3U16Neon(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8)
+    {
+        uint16x8x3_t v = vld3q_u16(src + 3 * i);
+        vst1q_u16(c0 + i, v.val[0]);
+        vst1q_u16(c1 + i, v.val[1]);
+        vst1q_u16(c2 + i, v.val[2]);
+    }
+    Scalar::deinterleave3_u16(src + 3 * i, c0 + i, c1 + i, c2 + i, pixels - i);
+}
+
+static void swapChannels02Neon(uint8_t *buffer, size_t pixels)
+{
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16)
+    {
+        uint8x16x3_t v = vld3q_u8(buffer + 3 * i);
+        uint8x16_t tmp = v.val[0];
+        v.val[0] = v.val[2];
+        v.val[2] = tmp;
+        vst3q_u8(buffer + 3 * i, v);
+    }
+    Scalar::swapChannels02(buffer + 3 * i, pixels - i);
+}
+
+static void shiftLeftNeon(uint16_t *buffer, size_t count, unsigned bits)
+{
+    const int16x8_t shift = vdupq_n_s16(static_cast<int16_t>(bits));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        vst1q_u16(buffer + i, vshlq_u16(vld1q_u16(buffer + i), shift));
+    Scalar::shiftLeft(buffer + i, count - i, bits);
+}
+
+static void byteSwapNeon(const uint16_t *src, uint16_t *dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x16_t v = vreinterpretq_u8_u16(vld1q_u16(src + i));
+        vst1q_u16(dst + i, vreinterpretq_u16_u8(vrev16q_u8(v)));
+    }
+    Scalar::byteSwap(src + i, dst + i, count - i);
+}
+
+// Saturating adds in this order equal min(sum, max), see pixelkernels_sse2.cpp
+
+static void bin2x2U8Neon(const uint8_t *src, uint8_t *dst, size_t width, size_t height)
+{
+    const size_t outW = width / 2;
+    const size_t outH = height / 2;
+
+    for (size_t y = 0; y < outH; y++)
+    {
+        const uint8_t *row0 = src + 2 * y * width;
+        const uint8_t *row1 = row0 + width;
+        uint8_t *out = dst + y * outW;
+
+        size_t x = 0;
+        for (; x + 16 <= outW; x += 16)
+        {
+            uint8x16x2_t a = vld2q_u8(row0 + 2 * x);
+            uint8x16x2_t b = vld2q_u8(row1 + 2 * x);
+            uint8x16_t sum = vqaddq_u8(vqaddq_u8(a.val[0], b.val[0]), vqaddq_u8(a.val[1], b.val[1]));
+            vst1q_u8(out + x, sum);
+        }
+
+        for (; x < outW; x++)
+        {
+            unsigned sum = row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+            out[x] = static_cast<uint8_t>(sum > 0xFF ? 0xFF : sum);
+        }
+    }
+}
+
+static void bin2x2U16Neon(const uint16_t *src, uint16_t *dst, size_t width, size_t height)
+{
+    const size_t outW = width / 2;
+    const size_t outH = height / 2;
+
+    for (size_t y = 0; y < outH; y++)
+    {
+        const uint16_t *row0 = src + 2 * y * width;
+        const uint16_t *row1 = row0 + width;
+        uint16_t *out = dst + y * outW;
+
+        size_t x = 0;
+        for (; x + 8 <= outW; x += 8)
+        {
+            uint16x8x2_t a = vld2q_u16(row0 + 2 * x);
+            uint16x8x2_t b = vld2q_u16(row1 + 2 * x);
+            uint16x8_t sum = vqaddq_u16(vqaddq_u16(a.val[0], b.val[0]), vqaddq_u16(a.val[1], b.val[1]));
+            vst1q_u16(out + x, sum);
+        }
+
+        for (; x < outW; x++)
+        {
+            uint32_t sum = row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+            out[x] = static_cast<uint16_t>(sum > 0xFFFF ? 0xFFFF : sum);
+        }
+    }
+}
+
+static void accumulateU8Neon(const uint8_t *src, float *acc, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(src + i);
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+
+        float32x4_t s0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo)));
+        float32x4_t s1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo)));
+        float32x4_t s2 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi)));
+        float32x4_t s3 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi)));
+
+        vst1q_f32(acc + i,      vaddq_f32(vld1q_f32(acc + i),      s0));
+        vst1q_f32(acc + i + 4,  vaddq_f32(vld1q_f32(acc + i + 4),  s1));
+        vst1q_f32(acc + i + 8,  vaddq_f32(vld1q_f32(acc + i + 8),  s2));
+        vst1q_f32(acc + i + 12, vaddq_f32(vld1q_f32(acc + i + 12), s3));
+    }
+    Scalar::accumulate_u8(src + i, acc + i, count - i);
+}
+
+static void accumulateU16Neon(const uint16_t *src, float *acc, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(src + i);
+        float32x4_t s0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+        float32x4_t s1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+
+        vst1q_f32(acc + i,     vaddq_f32(vld1q_f32(acc + i),     s0));
+        vst1q_f32(acc + i + 4, vaddq_f32(vld1q_f32(acc + i + 4), s1));
+    }
+    Scalar::accumulate_u16(src + i, acc + i, count - i);
+}
+
+#if defined(__aarch64__)
+// vcvtnq rounds to nearest even and vdivq is exact, ARMv7 NEON has neither so it keeps
+// the scalar store and sigma clip
+
+static void storeScaledU8Neon(const float *acc, float scale, uint8_t *dst, size_t count)
+{
+    const float32x4_t vmin = vdupq_n_f32(0.0f);
+    const float32x4_t vmax = vdupq_n_f32(255.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        float32x4_t v0 = vmulq_n_f32(vld1q_f32(acc + i), scale);
+        float32x4_t v1 = vmulq_n_f32(vld1q_f32(acc + i + 4), scale);
+        uint32x4_t q0 = vcvtnq_u32_f32(vminq_f32(vmaxq_f32(v0, vmin), vmax));
+        uint32x4_t q1 = vcvtnq_u32_f32(vminq_f32(vmaxq_f32(v1, vmin), vmax));
+        uint16x8_t w = vcombine_u16(vmovn_u32(q0), vmovn_u32(q1));
+        vst1_u8(dst + i, vmovn_u16(w));
+    }
+    Scalar::storeScaled_u8(acc + i, scale, dst + i, count - i);
+}
+
+static void storeScaledU16Neon(const float *acc, float scale, uint16_t *dst, size_t count)
+{
+    const float32x4_t vmin = vdupq_n_f32(0.0f);
+    const float32x4_t vmax = vdupq_n_f32(65535.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        float32x4_t v0 = vmulq_n_f32(vld1q_f32(acc + i), scale);
+        float32x4_t v1 = vmulq_n_f32(vld1q_f32(acc + i + 4), scale);
+        uint32x4_t q0 = vcvtnq_u32_f32(vminq_f32(vmaxq_f32(v0, vmin), vmax));
+        uint32x4_t q1 = vcvtnq_u32_f32(vminq_f32(vmaxq_f32(v1, vmin), vmax));
+        vst1q_u16(dst + i, vcombine_u16(vmovn_u32(q0), vmovn_u32(q1)));
+    }
+    Scalar::storeScaled_u16(acc + i, scale, dst + i, count - i);
+}
+
+// Four samples of the Scalar::sigmaClip step
+static inline void sigmaClipStepNeon(float32x4_t x, float *mean, float *m2, float *count, float sigma2, uint32x4_t warmup)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t mu = vld1q_f32(mean);
+    float32x4_t sq = vld1q_f32(m2);
+    float32x4_t n  = vld1q_f32(count);
+
+    float32x4_t delta = vsubq_f32(x, mu);
+    float32x4_t variance = vmaxq_f32(vdivq_f32(sq, vmaxq_f32(n, one)), one);
+    uint32x4_t accept = vorrq_u32(warmup, vcleq_f32(vmulq_f32(delta, delta), vmulq_n_f32(variance, sigma2)));
+
+    float32x4_t newN = vaddq_f32(n, one);
+    float32x4_t newMu = vaddq_f32(mu, vdivq_f32(delta, newN));
+    float32x4_t newSq = vaddq_f32(sq, vmulq_f32(delta, vsubq_f32(x, newMu)));
+
+    vst1q_f32(mean,  vbslq_f32(accept, newMu, mu));
+    vst1q_f32(m2,    vbslq_f32(accept, newSq, sq));
+    vst1q_f32(count, vbslq_f32(accept, newN, n));
+}
+
+static void sigmaClipU8Neon(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2,
+                            bool warmup)
+{
+    const uint32x4_t vwarmup = vdupq_n_u32(warmup ? 0xFFFFFFFF : 0);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        uint16x8_t v = vmovl_u8(vld1_u8(src + i));
+        sigmaClipStepNeon(vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), mean + i, m2 + i, count + i, sigma2, vwarmup);
+        sigmaClipStepNeon(vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), mean + i + 4, m2 + i + 4, count + i + 4, sigma2,
+                          vwarmup);
+    }
+    Scalar::sigmaClip_u8(src + i, mean + i, m2 + i, count + i, samples - i, sigma2, warmup);
+}
+
+static void sigmaClipU16Neon(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2,
+                             bool warmup)
+{
+    const uint32x4_t vwarmup = vdupq_n_u32(warmup ? 0xFFFFFFFF : 0);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        uint16x8_t v = vld1q_u16(src + i);
+        sigmaClipStepNeon(vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), mean + i, m2 + i, count + i, sigma2, vwarmup);
+        sigmaClipStepNeon(vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), mean + i + 4, m2 + i + 4, count + i + 4, sigma2,
+                          vwarmup);
+    }
+    Scalar::sigmaClip_u16(src + i, mean + i, m2 + i, count + i, samples - i, sigma2, warmup);
+}
+#endif
+
+static void unpackRaw10Neon(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    static const uint8_t highIndex[8] = { 0, 1, 2, 3, 5, 6, 7, 8 };
+    static const uint8_t lowIndex[8]  = { 4, 4, 4, 4, 9, 9, 9, 9 };
+    static const int16_t lowShift[8]  = { 6, 4, 2, 0, 6, 4, 2, 0 };
+    const uint8x8_t high = vld1_u8(highIndex);
+    const uint8x8_t low = vld1_u8(lowIndex);
+    const int16x8_t shift = vld1q_s16(lowShift);
+    const uint16x8_t lowMask = vdupq_n_u16(0x00C0);
+
+    // Two groups per step, the 16 byte load reads 6 bytes past them
+    size_t i = 0;
+    for (; i + 4 <= groups; i += 2, src += 10, dst += 8)
+    {
+        uint8x16_t v = vld1q_u8(src);
+        uint8x8x2_t table = {{ vget_low_u8(v), vget_high_u8(v) }};
+
+        uint16x8_t out = vshll_n_u8(vtbl2_u8(table, high), 8);
+        out = vorrq_u16(out, vandq_u16(vshlq_u16(vmovl_u8(vtbl2_u8(table, low)), shift), lowMask));
+        vst1q_u16(dst, out);
+    }
+    Scalar::unpackRaw10(src, dst, groups - i);
+}
+
+static void unpackRaw12Neon(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    const uint8x8_t nibbleMask = vdup_n_u8(0xF0);
+
+    size_t i = 0;
+    for (; i + 8 <= groups; i += 8, src += 24, dst += 16)
+    {
+        uint8x8x3_t g = vld3_u8(src);
+        uint16x8x2_t out;
+        out.val[0] = vorrq_u16(vshll_n_u8(g.val[0], 8), vmovl_u8(vshl_n_u8(g.val[2], 4)));
+        out.val[1] = vorrq_u16(vshll_n_u8(g.val[1], 8), vmovl_u8(vand_u8(g.val[2], nibbleMask)));
+        vst2q_u16(dst, out);
+    }
+    Scalar::unpackRaw12(src, dst, groups - i);
+}
+
+bool initNeon(Kernels &k)
+{
+    k.deinterleave3_u8  = deinterleave3U8Neon;
+    k.deinterleave3_u16 = deinterleave3U16Neon;
+    k.swapChannels02    = swapChannels02Neon;
+    k.shiftLeft         = shiftLeftNeon;
+    k.byteSwap          = byteSwapNeon;
+    k.bin2x2_u8         = bin2x2U8Neon;
+    k.bin2x2_u16        = bin2x2U16Neon;
+    k.accumulate_u8     = accumulateU8Neon;
+    k.accumulate_u16    = accumulateU16Neon;
+    k.unpackRaw10       = unpackRaw10Neon;
+    k.unpackRaw12       = unpackRaw12Neon;
+#if defined(__aarch64__)
+    k.storeScaled_u8    = storeScaledU8Neon;
+    k.storeScaled_u16   = storeScaledU16Neon;
+    k.sigmaClip_u8      = sigmaClipU8Neon;
+    k.sigmaClip_u16     = sigmaClipU16Neon;
+#endif
+    return true;
+}
+
+}
+
+#else
+
+namespace PixelKernels
+{
+
+bool initNeon(Kernels &)
+{
+    return false;
+}
+
+}
+
+#endif
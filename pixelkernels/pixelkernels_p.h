@@ -0,0 +1,72 @@
+/*
+    Pixel Kernels
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include "pixelkernels.h"
+
+namespace PixelKernels
+{
+
+/** Dispatch table, each instruction set overrides the entries it implements */
+struct Kernels
+{
+    void (*deinterleave3_u8)(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels);
+    void (*deinterleave3_u16)(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels);
+    void (*swapChannels02)(uint8_t *buffer, size_t pixels);
+    void (*shiftLeft)(uint16_t *buffer, size_t count, unsigned bits);
+    void (*byteSwap)(const uint16_t *src, uint16_t *dst, size_t count);
+    void (*bin2x2_u8)(const uint8_t *src, uint8_t *dst, size_t width, size_t height);
+    void (*bin2x2_u16)(const uint16_t *src, uint16_t *dst, size_t width, size_t height);
+    void (*accumulate_u8)(const uint8_t *src, float *acc, size_t count);
+    void (*accumulate_u16)(const uint16_t *src, float *acc, size_t count);
+    void (*storeScaled_u8)(const float *acc, float scale, uint8_t *dst, size_t count);
+    void (*storeScaled_u16)(const float *acc, float scale, uint16_t *dst, size_t count);
+    void (*sigmaClip_u8)(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup);
+    void (*sigmaClip_u16)(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup);
+    void (*unpackRaw10)(const uint8_t *src, uint16_t *dst, size_t groups);
+    void (*unpackRaw12)(const uint8_t *src, uint16_t *dst, size_t groups);
+};
+
+namespace Scalar
+{
+void deinterleave3_u8(const uint8_t *src, uint8_t *c0, uint8_t *c1, uint8_t *c2, size_t pixels);
+void deinterleave3_u16(const uint16_t *src, uint16_t *c0, uint16_t *c1, uint16_t *c2, size_t pixels);
+void swapChannels02(uint8_t *buffer, size_t pixels);
+void shiftLeft(uint16_t *buffer, size_t count, unsigned bits);
+void byteSwap(const uint16_t *src, uint16_t *dst, size_t count);
+void bin_u8(const uint8_t *src, uint8_t *dst, size_t width, size_t height, unsigned binX, unsigned binY);
+void bin_u16(const uint16_t *src, uint16_t *dst, size_t width, size_t height, unsigned binX, unsigned binY);
+void bin2x2_u8(const uint8_t *src, uint8_t *dst, size_t width, size_t height);
+void bin2x2_u16(const uint16_t *src, uint16_t *dst, size_t width, size_t height);
+void accumulate_u8(const uint8_t *src, float *acc, size_t count);
+void accumulate_u16(const uint16_t *src, float *acc, size_t count);
+void storeScaled_u8(const float *acc, float scale, uint8_t *dst, size_t count);
+void storeScaled_u16(const float *acc, float scale, uint16_t *dst, size_t count);
+void sigmaClip_u8(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup);
+void sigmaClip_u16(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2, bool warmup);
+void unpackRaw10(const uint8_t *src, uint16_t *dst, size_t groups);
+void unpackRaw12(const uint8_t *src, uint16_t *dst, size_t groups);
+}
+
+/** Fill @a kernels with the variants of each instruction set, false if not built in */
+bool initSse2(Kernels &kernels);
+bool initAvx2(Kernels &kernels);
+bool initNeon(Kernels &kernels);
+
+}
@@ -0,0 +1,361 @@
+/*
+    Pixel Kernels
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pixelkernels_p.h"
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+namespace PixelKernels
+{
+
+static void shiftLeftSse2(uint16_t *buffer, size_t count, unsigned bits)
+{
+    const __m128i shift = _mm_cvtsi32_si128(static_cast<int>(bits));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer + i), _mm_sll_epi16(v, shift));
+    }
+    Scalar::shiftLeft(buffer + i, count - i, bits);
+}
+
+static void byteSwapSse2(const uint16_t *src, uint16_t *dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+    }
+    Scalar::byteSwap(src + i, dst + i, count - i);
+}
+
+// Saturating a + c, then saturating (a + c) + (b + d), equals min(a + b + c + d, max)
+// because the total can only exceed max if one of the partial sums already did.
+
+static void bin2x2U8Sse2(const uint8_t *src, uint8_t *dst, size_t width, size_t height)
+{
+    const size_t outW = width / 2;
+    const size_t outH = height / 2;
+    const __m128i lowMask = _mm_set1_epi16(0x00FF);
+
+    for (size_t y = 0; y < outH; y++)
+    {
+        const uint8_t *row0 = src + 2 * y * width;
+        const uint8_t *row1 = row0 + width;
+        uint8_t *out = dst + y * outW;
+
+        size_t x = 0;
+        for (; x + 16 <= outW; x += 16)
+        {
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x + 16));
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x + 16));
+
+            __m128i v0 = _mm_adds_epu8(a0, b0);
+            __m128i v1 = _mm_adds_epu8(a1, b1);
+
+            __m128i s0 = _mm_adds_epu8(_mm_and_si128(v0, lowMask), _mm_srli_epi16(v0, 8));
+            __m128i s1 = _mm_adds_epu8(_mm_and_si128(v1, lowMask), _mm_srli_epi16(v1, 8));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(s0, s1));
+        }
+
+        for (; x < outW; x++)
+        {
+            unsigned sum = row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+            out[x] = static_cast<uint8_t>(sum > 0xFF ? 0xFF : sum);
+        }
+    }
+}
+
+static void bin2x2U16Sse2(const uint16_t *src, uint16_t *dst, size_t width, size_t height)
+{
+    const size_t outW = width / 2;
+    const size_t outH = height / 2;
+    const __m128i lowMask = _mm_set1_epi32(0x0000FFFF);
+    const __m128i bias32  = _mm_set1_epi32(0x8000);
+    const __m128i bias16  = _mm_set1_epi16(static_cast<short>(0x8000));
+
+    for (size_t y = 0; y < outH; y++)
+    {
+        const uint16_t *row0 = src + 2 * y * width;
+        const uint16_t *row1 = row0 + width;
+        uint16_t *out = dst + y * outW;
+
+        size_t x = 0;
+        for (; x + 8 <= outW; x += 8)
+        {
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x + 8));
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x + 8));
+
+            __m128i v0 = _mm_adds_epu16(a0, b0);
+            __m128i v1 = _mm_adds_epu16(a1, b1);
+
+            __m128i s0 = _mm_adds_epu16(_mm_and_si128(v0, lowMask), _mm_srli_epi32(v0, 16));
+            __m128i s1 = _mm_adds_epu16(_mm_and_si128(v1, lowMask), _mm_srli_epi32(v1, 16));
+
+            // SSE2 has no unsigned 32 -> 16 bit pack, bias into the signed range instead
+            s0 = _mm_sub_epi32(_mm_and_si128(s0, lowMask), bias32);
+            s1 = _mm_sub_epi32(_mm_and_si128(s1, lowMask), bias32);
+            __m128i packed = _mm_xor_si128(_mm_packs_epi32(s0, s1), bias16);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), packed);
+        }
+
+        for (; x < outW; x++)
+        {
+            uint32_t sum = row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1];
+            out[x] = static_cast<uint16_t>(sum > 0xFFFF ? 0xFFFF : sum);
+        }
+    }
+}
+
+static void accumulateU8Sse2(const uint8_t *src, float *acc, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+        __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+        __m128 s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+        __m128 s2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+        __m128 s3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+
+        _mm_storeu_ps(acc + i,      _mm_add_ps(_mm_loadu_ps(acc + i),      s0));
+        _mm_storeu_ps(acc + i + 4,  _mm_add_ps(_mm_loadu_ps(acc + i + 4),  s1));
+        _mm_storeu_ps(acc + i + 8,  _mm_add_ps(_mm_loadu_ps(acc + i + 8),  s2));
+        _mm_storeu_ps(acc + i + 12, _mm_add_ps(_mm_loadu_ps(acc + i + 12), s3));
+    }
+    Scalar::accumulate_u8(src + i, acc + i, count - i);
+}
+
+static void accumulateU16Sse2(const uint16_t *src, float *acc, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+        __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+        __m128 s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+
+        _mm_storeu_ps(acc + i,     _mm_add_ps(_mm_loadu_ps(acc + i),     s0));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), s1));
+    }
+    Scalar::accumulate_u16(src + i, acc + i, count - i);
+}
+
+// Clamping in float first keeps every value inside the pack range, the conversion
+// itself rounds to nearest even like std::nearbyint.
+
+static void storeScaledU8Sse2(const float *acc, float scale, uint8_t *dst, size_t count)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmin   = _mm_setzero_ps();
+    const __m128 vmax   = _mm_set1_ps(255.0f);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i q[4];
+        for (int j = 0; j < 4; j++)
+        {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(acc + i + 4 * j), vscale);
+            q[j] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, vmin), vmax));
+        }
+        __m128i lo = _mm_packs_epi32(q[0], q[1]);
+        __m128i hi = _mm_packs_epi32(q[2], q[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    Scalar::storeScaled_u8(acc + i, scale, dst + i, count - i);
+}
+
+static void storeScaledU16Sse2(const float *acc, float scale, uint16_t *dst, size_t count)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmin   = _mm_setzero_ps();
+    const __m128 vmax   = _mm_set1_ps(65535.0f);
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 v0 = _mm_mul_ps(_mm_loadu_ps(acc + i), vscale);
+        __m128 v1 = _mm_mul_ps(_mm_loadu_ps(acc + i + 4), vscale);
+        __m128i q0 = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v0, vmin), vmax));
+        __m128i q1 = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v1, vmin), vmax));
+
+        // Same signed pack trick as bin2x2U16Sse2
+        q0 = _mm_sub_epi32(q0, bias32);
+        q1 = _mm_sub_epi32(q1, bias32);
+        __m128i packed = _mm_xor_si128(_mm_packs_epi32(q0, q1), bias16);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), packed);
+    }
+    Scalar::storeScaled_u16(acc + i, scale, dst + i, count - i);
+}
+
+// Four samples of the Scalar::sigmaClip step
+static inline void sigmaClipStepSse2(__m128 x, float *mean, float *m2, float *count, __m128 sigma2, __m128 warmup)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 mu = _mm_loadu_ps(mean);
+    __m128 sq = _mm_loadu_ps(m2);
+    __m128 n  = _mm_loadu_ps(count);
+
+    __m128 delta = _mm_sub_ps(x, mu);
+    __m128 variance = _mm_max_ps(_mm_div_ps(sq, _mm_max_ps(n, one)), one);
+    __m128 accept = _mm_or_ps(warmup, _mm_cmple_ps(_mm_mul_ps(delta, delta), _mm_mul_ps(sigma2, variance)));
+
+    __m128 newN = _mm_add_ps(n, one);
+    __m128 newMu = _mm_add_ps(mu, _mm_div_ps(delta, newN));
+    __m128 newSq = _mm_add_ps(sq, _mm_mul_ps(delta, _mm_sub_ps(x, newMu)));
+
+    _mm_storeu_ps(mean,  _mm_or_ps(_mm_and_ps(accept, newMu), _mm_andnot_ps(accept, mu)));
+    _mm_storeu_ps(m2,    _mm_or_ps(_mm_and_ps(accept, newSq), _mm_andnot_ps(accept, sq)));
+    _mm_storeu_ps(count, _mm_or_ps(_mm_and_ps(accept, newN),  _mm_andnot_ps(accept, n)));
+}
+
+static void sigmaClipU8Sse2(const uint8_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2,
+                            bool warmup)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 vsigma2 = _mm_set1_ps(sigma2);
+    const __m128 vwarmup = _mm_castsi128_ps(_mm_set1_epi32(warmup ? -1 : 0));
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i)), zero);
+        sigmaClipStepSse2(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), mean + i, m2 + i, count + i, vsigma2, vwarmup);
+        sigmaClipStepSse2(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), mean + i + 4, m2 + i + 4, count + i + 4, vsigma2,
+                          vwarmup);
+    }
+    Scalar::sigmaClip_u8(src + i, mean + i, m2 + i, count + i, samples - i, sigma2, warmup);
+}
+
+static void sigmaClipU16Sse2(const uint16_t *src, float *mean, float *m2, float *count, size_t samples, float sigma2,
+                             bool warmup)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 vsigma2 = _mm_set1_ps(sigma2);
+    const __m128 vwarmup = _mm_castsi128_ps(_mm_set1_epi32(warmup ? -1 : 0));
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        sigmaClipStepSse2(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), mean + i, m2 + i, count + i, vsigma2, vwarmup);
+        sigmaClipStepSse2(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), mean + i + 4, m2 + i + 4, count + i + 4, vsigma2,
+                          vwarmup);
+    }
+    Scalar::sigmaClip_u16(src + i, mean + i, m2 + i, count + i, samples - i, sigma2, warmup);
+}
+
+static void unpackRaw10Sse2(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowScale = _mm_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1);
+    const __m128i lowMask = _mm_set1_epi16(0x00C0);
+
+    // Two groups per step, the 8 byte load of the second one reads 3 bytes into the next group
+    size_t i = 0;
+    for (; i + 3 <= groups; i += 2, src += 10, dst += 8)
+    {
+        __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src)),
+                                       _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + 5)));
+        // High bytes of both groups in the lower half, the low bit bytes at the start of each upper dword
+        v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+
+        __m128i high = _mm_unpacklo_epi8(zero, v);
+        __m128i low = _mm_unpackhi_epi8(v, zero);
+        low = _mm_shufflehi_epi16(_mm_shufflelo_epi16(low, 0), 0);
+        low = _mm_and_si128(_mm_mullo_epi16(low, lowScale), lowMask);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_or_si128(high, low));
+    }
+    Scalar::unpackRaw10(src, dst, groups - i);
+}
+
+static void unpackRaw12Sse2(const uint8_t *src, uint16_t *dst, size_t groups)
+{
+    const __m128i highMask0 = _mm_set1_epi32(0x0000FF00);
+    const __m128i lowMask0  = _mm_set1_epi32(0x000000F0);
+    const __m128i highMask1 = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    const __m128i lowMask1  = _mm_set1_epi32(0x00F00000);
+
+    // Four groups per step, the 16 byte load reads 4 bytes past them
+    size_t i = 0;
+    for (; i + 6 <= groups; i += 4, src += 12, dst += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        // One group per dword, the two pixels end up in its low and high word
+        __m128i g = _mm_unpacklo_epi64(_mm_unpacklo_epi32(v, _mm_srli_si128(v, 3)),
+                                       _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9)));
+
+        __m128i out = _mm_and_si128(_mm_slli_epi32(g, 8), highMask0);
+        out = _mm_or_si128(out, _mm_and_si128(_mm_srli_epi32(g, 12), lowMask0));
+        out = _mm_or_si128(out, _mm_and_si128(_mm_slli_epi32(g, 16), highMask1));
+        out = _mm_or_si128(out, _mm_and_si128(g, lowMask1));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), out);
+    }
+    Scalar::unpackRaw12(src, dst, groups - i);
+}
+
+bool initSse2(Kernels &k)
+{
+    k.shiftLeft       = shiftLeftSse2;
+    k.byteSwap        = byteSwapSse2;
+    k.bin2x2_u8       = bin2x2U8Sse2;
+    k.bin2x2_u16      = bin2x2U16Sse2;
+    k.accumulate_u8   = accumulateU8Sse2;
+    k.accumulate_u16  = accumulateU16Sse2;
+    k.storeScaled_u8  = storeScaledU8Sse2;
+    k.storeScaled_u16 = storeScaledU16Sse2;
+    k.sigmaClip_u8    = sigmaClipU8Sse2;
+    k.sigmaClip_u16   = sigmaClipU16Sse2;
+    k.unpackRaw10     = unpackRaw10Sse2;
+    k.unpackRaw12     = unpackRaw12Sse2;
+    return true;
+}
+
+}
+
+#else
+
+namespace PixelKernels
+{
+
+bool initSse2(Kernels &)
+{
+    return false;
+}
+
+}
+
+#endif
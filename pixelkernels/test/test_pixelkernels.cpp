@@ -0,0 +1,391 @@
+/*
+    Pixel Kernels unit tests
+
+    Each kernel is compared against the scalar loop it replaces in the drivers,
+    for every instruction set the build and the CPU support.
+*/
+
+#include "pixelkernels.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace PixelKernels;
+
+static const Isa allIsas[] = { ISA_SCALAR, ISA_SSE2, ISA_AVX2, ISA_NEON };
+
+// Sizes chosen to exercise the vector body and the scalar tail
+static const size_t pixelCounts[] = { 0, 1, 5, 15, 16, 17, 31, 64, 1000, 1923 * 7 };
+
+template <typename T>
+static std::vector<T> randomData(size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> dist(0, std::numeric_limits<T>::max());
+    std::vector<T> data(count);
+    for (auto &v : data)
+        v = static_cast<T>(dist(gen));
+    return data;
+}
+
+class PixelKernelsTest : public ::testing::TestWithParam<Isa>
+{
+    protected:
+        void SetUp() override
+        {
+            if (!selectIsa(GetParam()))
+                GTEST_SKIP() << toString(GetParam()) << " not supported here";
+        }
+};
+
+// ASIBase::grabImage: BGR24 to planar RGB
+TEST_P(PixelKernelsTest, DeinterleaveBGR24)
+{
+    for (size_t pixels : pixelCounts)
+    {
+        auto src = randomData<uint8_t>(pixels * 3, pixels);
+        std::vector<uint8_t> expected(pixels * 3), actual(pixels * 3, 0xAA);
+
+        uint8_t *dstR = expected.data();
+        uint8_t *dstG = expected.data() + pixels;
+        uint8_t *dstB = expected.data() + pixels * 2;
+        const uint8_t *s = src.data();
+        const uint8_t *end = src.data() + pixels * 3;
+        while (s != end)
+        {
+            *dstB++ = *s++;
+            *dstG++ = *s++;
+            *dstR++ = *s++;
+        }
+
+        deinterleave3(src.data(), actual.data() + pixels * 2, actual.data() + pixels, actual.data(), pixels);
+        EXPECT_EQ(expected, actual) << "pixels " << pixels;
+    }
+}
+
+// ToupBase and indi_webcam: RGB24 to planar RGB
+TEST_P(PixelKernelsTest, DeinterleaveRGB24)
+{
+    for (size_t pixels : pixelCounts)
+    {
+        auto src = randomData<uint8_t>(pixels * 3, pixels + 1);
+        std::vector<uint8_t> expected(pixels * 3), actual(pixels * 3, 0x55);
+
+        uint8_t *subR = expected.data();
+        uint8_t *subG = expected.data() + pixels;
+        uint8_t *subB = expected.data() + pixels * 2;
+        for (size_t i = 0; i < pixels * 3; i += 3)
+        {
+            *subR++ = src[i];
+            *subG++ = src[i + 1];
+            *subB++ = src[i + 2];
+        }
+
+        deinterleave3(src.data(), actual.data(), actual.data() + pixels, actual.data() + pixels * 2, pixels);
+        EXPECT_EQ(expected, actual) << "pixels " << pixels;
+    }
+}
+
+// indi_webcam: RGB48 to planar RGB
+TEST_P(PixelKernelsTest, DeinterleaveRGB48)
+{
+    for (size_t pixels : pixelCounts)
+    {
+        auto src = randomData<uint16_t>(pixels * 3, pixels + 2);
+        std::vector<uint16_t> expected(pixels * 3), actual(pixels * 3, 0xAAAA);
+
+        const uint16_t *s = src.data();
+        uint16_t *r = expected.data();
+        uint16_t *g = expected.data() + pixels;
+        uint16_t *b = expected.data() + pixels * 2;
+        for (size_t i = 0; i < pixels * 3; i += 3)
+        {
+            *r++ = *s++;
+            *g++ = *s++;
+            *b++ = *s++;
+        }
+
+        deinterleave3(src.data(), actual.data(), actual.data() + pixels, actual.data() + pixels * 2, pixels);
+        EXPECT_EQ(expected, actual) << "pixels " << pixels;
+    }
+}
+
+// ASIBase::workerStreamVideo: BGR24 <-> RGB24 in place
+TEST_P(PixelKernelsTest, SwapChannels)
+{
+    for (size_t pixels : pixelCounts)
+    {
+        auto expected = randomData<uint8_t>(pixels * 3, pixels + 3);
+        auto actual = expected;
+
+        for (size_t i = 0; i < pixels * 3; i += 3)
+            std::swap(expected[i], expected[i + 2]);
+
+        swapChannels02(actual.data(), pixels);
+        EXPECT_EQ(expected, actual) << "pixels " << pixels;
+    }
+}
+
+// Sv305CCD: 12 bit to 16 bit stretch
+TEST_P(PixelKernelsTest, ShiftLeft)
+{
+    for (unsigned bits : { 1u, 2u, 4u, 8u, 15u })
+        for (size_t count : pixelCounts)
+        {
+            auto expected = randomData<uint16_t>(count, count + bits);
+            auto actual = expected;
+
+            for (size_t i = 0; i < count; i++)
+                expected[i] <<= bits;
+
+            shiftLeft(actual.data(), count, bits);
+            EXPECT_EQ(expected, actual) << "count " << count << " bits " << bits;
+        }
+}
+
+// DSICCD::grabImage: big endian samples to host order
+TEST_P(PixelKernelsTest, FromBigEndian)
+{
+    for (size_t count : pixelCounts)
+    {
+        auto src = randomData<uint16_t>(count, count + 4);
+        std::vector<uint16_t> expected(count), actual(count), inPlace = src;
+
+        for (size_t i = 0; i < count; i++)
+            expected[i] = ntohs(src[i]);
+
+        fromBigEndian(src.data(), actual.data(), count);
+        fromBigEndian(inPlace.data(), inPlace.data(), count);
+        EXPECT_EQ(expected, actual) << "count " << count;
+        EXPECT_EQ(expected, inPlace) << "count " << count;
+    }
+}
+
+template <typename T>
+static std::vector<T> referenceBin(const std::vector<T> &src, size_t width, size_t height, unsigned binX, unsigned binY)
+{
+    size_t outW = width / binX, outH = height / binY;
+    std::vector<T> out(outW * outH);
+    for (size_t y = 0; y < outH; y++)
+        for (size_t x = 0; x < outW; x++)
+        {
+            uint32_t sum = 0;
+            for (unsigned j = 0; j < binY; j++)
+                for (unsigned i = 0; i < binX; i++)
+                    sum += src[(y * binY + j) * width + x * binX + i];
+            out[y * outW + x] = static_cast<T>(std::min<uint32_t>(sum, std::numeric_limits<T>::max()));
+        }
+    return out;
+}
+
+template <typename T>
+static void checkBin(unsigned binX, unsigned binY)
+{
+    for (size_t width : { 2, 7, 32, 33, 67, 640 })
+        for (size_t height : { 2, 3, 9, 48 })
+        {
+            auto src = randomData<T>(width * height, width * 131 + height);
+            auto expected = referenceBin(src, width, height, binX, binY);
+
+            std::vector<T> actual(expected.size());
+            bin(src.data(), actual.data(), width, height, binX, binY);
+            EXPECT_EQ(expected, actual) << width << "x" << height << " bin " << binX << "x" << binY;
+
+            // Binning in place as INDI::CCDChip::binFrame does
+            auto inPlace = src;
+            bin(inPlace.data(), inPlace.data(), width, height, binX, binY);
+            inPlace.resize(expected.size());
+            EXPECT_EQ(expected, inPlace) << width << "x" << height << " bin " << binX << "x" << binY << " in place";
+        }
+}
+
+TEST_P(PixelKernelsTest, Bin8)
+{
+    checkBin<uint8_t>(2, 2);
+    checkBin<uint8_t>(3, 3);
+    checkBin<uint8_t>(2, 1);
+}
+
+TEST_P(PixelKernelsTest, Bin16)
+{
+    checkBin<uint16_t>(2, 2);
+    checkBin<uint16_t>(4, 4);
+    checkBin<uint16_t>(1, 2);
+}
+
+// indi_webcam stacking: running float sum of each frame
+template <typename T>
+static void checkAccumulate()
+{
+    for (size_t count : pixelCounts)
+    {
+        auto src = randomData<T>(count, count + 7);
+        std::vector<float> expected(count), actual(count);
+        for (size_t i = 0; i < count; i++)
+            expected[i] = actual[i] = static_cast<float>(i % 1000) + 0.25f;
+
+        for (size_t i = 0; i < count; i++)
+            expected[i] += src[i];
+
+        accumulate(src.data(), actual.data(), count);
+        EXPECT_EQ(expected, actual) << "count " << count;
+    }
+}
+
+TEST_P(PixelKernelsTest, Accumulate8)
+{
+    checkAccumulate<uint8_t>();
+}
+
+TEST_P(PixelKernelsTest, Accumulate16)
+{
+    checkAccumulate<uint16_t>();
+}
+
+// indi_webcam stacking: averaged or integrated stack back to samples
+template <typename T>
+static void checkStoreScaled()
+{
+    const float maxValue = std::numeric_limits<T>::max();
+    for (size_t count : pixelCounts)
+    {
+        std::mt19937 gen(count);
+        std::uniform_real_distribution<float> dist(-10.0f, maxValue * 3);
+        std::vector<float> acc(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            // Mix in exact halves to pin down the tie rule
+            acc[i] = (i % 5 == 0) ? static_cast<float>(i % 600) + 0.5f : dist(gen);
+        }
+
+        for (float scale : { 1.0f, 1.0f / 3, 0.5f })
+        {
+            std::vector<T> expected(count), actual(count, 0x5A);
+            for (size_t i = 0; i < count; i++)
+            {
+                float v = std::min(std::max(acc[i] * scale, 0.0f), maxValue);
+                expected[i] = static_cast<T>(std::nearbyint(v));
+            }
+
+            storeScaled(acc.data(), scale, actual.data(), count);
+            EXPECT_EQ(expected, actual) << "count " << count << " scale " << scale;
+        }
+    }
+}
+
+TEST_P(PixelKernelsTest, StoreScaled8)
+{
+    checkStoreScaled<uint8_t>();
+}
+
+TEST_P(PixelKernelsTest, StoreScaled16)
+{
+    checkStoreScaled<uint16_t>();
+}
+
+// indi_webcam sigma clip stacking: several frames with outliers through the running state
+template <typename T>
+static void checkSigmaClip()
+{
+    for (size_t count : pixelCounts)
+    {
+        std::vector<float> expectedMean(count, 0), expectedM2(count, 0), expectedN(count, 0);
+        std::vector<float> mean(count, 0), m2(count, 0), n(count, 0);
+
+        for (unsigned frame = 0; frame < 8; frame++)
+        {
+            auto src = randomData<T>(count, count * 11 + frame);
+            // Mostly a narrow spread around a level, with every seventh sample far off
+            for (size_t i = 0; i < count; i++)
+                if ((i + frame) % 7 != 0)
+                    src[i] = static_cast<T>(std::numeric_limits<T>::max() / 2 + src[i] % 9);
+
+            const bool warmup = frame < 2;
+            for (size_t i = 0; i < count; i++)
+            {
+                const float x = src[i];
+                const float delta = x - expectedMean[i];
+                const float variance = std::max(expectedM2[i] / std::max(expectedN[i], 1.0f), 1.0f);
+                if (warmup || delta * delta <= 6.25f * variance)
+                {
+                    const float next = expectedN[i] + 1.0f;
+                    const float newMean = expectedMean[i] + delta / next;
+                    expectedM2[i] += delta * (x - newMean);
+                    expectedMean[i] = newMean;
+                    expectedN[i] = next;
+                }
+            }
+
+            sigmaClip(src.data(), mean.data(), m2.data(), n.data(), count, 6.25f, warmup);
+        }
+
+        EXPECT_EQ(expectedMean, mean) << "count " << count;
+        EXPECT_EQ(expectedM2, m2) << "count " << count;
+        EXPECT_EQ(expectedN, n) << "count " << count;
+    }
+}
+
+TEST_P(PixelKernelsTest, SigmaClip8)
+{
+    checkSigmaClip<uint8_t>();
+}
+
+TEST_P(PixelKernelsTest, SigmaClip16)
+{
+    checkSigmaClip<uint16_t>();
+}
+
+// indi_rpicam Raw10ToBayer16Pipeline: MIPI RAW10, 10 bit samples moved up to bit 15
+TEST_P(PixelKernelsTest, UnpackRaw10)
+{
+    for (size_t groups : pixelCounts)
+    {
+        auto src = randomData<uint8_t>(groups * 5, groups + 5);
+        std::vector<uint16_t> expected(groups * 4), actual(groups * 4 + 1, 0xAAAA);
+
+        for (size_t g = 0; g < groups; g++)
+            for (size_t p = 0; p < 4; p++)
+            {
+                unsigned sample = src[g * 5 + p] << 2 | ((src[g * 5 + 4] >> (2 * p)) & 0x03);
+                expected[g * 4 + p] = static_cast<uint16_t>(sample << 6);
+            }
+
+        unpackRaw10(src.data(), actual.data(), groups);
+        EXPECT_EQ(0xAAAA, actual.back()) << "groups " << groups;
+        actual.pop_back();
+        EXPECT_EQ(expected, actual) << "groups " << groups;
+    }
+}
+
+// indi_rpicam Raw12ToBayer16Pipeline: Broadcom RAW12, 12 bit samples moved up to bit 15
+TEST_P(PixelKernelsTest, UnpackRaw12)
+{
+    for (size_t groups : pixelCounts)
+    {
+        auto src = randomData<uint8_t>(groups * 3, groups + 12);
+        std::vector<uint16_t> expected(groups * 2), actual(groups * 2 + 1, 0xAAAA);
+
+        for (size_t g = 0; g < groups; g++)
+            for (size_t p = 0; p < 2; p++)
+            {
+                unsigned sample = src[g * 3 + p] << 4 | ((src[g * 3 + 2] >> (4 * p)) & 0x0F);
+                expected[g * 2 + p] = static_cast<uint16_t>(sample << 4);
+            }
+
+        unpackRaw12(src.data(), actual.data(), groups);
+        EXPECT_EQ(0xAAAA, actual.back()) << "groups " << groups;
+        actual.pop_back();
+        EXPECT_EQ(expected, actual) << "groups " << groups;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsas, PixelKernelsTest, ::testing::ValuesIn(allIsas),
+                         [](const ::testing::TestParamInfo<Isa> &info)
+{
+    return std::string(toString(info.param));
+});
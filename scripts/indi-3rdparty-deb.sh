@@ -35,6 +35,14 @@ for driver in ${DRIVER_LIST}; do
     cp -r ${INDI_SRCS}/${driver} .
     cp -r ${INDI_SRCS}/debian/${driver} debian
     cp -r ${INDI_SRCS}/cmake_modules ./
+    # Drivers using include(PixelKernels) build the shared pixel kernels next to cmake_modules
+    if grep -q "include(PixelKernels)" ${INDI_SRCS}/${driver}/CMakeLists.txt; then
+        cp -r ${INDI_SRCS}/pixelkernels ./
+    fi
+    # Drivers reusing the gphoto image decoders build them from ../indi-gphoto
+    if grep -q "../indi-gphoto" ${INDI_SRCS}/${driver}/CMakeLists.txt; then
+        cp -r ${INDI_SRCS}/indi-gphoto ./
+    fi
     fakeroot debian/rules -j$(($(nproc)+1)) binary
     popd
 done